@@ -0,0 +1,331 @@
+/**
+ * Replays a captured workload against a copy of its databases
+ *
+ * The input is either a capture written by `soliddb --capture <file>`
+ * (every statement of every session, with timing) or a database's
+ * transactions.log (writes only, no timing). The databases it uses are
+ * copied from --source into --work-dir first, so the originals are never
+ * modified, and each replay starts from the same state.
+ *
+ * Captured sessions are spread over --concurrency threads (default: one per
+ * session), each with its own parser and all sharing one registry, like the
+ * server. Statements are issued at their captured time divided by --speed,
+ * or as fast as possible with --speed 0.
+ *
+ * A transactions.log holds the whole history of its database, so it is
+ * replayed into a new database: its leading CREATE statements run first,
+ * untimed, and the rest is dealt round-robin over the threads as fast as
+ * possible, keeping each BEGIN..COMMIT block on one thread.
+ *
+ * Usage: soliddb_replay (--capture <file> | --log <db>/transactions.log)
+ *                       [--source <dir>] [--work-dir <dir>] [--speed X]
+ *                       [--concurrency N]
+ */
+#include "core/DatabaseRegistry.h"
+#include "parser/CommandParser.h"
+#include "util/Console.h"
+#include "util/Metrics.h"
+#include "util/StringUtils.h"
+#include "util/WorkloadCapture.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace soliddb;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ReplayConfig {
+    std::string capturePath;
+    std::string logPath;
+    std::string sourceDir = ".";
+    std::string workDir = "soliddb_replay";
+    double speed = 1.0;          // 0 = as fast as possible
+    size_t concurrency = 0;      // 0 = one thread per captured session
+};
+
+struct ReplayResult {
+    util::Histogram latency;
+    util::Histogram lag;         // How late statements started against the schedule
+    std::atomic<uint64_t> statements{0};
+    std::atomic<uint64_t> errors{0};
+};
+
+bool parseArgs(int argc, char* argv[], ReplayConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--capture") {
+            config.capturePath = value;
+        } else if (arg == "--log") {
+            config.logPath = value;
+        } else if (arg == "--source") {
+            config.sourceDir = value;
+        } else if (arg == "--work-dir") {
+            config.workDir = value;
+        } else if (arg == "--speed") {
+            config.speed = std::stod(value);
+        } else if (arg == "--concurrency") {
+            config.concurrency = std::stoul(value);
+        } else {
+            return false;
+        }
+    }
+    return config.capturePath.empty() != config.logPath.empty() && config.speed >= 0;
+}
+
+/**
+ * Whether a statement begins with an uppercase keyword, in any case
+ */
+bool startsWith(const std::string& statement, const std::string& keyword) {
+    return util::StringUtils::toUpper(statement.substr(0, keyword.size())) == keyword;
+}
+
+/**
+ * Read the statements of a transactions.log; they all belong to the database
+ * the log is in and carry no timing
+ */
+bool readTransactionLog(const std::string& path, std::vector<util::CapturedStatement>& statements) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::string database = fs::path(path).parent_path().filename().string();
+    std::string line;
+    while (std::getline(file, line)) {
+        line = util::StringUtils::trim(line);
+        if (!line.empty()) {
+            statements.push_back(util::CapturedStatement{0, 0, database, line});
+        }
+    }
+    return true;
+}
+
+/**
+ * Create the working directory and copy every database the workload runs
+ * against into it
+ */
+bool prepareWorkDir(const ReplayConfig& config, const std::vector<util::CapturedStatement>& statements,
+                    bool copyDatabases) {
+    std::set<std::string> databases;
+    for (const auto& captured : statements) {
+        if (!captured.database.empty()) {
+            databases.insert(captured.database);
+        }
+    }
+
+    std::error_code ec;
+    fs::remove_all(config.workDir, ec);
+    fs::create_directories(config.workDir, ec);
+    if (ec) {
+        std::cerr << "Error: Cannot create " << config.workDir << ": " << ec.message() << std::endl;
+        return false;
+    }
+
+    for (const auto& database : copyDatabases ? databases : std::set<std::string>()) {
+        fs::path source = fs::path(config.sourceDir) / database;
+        if (!fs::exists(source)) {
+            // Created during the capture; the replay creates it again
+            continue;
+        }
+        fs::path target = fs::path(config.workDir) / database;
+        fs::create_directories(target.parent_path(), ec);
+        fs::copy(source, target, fs::copy_options::recursive, ec);
+        if (ec) {
+            std::cerr << "Error: Cannot copy " << source << ": " << ec.message() << std::endl;
+            return false;
+        }
+        std::cerr << "Copied database '" << database << "'" << std::endl;
+    }
+    return true;
+}
+
+void runWorker(const std::vector<const util::CapturedStatement*>& statements,
+               std::shared_ptr<core::DatabaseRegistry> registry,
+               double speed, Clock::time_point start, ReplayResult& result) {
+    parser::CommandParser parser;
+    parser.setRegistry(std::move(registry));
+    parser.setOutput(util::Console::null());
+    parser.setQuiet(true);
+    std::shared_ptr<core::Database> currentDatabase;
+
+    for (const auto* captured : statements) {
+        if (startsWith(captured->statement, "EXIT")) {
+            continue;
+        }
+
+        // Several captured sessions may share this thread; follow their database
+        std::string currentName = currentDatabase ? currentDatabase->getName() : "";
+        if (!captured->database.empty() && captured->database != currentName) {
+            parser.executeCommand("USE " + captured->database, currentDatabase);
+        }
+
+        Clock::time_point scheduled = start;
+        if (speed > 0) {
+            scheduled += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::nanoseconds(static_cast<uint64_t>(captured->offsetNanoseconds / speed)));
+            std::this_thread::sleep_until(scheduled);
+        }
+
+        auto statementStart = Clock::now();
+        parser.executeCommand(captured->statement, currentDatabase);
+        result.latency.recordSince(statementStart);
+        if (speed > 0) {
+            result.lag.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(statementStart - scheduled).count()));
+        }
+        result.statements++;
+        if (parser.lastCommandFailed()) {
+            result.errors++;
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    ReplayConfig config;
+    try {
+        if (!parseArgs(argc, argv, config)) {
+            std::cerr << "Usage: " << argv[0]
+                      << " (--capture <file> | --log <db>/transactions.log) [--source <dir>]"
+                      << " [--work-dir <dir>] [--speed X] [--concurrency N]" << std::endl;
+            return 2;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Invalid argument: " << e.what() << std::endl;
+        return 2;
+    }
+
+    std::vector<util::CapturedStatement> statements;
+    bool loaded = config.capturePath.empty()
+        ? readTransactionLog(config.logPath, statements)
+        : util::WorkloadCapture::read(config.capturePath, statements);
+    if (!loaded) {
+        std::cerr << "Error: Cannot read workload from "
+                  << (config.capturePath.empty() ? config.logPath : config.capturePath) << std::endl;
+        return 1;
+    }
+    bool replayingLog = !config.logPath.empty();
+    size_t setupCount = 0;
+    if (replayingLog) {
+        while (setupCount < statements.size() && startsWith(statements[setupCount].statement, "CREATE")) {
+            setupCount++;
+        }
+        config.speed = 0;
+    }
+    if (!prepareWorkDir(config, statements, !replayingLog)) {
+        return 1;
+    }
+
+    // Group statements by session, keeping their captured order
+    std::map<uint32_t, std::vector<const util::CapturedStatement*>> sessions;
+    for (const auto& captured : statements) {
+        sessions[captured.session].push_back(&captured);
+    }
+    for (auto& [_, list] : sessions) {
+        std::stable_sort(list.begin(), list.end(), [](const auto* a, const auto* b) {
+            return a->offsetNanoseconds < b->offsetNanoseconds;
+        });
+    }
+
+    size_t threads = config.concurrency > 0 ? config.concurrency : std::max<size_t>(1, sessions.size());
+    std::vector<std::vector<const util::CapturedStatement*>> assignments(threads);
+    if (!replayingLog) {
+        size_t next = 0;
+        for (auto& [_, list] : sessions) {
+            auto& assigned = assignments[next++ % threads];
+            assigned.insert(assigned.end(), list.begin(), list.end());
+        }
+        for (auto& assigned : assignments) {
+            std::stable_sort(assigned.begin(), assigned.end(), [](const auto* a, const auto* b) {
+                return a->offsetNanoseconds < b->offsetNanoseconds;
+            });
+        }
+    } else {
+        size_t unit = 0;
+        for (size_t i = setupCount; i < statements.size(); unit++) {
+            auto& assigned = assignments[unit % threads];
+            bool inTransaction = startsWith(statements[i].statement, "BEGIN");
+            assigned.push_back(&statements[i++]);
+            while (inTransaction && i < statements.size()) {
+                const std::string& statement = statements[i].statement;
+                assigned.push_back(&statements[i++]);
+                inTransaction = !startsWith(statement, "COMMIT") && !startsWith(statement, "ROLLBACK");
+            }
+        }
+    }
+
+    fs::current_path(config.workDir);
+    util::Console::setQuiet(true);
+    auto registry = std::make_shared<core::DatabaseRegistry>();
+
+    // Engine errors (e.g. duplicate keys) are counted, not printed
+    std::streambuf* stdoutBuffer = std::cout.rdbuf(nullptr);
+
+    if (setupCount > 0) {
+        parser::CommandParser setup;
+        setup.setRegistry(registry);
+        setup.setOutput(util::Console::null());
+        std::shared_ptr<core::Database> currentDatabase;
+        for (size_t i = 0; i < setupCount; i++) {
+            setup.executeCommand(statements[i].statement, currentDatabase);
+        }
+    }
+
+    std::cerr << "Replaying " << statements.size() - setupCount << " statement(s) from " << sessions.size()
+              << " session(s) on " << threads << " thread(s)";
+    if (config.speed > 0) {
+        std::cerr << " at " << config.speed << "x speed";
+    }
+    std::cerr << "..." << std::endl;
+
+    ReplayResult result;
+    auto start = Clock::now();
+    {
+        std::vector<std::thread> workers;
+        for (const auto& assigned : assignments) {
+            workers.emplace_back(runWorker, std::cref(assigned), registry, config.speed, start, std::ref(result));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    registry->closeAll();
+    std::cout.rdbuf(stdoutBuffer);
+
+    auto format = util::Metrics::formatDuration;
+    std::cout << "Statements:  " << result.statements << " (" << result.errors << " failed)\n";
+    std::cout << "Elapsed:     " << std::fixed << std::setprecision(3) << seconds << " s\n";
+    std::cout << "Throughput:  " << std::setprecision(0) << result.statements / seconds << " statements/s\n";
+    std::cout << "Latency:     p50 " << format(result.latency.percentile(0.50))
+              << "  p90 " << format(result.latency.percentile(0.90))
+              << "  p99 " << format(result.latency.percentile(0.99))
+              << "  p99.9 " << format(result.latency.percentile(0.999))
+              << "  max " << format(result.latency.max()) << "\n";
+    if (result.lag.count() > 0) {
+        std::cout << "Start lag:   p50 " << format(result.lag.percentile(0.50))
+                  << "  p99 " << format(result.lag.percentile(0.99))
+                  << "  max " << format(result.lag.max()) << "\n";
+    }
+    std::cout << "\n" << util::Metrics::instance().report();
+    return 0;
+}
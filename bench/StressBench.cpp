@@ -0,0 +1,186 @@
+/**
+ * Multi-threaded stress benchmark for core::Database
+ *
+ * Runs point-lookup readers against one table while writer threads keep
+ * inserting into it, for an increasing number of reader threads, and reports
+ * read/write throughput and the read speedup over a single reader.
+ *
+ * Writers are rate limited (--write-rate per writer, 0 = unlimited) so the
+ * table grows by a similar amount in every round.
+ *
+ * Usage: soliddb_stress [--rows N] [--writers N] [--write-rate N]
+ *                       [--readers 1,2,4,8] [--seconds S]
+ */
+#include "core/Database.h"
+#include "util/Console.h"
+#include "util/StringUtils.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace soliddb;
+
+namespace {
+
+struct BenchConfig {
+    size_t rows = 20000;
+    size_t writers = 1;
+    size_t writeRate = 1000;
+    std::vector<size_t> readerCounts;
+    double seconds = 2.0;
+};
+
+struct RunResult {
+    double readsPerSecond;
+    double writesPerSecond;
+};
+
+RunResult runRound(core::Database& db, const BenchConfig& config, size_t readers,
+                   std::atomic<long long>& nextKey) {
+    std::atomic<bool> stop{false};
+    std::atomic<long long> reads{0};
+    std::atomic<long long> writes{0};
+    std::vector<std::thread> threads;
+
+    for (size_t r = 0; r < readers; r++) {
+        threads.emplace_back([&, r]() {
+            std::mt19937_64 rng(r + 1);
+            std::uniform_int_distribution<size_t> keys(0, config.rows - 1);
+            long long local = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto rows = db.select("bench", {"payload"}, "id=" + std::to_string(keys(rng)));
+                if (rows.size() != 1) {
+                    std::cerr << "Unexpected result size " << rows.size() << std::endl;
+                }
+                local++;
+            }
+            reads += local;
+        });
+    }
+
+    for (size_t w = 0; w < config.writers; w++) {
+        threads.emplace_back([&]() {
+            auto begin = std::chrono::steady_clock::now();
+            long long local = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                long long key = nextKey++;
+                db.insert("bench", {std::to_string(key), "w" + std::to_string(key)});
+                local++;
+                
+                if (config.writeRate > 0) {
+                    auto due = begin + std::chrono::duration<double>(
+                        static_cast<double>(local) / config.writeRate);
+                    std::this_thread::sleep_until(due);
+                }
+            }
+            writes += local;
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(config.seconds));
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return {reads / elapsed, writes / elapsed};
+}
+
+bool parseArgs(int argc, char* argv[], BenchConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--rows") {
+            config.rows = std::stoul(value);
+        } else if (arg == "--writers") {
+            config.writers = std::stoul(value);
+        } else if (arg == "--write-rate") {
+            config.writeRate = std::stoul(value);
+        } else if (arg == "--seconds") {
+            config.seconds = std::stod(value);
+        } else if (arg == "--readers") {
+            for (const auto& count : util::StringUtils::tokenize(value, ',')) {
+                config.readerCounts.push_back(std::stoul(count));
+            }
+        } else {
+            return false;
+        }
+    }
+    return config.rows > 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    try {
+        if (!parseArgs(argc, argv, config)) {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--rows N] [--writers N] [--write-rate N] [--readers 1,2,4,8] [--seconds S]"
+                      << std::endl;
+            return 2;
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Error: Invalid numeric argument" << std::endl;
+        return 2;
+    }
+
+    if (config.readerCounts.empty()) {
+        size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t count = 1; count <= cores; count *= 2) {
+            config.readerCounts.push_back(count);
+        }
+    }
+
+    util::Console::setQuiet(true);
+    std::string dbPath = (fs::temp_directory_path() / "soliddb_stress").string();
+    fs::remove_all(dbPath);
+
+    std::cout << "rows=" << config.rows << " writers=" << config.writers
+              << " write-rate=" << config.writeRate
+              << " seconds=" << config.seconds
+              << " cores=" << std::thread::hardware_concurrency() << "\n";
+    std::cout << std::left << std::setw(10) << "readers" << std::setw(16) << "reads/s"
+              << std::setw(16) << "writes/s" << "read speedup\n";
+
+    {
+        core::Database db(dbPath);
+        db.createTable("bench", std::vector<core::ColumnDef>{
+            core::ColumnDef("id", "INT", static_cast<int>(core::ColumnConstraint::PRIMARY_KEY)),
+            core::ColumnDef("payload", "STRING")});
+
+        for (size_t i = 0; i < config.rows; i++) {
+            db.insert("bench", {std::to_string(i), "p" + std::to_string(i)});
+        }
+
+        std::atomic<long long> nextKey{static_cast<long long>(config.rows)};
+        double baseline = 0;
+
+        for (size_t readers : config.readerCounts) {
+            RunResult result = runRound(db, config, readers, nextKey);
+            if (baseline == 0) {
+                baseline = result.readsPerSecond;
+            }
+            std::cout << std::left << std::setw(10) << readers
+                      << std::setw(16) << std::fixed << std::setprecision(0) << result.readsPerSecond
+                      << std::setw(16) << result.writesPerSecond
+                      << std::setprecision(2) << (baseline > 0 ? result.readsPerSecond / baseline : 0)
+                      << "x\n";
+        }
+    }
+
+    fs::remove_all(dbPath);
+    return 0;
+}
@@ -0,0 +1,489 @@
+/**
+ * Single-threaded benchmark suite for core::Database
+ *
+ * For each table size of a sweep, runs a set of reproducible synthetic
+ * workloads against a configurable schema and reports throughput, latency
+ * percentiles and peak RSS as JSON, so two builds can be compared with a
+ * plain diff or a script. The memory the loaded table takes is reported as
+ * the RSS growth over the insert workload and as the engine's own estimate
+ * (SHOW MEMORY), of which index_kb is the PRIMARY KEY and UNIQUE indexes:
+ *
+ *   insert      Database::insert of every row (Table::insertRow)
+ *   lookup      equality SELECT on the key column with skewed keys
+ *   scan        full-table SELECT of every column
+ *   checkpoint  Database::saveToFile of the loaded table
+ *   load        Database::loadFromFile of the saved table
+ *
+ * The size of the table file the checkpoint wrote is reported as file_kb;
+ * --compress on writes it as compressed column blocks (SET COMPRESSION).
+ *
+ * Keys follow a Zipfian distribution (--skew, 0 = uniform), generated with
+ * the method of Gray et al. ("Quickly Generating Billion-Record Synthetic
+ * Databases") so that no per-key table is needed at 1e7 rows. Every run uses
+ * the same seed unless --seed is given.
+ *
+ * Usage: soliddb_bench [--rows 1e3,1e4,1e5,1e6] [--schema id:INT:PK,...]
+ *                      [--lookups N] [--scans N] [--skew 0..1) [--seed N]
+ *                      [--time-limit S] [--compress on|off] [--output file.json]
+ */
+#include "core/Database.h"
+#include "util/Console.h"
+#include "util/StringUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using namespace soliddb;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    std::vector<size_t> rowCounts;
+    std::string schema = "id:INT:PK,email:TEXT:UNIQUE,name:TEXT,score:INT";
+    size_t lookups = 2000;
+    size_t scans = 3;
+    double skew = 0.99;
+    uint64_t seed = 42;
+    double timeLimit = 10.0;     // Per workload; lookups and scans stop early
+    bool compress = false;
+    std::string outputPath;      // Empty writes to stdout
+};
+
+/**
+ * Zipfian ranks in [0, n) after Gray et al.; rank 0 is the hottest key
+ */
+class ZipfianGenerator {
+public:
+    ZipfianGenerator(size_t n, double theta) : n_(n), theta_(theta) {
+        if (theta_ <= 0) {
+            return;
+        }
+        double zeta2 = 0;
+        for (size_t i = 1; i <= 2; i++) {
+            zeta2 += 1.0 / std::pow(static_cast<double>(i), theta_);
+        }
+        zetaN_ = 0;
+        for (size_t i = 1; i <= n_; i++) {
+            zetaN_ += 1.0 / std::pow(static_cast<double>(i), theta_);
+        }
+        alpha_ = 1.0 / (1.0 - theta_);
+        eta_ = (1.0 - std::pow(2.0 / n_, 1.0 - theta_)) / (1.0 - zeta2 / zetaN_);
+    }
+
+    template <typename Rng>
+    size_t next(Rng& rng) {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        if (theta_ <= 0) {
+            return std::min(n_ - 1, static_cast<size_t>(u * n_));
+        }
+        double uz = u * zetaN_;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < 1.0 + std::pow(0.5, theta_)) {
+            return std::min<size_t>(1, n_ - 1);
+        }
+        return std::min(n_ - 1, static_cast<size_t>(n_ * std::pow(eta_ * u - eta_ + 1.0, alpha_)));
+    }
+
+private:
+    size_t n_;
+    double theta_;
+    double zetaN_ = 0;
+    double alpha_ = 0;
+    double eta_ = 0;
+};
+
+/**
+ * Latency samples of one workload, in nanoseconds
+ */
+class LatencyRecorder {
+public:
+    void record(Clock::duration elapsed) {
+        samples_.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    size_t count() const {
+        return samples_.size();
+    }
+
+    void reserve(size_t count) {
+        samples_.reserve(count);
+    }
+
+    std::string percentilesJson() {
+        std::sort(samples_.begin(), samples_.end());
+        std::ostringstream json;
+        json << "{\"p50\": " << percentile(0.50) << ", \"p90\": " << percentile(0.90)
+             << ", \"p99\": " << percentile(0.99) << ", \"p999\": " << percentile(0.999)
+             << ", \"max\": " << (samples_.empty() ? 0 : samples_.back()) << "}";
+        return json.str();
+    }
+
+private:
+    std::vector<long long> samples_;
+
+    long long percentile(double p) const {
+        if (samples_.empty()) {
+            return 0;
+        }
+        size_t index = static_cast<size_t>(std::ceil(p * samples_.size()));
+        return samples_[std::min(samples_.size() - 1, index > 0 ? index - 1 : 0)];
+    }
+};
+
+struct WorkloadResult {
+    std::string name;
+    size_t operations = 0;
+    size_t rows = 0;             // Rows written or returned
+    double seconds = 0;
+    std::string latency;         // JSON object
+};
+
+long peakRssKilobytes() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * Current RSS (Linux; 0 elsewhere)
+ */
+long rssKilobytes() {
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0;
+    long resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0;
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+std::vector<core::ColumnDef> parseSchema(const std::string& spec) {
+    std::vector<core::ColumnDef> columns;
+    for (const auto& columnSpec : util::StringUtils::tokenize(spec, ',')) {
+        auto parts = util::StringUtils::tokenize(columnSpec, ':');
+        if (parts.size() < 2) {
+            throw std::invalid_argument("column spec must be name:TYPE[:PK|:UNIQUE|:NOTNULL]");
+        }
+        int constraints = 0;
+        for (size_t i = 2; i < parts.size(); i++) {
+            std::string flag = util::StringUtils::toUpper(parts[i]);
+            if (flag == "PK") {
+                constraints |= static_cast<int>(core::ColumnConstraint::PRIMARY_KEY);
+            } else if (flag == "UNIQUE") {
+                constraints |= static_cast<int>(core::ColumnConstraint::UNIQUE);
+            } else if (flag == "NOTNULL") {
+                constraints |= static_cast<int>(core::ColumnConstraint::NOT_NULL);
+            } else {
+                throw std::invalid_argument("unknown constraint " + parts[i]);
+            }
+        }
+        columns.emplace_back(parts[0], util::StringUtils::toUpper(parts[1]), constraints);
+    }
+    if (columns.empty()) {
+        throw std::invalid_argument("empty schema");
+    }
+    return columns;
+}
+
+/**
+ * Value of a key column for a row id; unique per id and per column
+ */
+std::string keyValue(const core::ColumnDef& column, size_t columnIndex, size_t id) {
+    if (column.type == "INT") {
+        return std::to_string(id * (columnIndex + 1));
+    }
+    return column.name + "-" + std::to_string(id);
+}
+
+std::vector<std::string> makeRow(const std::vector<core::ColumnDef>& columns, size_t id,
+                                 std::mt19937_64& rng) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz";
+    std::vector<std::string> row;
+    row.reserve(columns.size());
+    for (size_t i = 0; i < columns.size(); i++) {
+        if (columns[i].requiresUniqueValue()) {
+            row.push_back(keyValue(columns[i], i, id));
+        } else if (columns[i].type == "INT") {
+            row.push_back(std::to_string(rng() % 1000000));
+        } else {
+            std::string text(16, ' ');
+            for (auto& c : text) {
+                c = alphabet[rng() % 26];
+            }
+            row.push_back(std::move(text));
+        }
+    }
+    return row;
+}
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::string resultJson(WorkloadResult& result) {
+    std::ostringstream json;
+    json << "\"" << result.name << "\": {\"operations\": " << result.operations
+         << ", \"rows\": " << result.rows
+         << ", \"seconds\": " << result.seconds
+         << ", \"ops_per_sec\": " << (result.seconds > 0 ? result.operations / result.seconds : 0)
+         << ", \"rows_per_sec\": " << (result.seconds > 0 ? result.rows / result.seconds : 0)
+         << ", \"latency_ns\": " << result.latency << "}";
+    return json.str();
+}
+
+/**
+ * Run every workload for one table size
+ * @return JSON object for the size
+ */
+std::string runSize(const BenchConfig& config, const std::vector<core::ColumnDef>& columns,
+                    size_t rowCount) {
+    std::string dbPath = (fs::temp_directory_path() / "soliddb_bench").string();
+    fs::remove_all(dbPath);
+
+    std::mt19937_64 rng(config.seed);
+    std::vector<WorkloadResult> results;
+    long insertRssKilobytes = 0;
+    size_t tableBytes = 0;
+    size_t indexBytes = 0;
+    uintmax_t fileBytes = 0;
+
+    // Look rows up by the first key column (or the first column)
+    size_t keyColumn = 0;
+    for (size_t i = 0; i < columns.size(); i++) {
+        if (columns[i].requiresUniqueValue()) {
+            keyColumn = i;
+            break;
+        }
+    }
+
+    {
+        auto db = std::make_unique<core::Database>(dbPath);
+        db->setCompression(config.compress);
+        db->createTable("bench", columns);
+
+        // Rows are generated up front so only the insert is timed
+        std::vector<std::vector<std::string>> rows;
+        rows.reserve(rowCount);
+        for (size_t id = 0; id < rowCount; id++) {
+            rows.push_back(makeRow(columns, id, rng));
+        }
+
+        WorkloadResult insert;
+        insert.name = "insert";
+        LatencyRecorder insertLatency;
+        insertLatency.reserve(rowCount);
+        long rssBefore = rssKilobytes();
+        auto start = Clock::now();
+        for (const auto& row : rows) {
+            auto opStart = Clock::now();
+            if (db->insert("bench", row)) {
+                insert.rows++;
+            }
+            insertLatency.record(Clock::now() - opStart);
+        }
+        insert.seconds = secondsSince(start);
+        insert.operations = rowCount;
+        insertRssKilobytes = rssKilobytes() - rssBefore;
+        core::DatabaseMemoryUsage usage = db->getMemoryReport();
+        tableBytes = usage.total();
+        for (const auto& [_, table] : usage.tables) {
+            indexBytes += table.primaryKeyIndex + table.uniqueIndexes;
+        }
+        insert.latency = insertLatency.percentilesJson();
+        results.push_back(insert);
+
+        // Skewed keys; hot ranks are scattered over the table by a fixed permutation
+        ZipfianGenerator zipf(rowCount, config.skew);
+        std::vector<std::string> lookupKeys;
+        lookupKeys.reserve(config.lookups);
+        for (size_t i = 0; i < config.lookups; i++) {
+            size_t id = (zipf.next(rng) * 2654435761ULL) % rowCount;
+            lookupKeys.push_back(columns[keyColumn].name + "=" + rows[id][keyColumn]);
+        }
+        rows.clear();
+        rows.shrink_to_fit();
+
+        WorkloadResult lookup;
+        lookup.name = "lookup";
+        LatencyRecorder lookupLatency;
+        start = Clock::now();
+        for (const auto& condition : lookupKeys) {
+            auto opStart = Clock::now();
+            lookup.rows += db->select("bench", {}, condition).size();
+            lookupLatency.record(Clock::now() - opStart);
+            lookup.operations++;
+            if (secondsSince(start) > config.timeLimit) {
+                break;
+            }
+        }
+        lookup.seconds = secondsSince(start);
+        lookup.latency = lookupLatency.percentilesJson();
+        results.push_back(lookup);
+
+        WorkloadResult scan;
+        scan.name = "scan";
+        LatencyRecorder scanLatency;
+        start = Clock::now();
+        for (size_t i = 0; i < config.scans; i++) {
+            auto opStart = Clock::now();
+            scan.rows += db->select("bench", {}).size();
+            scanLatency.record(Clock::now() - opStart);
+            scan.operations++;
+            if (secondsSince(start) > config.timeLimit) {
+                break;
+            }
+        }
+        scan.seconds = secondsSince(start);
+        scan.latency = scanLatency.percentilesJson();
+        results.push_back(scan);
+
+        WorkloadResult checkpoint;
+        checkpoint.name = "checkpoint";
+        LatencyRecorder checkpointLatency;
+        start = Clock::now();
+        db->saveToFile();
+        checkpointLatency.record(Clock::now() - start);
+        checkpoint.seconds = secondsSince(start);
+        checkpoint.operations = 1;
+        checkpoint.rows = rowCount;
+        checkpoint.latency = checkpointLatency.percentilesJson();
+        results.push_back(checkpoint);
+        fileBytes = fs::file_size(dbPath + "/bench.tbl");
+    }
+
+    {
+        WorkloadResult load;
+        load.name = "load";
+        LatencyRecorder loadLatency;
+        auto start = Clock::now();
+        auto db = core::Database::loadFromFile(dbPath);
+        loadLatency.record(Clock::now() - start);
+        load.seconds = secondsSince(start);
+        load.operations = 1;
+        load.rows = db ? db->getTable("bench")->getRowCount() : 0;
+        load.latency = loadLatency.percentilesJson();
+        results.push_back(load);
+    }
+
+    fs::remove_all(dbPath);
+
+    std::ostringstream json;
+    json << "    {\"rows\": " << rowCount << ", \"peak_rss_kb\": " << peakRssKilobytes()
+         << ", \"insert_rss_kb\": " << insertRssKilobytes
+         << ", \"table_kb\": " << tableBytes / 1024 << ", \"index_kb\": " << indexBytes / 1024
+         << ", \"file_kb\": " << fileBytes / 1024
+         << ", \"workloads\": {\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        json << "      " << resultJson(results[i]) << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    json << "    }}";
+    return json.str();
+}
+
+bool parseArgs(int argc, char* argv[], BenchConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--rows") {
+            // Accepts 1e3-style counts
+            for (const auto& count : util::StringUtils::tokenize(value, ',')) {
+                config.rowCounts.push_back(static_cast<size_t>(std::stod(count)));
+            }
+        } else if (arg == "--schema") {
+            config.schema = value;
+        } else if (arg == "--lookups") {
+            config.lookups = std::stoul(value);
+        } else if (arg == "--scans") {
+            config.scans = std::stoul(value);
+        } else if (arg == "--skew") {
+            config.skew = std::stod(value);
+        } else if (arg == "--seed") {
+            config.seed = std::stoull(value);
+        } else if (arg == "--time-limit") {
+            config.timeLimit = std::stod(value);
+        } else if (arg == "--compress") {
+            std::string mode = util::StringUtils::toLower(value);
+            if (mode != "on" && mode != "off") {
+                return false;
+            }
+            config.compress = mode == "on";
+        } else if (arg == "--output") {
+            config.outputPath = value;
+        } else {
+            return false;
+        }
+    }
+    // Gray's method covers 0 < skew < 1
+    return config.skew >= 0 && config.skew < 1.0 &&
+           std::find(config.rowCounts.begin(), config.rowCounts.end(), 0) == config.rowCounts.end();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    std::vector<core::ColumnDef> columns;
+    try {
+        if (!parseArgs(argc, argv, config)) {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--rows 1e3,1e4,1e5,1e6] [--schema id:INT:PK,email:TEXT:UNIQUE,...]"
+                      << " [--lookups N] [--scans N] [--skew S] [--seed N] [--time-limit S]"
+                      << " [--compress on|off] [--output file.json]" << std::endl;
+            return 2;
+        }
+        columns = parseSchema(config.schema);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Invalid argument: " << e.what() << std::endl;
+        return 2;
+    }
+
+    if (config.rowCounts.empty()) {
+        config.rowCounts = {1000, 10000, 100000, 1000000};
+    }
+
+    util::Console::setQuiet(true);
+
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"soliddb_bench\",\n"
+         << "  \"config\": {\"schema\": \"" << config.schema << "\", \"lookups\": " << config.lookups
+         << ", \"scans\": " << config.scans << ", \"skew\": " << config.skew
+         << ", \"seed\": " << config.seed << ", \"time_limit\": " << config.timeLimit
+         << ", \"compress\": " << (config.compress ? "true" : "false") << "},\n"
+         << "  \"results\": [\n";
+
+    for (size_t i = 0; i < config.rowCounts.size(); i++) {
+        size_t rowCount = config.rowCounts[i];
+        std::cerr << "Running " << rowCount << " rows..." << std::endl;
+        json << runSize(config, columns, rowCount) << (i + 1 < config.rowCounts.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+
+    if (config.outputPath.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream output(config.outputPath);
+        if (!output) {
+            std::cerr << "Error: Cannot write " << config.outputPath << std::endl;
+            return 1;
+        }
+        output << json.str();
+    }
+    return 0;
+}
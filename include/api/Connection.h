@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "core/Database.h"
+#include "core/Table.h"
+#include "core/Transaction.h"
+
+namespace soliddb {
+namespace api {
+
+class Connection;
+class TableHandle;
+
+/**
+ * Reusable insert statement with values bound by column index.
+ *
+ * Values are bound directly into the row buffer, so a hot loop of
+ * bind/execute performs no parsing. NULL is stored as an empty value,
+ * matching the SQL front end. Like in SQL, values cannot contain commas
+ * or line breaks: rows with such values are rejected.
+ */
+class InsertStatement {
+public:
+    InsertStatement& bind(size_t column, int64_t value);
+    InsertStatement& bind(size_t column, int value) { return bind(column, static_cast<int64_t>(value)); }
+    InsertStatement& bind(size_t column, double value);
+    InsertStatement& bind(size_t column, std::string_view value);
+    InsertStatement& bindNull(size_t column);
+
+    /**
+     * Insert the bound row
+     * @return true on success; bindings are kept for the next execute
+     */
+    bool execute();
+
+    /**
+     * Queue the bound row for executeBatch()
+     */
+    void addBatch();
+
+    /**
+     * Insert every queued row under one lock acquisition and one commit
+     * (or into the open transaction of the connection)
+     * @return number of rows inserted
+     */
+    size_t executeBatch();
+
+    size_t getBatchSize() const;
+
+private:
+    friend class TableHandle;
+    InsertStatement(Connection& connection, std::string table, size_t columnCount);
+
+    Connection& connection_;
+    std::string table_;
+    std::vector<std::string> row_;
+    std::vector<std::vector<std::string>> batch_;
+};
+
+/**
+ * Forward-only cursor over a table snapshot, optionally filtered by an
+ * equality predicate on one column. Rows are read in place without copying.
+ */
+class Cursor {
+public:
+    /**
+     * Advance to the next matching row
+     * @return false when the cursor is exhausted
+     */
+    bool next();
+
+    size_t getColumnCount() const;
+    bool isNull(size_t column) const;
+    std::string_view getString(size_t column) const;
+
+    /**
+     * Read a column as an integer
+     * @return std::nullopt for NULL or non-numeric values
+     */
+    std::optional<int64_t> getInt(size_t column) const;
+    std::optional<double> getDouble(size_t column) const;
+
+    /**
+     * Copy of the current row
+     */
+    std::vector<std::string> getRow() const;
+
+private:
+    friend class TableHandle;
+    Cursor(core::TableCursor cursor, size_t columnCount, int filterColumn, std::string filterValue);
+    size_t checkColumn(size_t column) const;
+
+    core::TableCursor cursor_;
+    size_t columnCount_;
+    int filterColumn_;          // -1 when unfiltered
+    std::string filterValue_;
+};
+
+/**
+ * Typed access to one table of a connection
+ */
+class TableHandle {
+public:
+    std::string getName() const;
+    const std::vector<core::ColumnDef>& getColumns() const;
+
+    /**
+     * Get the index of a column for use with bind/get, or -1 if unknown
+     */
+    int getColumnIndex(const std::string& columnName) const;
+
+    InsertStatement prepareInsert();
+
+    /**
+     * Insert one row of already formatted values (no commas or line breaks)
+     */
+    bool insert(const std::vector<std::string>& values);
+
+    /**
+     * Insert many rows at once; rows with a comma or line break in a value
+     * are skipped
+     * @return number of rows inserted
+     */
+    size_t insertBatch(const std::vector<std::vector<std::string>>& rows);
+
+    /**
+     * Iterate over every row visible to the connection
+     */
+    Cursor scan() const;
+
+    /**
+     * Iterate over rows whose column equals a value
+     */
+    Cursor scanWhere(size_t column, std::string_view value) const;
+
+private:
+    friend class Connection;
+    TableHandle(Connection& connection, std::shared_ptr<core::Table> table);
+
+    Connection& connection_;
+    std::shared_ptr<core::Table> table_;
+};
+
+/**
+ * Embedded, parser-free entry point to SolidDB.
+ *
+ * A connection owns (or shares) one database. Writes made while a
+ * transaction is open go through it; otherwise each call commits on its
+ * own. A connection is meant to be used from one thread at a time, but
+ * several connections may share a database.
+ *
+ *     auto conn = api::Connection::open("mydb");
+ *     auto users = conn->table("users");
+ *     auto insert = users->prepareInsert();
+ *     insert.bind(0, int64_t{1}).bind(1, "alice").execute();
+ *     for (auto cursor = users->scan(); cursor.next();) {
+ *         std::cout << cursor.getString(1) << "\n";
+ *     }
+ */
+class Connection {
+public:
+    /**
+     * Open an existing database
+     * @return nullptr if it cannot be loaded
+     */
+    static std::unique_ptr<Connection> open(const std::string& name);
+
+    /**
+     * Create a new, empty database
+     */
+    static std::unique_ptr<Connection> create(const std::string& name);
+
+    /**
+     * Attach to a database that is already open
+     */
+    explicit Connection(std::shared_ptr<core::Database> database);
+    ~Connection();
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    bool createTable(const std::string& name, const std::vector<core::ColumnDef>& columns);
+    bool dropTable(const std::string& name);
+
+    /**
+     * Get a handle to a table
+     * @return std::nullopt if the table does not exist
+     */
+    std::optional<TableHandle> table(const std::string& name);
+
+    bool begin();
+    bool commit();
+    void rollback();
+    bool inTransaction() const;
+
+    bool checkpoint();
+
+    std::shared_ptr<core::Database> getDatabase() const;
+
+private:
+    friend class InsertStatement;
+    friend class TableHandle;
+
+    bool insertRow(const std::string& table, const std::vector<std::string>& values);
+    size_t insertRows(const std::string& table, const std::vector<std::vector<std::string>>& rows);
+    uint64_t ownMarker() const;
+
+    std::shared_ptr<core::Database> database_;
+    std::unique_ptr<core::Transaction> transaction_;
+};
+
+} // namespace api
+} // namespace soliddb
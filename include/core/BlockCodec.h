@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Column-wise compression of the row blocks of a table file
+ *
+ * A compressed table file stores its rows in blocks of up to BLOCK_ROWS
+ * rows. A block stores each column on its own, with the codec that suits it:
+ *
+ *   DELTA_PACK  integers as differences from the previous row, bit-packed
+ *   FRAME_PACK  integers as offsets from the block minimum, bit-packed
+ *   LZ          text values, newline-separated and LZ-compressed (util::Lz)
+ *   PLAIN       text values, newline-separated, when LZ does not pay off
+ *
+ * Integer columns use whichever of the two packings needs fewer bits; ids
+ * and timestamps pack to a few bits per row with deltas, dictionary codes
+ * with a frame. Blocks are independent of each other, so they are encoded
+ * and decoded in parallel.
+ */
+class BlockCodec {
+public:
+    static constexpr size_t BLOCK_ROWS = 16384;
+
+    enum class Codec : uint8_t {
+        PLAIN = 0,
+        LZ = 1,
+        DELTA_PACK = 2,
+        FRAME_PACK = 3
+    };
+
+    /**
+     * Values of one column of a block. Integer columns hold the values as
+     * integers; the text must then be exactly what the integers print as.
+     */
+    struct Column {
+        std::vector<std::string_view> text;
+        std::vector<int64_t> integers;
+        bool isInteger = false;
+    };
+
+    /**
+     * Encode the columns of a block, each holding rowCount values
+     */
+    static std::string encodeBlock(const std::vector<Column>& columns, size_t rowCount);
+
+    /**
+     * Decode a block written by encodeBlock into rows of text values
+     * @return false if the block is malformed
+     */
+    static bool decodeBlock(std::string_view block, size_t columnCount,
+                            std::vector<std::vector<std::string>>& rows);
+
+    /**
+     * Run task(0) .. task(count - 1) on up to one thread per core and wait
+     * for all of them
+     */
+    static void parallelFor(size_t count, const std::function<void(size_t)>& task);
+};
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "core/Pager.h"
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Fixed budget of page frames caching the pages of every paged table
+ *
+ * A page is read into a frame when it is pinned and stays there while any
+ * PageHandle pins it. Unpinned frames are reused in clock order: the hand
+ * sweeps the frames, giving each recently used one a second chance, and
+ * evicts the first that was not used since the last sweep, writing it back
+ * first if it is dirty. So a working set larger than the budget costs page
+ * reads rather than failing, and one that fits is served from memory.
+ *
+ * Frames are allocated on first use, up to the capacity. Hits, misses,
+ * evictions and write-backs are counted in util::Metrics (SHOW STATS).
+ * The pool is safe for concurrent use; page contents are not synchronized
+ * by it, so the tables that own the pages guard them with their own locks.
+ */
+class BufferPool {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024 * 1024;
+    static constexpr size_t MIN_FRAMES = 16;
+
+    /**
+     * A pinned page; unpinned when destroyed
+     */
+    class PageHandle {
+    public:
+        PageHandle() = default;
+        ~PageHandle();
+
+        PageHandle(PageHandle&& other) noexcept;
+        PageHandle& operator=(PageHandle&& other) noexcept;
+        PageHandle(const PageHandle&) = delete;
+        PageHandle& operator=(const PageHandle&) = delete;
+
+        explicit operator bool() const { return pool_ != nullptr; }
+
+        Pager::PageId id() const { return id_; }
+        const char* data() const { return data_; }
+
+        /**
+         * Page contents for writing; the page is written back before its
+         * frame is reused
+         */
+        char* mutableData() {
+            dirty_ = true;
+            return data_;
+        }
+
+        /**
+         * Unpin early
+         */
+        void release();
+
+    private:
+        friend class BufferPool;
+        PageHandle(BufferPool* pool, size_t frame, Pager::PageId id, char* data, bool dirty)
+            : pool_(pool), frame_(frame), id_(id), data_(data), dirty_(dirty) {}
+
+        BufferPool* pool_ = nullptr;
+        size_t frame_ = 0;
+        Pager::PageId id_ = 0;
+        char* data_ = nullptr;
+        bool dirty_ = false;
+    };
+
+    struct Usage {
+        size_t capacityPages = 0;
+        size_t residentPages = 0;
+        size_t dirtyPages = 0;
+        size_t pinnedPages = 0;
+    };
+
+    explicit BufferPool(size_t capacityBytes = DEFAULT_CAPACITY);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * The pool shared by every paged table of the process
+     */
+    static BufferPool& instance();
+
+    /**
+     * Change the budget (at least MIN_FRAMES pages). Shrinking evicts
+     * unpinned frames beyond the new budget.
+     */
+    void setCapacity(size_t bytes);
+    size_t getCapacity() const;
+
+    /**
+     * Pin a page, reading it unless it is resident
+     * @return an empty handle if every frame is pinned or the read failed
+     */
+    PageHandle pin(Pager& pager, Pager::PageId id);
+
+    /**
+     * Allocate a new, zeroed page of a file and pin it (dirty)
+     */
+    PageHandle pinNew(Pager& pager);
+
+    /**
+     * Write back every dirty page of a file (not synced; see Pager::sync)
+     */
+    bool flush(Pager& pager);
+
+    /**
+     * Forget every page of a file without writing it back. Call before the
+     * pager is destroyed; its pages must not be pinned.
+     */
+    void discard(Pager& pager);
+
+    Usage getUsage() const;
+
+private:
+    struct Frame {
+        Pager* pager = nullptr;       // nullptr while free
+        Pager::PageId id = 0;
+        unsigned pins = 0;
+        bool dirty = false;
+        bool referenced = false;      // Used since the clock hand last passed
+        std::unique_ptr<char[]> data{new char[Pager::PAGE_SIZE]};
+    };
+
+    struct PageKey {
+        const Pager* pager;
+        Pager::PageId id;
+
+        bool operator==(const PageKey& other) const { return pager == other.pager && id == other.id; }
+    };
+
+    struct PageKeyHash {
+        size_t operator()(const PageKey& key) const {
+            return std::hash<const void*>()(key.pager) ^ (size_t(key.id) * 0x9e3779b97f4a7c15ULL);
+        }
+    };
+
+    void unpin(size_t frame, bool dirty);
+
+    /**
+     * Free frame for a new page: a new one while under capacity, else the
+     * clock's victim (written back if dirty). Called with mutex_ held.
+     */
+    std::optional<size_t> claimFrame();
+
+    /**
+     * Write back a dirty frame and make it free. Called with mutex_ held.
+     */
+    bool evict(Frame& frame);
+
+    mutable std::mutex mutex_;        // Guards everything below; held during page I/O
+    std::vector<Frame> frames_;
+    size_t capacityPages_;
+    size_t hand_ = 0;
+    std::unordered_map<PageKey, size_t, PageKeyHash> pageTable_;
+};
+
+} // namespace core
+} // namespace soliddb
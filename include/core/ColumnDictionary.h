@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "core/RowStore.h"
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Distinct values of one column mapped to dense integer codes
+ *
+ * Codes are assigned in order of first appearance and never change. The
+ * single writer (holding the table's write lock) adds values; readers decode
+ * and search without any lock, since entries are published with a release
+ * store after they are written and never modified afterwards.
+ *
+ * Once a column has more distinct values than fit, the dictionary is frozen:
+ * it keeps decoding the versions already coded, but new versions of the
+ * column are stored as plain text.
+ */
+class ColumnDictionary {
+public:
+    static constexpr uint32_t MAX_SIZE = 256;
+
+    ColumnDictionary();
+
+    /**
+     * Code of a value, adding it if it is new (writer side)
+     * @return std::nullopt if the dictionary is frozen, or full (which freezes it)
+     */
+    std::optional<uint32_t> encode(const std::string& value);
+
+    /**
+     * Code of a value that is already in the dictionary (reader side)
+     */
+    std::optional<uint32_t> find(const std::string& value) const;
+
+    /**
+     * Value of a code that a published row version refers to
+     */
+    const std::string& decode(uint32_t code) const {
+        return entries_[code];
+    }
+
+    size_t size() const {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Stop coding new versions (see class comment)
+     */
+    void freeze();
+    bool isFrozen() const;
+
+    /**
+     * Estimated heap bytes of the entries and the writer's lookup table
+     */
+    size_t memoryBytes() const;
+
+private:
+    std::unique_ptr<std::string[]> entries_;
+    std::atomic<size_t> size_{0};
+    std::atomic<bool> frozen_{false};
+    std::atomic<size_t> memoryBytes_;
+    std::unordered_map<std::string, uint32_t> codes_;   // Writer only
+};
+
+/**
+ * Dictionary of every column of a table (nullptr for columns never coded)
+ */
+using ColumnDictionaries = std::vector<std::shared_ptr<ColumnDictionary>>;
+
+/**
+ * Text of one column of a stored row
+ */
+inline std::string_view decodeColumn(const EncodedRow& row, size_t column,
+                                     const ColumnDictionaries& dictionaries) {
+    size_t position = row.position(column);
+    if (row.isCoded(column)) {
+        return dictionaries[column]->decode(row.code(position));
+    }
+    return row.value(position);
+}
+
+} // namespace core
+} // namespace soliddb
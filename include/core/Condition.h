@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Comparison of a WHERE condition ("column<value", ...)
+ */
+enum class Comparison { EQUAL, LESS, LESS_EQUAL, GREATER, GREATER_EQUAL };
+
+/**
+ * Symbol of a comparison ("<=")
+ */
+const char* comparisonSymbol(Comparison comparison);
+
+/**
+ * Check a comparison against the sign of (left - right)
+ */
+inline bool holds(Comparison comparison, int order) {
+    switch (comparison) {
+        case Comparison::EQUAL: return order == 0;
+        case Comparison::LESS: return order < 0;
+        case Comparison::LESS_EQUAL: return order <= 0;
+        case Comparison::GREATER: return order > 0;
+        case Comparison::GREATER_EQUAL: return order >= 0;
+    }
+    return false;
+}
+
+/**
+ * Parse a whole value as a 64-bit integer
+ * @return false if it is not one
+ */
+bool parseInteger(std::string_view text, int64_t& value);
+
+/**
+ * WHERE condition split into column, comparison and value
+ */
+struct Condition {
+    std::string column;
+    Comparison comparison = Comparison::EQUAL;
+    std::string value;
+
+    /**
+     * Split "column=value" (or <, <=, >, >=) at its first comparison; a
+     * value in double quotes loses them
+     * @return false if the text has no comparison
+     */
+    static bool parse(const std::string& text, Condition& condition);
+};
+
+/**
+ * A condition planned against a table's columns, for the engines that test
+ * stored values one at a time (paged, LSM and mapped tables); compares the
+ * way Table does
+ */
+struct ColumnPredicate {
+    int column = -1;              // -1 matches every row
+    bool matchesNothing = false;  // Condition names an unknown column
+    Comparison comparison = Comparison::EQUAL;
+    std::string value;
+    bool isInteger = false;       // Range on an INT column, compared as integers
+    int64_t integer = 0;
+
+    /**
+     * @param column index of condition.column, -1 if the table has none
+     * @param integerColumn whether that column is an INT column
+     */
+    static ColumnPredicate plan(const Condition& condition, int column, bool integerColumn);
+
+    /**
+     * Whether an index on the column can answer it
+     */
+    bool isEquality() const { return column >= 0 && comparison == Comparison::EQUAL; }
+
+    /**
+     * Whether a row whose column holds text ("" is NULL) matches; NULLs
+     * only match "column=" and never a range
+     */
+    bool matches(std::string_view text) const;
+
+    /**
+     * "id > '7'"
+     */
+    std::string describe(const std::string& columnName) const;
+};
+
+} // namespace core
+} // namespace soliddb
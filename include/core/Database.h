@@ -1,16 +1,83 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
+#include <thread>
 #include <vector>
+#include "core/LsmTable.h"
+#include "core/MappedTable.h"
+#include "core/PagedTable.h"
+#include "core/PartitionedTable.h"
+#include "core/ResultCache.h"
 #include "core/Table.h"
+#include "core/Transaction.h"
+#include "core/VersionManager.h"
 
 namespace soliddb {
 namespace core {
 
+/**
+ * Estimated memory of a database: every table plus the in-memory operation log
+ */
+struct DatabaseMemoryUsage {
+    std::vector<std::pair<std::string, TableMemoryUsage>> tables;
+    size_t operationLog = 0;
+
+    size_t total() const {
+        size_t bytes = operationLog;
+        for (const auto& [_, table] : tables) {
+            bytes += table.total();
+        }
+        return bytes;
+    }
+};
+
+/**
+ * How a table stores its rows (CREATE TABLE ... ENGINE=<engine>)
+ */
+enum class StorageEngine {
+    MEMORY,   // Multi-versioned rows kept in memory (Table); the default
+    PAGED,    // Rows in a page file cached by the buffer pool (PagedTable)
+    LSM       // Log-structured merge tree of sorted runs (LsmTable)
+};
+
 /**
  * Represents a database containing multiple tables
+ *
+ * Safe for concurrent use: the table catalog is guarded by a shared mutex and
+ * every table carries its own writer lock. Table handles are shared
+ * pointers, so a table stays alive while a statement is still using it.
+ * All tables share one version manager; a background thread periodically
+ * reclaims row versions that no active snapshot can see and compacts tables
+ * that deletes and updates have left sparse.
+ *
+ * Explicit transactions are made durable by appending their redo records
+ * to wal.log with a single flush; checkpoints write every table at one
+ * snapshot and drop the redo records that snapshot covers. Loading a
+ * database replays the committed records left in wal.log.
+ *
+ * Paged tables (see PagedTable) keep their rows in a page file and only
+ * cache them, so they are not limited by memory; LSM tables (see LsmTable)
+ * append to a log and write sorted runs, for write-heavy tables. Both take
+ * part in checkpoints but not in transactions.
+ *
+ * Partitioned tables (see PartitionedTable) spread their rows over several
+ * in-memory tables. Statements are routed to the partitions they may
+ * touch; an UPDATE or DELETE touching several runs as one transaction, and
+ * checkpoints only rewrite the partitions changed since their last write.
+ *
+ * SELECTs outside transactions may be served from the process-wide
+ * ResultCache, keyed by the write version of the table they read.
+ *
+ * A database opened with openReadOnly() holds no Table objects: it serves
+ * SELECTs from memory-mapped table files (see MappedTable) written by
+ * exportReadOnly(), and rejects every write.
  */
 class Database {
 public:
@@ -18,36 +85,260 @@ public:
     ~Database();
 
     bool createTable(const std::string& name, const std::vector<std::pair<std::string, std::string>>& columns);
-    bool createTable(const std::string& name, const std::vector<ColumnDef>& columns);
+    bool createTable(const std::string& name, const std::vector<ColumnDef>& columns,
+                     StorageEngine engine = StorageEngine::MEMORY);
+    
+    /**
+     * Create a table partitioned by one column's value (MEMORY engine only)
+     */
+    bool createPartitionedTable(const std::string& name, const std::vector<ColumnDef>& columns,
+                                const PartitionScheme& scheme);
     
     bool dropTable(const std::string& name);
-    std::unique_ptr<Table>& getTable(const std::string& name);
+    
+    /**
+     * Drop a RANGE partition of a table and its file (see PartitionedTable::dropPartition)
+     */
+    bool dropPartition(const std::string& tableName, const std::string& partitionName);
+    
+    std::shared_ptr<Table> getTable(const std::string& name) const;
+    std::shared_ptr<PagedTable> getPagedTable(const std::string& name) const;
+    std::shared_ptr<LsmTable> getLsmTable(const std::string& name) const;
+    std::shared_ptr<PartitionedTable> getPartitionedTable(const std::string& name) const;
     bool tableExists(const std::string& name) const;
     std::vector<std::string> getTableNames() const;
     
     bool insert(const std::string& tableName, const std::vector<std::string>& values);
+    /**
+     * Insert several rows with one lock acquisition and one commit timestamp
+     * @return number of rows inserted (rows violating constraints are skipped)
+     */
+    size_t insertBatch(const std::string& tableName, const std::vector<std::vector<std::string>>& rows);
+    
+    /**
+     * Set columns of the rows matching a condition ("" matches every row)
+     * @param count receives the number of rows updated
+     * @return false if nothing could be changed (see Table::updateRows)
+     */
+    bool update(const std::string& tableName, const std::vector<std::pair<std::string, std::string>>& assignments,
+                const std::string& whereCondition, size_t& count);
+    
+    /**
+     * Delete the rows matching a condition ("" matches every row)
+     * @param count receives the number of rows deleted
+     */
+    bool deleteRows(const std::string& tableName, const std::string& whereCondition, size_t& count);
+    
     std::vector<std::vector<std::string>> select(
         const std::string& tableName, 
         const std::vector<std::string>& columns,
-        const std::string& whereCondition = "");
+        const std::string& whereCondition = "",
+        const Transaction* transaction = nullptr,
+        QueryPlan* analysis = nullptr);
+    
+    /**
+     * Plan a select without running it
+     * @return false if the table does not exist
+     */
+    bool explainSelect(const std::string& tableName, const std::vector<std::string>& columns,
+                       const std::string& whereCondition, QueryPlan& plan) const;
+    
+    /**
+     * Start an explicit transaction
+     */
+    std::unique_ptr<Transaction> beginTransaction();
+    
+    /**
+     * Insert a row as part of a transaction; invisible to others until commit
+     */
+    bool insert(const std::string& tableName, const std::vector<std::string>& values,
+                Transaction& transaction);
+    
+    /**
+     * Update or delete rows as part of a transaction. The rows stay locked
+     * against other writers until commit or rollback.
+     */
+    bool update(const std::string& tableName, const std::vector<std::pair<std::string, std::string>>& assignments,
+                const std::string& whereCondition, Transaction& transaction, size_t& count);
+    bool deleteRows(const std::string& tableName, const std::string& whereCondition,
+                    Transaction& transaction, size_t& count);
+    
+    /**
+     * Make a transaction durable (one redo log flush) and visible.
+     * If the redo log cannot be written the transaction is rolled back.
+     */
+    bool commitTransaction(Transaction& transaction);
+    
+    /**
+     * Undo every change of a transaction, newest first
+     */
+    void rollbackTransaction(Transaction& transaction);
     
     bool loadFromFile();
     bool saveToFile() const;
-    bool checkpoint() const;
+    bool checkpoint();
     
     static std::unique_ptr<Database> loadFromFile(const std::string& name);
     
+    /**
+     * Open a database read-only from the files of its last exportReadOnly().
+     * Tables are mapped, not loaded, so opening costs the same for any
+     * table size.
+     * @return nullptr if the database has no metadata file
+     */
+    static std::unique_ptr<Database> openReadOnly(const std::string& name);
+    
+    /**
+     * Write every table, as visible now, as a query-ready file
+     * (<table>.ro) for read-only opens; other processes that have the old
+     * files mapped keep reading them
+     */
+    bool exportReadOnly() const;
+    
+    bool isReadOnly() const;
+    std::shared_ptr<MappedTable> getMappedTable(const std::string& name) const;
+    
     void logOperation(const std::string& operation);
     std::string getName() const;
     std::string getDataDir() const;
     
+    std::shared_ptr<VersionManager> getVersionManager() const;
+    
+    /**
+     * Check whether anything changed since the last successful save
+     */
+    bool isDirty() const;
+    
+    /**
+     * Estimated bytes held by all tables and the operation log
+     */
+    size_t getMemoryUsage() const;
+    
+    /**
+     * Estimated memory per table and component, tables sorted by name
+     */
+    DatabaseMemoryUsage getMemoryReport() const;
+    
+    /**
+     * Limit the memory of this database (0 = unlimited). Once the estimate
+     * exceeds it, old versions are collected and, if that is not enough,
+     * writes are rejected until memory is freed or the budget is raised.
+     */
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const;
+    
+    /**
+     * Store table files as compressed column blocks (see BlockCodec) from
+     * the next checkpoint on. The setting is saved in the metadata file.
+     */
+    void setCompression(bool enabled);
+    bool isCompressionEnabled() const;
+    
+    /**
+     * Reclaim row versions no active snapshot can see, in every table
+     * @return number of versions reclaimed
+     */
+    size_t collectGarbage();
+    
+    /**
+     * Move live rows out of mostly dead chunks in every table (see
+     * Table::compact); runs after each garbage collection
+     * @return number of row versions moved
+     */
+    size_t compact();
+    
+    static constexpr std::chrono::milliseconds GC_INTERVAL{1000};
+    
 private:
     std::string name_;
     std::string dataDir_;
-    std::unordered_map<std::string, std::unique_ptr<Table>> tables_;
+    std::unordered_map<std::string, std::shared_ptr<Table>> tables_;
+    std::unordered_map<std::string, std::shared_ptr<PagedTable>> pagedTables_;
+    std::unordered_map<std::string, std::shared_ptr<LsmTable>> lsmTables_;
+    std::unordered_map<std::string, std::shared_ptr<PartitionedTable>> partitionedTables_;
+    mutable std::shared_mutex catalogMutex_;  // Guards the table maps
+    uint64_t catalogVersion_ = 1;             // Bumped on CREATE/DROP, guarded by catalogMutex_
+    bool compression_ = false;                // Guarded by catalogMutex_
+    
+    // Read-only databases: the mapped tables, fixed when opened
+    bool readOnly_ = false;
+    std::unordered_map<std::string, std::shared_ptr<MappedTable>> mappedTables_;
+    
+    // State covered by the last successful save; a new database starts dirty
+    mutable std::atomic<uint64_t> savedTimestamp_{VersionManager::BOOTSTRAP_TS};
+    mutable std::atomic<uint64_t> savedCatalogVersion_{0};
+    
     std::vector<std::string> wal_;
-    int operationsSinceCheckpoint_ = 0;
+    std::mutex walMutex_;                     // Guards wal_ and the log file
+    std::atomic<size_t> walBytes_{0};         // Estimated heap bytes of wal_
+    std::atomic<size_t> memoryBudget_{0};
+    std::atomic<int> operationsSinceCheckpoint_{0};
+    
+    mutable std::mutex saveMutex_;            // One save at a time writes the .tmp files
+    
+    std::shared_ptr<VersionManager> versionManager_;
+    std::atomic<uint64_t> nextTransactionId_{1};
+    mutable std::mutex redoMutex_;            // Guards wal.log; taken after the commit mutex
+    
+    std::thread gcThread_;
+    std::mutex gcMutex_;
+    std::condition_variable gcWake_;
+    bool gcStopping_ = false;
+    
+    bool admitWrite();
+    
+    /**
+     * Whether any table has this name; the caller holds catalogMutex_
+     */
+    bool isCatalogued(const std::string& tableName) const;
+    
+    /**
+     * Write version of a table whose selects may be cached (in-memory and
+     * partitioned tables; paged and LSM writes are not versioned)
+     * @return false if the table is not one of those
+     */
+    bool resultVersion(const std::string& tableName, ResultCache::Version& version) const;
+    
+    /**
+     * In-memory table a row of a table goes to: the table itself, or the
+     * partition taking the row's value (nullptr if there is none)
+     */
+    std::shared_ptr<Table> tableForRow(const std::string& tableName, const std::vector<std::string>& values) const;
+    
+    /**
+     * Every in-memory table, partitions included
+     */
+    std::vector<std::shared_ptr<Table>> allTables() const;
+    
+    /**
+     * UPDATE (with assignments) or DELETE the matching rows of every
+     * partition that may hold some, as part of a transaction. If one
+     * partition fails, the statement's changes to the others are undone.
+     */
+    bool changePartitions(const PartitionedTable& table,
+                          const std::vector<std::pair<std::string, std::string>>* assignments,
+                          const std::string& whereCondition, Transaction& transaction, size_t& count);
+    
+    /**
+     * Undo a transaction's changes after the first undoSize, newest first
+     */
+    void undoChanges(Transaction& transaction, size_t undoSize);
+    void addRedoRecords(Transaction& transaction, const std::string& tableName,
+                        const std::shared_ptr<Table>& table, const RowChanges& changes);
+    void garbageCollectorLoop();
+    void stopGarbageCollector();
+    
+    std::string redoLogPath() const;
+    bool appendToRedoLog(const std::string& records);
+    size_t redoLogSize() const;
+    void truncateRedoLog(size_t offset) const;
+    size_t recoverFromRedoLog();
     
+    /**
+     * Print an error if the table is paged or LSM (their rows are not versioned)
+     * @return true if it is
+     */
+    bool rejectUnversionedInTransaction(const std::string& tableName) const;
     bool loadMetadata();
     bool saveMetadata() const;
     
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "core/Database.h"
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Process-wide cache of open databases, shared by every session that uses them.
+ *
+ * Databases stay open after their last user switches away, so USE of a
+ * recently used database is a lookup instead of a reload from disk. When
+ * the estimated memory of the open databases exceeds the budget, the least
+ * recently used ones that nobody holds are closed; closing checkpoints a
+ * database only if it changed since its last save. Opening a database that
+ * is still being closed waits until its files are written.
+ */
+class DatabaseRegistry {
+public:
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+
+    explicit DatabaseRegistry(size_t memoryBudget = DEFAULT_MEMORY_BUDGET);
+    ~DatabaseRegistry();
+
+    /**
+     * Get an open database, loading it from disk on first use
+     * @return nullptr if the database cannot be loaded
+     */
+    std::shared_ptr<Database> open(const std::string& name);
+
+    /**
+     * Create a new database, or return it if it is already open
+     */
+    std::shared_ptr<Database> create(const std::string& name);
+
+    /**
+     * Get a database only if it is already open
+     */
+    std::shared_ptr<Database> find(const std::string& name) const;
+
+    /**
+     * Names of all open databases, most recently used first
+     */
+    std::vector<std::string> getOpenDatabases() const;
+
+    /**
+     * Change the memory budget and evict down to it
+     */
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const;
+
+    /**
+     * Memory budget applied to every database opened from now on, and to
+     * those already open (0 = unlimited); see Database::setMemoryBudget
+     */
+    void setDatabaseMemoryBudget(size_t bytes);
+    size_t getDatabaseMemoryBudget() const;
+    
+    /**
+     * Open databases read-only from now on (see Database::openReadOnly);
+     * creating databases is then refused
+     */
+    void setReadOnly(bool readOnly);
+    bool isReadOnly() const;
+
+    /**
+     * Close unused databases, least recently used first, until the open
+     * databases fit in the budget
+     * @return number of databases closed
+     */
+    size_t evict();
+
+    /**
+     * Close every database (each is checkpointed once its last user lets go)
+     */
+    void closeAll();
+
+private:
+    struct Entry {
+        std::shared_ptr<Database> database;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    /**
+     * A database taken out of the cache, destroyed outside the lock
+     */
+    struct Closing {
+        std::string name;
+        std::shared_ptr<Database> database;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> databases_;
+    std::unordered_set<std::string> closing_;  // Names whose database is being destroyed
+    std::condition_variable closed_;           // Signalled when a name leaves closing_
+    std::list<std::string> lru_;               // Front is the most recently used
+    size_t memoryBudget_;
+    size_t databaseMemoryBudget_ = 0;
+    bool readOnly_ = false;
+
+    std::unique_ptr<Database> loadLocked(const std::string& name) const;
+    std::shared_ptr<Database> insertLocked(const std::string& name, std::shared_ptr<Database> database);
+    void touchLocked(Entry& entry);
+    std::vector<Closing> collectEvictionsLocked();
+
+    /**
+     * Wait until no database of this name is being closed
+     */
+    void waitUntilClosedLocked(std::unique_lock<std::mutex>& lock, const std::string& name);
+
+    /**
+     * Destroy (and so checkpoint) databases taken out of the cache, then
+     * let waiting opens of their names go ahead
+     */
+    void finishClosing(std::vector<Closing>& closing);
+};
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string_view>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Flat hash index from keys to row slots, for PRIMARY KEY and UNIQUE
+ * constraints (a Swiss table)
+ *
+ * Entries hold only the row's slot, plus one control byte with 7 bits of
+ * the key's hash (its tag) in a separate array; the key itself is read
+ * from the row. Control bytes are probed a group of 16 at a time, with one
+ * SSE2 compare matching the tag against the whole group, so only entries
+ * whose tag matches (1 in 128 of the others) cost a key comparison through
+ * the equals callback of find(). An index takes 9 bytes per entry at up to
+ * 7/8 load.
+ *
+ * Growing re-places every entry, which needs its hash again: insert() takes
+ * a callback returning the hash of an indexed slot's key. Erased entries
+ * leave a tombstone unless their group still has a free entry; tombstones
+ * are dropped by the next rehash. Not thread-safe; Table guards it with its
+ * write lock.
+ */
+class KeyIndex {
+public:
+    static constexpr size_t NOT_FOUND = std::numeric_limits<size_t>::max();
+
+    static uint64_t hash(std::string_view key) {
+        return std::hash<std::string_view>{}(key);
+    }
+
+    /**
+     * Find the entry of a key
+     * @param equals called with the slot of each entry whose tag matches;
+     *        returns whether that row holds the key
+     * @return position of the entry, or NOT_FOUND
+     */
+    template <typename Equals>
+    size_t find(uint64_t hash, Equals&& equals) const {
+        if (slots_.empty()) {
+            return NOT_FOUND;
+        }
+        size_t groupMask = slots_.size() / GROUP_SIZE - 1;
+        size_t group = (hash >> 7) & groupMask;
+        // Triangular probing visits every group once (the count is a power of two)
+        for (size_t step = 1;; step++) {
+            const int8_t* control = &control_[group * GROUP_SIZE];
+            for (uint32_t matches = matchTag(control, tagOf(hash)); matches != 0; matches &= matches - 1) {
+                size_t position = group * GROUP_SIZE + static_cast<size_t>(__builtin_ctz(matches));
+                if (equals(slots_[position])) {
+                    return position;
+                }
+            }
+            if (matchTag(control, EMPTY) != 0) {
+                return NOT_FOUND;
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    size_t slotAt(size_t position) const { return slots_[position]; }
+    void setSlot(size_t position, size_t slot) { slots_[position] = slot; }
+
+    /**
+     * Add an entry for a key that is not indexed yet
+     * @param hashOf returns the hash of the key of an indexed slot; called
+     *        for every entry when the index grows
+     */
+    template <typename HashOf>
+    void insert(uint64_t hash, size_t slot, HashOf&& hashOf) {
+        if (growthLeft_ == 0) {
+            // Rows are read in slot order, mostly sequential in memory
+            std::vector<size_t> indexed = usedSlots();
+            allocate(size_ * 2);
+            for (size_t indexedSlot : indexed) {
+                place(hashOf(indexedSlot), indexedSlot);
+            }
+        }
+        place(hash, slot);
+    }
+
+    /**
+     * Remove the entry of a row under a key's hash
+     * @return false if there is none
+     */
+    bool erase(uint64_t hash, size_t slot);
+
+    size_t size() const { return size_; }
+    size_t memoryBytes() const { return control_.capacity() + slots_.capacity() * sizeof(size_t); }
+
+private:
+    static constexpr size_t GROUP_SIZE = 16;
+    // Control byte of a free entry and of an erased one; used entries hold their 7-bit tag
+    static constexpr int8_t EMPTY = -128;
+    static constexpr int8_t DELETED = -2;
+
+    static int8_t tagOf(uint64_t hash) { return static_cast<int8_t>(hash & 0x7f); }
+
+    /**
+     * Bit i is set if control byte i of the group equals value
+     */
+    static uint32_t matchTag(const int8_t* group, int8_t value) {
+#ifdef __SSE2__
+        __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value))));
+#else
+        uint32_t matches = 0;
+        for (size_t i = 0; i < GROUP_SIZE; i++) {
+            matches |= static_cast<uint32_t>(group[i] == value) << i;
+        }
+        return matches;
+#endif
+    }
+
+    /**
+     * Bit i is set if entry i of the group is free or erased
+     */
+    static uint32_t matchUnused(const int8_t* group) {
+#ifdef __SSE2__
+        // Both have the sign bit set, tags never do
+        __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(control));
+#else
+        uint32_t matches = 0;
+        for (size_t i = 0; i < GROUP_SIZE; i++) {
+            matches |= static_cast<uint32_t>(group[i] < 0) << i;
+        }
+        return matches;
+#endif
+    }
+
+    /**
+     * Replace the arrays with empty ones with room for entries keys at
+     * 7/8 load (rehashing a full index doubles it)
+     */
+    void allocate(size_t entries);
+
+    /**
+     * Slots of every entry, sorted
+     */
+    std::vector<size_t> usedSlots() const;
+
+    /**
+     * Put an entry in the first free or erased position of its probe sequence
+     */
+    void place(uint64_t hash, size_t slot);
+
+    std::vector<int8_t> control_;
+    std::vector<size_t> slots_;
+    size_t size_ = 0;
+    size_t growthLeft_ = 0;   // Free entries that may still be used before a rehash
+};
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "core/Condition.h"
+#include "core/QueryPlan.h"
+#include "core/SortedRun.h"
+#include "core/Table.h"
+#include "util/SharedMutex.h"
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Write and compaction statistics of an LsmTable
+ */
+struct LsmStats {
+    uint64_t bytesIn = 0;          // Keys and rows written by statements
+    uint64_t logBytes = 0;         // Written to the table's log
+    uint64_t flushBytes = 0;       // Written as level 0 runs
+    uint64_t compactionBytes = 0;  // Written by compactions
+    uint64_t flushes = 0;
+    uint64_t compactions = 0;
+    uint64_t memtableBytes = 0;
+    std::vector<size_t> runsPerLevel;
+    std::vector<uint64_t> bytesPerLevel;
+
+    /**
+     * Bytes written to disk per byte written by statements
+     */
+    double writeAmplification() const {
+        return bytesIn == 0 ? 0.0 : double(logBytes + flushBytes + compactionBytes) / double(bytesIn);
+    }
+};
+
+/**
+ * Log-structured merge table for write-heavy tables (CREATE TABLE ...
+ * ENGINE=LSM), kept in the directory <table>.lsm
+ *
+ * Writes go to an append-only log and a sorted in-memory memtable, so an
+ * INSERT costs one sequential write however large the table is. A full
+ * memtable is frozen and written out by the table's background thread as
+ * an immutable SortedRun in level 0; once a level holds RUNS_PER_LEVEL
+ * runs they are merged into one run of the next level (tiered compaction),
+ * keeping the newest entry of every key and dropping deleted rows once no
+ * older level is left. Checkpoints only sync the log.
+ *
+ * Rows are keyed by the PRIMARY KEY, or by insertion order if the table
+ * has none. A lookup on the key checks the memtables and then the runs
+ * from newest to oldest, where each run's Bloom filter and fence pointers
+ * limit it to at most one block read; other conditions merge-scan all of
+ * them. UNIQUE is only supported on the key. Like PagedTable, rows are not
+ * versioned, so LSM tables cannot be changed in a transaction.
+ *
+ * Files: MANIFEST (schema, live runs and the oldest live log), <id>.run
+ * and <id>.log; see docs/Storage.md.
+ */
+class LsmTable {
+public:
+    static constexpr size_t MEMTABLE_BYTES = 4 * 1024 * 1024;
+    static constexpr size_t RUNS_PER_LEVEL = 4;
+
+    ~LsmTable();
+
+    LsmTable(const LsmTable&) = delete;
+    LsmTable& operator=(const LsmTable&) = delete;
+
+    /**
+     * Create an empty table in a new directory
+     */
+    static std::unique_ptr<LsmTable> create(const std::string& name, const std::vector<ColumnDef>& columns,
+                                            const std::string& directory);
+
+    /**
+     * Open a table and replay its logs into the memtable
+     * @return nullptr if the directory has no valid manifest
+     */
+    static std::unique_ptr<LsmTable> open(const std::string& directory);
+
+    bool insertRow(const std::vector<std::string>& values);
+
+    /**
+     * Set columns of the rows matching a condition ("" matches every row)
+     * @return false on an unknown column or a constraint violation; nothing
+     *         is changed then
+     */
+    bool updateRows(const std::vector<std::pair<std::string, std::string>>& assignments,
+                    const std::string& whereCondition, size_t& count);
+
+    bool deleteRows(const std::string& whereCondition, size_t& count);
+
+    /**
+     * Select rows (all columns if columns is empty) matching a
+     * "column=value" condition, in key order; see Table::selectRows
+     */
+    std::vector<std::vector<std::string>> selectRows(const std::vector<std::string>& columns,
+                                                     const std::string& whereCondition = "",
+                                                     QueryPlan* analysis = nullptr) const;
+
+    QueryPlan explainSelect(const std::vector<std::string>& columns, const std::string& whereCondition = "") const;
+
+    /**
+     * Sync the log, making every write so far durable
+     */
+    bool flush();
+
+    /**
+     * Check whether anything was written since the last flush()
+     */
+    bool isModified() const;
+
+    const std::string& getName() const;
+    const std::vector<ColumnDef>& getColumns() const;
+    size_t getRowCount() const;
+    LsmStats getStats() const;
+
+    /**
+     * Estimated memory: memtables as values, fence pointers and Bloom
+     * filters as the primary key index
+     */
+    TableMemoryUsage getMemoryUsage() const;
+
+    int getColumnIndex(const std::string& columnName) const;
+
+private:
+    struct MemEntry {
+        bool tombstone = false;
+        std::string value;
+    };
+    using Memtable = std::map<std::string, MemEntry, std::less<>>;
+
+    // INSERT adds a row, UPDATE replaces one, DELETE writes a tombstone
+    enum class LogOp : char { INSERT = 'I', UPDATE = 'U', DELETE = 'D' };
+
+    struct Change {
+        LogOp op;
+        std::string key;
+        std::string row;              // Empty for DELETE
+    };
+
+    using Predicate = ColumnPredicate;
+
+    LsmTable(const std::string& name, const std::vector<ColumnDef>& columns, const std::string& directory);
+
+    std::string runPath(uint64_t id) const;
+    std::string logPath(uint64_t id) const;
+
+    /**
+     * Key of a primary key value, ordered numerically for INT keys (rows of
+     * tables without a primary key are keyed by insertion sequence number)
+     */
+    std::string encodeKey(const std::string& value) const;
+
+    static std::string encodeRow(const std::vector<std::string>& values);
+    std::vector<std::string> decodeRow(std::string_view row) const;
+
+    /**
+     * Newest entry of a key in the memtables and runs
+     * @return false if the key is absent or deleted
+     */
+    bool get(std::string_view key, std::string& row) const;
+
+    /**
+     * Call fn(key, row) for every live row in key order
+     */
+    void scan(const std::function<void(std::string_view, std::string_view)>& fn) const;
+
+    /**
+     * Rows matching a predicate, with their keys, via the key when possible
+     */
+    void findRows(const Predicate& predicate, std::vector<std::string>& keys,
+                  std::vector<std::vector<std::string>>& rows) const;
+
+    bool validateRow(const std::vector<std::string>& values) const;
+
+    /**
+     * Log and apply one statement's changes; called with mutex_ held
+     */
+    bool write(const std::vector<Change>& changes);
+
+    /**
+     * Apply a change to the memtable and the row count
+     */
+    void apply(const Change& change);
+
+    /**
+     * Freeze a full memtable and hand it to the background thread, waiting
+     * if the previous one is still being written. Called with mutex_ held.
+     */
+    void rotateMemtable(std::unique_lock<util::SharedMutex>& lock);
+
+    /**
+     * Start appending to a new log (closing the current one). The memtable
+     * keeps the changes of the earlier logs, so they stay in memtableLogs_
+     * until a rotation hands them to the frozen memtable.
+     */
+    bool openLog(uint64_t id);
+    bool appendLog(const std::string& records);
+    bool replayLog(uint64_t id);
+    bool writeManifest() const;
+    bool loadManifest();
+
+    void backgroundLoop();
+    void flushImmutable();
+
+    /**
+     * Merge every run of a level into one run of the next
+     */
+    void compactLevel(size_t level);
+    int levelDueForCompaction() const;
+
+    Predicate planCondition(const std::string& condition) const;
+    void planSelect(const std::vector<std::string>& columns, const std::string& whereCondition,
+                    std::vector<int>& columnIndices, Predicate& predicate) const;
+    QueryPlan describeSelect(const std::vector<int>& columnIndices, const Predicate& predicate,
+                             bool hasCondition) const;
+    size_t runCount() const;
+
+    std::string name_;
+    std::vector<ColumnDef> columns_;
+    std::string directory_;
+    int keyColumn_ = -1;                       // PRIMARY KEY column, -1 for insertion order
+
+    // Guarded by mutex_ (exclusive for writers and for installing runs)
+    Memtable memtable_;
+    size_t memtableBytes_ = 0;
+    std::vector<uint64_t> memtableLogs_;       // Logs holding the memtable's changes; the last is appended to
+    std::shared_ptr<const Memtable> immutable_; // Frozen, being written to level 0
+    size_t immutableBytes_ = 0;
+    std::vector<uint64_t> immutableLogs_;
+    std::vector<std::vector<std::shared_ptr<SortedRun>>> levels_;  // Oldest run first in each level
+    uint64_t nextFileId_ = 1;                  // Ids of run and log files
+    uint64_t nextSequence_ = 0;
+    size_t rowCount_ = 0;
+    int logFd_ = -1;
+    // State of the frozen memtable, recorded in the manifest once it is written
+    uint64_t frozenSequence_ = 0;
+    size_t frozenRowCount_ = 0;
+    uint64_t manifestSequence_ = 0;
+    size_t manifestRowCount_ = 0;
+    LsmStats stats_;
+
+    std::atomic<uint64_t> version_{0};         // Bumped by every write
+    std::atomic<uint64_t> flushedVersion_{0};
+
+    mutable util::SharedMutex mutex_;
+
+    std::condition_variable_any immutableWritten_;  // Signalled with mutex_ when immutable_ is cleared
+    bool backgroundFailed_ = false;            // A run could not be written; stop freezing memtables
+
+    std::thread worker_;
+    std::mutex workerMutex_;                   // Taken after mutex_, never before
+    std::condition_variable workerWake_;
+    bool workPending_ = false;
+    bool workerStopping_ = false;
+};
+
+} // namespace core
+} // namespace soliddb
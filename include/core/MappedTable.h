@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/Condition.h"
+#include "core/QueryPlan.h"
+#include "core/Table.h"
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Immutable table served straight from a memory-mapped file
+ *
+ * The file (<table>.ro, written by write()) is query-ready: every column is
+ * a segment of value end offsets followed by the value bytes, and every
+ * PRIMARY KEY and UNIQUE column has a persisted index of row ids sorted by
+ * value. Opening maps the file and checks its header, so it costs the same
+ * for any table size. Pages are read on first touch and stay in the page
+ * cache, which every process mapping the same file shares. Values are
+ * string_views into the mapping; nothing is copied until a result is built.
+ *
+ * Replacing the file (write() renames a new one into place) does not affect
+ * tables already mapped: they keep reading the old file until closed.
+ */
+class MappedTable {
+public:
+    ~MappedTable();
+
+    MappedTable(const MappedTable&) = delete;
+    MappedTable& operator=(const MappedTable&) = delete;
+
+    /**
+     * Map a table file
+     * @return nullptr if the file is missing or not a valid table file
+     */
+    static std::unique_ptr<MappedTable> open(const std::string& path);
+
+    /**
+     * Write the rows of a table visible now as a table file, replacing the
+     * file at path atomically
+     */
+    static bool write(const Table& table, const std::string& path);
+
+    const std::string& getName() const;
+    const std::vector<ColumnDef>& getColumns() const;
+    size_t getRowCount() const;
+
+    /**
+     * Size of the mapping (resident only as far as pages were touched)
+     */
+    size_t getMappedBytes() const;
+
+    /**
+     * Value of one column of a row, read in place
+     */
+    std::string_view value(size_t row, size_t column) const;
+
+    /**
+     * Select rows (all columns if columns is empty) matching a
+     * "column=value" condition. Indexed columns are looked up by binary
+     * search, others are scanned.
+     */
+    std::vector<std::vector<std::string>> selectRows(const std::vector<std::string>& columns,
+                                                     const std::string& whereCondition,
+                                                     QueryPlan* analysis = nullptr) const;
+
+    QueryPlan explainSelect(const std::vector<std::string>& columns, const std::string& whereCondition) const;
+
+private:
+    static constexpr char MAGIC[8] = {'S', 'D', 'B', 'R', 'O', '0', '1', '\0'};
+
+    // On-disk layout, in host byte order; every section is 8-byte aligned
+    struct FileHeader {
+        char magic[8];
+        uint64_t rowCount;
+        uint64_t columnCount;
+        uint64_t schemaOffset;      // Text: "<name>\n" then "<column>,<type>,<constraints>\n" each
+        uint64_t schemaSize;
+        uint64_t columnsOffset;     // ColumnSegment[columnCount]
+    };
+
+    struct ColumnSegment {
+        uint64_t offsetsOffset;     // uint64_t[rowCount + 1]; row i is bytes [offsets[i], offsets[i + 1])
+        uint64_t bytesOffset;
+        uint64_t indexOffset;       // uint64_t[indexCount] row ids sorted by value, 0 if none
+        uint64_t indexCount;        // Rows with a value (NULLs are not indexed)
+    };
+
+    using Predicate = ColumnPredicate;
+
+    MappedTable() = default;
+
+    void planSelect(const std::vector<std::string>& columns, const std::string& whereCondition,
+                    std::vector<int>& columnIndices, Predicate& predicate) const;
+    QueryPlan describeSelect(const std::vector<int>& columnIndices, const Predicate& predicate,
+                             bool hasCondition) const;
+
+    /**
+     * Rows whose indexed column equals value (at most one; keys are unique)
+     */
+    std::vector<size_t> lookup(size_t column, const std::string& value) const;
+
+    int getColumnIndex(const std::string& columnName) const;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::string name_;
+    std::vector<ColumnDef> columns_;
+    size_t rowCount_ = 0;
+    std::vector<const uint64_t*> offsets_;
+    std::vector<const char*> bytes_;
+    std::vector<const uint64_t*> indexes_;     // nullptr for columns without an index
+    std::vector<size_t> indexCounts_;
+};
+
+} // namespace core
+} // namespace soliddb
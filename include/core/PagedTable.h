@@ -0,0 +1,211 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "core/BufferPool.h"
+#include "core/Condition.h"
+#include "core/Pager.h"
+#include "core/QueryPlan.h"
+#include "core/Table.h"
+#include "util/SharedMutex.h"
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Table whose rows live in a page file (<table>.pages) and are only cached
+ * in memory, so it can be far larger than RAM
+ *
+ * Page 0 holds the schema; every other page is a slotted page: a header,
+ * an array of slots growing forwards and records growing backwards from
+ * the end. A row is addressed by its page id and slot (a RowId) and is
+ * reached by pinning its page in the BufferPool, so only the pages a query
+ * touches are resident, up to the pool's budget. Rows are stored as
+ * length-prefixed values and must fit in one page.
+ *
+ * The PRIMARY KEY and UNIQUE indexes (key -> RowId) stay in memory and are
+ * rebuilt by a scan when the table is opened. Rows are not versioned:
+ * readers share the table lock, writers take it exclusively, and a row's
+ * latest values are what every statement sees. Changed pages reach the file
+ * when they are evicted or at a checkpoint (flush()).
+ */
+class PagedTable {
+public:
+    using RowId = uint64_t;
+
+    ~PagedTable();
+
+    PagedTable(const PagedTable&) = delete;
+    PagedTable& operator=(const PagedTable&) = delete;
+
+    /**
+     * Create an empty table file, replacing any file at path
+     */
+    static std::unique_ptr<PagedTable> create(const std::string& name, const std::vector<ColumnDef>& columns,
+                                              const std::string& path, BufferPool& pool = BufferPool::instance());
+
+    /**
+     * Open a table file and rebuild its indexes
+     * @return nullptr if the file is missing or not a table file
+     */
+    static std::unique_ptr<PagedTable> open(const std::string& path, BufferPool& pool = BufferPool::instance());
+
+    bool insertRow(const std::vector<std::string>& values);
+
+    /**
+     * Set columns of the rows matching a condition ("" matches every row)
+     * @return false on an unknown column or a constraint violation; nothing
+     *         is changed then
+     */
+    bool updateRows(const std::vector<std::pair<std::string, std::string>>& assignments,
+                    const std::string& whereCondition, size_t& count);
+
+    bool deleteRows(const std::string& whereCondition, size_t& count);
+
+    /**
+     * Select rows (all columns if columns is empty) matching a
+     * "column=value" condition; see Table::selectRows
+     */
+    std::vector<std::vector<std::string>> selectRows(const std::vector<std::string>& columns,
+                                                     const std::string& whereCondition = "",
+                                                     QueryPlan* analysis = nullptr) const;
+
+    QueryPlan explainSelect(const std::vector<std::string>& columns, const std::string& whereCondition = "") const;
+
+    /**
+     * Write every changed page to the file and sync it
+     */
+    bool flush();
+
+    /**
+     * Check whether anything changed since the last flush()
+     */
+    bool isModified() const;
+
+    const std::string& getName() const;
+    const std::vector<ColumnDef>& getColumns() const;
+    size_t getRowCount() const;
+    size_t getPageCount() const;
+
+    /**
+     * Estimated memory of the indexes (pages are accounted to the buffer pool)
+     */
+    TableMemoryUsage getMemoryUsage() const;
+
+    int getColumnIndex(const std::string& columnName) const;
+
+private:
+    static constexpr char MAGIC[8] = {'S', 'D', 'B', 'P', 'G', '0', '1', '\0'};
+
+    // Slotted page layout, in host byte order
+    struct PageHeader {
+        uint16_t slotCount;
+        uint16_t dataStart;           // Records occupy [dataStart, PAGE_SIZE)
+    };
+
+    struct Slot {
+        uint16_t offset;
+        uint16_t length;              // 0 for a free slot
+    };
+
+    static constexpr size_t MAX_RECORD_SIZE = Pager::PAGE_SIZE - sizeof(PageHeader) - sizeof(Slot);
+
+    // Index entries of rows an UPDATE is about to write
+    static constexpr RowId PENDING_ROW = ~RowId{0};
+
+    using Predicate = ColumnPredicate;
+
+    PagedTable(const std::string& name, const std::vector<ColumnDef>& columns,
+               std::unique_ptr<Pager> pager, BufferPool& pool);
+
+    static RowId makeRowId(Pager::PageId page, size_t slot) { return (RowId(page) << 16) | slot; }
+    static Pager::PageId pageOf(RowId row) { return static_cast<Pager::PageId>(row >> 16); }
+    static size_t slotOf(RowId row) { return static_cast<size_t>(row & 0xffff); }
+
+    static std::string encodeRecord(const std::vector<std::string>& values);
+    static std::string_view recordValue(std::string_view record, size_t column);
+    std::vector<std::string> decodeRecord(std::string_view record) const;
+    static std::string_view recordAt(const char* page, size_t slot);
+
+    bool loadRows();
+    bool validateRow(const std::vector<std::string>& values) const;
+    bool checkConstraints(const std::vector<std::string>& values) const;
+    void indexRow(const std::vector<std::string>& values, RowId row);
+    void unindexRow(const std::vector<std::string>& values);
+
+    /**
+     * Store a record, preferring the given page (0 for none)
+     */
+    bool placeRecord(const std::string& record, Pager::PageId preferredPage, RowId& row);
+    bool placeOnPage(Pager::PageId page, const std::string& record, RowId& row);
+    bool removeRecord(RowId row);
+
+    /**
+     * Space a page could give a new record after compacting it
+     */
+    static size_t reclaimableBytes(const char* page);
+    static void compactPage(char* page);
+    void noteFreeSpace(Pager::PageId page, const char* data);
+
+    /**
+     * Call fn(row, record) for every row, pinning one page at a time
+     * @return false if a page could not be pinned
+     */
+    bool scan(const std::function<void(RowId, std::string_view)>& fn) const;
+
+    /**
+     * Copy the record of a row
+     */
+    bool readRecord(RowId row, std::string& record) const;
+
+    /**
+     * Row matching an indexed predicate, if any
+     */
+    bool lookup(const Predicate& predicate, RowId& row) const;
+
+    /**
+     * Rows matching a predicate and their values, via an index when possible
+     */
+    bool findRows(const Predicate& predicate, std::vector<RowId>& rows,
+                  std::vector<std::vector<std::string>>& values) const;
+
+    Predicate planCondition(const std::string& condition) const;
+    void planSelect(const std::vector<std::string>& columns, const std::string& whereCondition,
+                    std::vector<int>& columnIndices, Predicate& predicate) const;
+    QueryPlan describeSelect(const std::vector<int>& columnIndices, const Predicate& predicate,
+                             bool hasCondition) const;
+
+    std::string name_;
+    std::vector<ColumnDef> columns_;
+    std::unique_ptr<Pager> pager_;
+    BufferPool& pool_;
+
+    std::vector<uint16_t> freeBytes_;          // Reclaimable bytes per page
+    std::vector<Pager::PageId> reusablePages_; // Pages deletes left at least a quarter free
+    std::vector<bool> isReusable_;
+    Pager::PageId lastPage_ = 0;               // Page new rows go to; 0 until the first insert
+    size_t rowCount_ = 0;
+
+    // Key -> row of the PRIMARY KEY and of every UNIQUE column (NULLs in
+    // UNIQUE columns are not indexed), by column
+    struct KeyIndex {
+        std::unordered_map<std::string, RowId> rows;
+        size_t keyBytes = 0;                   // Heap bytes of the keys
+    };
+    std::unordered_map<size_t, KeyIndex> indexes_;
+
+    std::atomic<uint64_t> version_{0};         // Bumped by every write
+    std::atomic<uint64_t> flushedVersion_{0};
+
+    mutable util::SharedMutex mutex_;
+};
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace soliddb {
+namespace core {
+
+/**
+ * A file of fixed-size pages, read and written by page id
+ *
+ * The pager does no caching of its own; pages are cached, pinned and
+ * written back by the BufferPool. Pages past the end of the file read as
+ * zeros, so a page allocated but not yet written back is simply empty.
+ */
+class Pager {
+public:
+    using PageId = uint32_t;
+
+    static constexpr size_t PAGE_SIZE = 8192;
+
+    ~Pager();
+
+    Pager(const Pager&) = delete;
+    Pager& operator=(const Pager&) = delete;
+
+    /**
+     * Open a page file, creating it if it does not exist
+     * @return nullptr if the file cannot be opened or is not a whole number of pages
+     */
+    static std::unique_ptr<Pager> open(const std::string& path);
+
+    /**
+     * Read a page into a PAGE_SIZE buffer
+     */
+    bool readPage(PageId id, char* data) const;
+
+    /**
+     * Write a PAGE_SIZE buffer to a page
+     */
+    bool writePage(PageId id, const char* data);
+
+    /**
+     * Reserve the next page id; the file grows when the page is written
+     */
+    PageId allocatePage();
+
+    /**
+     * Number of pages, including allocated ones not written yet
+     */
+    size_t getPageCount() const;
+
+    /**
+     * Flush written pages to stable storage
+     */
+    bool sync();
+
+    const std::string& getPath() const;
+
+private:
+    Pager(int fd, const std::string& path, size_t pageCount);
+
+    int fd_;
+    std::string path_;
+    std::atomic<size_t> pageCount_;
+};
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "core/Condition.h"
+#include "core/QueryPlan.h"
+#include "core/Table.h"
+#include "core/VersionManager.h"
+
+namespace soliddb {
+namespace core {
+
+/**
+ * How the rows of a partitioned table are spread over its partitions
+ * (CREATE TABLE ... PARTITION BY HASH(<column>) <count> or
+ * PARTITION BY RANGE(<column>) (<bound>, ...))
+ */
+struct PartitionScheme {
+    enum class Kind { HASH, RANGE };
+
+    Kind kind = Kind::HASH;
+    std::string column;
+    size_t count = 0;                 // HASH: number of partitions
+    std::vector<std::string> bounds;  // RANGE: ascending; n bounds make n + 1 partitions
+
+    size_t partitionCount() const { return kind == Kind::HASH ? count : bounds.size() + 1; }
+
+    /**
+     * "HASH(id) 4" or "RANGE(id) (100, 200)"
+     */
+    std::string describe() const;
+};
+
+/**
+ * One partition: a table of its own, stored in <table>.<partition>.tbl
+ */
+struct Partition {
+    std::string name;                 // p0, p1, ... in scheme order
+    std::shared_ptr<Table> table;     // Named <table>.<partition>
+    // RANGE: the partition holds lower <= value < upper
+    bool hasLower = false;
+    bool hasUpper = false;
+    std::string lower;
+    std::string upper;
+    // Commit timestamp the partition's file was last written at
+    bool saved = false;
+    uint64_t savedTs = 0;
+
+    /**
+     * "id < 100", "100 <= id < 200", "hash(id) % 4 = 1"
+     */
+    std::string describeBounds(const PartitionScheme& scheme) const;
+};
+
+/**
+ * A table whose rows are spread over several partitions by the value of
+ * one column (CREATE TABLE ... PARTITION BY ...)
+ *
+ * Every partition is an ordinary in-memory Table with its own indexes,
+ * zone maps and table file, so a checkpoint only rewrites the partitions
+ * that changed since they were last written and dropping a RANGE partition
+ * only drops its table and file. HASH partitions take the rows whose value
+ * hashes (util::BloomFilter::hash, stable across restarts) to them; RANGE
+ * partitions the rows between their bounds, compared as integers on INT
+ * columns (whose values must then be integers) and as text otherwise.
+ *
+ * A condition on the partition column prunes the partitions that cannot
+ * hold a match: equality picks one HASH partition, and a comparison keeps
+ * the RANGE partitions whose bounds overlap it. The remaining partitions
+ * are scanned at one snapshot, in parallel once the table is large enough.
+ * PRIMARY KEY and UNIQUE are checked per partition, so they are only
+ * allowed on the partition column, which UPDATE may not change.
+ */
+class PartitionedTable {
+public:
+    /** Versions a table needs before its partitions are scanned in parallel */
+    static constexpr size_t PARALLEL_SCAN_VERSIONS = 64 * 1024;
+
+    /**
+     * Create a table with empty partitions
+     * @return nullptr (with an error printed) if the scheme does not fit the columns
+     */
+    static std::unique_ptr<PartitionedTable> create(const std::string& name, const std::vector<ColumnDef>& columns,
+                                                    const PartitionScheme& scheme,
+                                                    std::shared_ptr<VersionManager> versionManager);
+
+    /**
+     * Reassemble a table from its loaded partitions, by partition name.
+     * Partitions in dropped are left out; others missing start empty.
+     * @return nullptr if no partition was loaded
+     */
+    static std::unique_ptr<PartitionedTable> restore(
+        const std::string& name, const PartitionScheme& scheme,
+        const std::vector<std::pair<std::string, std::shared_ptr<Table>>>& loaded,
+        const std::vector<std::string>& dropped, std::shared_ptr<VersionManager> versionManager);
+
+    std::string getName() const;
+    const std::vector<ColumnDef>& getColumns() const;
+    const PartitionScheme& getScheme() const;
+
+    /**
+     * Partitions not dropped yet, in scheme order
+     */
+    std::vector<Partition> getPartitions() const;
+
+    /**
+     * Names of the partitions dropped so far
+     */
+    std::vector<std::string> getDroppedPartitions() const;
+
+    /**
+     * Partition a row belongs to
+     * @return nullptr (with an error printed) if no partition takes its value
+     */
+    std::shared_ptr<Table> partitionFor(const std::vector<std::string>& values) const;
+
+    /**
+     * Partitions that may hold rows matching a condition ("" keeps all)
+     */
+    std::vector<Partition> partitionsFor(const std::string& whereCondition) const;
+
+    /**
+     * Print an error if an UPDATE would move rows between partitions
+     * @return true if it would
+     */
+    bool rejectsAssignments(const std::vector<std::pair<std::string, std::string>>& assignments) const;
+
+    /**
+     * Select from the partitions that may match, all at one snapshot; see Table::selectRows
+     */
+    std::vector<std::vector<std::string>> selectRows(const std::vector<std::string>& columns,
+                                                     const std::string& whereCondition = "",
+                                                     uint64_t ownMarker = 0,
+                                                     QueryPlan* analysis = nullptr) const;
+
+    QueryPlan explainSelect(const std::vector<std::string>& columns, const std::string& whereCondition = "") const;
+
+    /**
+     * Drop a RANGE partition with its rows; values in its range are
+     * rejected from then on. The last partition cannot be dropped.
+     * @return the dropped partition's table, or nullptr (with an error printed)
+     */
+    std::shared_ptr<Table> dropPartition(const std::string& partitionName);
+
+    /**
+     * Record that a partition's file holds its rows as of a commit timestamp
+     */
+    void markSaved(const std::string& partitionName, uint64_t timestamp);
+
+    size_t getRowCount() const;
+
+    /**
+     * Latest commit to any partition (see Table::getLastCommitTimestamp)
+     */
+    uint64_t getLastCommitTimestamp() const;
+
+private:
+    PartitionedTable(const std::string& name, const std::vector<ColumnDef>& columns, const PartitionScheme& scheme,
+                     std::shared_ptr<VersionManager> versionManager);
+
+    /**
+     * Empty partitions named and bounded as the scheme says
+     */
+    std::vector<Partition> layout() const;
+
+    /**
+     * Order of two values of the partition column (-1, 0 or 1)
+     */
+    int compareValues(std::string_view left, std::string_view right) const;
+
+    /**
+     * Whether a select scans these partitions on several threads: there
+     * are several, with PARALLEL_SCAN_VERSIONS between them, and cores to spare
+     */
+    bool scansInParallel(const std::vector<Partition>& partitions) const;
+
+    /**
+     * Whether a RANGE partition may hold a value satisfying a comparison
+     */
+    bool mayHold(const Partition& partition, Comparison comparison, std::string_view value) const;
+
+    std::string name_;
+    std::vector<ColumnDef> columns_;
+    PartitionScheme scheme_;
+    std::shared_ptr<VersionManager> versionManager_;
+    size_t column_ = 0;               // Index of the partition column
+    bool integerColumn_ = false;      // RANGE bounds compare as integers
+
+    std::vector<Partition> partitions_;
+    std::vector<std::string> dropped_;
+    mutable std::shared_mutex mutex_; // Guards partitions_ and dropped_
+};
+
+} // namespace core
+} // namespace soliddb
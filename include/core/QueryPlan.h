@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace soliddb {
+namespace core {
+
+/**
+ * One step of a query plan. The runtime fields are filled in only when the
+ * query is executed under EXPLAIN ANALYZE.
+ */
+struct PlanOperator {
+    std::string name;        // e.g. "SeqScan", "Filter", "Project"
+    std::string detail;      // Access path, predicate or column list
+
+    uint64_t nanoseconds = 0;
+    size_t rowsIn = 0;
+    size_t rowsOut = 0;
+    size_t bytesAllocated = 0;
+};
+
+/**
+ * Operators of a query, from the root (last to run) down to the access path
+ */
+struct QueryPlan {
+    std::vector<PlanOperator> operators;
+    bool analyzed = false;
+
+    /**
+     * Add an operator below the current ones
+     * @return the new operator
+     */
+    PlanOperator& add(const std::string& name, const std::string& detail);
+
+    /**
+     * Find an operator by name, or nullptr
+     */
+    PlanOperator* find(const std::string& name);
+
+    /**
+     * Indented tree, one operator per line, with runtime figures if analyzed
+     */
+    std::string format() const;
+};
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Byte budget of SELECT results shared by every database of the process,
+ * for statements that are run again and again while their table rarely
+ * changes
+ *
+ * An entry is keyed by its database and the normalized statement (table,
+ * columns and condition) and remembers the write version of the table it
+ * read. A lookup only hits while the table still has that version, so any
+ * commit to the table, or a CREATE or DROP, makes its entries stale without
+ * the writers having to know about the cache; stale entries are dropped
+ * when they are looked up or evicted. Entries are evicted least recently
+ * used first once the budget is exceeded.
+ *
+ * A capacity of 0 (the default) disables the cache. Hits, misses and
+ * evictions are counted in util::Metrics (SHOW STATS). Safe for concurrent
+ * use; rows are shared with the callers, never changed once stored.
+ */
+class ResultCache {
+public:
+    using Rows = std::vector<std::vector<std::string>>;
+
+    /**
+     * Write version of a table: the catalog version of its database and
+     * the timestamp of the table's latest commit
+     */
+    struct Version {
+        uint64_t catalog = 0;
+        uint64_t commit = 0;
+
+        bool operator==(const Version& other) const {
+            return catalog == other.catalog && commit == other.commit;
+        }
+    };
+
+    struct Usage {
+        size_t capacityBytes = 0;
+        size_t bytes = 0;
+        size_t entries = 0;
+    };
+
+    ResultCache() = default;
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    /**
+     * The cache shared by every database of the process
+     */
+    static ResultCache& instance();
+
+    /**
+     * Change the budget (0 disables the cache); shrinking evicts entries
+     */
+    void setCapacity(size_t bytes);
+    size_t getCapacity() const;
+    bool isEnabled() const;
+
+    /**
+     * Key of a select: its table, columns ("" for all) and condition,
+     * trimmed
+     */
+    static std::string makeKey(const std::string& tableName, const std::vector<std::string>& columns,
+                               const std::string& whereCondition);
+
+    /**
+     * Rows cached for a key of a database, if they were read at this version
+     * @return nullptr on a miss (a stale entry is dropped)
+     */
+    std::shared_ptr<const Rows> lookup(const void* database, const std::string& key, const Version& version);
+
+    /**
+     * Cache the rows a key read at a version; rows larger than the whole
+     * budget are not cached
+     */
+    void store(const void* database, const std::string& key, const Version& version, Rows rows);
+
+    /**
+     * Drop every entry of a database (when it is closed)
+     */
+    void forget(const void* database);
+
+    Usage getUsage() const;
+
+private:
+    struct Entry {
+        const void* database;
+        std::string key;              // Database address, then the select's key
+        Version version;
+        std::shared_ptr<const Rows> rows;
+        size_t bytes;
+    };
+
+    static std::string entryKey(const void* database, const std::string& key);
+
+    /**
+     * Remove an entry. Called with mutex_ held.
+     */
+    void erase(std::list<Entry>::iterator entry);
+
+    /**
+     * Evict least recently used entries down to the budget. Called with mutex_ held.
+     */
+    void evictToCapacity();
+
+    mutable std::mutex mutex_;        // Guards everything below
+    size_t capacityBytes_ = 0;
+    size_t bytes_ = 0;
+    std::list<Entry> entries_;        // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+} // namespace core
+} // namespace soliddb
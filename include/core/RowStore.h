@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/VersionManager.h"
+#include "util/Arena.h"
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Heap bytes owned by a string (nothing while it fits the inline buffer)
+ */
+inline size_t stringHeapBytes(const std::string& value) {
+    static const size_t inlineCapacity = std::string().capacity();
+    return value.capacity() > inlineCapacity ? value.capacity() + 1 : 0;
+}
+
+/**
+ * Values of a row about to be stored: text of the plain columns and codes of
+ * the columns coded by their ColumnDictionary, both in column order. The
+ * text views only need to stay valid until RowStore::append returns.
+ */
+struct RowImage {
+    std::vector<std::string_view> values;
+    std::vector<uint32_t> codes;
+    uint64_t codedColumns = 0;
+
+    void clear() {
+        values.clear();
+        codes.clear();
+        codedColumns = 0;
+    }
+};
+
+/**
+ * Stored values of a row, packed into its chunk's arena as the codes, the
+ * end offset of each text value, then the text bytes. Columns whose bit is
+ * set in codedColumns are kept as codes, the others as text; both in column
+ * order. Only the first 64 columns can be coded.
+ */
+struct EncodedRow {
+    static constexpr size_t MAX_CODED_COLUMNS = 64;
+
+    const uint32_t* data = nullptr;
+    uint64_t codedColumns = 0;
+    uint32_t codeCount = 0;
+    uint32_t valueCount = 0;
+
+    bool isCoded(size_t column) const {
+        return column < MAX_CODED_COLUMNS && ((codedColumns >> column) & 1) != 0;
+    }
+
+    /**
+     * Position of a column among the codes (if coded) or values (if not)
+     */
+    size_t position(size_t column) const {
+        size_t codedBefore = column < MAX_CODED_COLUMNS
+            ? __builtin_popcountll(codedColumns & ((uint64_t{1} << column) - 1))
+            : __builtin_popcountll(codedColumns);
+        return isCoded(column) ? codedBefore : column - codedBefore;
+    }
+
+    size_t columnCount() const {
+        return codeCount + valueCount;
+    }
+
+    uint32_t code(size_t position) const {
+        return data[position];
+    }
+
+    std::string_view value(size_t position) const {
+        const uint32_t* ends = data + codeCount;
+        const char* text = reinterpret_cast<const char*>(ends + valueCount);
+        uint32_t begin = position == 0 ? 0 : ends[position - 1];
+        return std::string_view(text + begin, ends[position] - begin);
+    }
+};
+
+/**
+ * One version of a row, stamped with the commit timestamps that created
+ * and superseded it
+ */
+struct RowVersion {
+    std::atomic<uint64_t> begin{VersionManager::INFINITE_TS};
+    std::atomic<uint64_t> end{VersionManager::INFINITE_TS};
+    EncodedRow row;
+    bool reclaimed = false;  // Dead for every snapshot; values await chunk release
+
+    /**
+     * Check visibility at a snapshot. Versions the reader's own transaction
+     * wrote (begin stamped with ownMarker) are visible as well, and those it
+     * deleted (end stamped with ownMarker) are not.
+     */
+    bool isVisible(uint64_t snapshot, uint64_t ownMarker = 0) const {
+        uint64_t beginTs = begin.load(std::memory_order_acquire);
+        uint64_t endTs = end.load(std::memory_order_acquire);
+        return (beginTs <= snapshot || beginTs == ownMarker) &&
+               endTs > snapshot && endTs != ownMarker;
+    }
+};
+
+/**
+ * Append-only storage for row versions, split into fixed-size chunks
+ *
+ * A single writer (holding the table's write lock) appends versions and
+ * publishes them with a release store; readers take a View and scan it
+ * without any lock. The values of a chunk's versions are packed into the
+ * chunk's own arena, so a row costs no allocation of its own and a chunk's
+ * values are freed together: when every version in it is reclaimed the chunk
+ * is released, and readers still holding a View keep it alive.
+ *
+ * Ending a version (delete, update) stamps its end timestamp and sets its
+ * bit in the chunk's tombstone bitmap, so the garbage collector only visits
+ * ended versions. Chunks left mostly reclaimed are compacted by the table:
+ * it copies their live versions to the end of the store and ends the
+ * originals, after which the whole chunk can be released.
+ */
+class RowStore {
+public:
+    static constexpr size_t CHUNK_SIZE = 1024;
+
+    /** Reclaimed versions that make a full chunk worth compacting */
+    static constexpr size_t COMPACT_THRESHOLD = CHUNK_SIZE / 2;
+
+    struct Chunk {
+        std::unique_ptr<RowVersion[]> versions{new RowVersion[CHUNK_SIZE]};
+        util::Arena values;
+        std::array<std::atomic<uint64_t>, CHUNK_SIZE / 64> tombstones{};  // Ended, not reclaimed yet
+        size_t reclaimedCount = 0;
+    };
+
+    /**
+     * Consistent, lock-free view of the versions published so far
+     */
+    class View {
+    public:
+        size_t size() const { return count_; }
+
+        /**
+         * Call fn(slot, version) for every version visible at the snapshot,
+         * or only for those in slots [firstSlot, lastSlot)
+         */
+        template <typename Fn>
+        void forEachVisible(uint64_t snapshot, Fn&& fn, uint64_t ownMarker = 0, size_t firstSlot = 0,
+                            size_t lastSlot = SIZE_MAX) const {
+            lastSlot = std::min(lastSlot, count_);
+            for (size_t c = firstSlot / CHUNK_SIZE; c < chunks_.size() && c * CHUNK_SIZE < lastSlot; c++) {
+                const Chunk* chunk = chunks_[c].get();
+                if (!chunk) {
+                    continue;
+                }
+                size_t first = std::max(c * CHUNK_SIZE, firstSlot);
+                size_t last = std::min(lastSlot, c * CHUNK_SIZE + CHUNK_SIZE);
+                for (size_t slot = first; slot < last; slot++) {
+                    const RowVersion& version = chunk->versions[slot - c * CHUNK_SIZE];
+                    if (version.isVisible(snapshot, ownMarker)) {
+                        fn(slot, version);
+                    }
+                }
+            }
+        }
+
+        /**
+         * Version in a slot, or nullptr if its chunk was released
+         */
+        const RowVersion* get(size_t slot) const {
+            const Chunk* chunk = chunks_[slot / CHUNK_SIZE].get();
+            return chunk ? &chunk->versions[slot % CHUNK_SIZE] : nullptr;
+        }
+
+    private:
+        friend class RowStore;
+        std::vector<std::shared_ptr<Chunk>> chunks_;
+        size_t count_ = 0;
+    };
+
+    /**
+     * Copy a row into the store and publish it. Writers must be serialized.
+     * @return slot id of the new version
+     */
+    size_t append(const RowImage& row, uint64_t beginTs);
+
+    /**
+     * Append a copy of a version's values as a new version (compaction).
+     * Writers must be serialized.
+     * @return slot id of the copy
+     */
+    size_t appendCopy(size_t slot, uint64_t beginTs);
+
+    /**
+     * Stamp the end of a version with a commit timestamp and mark it for the
+     * garbage collector. Callers must own the version (table write lock, or
+     * a transaction committing its own delete).
+     */
+    void retire(size_t slot, uint64_t endTs);
+
+    /**
+     * Access a version by slot id (writer side; the slot must not be released)
+     */
+    RowVersion& at(size_t slot);
+    const RowVersion& at(size_t slot) const;
+
+    /**
+     * Take a view of all published versions
+     */
+    View view() const;
+
+    /**
+     * Number of slots ever appended
+     */
+    size_t size() const;
+
+    /**
+     * Reclaim versions that ended at or before the horizon and release
+     * chunks (with their values) whose versions are all reclaimed. Writers
+     * must be serialized with this call.
+     * @return number of versions reclaimed
+     */
+    size_t collectGarbage(uint64_t horizon);
+
+    /**
+     * Full chunks with at least COMPACT_THRESHOLD reclaimed versions that
+     * are not released yet. Writers must be serialized with this call.
+     */
+    std::vector<size_t> sparseChunks() const;
+
+    /**
+     * Number of live chunks
+     */
+    size_t chunkCount() const;
+
+    /**
+     * Bytes of the version slots in live chunks
+     */
+    size_t slotBytes() const;
+
+    /**
+     * Bytes of the value arenas of live chunks
+     */
+    size_t valueBytes() const;
+
+private:
+    mutable std::mutex directoryMutex_;       // Guards chunks_ (not their contents)
+    std::vector<std::shared_ptr<Chunk>> chunks_;
+    std::atomic<size_t> published_{0};
+    std::atomic<size_t> valueBytes_{0};
+};
+
+} // namespace core
+} // namespace soliddb
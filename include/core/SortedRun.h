@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "util/BloomFilter.h"
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Immutable file of key-sorted entries, one level of an LsmTable
+ *
+ * Entries (a key and either a value or a tombstone) are packed into blocks
+ * of about BLOCK_SIZE bytes. The first key of every block (a fence pointer)
+ * and a Bloom filter over all keys are kept in memory, so a point lookup
+ * reads at most one block: none if the filter rules the key out, and none
+ * if the key sorts outside the run.
+ *
+ * Layout, in host byte order:
+ *
+ *   blocks   per entry: varint key size, key, byte tombstone,
+ *            varint value size, value
+ *   index    varint block count, then per block: varint key size,
+ *            first key, varint offset, varint size
+ *   filter   util::BloomFilter::serialize()
+ *   footer   uint64 index offset, uint64 filter offset,
+ *            uint64 entry count, "SDBRUN01"
+ */
+class SortedRun {
+public:
+    static constexpr size_t BLOCK_SIZE = 4096;
+
+    /**
+     * Writes a run from entries added in ascending key order
+     */
+    class Writer {
+    public:
+        /**
+         * @param expectedEntries sizes the Bloom filter (an upper bound is fine)
+         */
+        Writer(const std::string& path, size_t expectedEntries);
+        ~Writer();
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        bool add(std::string_view key, bool tombstone, std::string_view value);
+
+        /**
+         * Write the index, filter and footer, sync the file and open it
+         * @return nullptr if anything could not be written
+         */
+        std::shared_ptr<SortedRun> finish(uint64_t id);
+
+        size_t getEntryCount() const { return entryCount_; }
+
+    private:
+        /**
+         * Queue bytes for the file, writing once a megabyte is queued
+         */
+        bool append(const std::string& data);
+        bool writeBuffer();
+        bool endBlock();
+
+        std::string path_;
+        int fd_ = -1;
+        bool failed_ = false;
+        uint64_t offset_ = 0;
+        uint64_t entryCount_ = 0;
+        std::string buffer_;
+        std::string block_;
+        std::string blockFirstKey_;
+        std::string index_;
+        uint64_t blockCount_ = 0;
+        util::BloomFilter filter_;
+    };
+
+    /**
+     * Forward cursor over the entries of a run, reading a block at a time
+     */
+    class Iterator {
+    public:
+        explicit Iterator(const SortedRun& run);
+
+        bool valid() const { return valid_; }
+        std::string_view key() const { return std::string_view(block_).substr(keyOffset_, keySize_); }
+        bool tombstone() const { return tombstone_; }
+        std::string_view value() const { return std::string_view(block_).substr(valueOffset_, valueSize_); }
+        void next();
+
+    private:
+        bool loadBlock();
+        bool decodeCurrent();
+
+        const SortedRun* run_;
+        size_t blockIndex_ = 0;
+        std::string block_;
+        size_t pos_ = 0;
+        bool valid_ = false;
+        // The current entry, as positions in block_ so the iterator can move
+        size_t keyOffset_ = 0;
+        size_t keySize_ = 0;
+        bool tombstone_ = false;
+        size_t valueOffset_ = 0;
+        size_t valueSize_ = 0;
+    };
+
+    enum class Lookup { ABSENT, FOUND, DELETED };
+
+    ~SortedRun();
+
+    SortedRun(const SortedRun&) = delete;
+    SortedRun& operator=(const SortedRun&) = delete;
+
+    /**
+     * Open a run file, reading its index and filter
+     * @return nullptr if the file is missing or not a complete run
+     */
+    static std::shared_ptr<SortedRun> open(const std::string& path, uint64_t id);
+
+    /**
+     * Find a key; value receives its value if FOUND
+     */
+    Lookup get(std::string_view key, std::string& value) const;
+
+    Iterator begin() const { return Iterator(*this); }
+
+    uint64_t getId() const { return id_; }
+    const std::string& getPath() const { return path_; }
+    uint64_t getEntryCount() const { return entryCount_; }
+    uint64_t getFileBytes() const { return fileBytes_; }
+
+    /**
+     * Bytes of the fence pointers and the filter
+     */
+    size_t getMemoryUsage() const;
+
+private:
+    struct Fence {
+        std::string firstKey;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    SortedRun(int fd, const std::string& path, uint64_t id) : fd_(fd), path_(path), id_(id) {}
+
+    bool readBlock(size_t index, std::string& block) const;
+
+    /**
+     * Decode the entry at pos and advance past it
+     * @return false at the end of the block or on a malformed entry
+     */
+    static bool decodeEntry(std::string_view block, size_t& pos, std::string_view& key, bool& tombstone,
+                            std::string_view& value);
+
+    int fd_;
+    std::string path_;
+    uint64_t id_;
+    uint64_t entryCount_ = 0;
+    uint64_t fileBytes_ = 0;
+    std::vector<Fence> fences_;
+    util::BloomFilter filter_;
+};
+
+} // namespace core
+} // namespace soliddb
@@ -1,10 +1,19 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <functional>
 #include <memory>
-#include <unordered_map>
-#include <unordered_set>
+#include <shared_mutex>
+#include <limits>
+#include "core/ColumnDictionary.h"
+#include "core/KeyIndex.h"
+#include "core/QueryPlan.h"
+#include "core/RowStore.h"
+#include "core/VersionManager.h"
+#include "core/ZoneMap.h"
+#include "util/SharedMutex.h"
 
 namespace soliddb {
 namespace core {
@@ -36,20 +45,107 @@ struct ColumnDef {
     bool requiresUniqueValue() const { return isPrimaryKey() || isUnique(); }
 };
 
+/**
+ * Estimated memory held by one table, by component
+ */
+struct TableMemoryUsage {
+    size_t versionSlots = 0;     // Allocated row version slots
+    size_t values = 0;           // Row values, including versions not collected yet
+    size_t primaryKeyIndex = 0;
+    size_t uniqueIndexes = 0;
+    size_t dictionaries = 0;
+
+    size_t total() const { return versionSlots + values + primaryKeyIndex + uniqueIndexes + dictionaries; }
+};
+
+/**
+ * Versions written by one UPDATE or DELETE
+ */
+struct RowChanges {
+    std::vector<size_t> ended;    // Versions of the changed rows, now deleted
+    std::vector<size_t> added;    // Their new versions (UPDATE only), same order
+    // Values of both, kept for the redo log of transactions only
+    std::vector<std::vector<std::string>> endedRows;
+    std::vector<std::vector<std::string>> addedRows;
+};
+
+/**
+ * Forward-only, lock-free iterator over the rows visible at one snapshot.
+ * Value references stay valid until the next call to next().
+ */
+class TableCursor {
+public:
+    TableCursor(std::unique_ptr<VersionManager::Snapshot> snapshot, RowStore::View view,
+                ColumnDictionaries dictionaries, uint64_t ownMarker);
+
+    /**
+     * Advance to the next visible row
+     * @return false when there are no more rows
+     */
+    bool next();
+
+    /**
+     * Value of one column of the current row, read in place
+     */
+    std::string_view get(size_t column) const;
+
+    /**
+     * Values of the current row (decoded into a buffer on first use)
+     */
+    const std::vector<std::string>& row() const;
+
+    size_t getColumnCount() const;
+
+private:
+    std::unique_ptr<VersionManager::Snapshot> snapshot_;
+    RowStore::View view_;
+    ColumnDictionaries dictionaries_;
+    uint64_t ownMarker_;
+    size_t position_ = 0;
+    const RowVersion* current_ = nullptr;
+    mutable std::vector<std::string> decoded_;
+    mutable bool isDecoded_ = false;
+};
+
 /**
  * Represents a table in the database
+ *
+ * Rows are multi-versioned: every version carries begin/end commit
+ * timestamps and readers (selects, serialization) scan a snapshot without
+ * taking any lock, so long scans never block writers. Writers serialize on
+ * the table's write lock, which also guards the indexes.
+ *
+ * DELETE ends the current version of each row it matches; UPDATE ends it
+ * and appends the new one. The PRIMARY KEY and UNIQUE indexes (KeyIndex,
+ * a Swiss table) map each key to the slot of its current version and are
+ * maintained in place; they keep no copy of the key but read it from the
+ * row. Keys of rows a transaction deleted stay in the indexes until it
+ * commits, so nobody else can take them while it might still roll back.
+ *
+ * Scans with a WHERE condition skip the blocks of 64K slots whose ZoneMap
+ * (per-column minimum, maximum and NULL count) rules the condition out.
+ *
+ * Columns that are neither PRIMARY KEY nor UNIQUE are dictionary coded:
+ * each distinct value is stored once and rows hold a 4-byte code, and
+ * equality filters compare codes. A column that turns out to have more than
+ * ColumnDictionary::MAX_SIZE distinct values falls back to plain text for
+ * new rows.
  */
 class Table {
 public:
     /**
-     * Create a new table with the given name and column definitions
+     * Create a new table with the given name and column definitions.
+     * Tables of one database share its version manager; a standalone table
+     * gets its own.
      */
-    Table(const std::string& name, const std::vector<ColumnDef>& columns);
+    Table(const std::string& name, const std::vector<ColumnDef>& columns,
+          std::shared_ptr<VersionManager> versionManager = nullptr);
 
     /**
      * Create a table with basic column definitions (backwards compatibility)
      */
-    Table(const std::string& name, const std::vector<std::pair<std::string, std::string>>& columns);
+    Table(const std::string& name, const std::vector<std::pair<std::string, std::string>>& columns,
+          std::shared_ptr<VersionManager> versionManager = nullptr);
 
     /**
      * Insert a row into the table
@@ -57,13 +153,101 @@ public:
     bool insertRow(const std::vector<std::string>& values);
 
     /**
-     * Select rows from the table with optional where condition
+     * Insert several rows under one lock acquisition and one commit.
+     * Rows violating a constraint are skipped.
+     * @return number of rows inserted
+     */
+    size_t insertRows(const std::vector<std::vector<std::string>>& rows);
+
+    /**
+     * Insert a row on behalf of an open transaction. The new version stays
+     * invisible to other snapshots until commitVersion() stamps it.
+     * @param slot receives the slot id of the new version
+     */
+    bool insertUncommitted(const std::vector<std::string>& values, uint64_t txnMarker, size_t& slot);
+
+    /**
+     * Stamp a version written by a transaction with its commit timestamp
+     */
+    void commitVersion(size_t slot, uint64_t commitTs);
+
+    /**
+     * Undo an uncommitted insert: drop its index entries and retire the version
+     */
+    void undoInsert(size_t slot);
+
+    /**
+     * Set columns of the rows matching a condition ("" matches every row).
+     * With a transaction marker the changes stay invisible to other
+     * snapshots until commitVersion() and commitDelete() stamp them.
+     * @return false on an unknown column, a constraint violation or a row
+     *         another transaction is changing; nothing is changed then
+     */
+    bool updateRows(const std::vector<std::pair<std::string, std::string>>& assignments,
+                    const std::string& whereCondition, uint64_t txnMarker, RowChanges& changes);
+
+    /**
+     * Delete the rows matching a condition ("" matches every row); see updateRows()
+     */
+    bool deleteRows(const std::string& whereCondition, uint64_t txnMarker, RowChanges& changes);
+
+    /**
+     * Stamp a version deleted by a transaction with its commit timestamp
+     */
+    void commitDelete(size_t slot, uint64_t commitTs);
+
+    /**
+     * Drop the index entries a committed delete kept reserved
+     */
+    void releaseDeleted(size_t slot);
+
+    /**
+     * Undo an uncommitted delete: make the version current again
+     */
+    void undoDelete(size_t slot);
+
+    /**
+     * Add a row that is already committed (table files, redo log replay)
+     */
+    bool loadRow(const std::vector<std::string>& values);
+
+    /**
+     * Remove a committed row with exactly these values (redo log replay)
+     */
+    bool unloadRow(const std::vector<std::string>& values);
+
+    /**
+     * Select rows from the table with optional where condition.
+     * ownMarker makes a transaction's own uncommitted rows visible.
+     * When analysis is given, the plan is stored there with the time, row
+     * counts and bytes of each operator (slower; for EXPLAIN ANALYZE).
+     * Without a snapshot the rows committed so far are read.
      */
     std::vector<std::vector<std::string>> selectRows(
         const std::vector<std::string>& columns,
-        const std::string& whereCondition = ""
+        const std::string& whereCondition = "",
+        uint64_t ownMarker = 0,
+        QueryPlan* analysis = nullptr,
+        const VersionManager::Snapshot* snapshot = nullptr
     ) const;
 
+    /**
+     * Plan a select without running it (EXPLAIN)
+     */
+    QueryPlan explainSelect(const std::vector<std::string>& columns,
+                            const std::string& whereCondition = "") const;
+
+    /**
+     * Open a cursor over the rows visible now (plus the caller's own
+     * uncommitted rows when ownMarker is given)
+     */
+    TableCursor openCursor(uint64_t ownMarker = 0) const;
+
+    /**
+     * Get the index of a column, or -1 if there is no such column
+     */
+    int getColumnIndex(const std::string& columnName) const;
+
     /**
      * Get the table name
      */
@@ -84,32 +268,198 @@ public:
      */
     size_t getRowCount() const;
 
+    /**
+     * Get the number of stored row versions, including dead ones not yet collected
+     */
+    size_t getVersionCount() const;
+
+    /**
+     * Estimated memory of the version slots, values and indexes. Maintained
+     * incrementally by writers, so it is cheap enough to check per write.
+     */
+    TableMemoryUsage getMemoryUsage() const;
+
+    /**
+     * Timestamp of the latest commit that changed the rows (inserted or
+     * ended a version); BOOTSTRAP_TS if none did since the table was loaded
+     */
+    uint64_t getLastCommitTimestamp() const;
+
+    /**
+     * Reclaim versions that ended at or before the horizon
+     * @return number of versions reclaimed
+     */
+    size_t collectGarbage(uint64_t horizon);
+
+    /**
+     * Move the current versions out of mostly reclaimed chunks (see
+     * RowStore) so the chunks can be released. Readers are not blocked:
+     * the copies are committed at one timestamp, and older snapshots keep
+     * reading the originals until the garbage collector reclaims them.
+     * @return number of versions moved
+     */
+    size_t compact();
+
     /**
      * Serialize the table to a string for storage
      */
     std::string serialize() const;
 
     /**
-     * Deserialize a table from string
+     * Serialize the rows visible at the given (registered) snapshot
+     * @param compressed store the rows as compressed column blocks (see BlockCodec)
      */
-    static std::unique_ptr<Table> deserialize(const std::string& data);
+    std::string serialize(uint64_t snapshotTs, bool compressed = false) const;
+
+    /**
+     * Deserialize a table from string, in either row format
+     */
+    static std::unique_ptr<Table> deserialize(const std::string& data,
+                                              std::shared_ptr<VersionManager> versionManager = nullptr);
 
 private:
     std::string name_;
     std::vector<ColumnDef> columns_;
-    std::vector<std::vector<std::string>> rows_;
+    std::shared_ptr<VersionManager> versionManager_;
+    RowStore rows_;
+    std::atomic<size_t> liveRows_{0};
+    std::atomic<size_t> retiredVersions_{0};  // Ended versions not yet reclaimed
+    std::atomic<uint64_t> lastCommitTs_{VersionManager::BOOTSTRAP_TS};
+    std::atomic<size_t> primaryKeyIndexBytes_{0};
+    std::atomic<size_t> uniqueIndexBytes_{0};
+    ColumnDictionaries dictionaries_;
+    RowImage encodeBuffer_;                    // Reused by writers for every row
+    
+    // Index for primary key lookup (key -> row slot)
+    KeyIndex primaryKeyIndex_;
     
-    // Index for primary key lookup
-    std::unordered_map<std::string, size_t> primaryKeyIndex_;
+    // Indexes for UNIQUE columns other than the primary key (value -> row slot);
+    // NULLs are not indexed
+    std::vector<KeyIndex> uniqueIndexes_;
     
-    // Indexes for unique columns
-    std::vector<std::unordered_set<std::string>> uniqueIndexes_;
+    // Index entries for the rows an UPDATE is about to write hold this flag
+    // and the row's position in pendingRows_
+    static constexpr size_t PENDING_SLOT = size_t{1} << 63;
+    const std::vector<std::vector<std::string>>* pendingRows_ = nullptr;
+    
+    // Zones of every version appended; widened by the writer before a
+    // version is published, read by scans under zonesMutex_
+    ZoneMap zones_;
+    mutable util::SharedMutex zonesMutex_;
+    bool maintainZones_ = true;                // Off while loading a file that has its zones
+    
+    mutable util::SharedMutex mutex_;
 
     // Helper methods
+    void initDictionaries();
+    ZoneMap newZoneMap() const;
+    
+    /**
+     * Recompute the zones from every version in the store
+     */
+    void rebuildZones();
+    const RowImage& encodeRow(const std::vector<std::string>& values);
+    std::vector<std::string> decodeRow(const EncodedRow& row) const;
+    size_t appendRow(const std::vector<std::string>& values, uint64_t beginTs);
+    void retireVersion(size_t slot, uint64_t endTs);
+    
+    /**
+     * Record a commit stamp in lastCommitTs_ (transaction markers are not commits)
+     */
+    void noteCommit(uint64_t commitTs);
+    void indexRow(const std::vector<std::string>& values, size_t slot, bool replace = true);
+    void unindexRow(const std::vector<std::string>& values, size_t slot);
+    void unindexVersion(size_t slot);
+    void updateIndexMemory();
+    static bool isPending(size_t slot) { return (slot & PENDING_SLOT) != 0; }
+    
+    /**
+     * Key of an indexed row (or pending row) in a key column
+     */
+    std::string_view indexedKey(size_t slot, size_t column) const;
+    
+    /**
+     * Position of a key's entry in the index of its column, or KeyIndex::NOT_FOUND
+     */
+    size_t findKey(const KeyIndex& index, size_t column, std::string_view key) const;
+    bool isUniqueIndexed(size_t column) const;
     bool validateRow(const std::vector<std::string>& values) const;
-    bool checkConstraints(const std::vector<std::string>& values);
-    int getColumnIndex(const std::string& columnName) const;
-    bool evaluateCondition(const std::vector<std::string>& row, const std::string& condition) const;
+    /**
+     * Check NOT NULL, PRIMARY KEY and UNIQUE. Keys held by rows the
+     * transaction ownMarker deleted itself count as free.
+     */
+    bool checkConstraints(const std::vector<std::string>& values, uint64_t ownMarker = 0);
+    
+    /**
+     * Load the compressed row blocks that start at offset in a table file
+     * @return false if a block is missing or corrupt (rows before it are loaded)
+     */
+    bool loadBlocks(const std::string& data, size_t offset, size_t blockCount,
+                    const std::function<void(std::vector<std::string>&)>& loadValues);
+    
+    /**
+     * "column=value" (or <, <=, >, >=) condition resolved against the schema
+     * once per query. Equality compares the text; ranges compare INT columns
+     * as integers (given an integer value) and others as text, and never
+     * match NULLs.
+     */
+    struct Predicate {
+        int column = -1;              // -1 matches every row
+        bool matchesNothing = false;  // Condition names an unknown column
+        Comparison comparison = Comparison::EQUAL;
+        std::string value;
+        bool hasCode = false;         // Value is in the column's dictionary
+        uint32_t code = 0;
+        bool isInteger = false;       // Range on an INT column, compared as integers
+        int64_t integer = 0;
+        const ColumnDictionary* dictionary = nullptr;
+        
+        bool matches(const EncodedRow& row) const {
+            if (matchesNothing || column < 0) {
+                return !matchesNothing;
+            }
+            size_t position = row.position(column);
+            if (comparison == Comparison::EQUAL) {
+                if (row.isCoded(column)) {
+                    return hasCode && row.code(position) == code;
+                }
+                return row.value(position) == value;
+            }
+            
+            std::string_view text = row.isCoded(column) ? std::string_view(dictionary->decode(row.code(position)))
+                                                        : row.value(position);
+            if (text.empty()) {
+                return false;
+            }
+            if (isInteger) {
+                int64_t rowInteger = 0;
+                return parseInteger(text, rowInteger) &&
+                       holds(comparison, (rowInteger > integer) - (rowInteger < integer));
+            }
+            return holds(comparison, text.compare(value));
+        }
+    };
+    Predicate planCondition(const std::string& condition) const;
+    
+    /**
+     * Call fn(slot, version) for every version visible at a snapshot,
+     * skipping the blocks whose zones rule the predicate out
+     * @return number of blocks skipped
+     */
+    template <typename Fn>
+    size_t scanBlocks(const RowStore::View& view, const Predicate& predicate, uint64_t snapshot,
+                      uint64_t ownMarker, Fn&& fn) const;
+    
+    /**
+     * Blocks among the first slotCount slots that the zones rule out
+     */
+    std::vector<bool> ruledOutBlocks(const Predicate& predicate, size_t slotCount) const;
+    bool findRowsToChange(const std::string& whereCondition, uint64_t ownMarker,
+                          std::vector<size_t>& slots) const;
+    void planSelect(const std::vector<std::string>& columns, const std::string& whereCondition,
+                    std::vector<int>& columnIndices, Predicate& predicate) const;
+    QueryPlan describeSelect(const std::vector<int>& columnIndices, const Predicate& predicate,
+                             bool hasCondition, const RowStore::View& view) const;
     int getPrimaryKeyColumnIndex() const;
 };
 
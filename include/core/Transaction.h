@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace soliddb {
+namespace core {
+
+class Table;
+
+/**
+ * An explicit transaction (BEGIN ... COMMIT/ROLLBACK)
+ *
+ * Versions written by the transaction are stamped with its marker instead
+ * of a commit timestamp, which hides them from every snapshot except the
+ * transaction's own; versions it deletes get the marker as their end stamp,
+ * which hides them from the transaction only. The undo log lists those
+ * versions so COMMIT and ROLLBACK cost time proportional to the
+ * transaction's changes; the redo log holds the WAL records flushed on
+ * COMMIT.
+ */
+class Transaction {
+public:
+    /** Marker bit distinguishing transaction ids from commit timestamps */
+    static constexpr uint64_t MARKER_FLAG = 1ULL << 63;
+
+    explicit Transaction(uint64_t id) : id_(id) {}
+
+    uint64_t getId() const { return id_; }
+
+    /**
+     * Begin stamp of versions this transaction wrote, and end stamp of
+     * versions it deleted, until it commits
+     */
+    uint64_t marker() const { return MARKER_FLAG | id_; }
+
+    /**
+     * Number of rows inserted, updated or deleted so far
+     */
+    size_t getChangeCount() const { return changeCount_; }
+
+    /**
+     * Remember a statement for the transaction log written on commit
+     */
+    void addStatement(const std::string& statement) { statements_.push_back(statement); }
+
+private:
+    friend class Database;
+
+    struct UndoEntry {
+        std::shared_ptr<Table> table;
+        size_t slot;
+        bool isDelete;  // Ended an existing version instead of adding one
+    };
+
+    uint64_t id_;
+    size_t changeCount_ = 0;
+    std::vector<UndoEntry> undoLog_;
+    std::string redoLog_;
+    std::vector<std::string> statements_;
+};
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Hands out commit timestamps and tracks the snapshots readers are using
+ *
+ * A row version is visible to a snapshot taken at timestamp S when
+ * begin <= S < end. Commits are stamped under a mutex and only become
+ * visible to new snapshots once fully stamped, so a snapshot never sees
+ * part of a commit. One VersionManager is shared by all tables of a database.
+ */
+class VersionManager {
+public:
+    /** End timestamp of a version nobody has superseded yet */
+    static constexpr uint64_t INFINITE_TS = std::numeric_limits<uint64_t>::max();
+
+    /** Begin timestamp of rows loaded from disk: visible to every snapshot */
+    static constexpr uint64_t BOOTSTRAP_TS = 0;
+
+    /**
+     * A registered read snapshot; released on destruction
+     */
+    class Snapshot {
+    public:
+        Snapshot(VersionManager& manager, uint64_t timestamp);
+        ~Snapshot();
+
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        uint64_t timestamp() const { return timestamp_; }
+
+    private:
+        VersionManager& manager_;
+        uint64_t timestamp_;
+    };
+
+    /**
+     * Exclusive right to stamp one commit. The timestamp becomes visible to
+     * new snapshots when the guard is destroyed.
+     */
+    class CommitGuard {
+    public:
+        explicit CommitGuard(VersionManager& manager);
+        ~CommitGuard();
+
+        CommitGuard(const CommitGuard&) = delete;
+        CommitGuard& operator=(const CommitGuard&) = delete;
+
+        uint64_t timestamp() const { return timestamp_; }
+
+    private:
+        VersionManager& manager_;
+        std::unique_lock<std::mutex> lock_;
+        uint64_t timestamp_;
+    };
+
+    /**
+     * Timestamp of the latest fully committed change
+     */
+    uint64_t currentTimestamp() const;
+
+    /**
+     * Register a snapshot of everything committed so far
+     */
+    Snapshot openSnapshot();
+
+    /**
+     * Register a snapshot owned by the caller (for cursors that outlive the call)
+     */
+    std::unique_ptr<Snapshot> openSnapshotHandle();
+
+    /**
+     * Register a snapshot while no commit is in flight and call
+     * fn(timestamp) before the next commit can start. Used by checkpoints
+     * to pair a snapshot with a position in the redo log.
+     */
+    template <typename Fn>
+    Snapshot openSnapshotExclusive(Fn&& fn) {
+        std::lock_guard<std::mutex> lock(commitMutex_);
+        uint64_t timestamp = registerSnapshot();
+        fn(timestamp);
+        return Snapshot(*this, timestamp);
+    }
+
+    /**
+     * Oldest timestamp any active snapshot reads at. Versions that ended at
+     * or before it are invisible to every current and future snapshot.
+     */
+    uint64_t oldestActiveSnapshot() const;
+
+    /**
+     * Number of snapshots currently open
+     */
+    size_t activeSnapshotCount() const;
+
+private:
+    std::atomic<uint64_t> clock_{BOOTSTRAP_TS};
+    std::mutex commitMutex_;
+
+    mutable std::mutex snapshotMutex_;
+    std::map<uint64_t, size_t> activeSnapshots_;  // timestamp -> reader count
+
+    uint64_t registerSnapshot();
+    void releaseSnapshot(uint64_t timestamp);
+};
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/Condition.h"
+
+namespace soliddb {
+namespace core {
+
+/**
+ * Per-block summaries of a table's columns (zone maps), letting scans skip
+ * blocks that cannot hold a matching row
+ *
+ * Slots are grouped into blocks of BLOCK_ROWS. For each column a block
+ * keeps the smallest and largest non-NULL value and the number of NULLs of
+ * every version ever added to it; INT columns are ordered as integers, the
+ * others as text. Ended versions are never taken out, so a zone only widens
+ * and may cover values no live row holds: it can rule a block out, never
+ * prove it holds a match. Not thread-safe; Table guards it with a lock of
+ * its own, since scans read it while the writer adds rows.
+ */
+class ZoneMap {
+public:
+    static constexpr size_t BLOCK_ROWS = 64 * 1024;
+
+    /**
+     * @param integerColumns columns ordered as integers (INT columns)
+     */
+    explicit ZoneMap(std::vector<bool> integerColumns = {});
+
+    /**
+     * Widen the zone of a slot's block to cover a value ("" is NULL)
+     */
+    void add(size_t slot, size_t column, std::string_view value);
+
+    /**
+     * Whether no value of the column in a block can satisfy
+     * "column <comparison> value" (false for blocks without a zone)
+     */
+    bool rulesOut(size_t block, size_t column, Comparison comparison, std::string_view value) const;
+
+    size_t blockCount() const;
+    void clear();
+
+    /**
+     * Write the zones as a "ZONES <blocks>" section of a table file
+     */
+    void write(std::ostream& out) const;
+
+    /**
+     * Read the zones of a section whose header line was already read
+     * @return false if the section is truncated
+     */
+    bool read(std::istream& in, size_t blockCount);
+
+private:
+    struct Zone {
+        size_t nullCount = 0;
+        size_t valueCount = 0;         // Non-NULL values
+        bool ordered = true;           // False once an INT column got a non-integer
+        int64_t minInteger = 0;
+        int64_t maxInteger = 0;
+        std::string minText;
+        std::string maxText;
+    };
+
+    Zone& zoneOf(size_t block, size_t column);
+    const Zone& zoneOf(size_t block, size_t column) const;
+
+    std::vector<bool> integerColumns_;
+    std::vector<Zone> zones_;          // Block by block, a zone per column
+};
+
+} // namespace core
+} // namespace soliddb
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
 #include <functional>
+#include <ostream>
 #include "core/Database.h"
+#include "core/DatabaseRegistry.h"
 #include "core/Table.h"
+#include "core/Transaction.h"
 
 namespace soliddb {
 namespace parser {
@@ -20,6 +24,11 @@ public:
      */
     CommandParser();
 
+    /**
+     * Roll back a transaction left open
+     */
+    ~CommandParser();
+
     /**
      * Parse and execute a command string
      * @return true if the command was executed successfully
@@ -31,23 +40,85 @@ public:
      */
     void printHelp() const;
 
+    /**
+     * Redirect command output (results, status and errors) to the given stream
+     */
+    void setOutput(std::ostream& out);
+
+    /**
+     * Suppress status messages; query results and errors are still written
+     */
+    void setQuiet(bool quiet);
+
+    /**
+     * Check whether the last executed command reported an error
+     */
+    bool lastCommandFailed() const;
+
+    /**
+     * Open and create databases through a shared registry instead of the
+     * parser's own (used when several sessions share databases)
+     */
+    void setRegistry(std::shared_ptr<core::DatabaseRegistry> registry);
+
+    /**
+     * Cache of databases this parser has opened
+     */
+    std::shared_ptr<core::DatabaseRegistry> getRegistry() const;
+
 private:
     int operationCount;  // Counter for write operations since last checkpoint
+    uint32_t sessionId_;  // Identifies this parser's statements in a workload capture
+    std::ostream* out_;
+    bool quiet_;
+    bool lastCommandFailed_;
+    std::shared_ptr<core::DatabaseRegistry> registry_;
+    
+    // Explicit transaction opened with BEGIN, and the database it belongs to
+    std::unique_ptr<core::Transaction> transaction_;
+    std::shared_ptr<core::Database> transactionDatabase_;
+
+    std::ostream& out() const;
+    std::ostream& status() const;
+    std::ostream& error();
 
     bool handleCreateDatabase(const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
     bool handleCreateTable(const std::string& command, const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
+    bool handleAlterTable(const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
     bool handleUseDatabase(const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
     bool handleInsert(const std::string& command, const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
-    bool handleSelect(const std::string& command, const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
+    bool handleUpdate(const std::string& command, const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
+    bool handleDelete(const std::string& command, const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
+    enum class ExplainMode { NONE, PLAN, ANALYZE };
+
+    bool handleSelect(const std::string& command, const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase,
+                      ExplainMode explain = ExplainMode::NONE);
+    bool handleExplain(const std::string& command, const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
     bool handleListDatabases(const std::vector<std::string>& tokens);
     bool handleListTables(const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
     bool handleSave(const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
-    bool handleRollback(const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
+    bool handleBegin(std::shared_ptr<core::Database>& currentDatabase);
+    bool handleCommit();
+    bool handleRollback();
+    bool handleShowStats(const std::vector<std::string>& tokens);
+    bool handleShowMemory(std::shared_ptr<core::Database>& currentDatabase);
+    bool handleShowLsm(std::shared_ptr<core::Database>& currentDatabase);
+    bool handleShowPartitions(std::shared_ptr<core::Database>& currentDatabase);
+    bool handleSetMemoryBudget(const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
+    bool handleSetCompression(const std::vector<std::string>& tokens, std::shared_ptr<core::Database>& currentDatabase);
+    bool handleExportReadOnly(std::shared_ptr<core::Database>& currentDatabase);
 
     std::vector<std::string> tokenize(const std::string& input, char delimiter) const;
     std::vector<std::pair<std::string, std::string>> parseColumnDefinitions(const std::string& columnDefs) const;
     std::vector<core::ColumnDef> parseColumnDefsWithConstraints(const std::string& columnDefs) const;
     std::vector<std::string> parseValueList(const std::string& valueList) const;
+
+    /**
+     * Parse "PARTITION BY HASH(<column>) <count>" or
+     * "PARTITION BY RANGE(<column>) (<bound>, ...)"
+     * @return false (with an error printed) if the clause is malformed
+     */
+    bool parsePartitionClause(const std::string& clause, core::PartitionScheme& scheme);
 };
 
 } // namespace parser
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace soliddb {
+namespace server {
+
+/**
+ * Wire protocol shared by clients and the server
+ *
+ * Every message is a frame: a 4-byte big-endian payload length followed by
+ * the payload. A request payload is one statement. A response payload is a
+ * status byte followed by the text the statement produced.
+ */
+namespace protocol {
+
+constexpr size_t HEADER_SIZE = 4;
+constexpr uint32_t MAX_FRAME_SIZE = 16 * 1024 * 1024;
+
+constexpr char STATUS_OK = 0x00;
+constexpr char STATUS_ERROR = 0x01;
+constexpr char STATUS_CLOSE = 0x02;  // Statement succeeded, server closes the connection
+
+/**
+ * Append a frame carrying the payload to the output buffer
+ */
+void appendFrame(std::string& out, const std::string& payload);
+
+/**
+ * Append a response frame (status byte + body) to the output buffer
+ */
+void appendResponse(std::string& out, char status, const std::string& body);
+
+} // namespace protocol
+
+/**
+ * Incrementally extracts frames from a byte stream
+ */
+class FrameDecoder {
+public:
+    /**
+     * Append received bytes
+     */
+    void feed(const char* data, size_t length);
+
+    /**
+     * Extract the next complete frame payload
+     * @return false if no complete frame is buffered yet
+     */
+    bool next(std::string& payload);
+
+    /**
+     * True once a frame header announced a payload larger than MAX_FRAME_SIZE
+     */
+    bool hasError() const;
+
+private:
+    std::string buffer_;
+    size_t offset_ = 0;
+    bool error_ = false;
+};
+
+} // namespace server
+} // namespace soliddb
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "core/DatabaseRegistry.h"
+#include "server/Protocol.h"
+#include "server/Session.h"
+#include "util/ThreadPool.h"
+
+namespace soliddb {
+namespace server {
+
+/**
+ * Server configuration
+ */
+struct ServerConfig {
+    std::string host = "127.0.0.1";
+    uint16_t port = 5433;
+    size_t workerThreads = 4;
+    size_t maxConnections = 1024;
+    size_t databaseCacheBytes = core::DatabaseRegistry::DEFAULT_MEMORY_BUDGET;
+    size_t databaseMemoryBudget = 0;    // Per database, 0 = unlimited
+    bool readOnly = false;              // Open databases read-only (EXPORT READONLY files)
+};
+
+/**
+ * TCP server: a single epoll event loop owns every socket, statements run on
+ * a worker pool, and all sessions share one registry of open databases.
+ * Requests on one connection are executed one at a time, in order.
+ */
+class Server {
+public:
+    explicit Server(const ServerConfig& config);
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    /**
+     * Bind the listening socket and run the event loop until stop() is called
+     * @return false if the server could not start
+     */
+    bool run();
+
+    /**
+     * Ask the event loop to exit. Async-signal-safe.
+     */
+    void stop();
+
+private:
+    struct Connection {
+        int fd = -1;
+        FrameDecoder decoder;
+        std::string writeBuffer;
+        size_t writeOffset = 0;
+        std::deque<std::string> pending;
+        bool busy = false;            // A request is executing on a worker
+        bool closeAfterWrite = false;
+        bool peerClosed = false;      // Client shut down its side; close once its requests are answered
+        uint32_t events = 0;          // Currently registered epoll events
+        std::shared_ptr<Session> session;
+    };
+
+    struct Completion {
+        uint64_t connectionId;
+        Response response;
+    };
+
+    ServerConfig config_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;                 // eventfd: completions ready or stop requested
+    std::atomic<bool> running_{false};
+
+    std::shared_ptr<core::DatabaseRegistry> registry_;
+    std::unique_ptr<util::ThreadPool> workers_;
+
+    uint64_t nextConnectionId_ = 2;   // 0 = listen socket, 1 = wake eventfd
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections_;
+
+    std::mutex completionMutex_;
+    std::deque<Completion> completions_;
+
+    bool openListenSocket();
+    void acceptConnections();
+    void handleReadable(uint64_t id, Connection& conn);
+    void handleWritable(uint64_t id, Connection& conn);
+    void drainCompletions();
+    void dispatchNext(uint64_t id, Connection& conn);
+    bool flushWrites(Connection& conn);
+    void updateInterest(uint64_t id, Connection& conn);
+    void closeConnection(uint64_t id);
+    void wake();
+};
+
+} // namespace server
+} // namespace soliddb
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "core/Database.h"
+#include "core/DatabaseRegistry.h"
+#include "parser/CommandParser.h"
+
+namespace soliddb {
+namespace server {
+
+/**
+ * Result of executing one request in a session
+ */
+struct Response {
+    bool ok = true;
+    bool close = false;   // Client asked to end the session (EXIT)
+    std::string body;
+};
+
+/**
+ * Per-connection state: the current database, a command parser and the
+ * prepared statements created on this connection
+ *
+ * Besides every CommandParser command, a session understands:
+ *   PREPARE <name> AS <statement with ? placeholders>
+ *   EXECUTE <name> [(<value1>, <value2>, ...)]
+ *   DEALLOCATE <name>
+ */
+class Session {
+public:
+    explicit Session(std::shared_ptr<core::DatabaseRegistry> registry);
+
+    /**
+     * Execute one request and capture everything it printed
+     */
+    Response execute(const std::string& request);
+
+    /**
+     * Name of the current database, or empty if none is selected
+     */
+    std::string getCurrentDatabaseName() const;
+
+private:
+    std::shared_ptr<core::DatabaseRegistry> registry_;
+    std::shared_ptr<core::Database> currentDatabase_;
+    parser::CommandParser parser_;
+    std::unordered_map<std::string, std::string> preparedStatements_;
+
+    Response runStatement(const std::string& statement);
+    Response handlePrepare(const std::string& request, const std::vector<std::string>& tokens);
+    Response handleExecute(const std::string& request, const std::vector<std::string>& tokens);
+    Response handleDeallocate(const std::vector<std::string>& tokens);
+
+    static std::string bindParameters(const std::string& statement,
+                                      const std::vector<std::string>& parameters,
+                                      std::string& error);
+};
+
+} // namespace server
+} // namespace soliddb
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace soliddb {
+namespace util {
+
+/**
+ * Bump allocator over large slabs
+ *
+ * Allocations are carved off the current slab and never freed one by one;
+ * every slab is released at once when the arena is destroyed. Slabs start
+ * small and double up to MAX_SLAB_SIZE, so small arenas stay small. Blocks
+ * never move, so pointers handed out stay valid for the arena's lifetime.
+ * Not thread-safe: one thread allocates, others may read what it wrote once
+ * it is published.
+ */
+class Arena {
+public:
+    static constexpr size_t MIN_SLAB_SIZE = 4 * 1024;
+    static constexpr size_t MAX_SLAB_SIZE = 64 * 1024;
+
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * Allocate uninitialized memory. Requests larger than a slab get a
+     * slab of their own.
+     * @param alignment power of two, at most alignof(std::max_align_t)
+     */
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * Bytes of every slab, used or not
+     */
+    size_t reservedBytes() const {
+        return reservedBytes_;
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]>> slabs_;
+    char* cursor_ = nullptr;
+    size_t remaining_ = 0;
+    size_t nextSlabSize_ = MIN_SLAB_SIZE;
+    size_t reservedBytes_ = 0;
+};
+
+} // namespace util
+} // namespace soliddb
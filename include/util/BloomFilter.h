@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace soliddb {
+namespace util {
+
+/**
+ * Blocked Bloom filter over string keys
+ *
+ * Each key maps to one 64-byte block and sets all of its bits inside that
+ * block, so adding or probing a key touches a single cache line. At the
+ * default 10 bits per key about 1% of absent keys are reported as present;
+ * a present key is never reported absent.
+ */
+class BloomFilter {
+public:
+    static constexpr size_t DEFAULT_BITS_PER_KEY = 10;
+
+    BloomFilter() = default;
+
+    /**
+     * Empty filter sized for the given number of keys
+     */
+    explicit BloomFilter(size_t expectedKeys, size_t bitsPerKey = DEFAULT_BITS_PER_KEY);
+
+    void add(std::string_view key);
+
+    /**
+     * False if the key was certainly never added. An empty (default
+     * constructed) filter may contain anything.
+     */
+    bool mayContain(std::string_view key) const;
+
+    void addHash(uint64_t hash);
+    bool mayContainHash(uint64_t hash) const;
+
+    /**
+     * Hash used for keys; stable across processes, so filters can be stored
+     */
+    static uint64_t hash(std::string_view key);
+
+    /**
+     * Append the filter to out, in host byte order
+     */
+    void serialize(std::string& out) const;
+
+    /**
+     * Read a filter written by serialize()
+     * @return false if data is not a complete filter
+     */
+    static bool deserialize(std::string_view data, BloomFilter& filter);
+
+    size_t memoryBytes() const;
+
+private:
+    static constexpr size_t BLOCK_WORDS = 8;     // 512 bits, one cache line
+    static constexpr size_t BLOCK_BITS = BLOCK_WORDS * 64;
+
+    struct alignas(64) Block {
+        uint64_t words[BLOCK_WORDS];
+    };
+
+    size_t blockIndex(uint64_t hash) const;
+
+    uint32_t probes_ = 0;
+    std::vector<Block> blocks_;
+};
+
+} // namespace util
+} // namespace soliddb
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+namespace soliddb {
+namespace util {
+
+/**
+ * Process-wide console output policy
+ *
+ * Status chatter ("Loaded table", "Performing checkpoint...") goes through
+ * info() so batch runs can silence it, and std::cout can be switched to a
+ * large buffer that ignores std::endl flushes.
+ */
+class Console {
+public:
+    /**
+     * Enable or disable quiet mode (suppresses status chatter)
+     */
+    static void setQuiet(bool quiet);
+
+    /**
+     * Check whether quiet mode is enabled
+     */
+    static bool isQuiet();
+
+    /**
+     * Stream for status messages; output is discarded in quiet mode
+     */
+    static std::ostream& info();
+
+    /**
+     * Stream that discards everything written to it
+     */
+    static std::ostream& null();
+
+    /**
+     * Route std::cout through a buffer of the given size. The buffer is only
+     * written out when full or on flush(), so std::endl no longer costs a write.
+     */
+    static void enableBufferedOutput(size_t bufferSize = 1 << 16);
+
+    /**
+     * Write out any buffered std::cout output
+     */
+    static void flush();
+};
+
+} // namespace util
+} // namespace soliddb
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace soliddb {
+namespace util {
+
+/**
+ * LZ77 compressor in the LZ4 block format
+ *
+ * A greedy single-pass matcher over a 4 KiB-entry hash table: fast rather
+ * than tight, which suits checkpoints that rewrite whole tables. The output
+ * is a plain LZ4 block (no frame header or checksum), so the caller stores
+ * the uncompressed size next to it.
+ */
+class Lz {
+public:
+    /**
+     * Append the compressed form of data to out
+     */
+    static void compress(const char* data, size_t size, std::string& out);
+
+    /**
+     * Decompress a block that expands to exactly outSize bytes
+     * @return false if the block is malformed
+     */
+    static bool decompress(const char* data, size_t size, char* out, size_t outSize);
+
+private:
+    static constexpr unsigned HASH_BITS = 12;
+    static constexpr size_t MIN_MATCH = 4;
+    static constexpr size_t LAST_LITERALS = 5;   // Format: a block ends with literals
+    static constexpr size_t MATCH_LIMIT = 12;    // Format: no match starts in the last 12 bytes
+    static constexpr size_t MAX_OFFSET = 65535;
+};
+
+} // namespace util
+} // namespace soliddb
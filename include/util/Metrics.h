@@ -0,0 +1,215 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace soliddb {
+namespace util {
+
+/**
+ * Lock-free latency histogram with HDR-style log-linear buckets.
+ *
+ * Every power of two is split into 16 sub-buckets, so any recorded value is
+ * reported within about 6% while the whole 64-bit range fits in a fixed
+ * array of counters. Recording is a handful of relaxed atomic adds.
+ */
+class Histogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    /**
+     * Record one value (nanoseconds for timers)
+     */
+    void record(uint64_t value);
+
+    /**
+     * Record the nanoseconds elapsed since a start time
+     */
+    void recordSince(std::chrono::steady_clock::time_point start);
+
+    uint64_t count() const;
+    uint64_t sum() const;
+    uint64_t max() const;
+
+    /**
+     * Smallest value that at least the given fraction of samples do not exceed
+     * (bucket upper bound, capped at the maximum recorded value)
+     */
+    uint64_t percentile(double fraction) const;
+
+    void reset();
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(size_t index);
+};
+
+/**
+ * Process-wide engine metrics: latency histograms per statement type and
+ * per execution phase, and monotonically increasing counters
+ */
+class Metrics {
+public:
+    enum class Statement { CREATE, USE, INSERT, UPDATE, DELETE, SELECT, BEGIN, COMMIT, ROLLBACK, CHECKPOINT, LIST, SHOW,
+                           EXPLAIN, OTHER, COUNT };
+    enum class Phase { PARSE, PLAN, EXECUTE, WAL, CHECKPOINT, COUNT };
+    enum class Counter { ROWS_SCANNED, ROWS_RETURNED, ROWS_UPDATED, ROWS_DELETED, ROWS_COMPACTED, INDEX_PROBES,
+                         INDEX_HITS, BYTES_WRITTEN, PAGE_HITS, PAGE_MISSES, PAGE_EVICTIONS, PAGE_WRITEBACKS,
+                         LSM_FLUSHES, LSM_COMPACTIONS, BLOOM_SKIPS, RUN_BLOCK_READS, BLOCKS_SKIPPED, BLOCKS_SCANNED,
+                         CACHE_HITS, CACHE_MISSES, CACHE_EVICTIONS, COUNT };
+
+    /**
+     * What one statement recorded: the phase times and counters added by
+     * the thread while the trace was active, and the access path it used
+     */
+    struct Trace {
+        std::array<uint64_t, static_cast<size_t>(Phase::COUNT)> phaseNanoseconds{};
+        std::array<uint64_t, static_cast<size_t>(Counter::COUNT)> counters{};
+        std::string accessPath;
+    };
+
+    static Metrics& instance();
+
+    Histogram& statement(Statement type);
+    Histogram& phase(Phase phase);
+
+    /**
+     * Record a phase duration, also into the active trace of this thread
+     */
+    void recordPhase(Phase phase, uint64_t nanoseconds);
+
+    /**
+     * Add to a counter, and to the active trace of this thread
+     */
+    void add(Counter counter, uint64_t amount = 1);
+    uint64_t get(Counter counter) const;
+
+    /**
+     * Map the leading keyword of a statement to its type
+     */
+    static Statement classify(const std::string& keyword);
+
+    /**
+     * Trace that receives what the calling thread records (nullptr for none)
+     */
+    static Trace* activeTrace();
+    static void setActiveTrace(Trace* trace);
+
+    static const char* phaseName(Phase phase);
+    static const char* counterName(Counter counter);
+
+    /**
+     * Human-readable table of every non-empty histogram and all counters
+     */
+    std::string report() const;
+
+    /**
+     * Nanoseconds formatted with a readable unit ("950ns", "1.2ms")
+     */
+    static std::string formatDuration(uint64_t nanoseconds);
+
+    /**
+     * Clear all histograms and counters
+     */
+    void reset();
+
+    /**
+     * Append report() to a file every interval, from a background thread
+     */
+    bool startPeriodicDump(const std::string& path, std::chrono::seconds interval);
+    void stopPeriodicDump();
+
+private:
+    Metrics() = default;
+    ~Metrics();
+
+    std::array<Histogram, static_cast<size_t>(Statement::COUNT)> statements_;
+    std::array<Histogram, static_cast<size_t>(Phase::COUNT)> phases_;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::COUNT)> counters_{};
+
+    std::thread dumpThread_;
+    std::mutex dumpMutex_;
+    std::condition_variable dumpWake_;
+    bool dumpStopping_ = false;
+};
+
+/**
+ * Makes a trace the active one of the calling thread for the lifetime of a scope
+ */
+class TraceScope {
+public:
+    explicit TraceScope(Metrics::Trace& trace) : previous_(Metrics::activeTrace()) {
+        Metrics::setActiveTrace(&trace);
+    }
+
+    ~TraceScope() {
+        Metrics::setActiveTrace(previous_);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    Metrics::Trace* previous_;
+};
+
+/**
+ * Records the lifetime of a scope as a phase (see Metrics::recordPhase)
+ */
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Metrics::Phase phase,
+                        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now())
+        : phase_(phase), start_(start) {}
+
+    ~PhaseTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        Metrics::instance().recordPhase(
+            phase_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    Metrics::Phase phase_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Records the lifetime of a scope into a histogram, in nanoseconds
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram,
+                         std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now())
+        : histogram_(histogram), start_(start) {}
+
+    ~ScopedTimer() {
+        histogram_.recordSince(start_);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace util
+} // namespace soliddb
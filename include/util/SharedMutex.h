@@ -0,0 +1,36 @@
+#pragma once
+
+#include <pthread.h>
+
+namespace soliddb {
+namespace util {
+
+/**
+ * Reader/writer mutex that gives waiting writers priority over new readers
+ *
+ * std::shared_mutex on glibc prefers readers, so a steady stream of
+ * overlapping SELECTs can starve INSERTs forever. Usable with
+ * std::shared_lock and std::unique_lock.
+ */
+class SharedMutex {
+public:
+    SharedMutex();
+    ~SharedMutex();
+
+    SharedMutex(const SharedMutex&) = delete;
+    SharedMutex& operator=(const SharedMutex&) = delete;
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+    void lock_shared();
+    bool try_lock_shared();
+    void unlock_shared();
+
+private:
+    pthread_rwlock_t rwlock_;
+};
+
+} // namespace util
+} // namespace soliddb
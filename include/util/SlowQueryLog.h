@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "util/Metrics.h"
+
+namespace soliddb {
+namespace util {
+
+/**
+ * Log of statements slower than a threshold, written to slow_query.log in
+ * the directory of the database they ran against.
+ *
+ * Each entry holds the normalized statement, its total time, the time of
+ * every phase, the rows scanned and returned, and the access path. Entries
+ * are queued and written by a background thread, so a slow disk never
+ * delays the statement being logged; if the queue is full, entries are
+ * dropped and counted instead.
+ */
+class SlowQueryLog {
+public:
+    static constexpr size_t MAX_QUEUED_ENTRIES = 10000;
+    static constexpr const char* FILE_NAME = "slow_query.log";
+
+    static SlowQueryLog& instance();
+
+    /**
+     * Log statements that take at least this long (zero disables the log)
+     */
+    void setThreshold(std::chrono::microseconds threshold);
+    std::chrono::microseconds getThreshold() const;
+    bool isEnabled() const;
+
+    /**
+     * Queue a statement if it is at or above the threshold
+     * @param directory directory to log into ("" for the working directory)
+     */
+    void record(const std::string& directory, const std::string& statement,
+                uint64_t totalNanoseconds, const Metrics::Trace& trace);
+
+    /**
+     * Replace literals with '?' and collapse whitespace, so that statements
+     * differing only in their values look the same
+     */
+    static std::string normalize(const std::string& statement);
+
+    /**
+     * Block until every queued entry has been written
+     */
+    void flush();
+
+    uint64_t getDroppedCount() const;
+
+private:
+    struct Entry {
+        std::string directory;
+        std::string line;
+    };
+
+    SlowQueryLog() = default;
+    ~SlowQueryLog();
+
+    void writerLoop();
+
+    std::atomic<int64_t> thresholdMicros_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable drained_;
+    std::deque<Entry> queue_;
+    bool writing_ = false;
+    bool stopping_ = false;
+    std::thread writer_;
+};
+
+} // namespace util
+} // namespace soliddb
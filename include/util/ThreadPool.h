@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace soliddb {
+namespace util {
+
+/**
+ * Fixed-size pool of worker threads executing queued tasks in FIFO order
+ */
+class ThreadPool {
+public:
+    /**
+     * Start the given number of worker threads (at least one)
+     */
+    explicit ThreadPool(size_t threadCount);
+
+    /**
+     * Finish queued tasks and join all workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Queue a task for execution on a worker thread
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * Number of worker threads
+     */
+    size_t size() const;
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+    bool stopping_ = false;
+
+    void workerLoop();
+};
+
+} // namespace util
+} // namespace soliddb
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace soliddb {
+namespace util {
+
+/**
+ * LEB128 variable-length integers, as used by the compressed table blocks,
+ * the LSM logs and manifest, and the sorted runs: 7 bits per byte, low
+ * bits first, the high bit set on every byte but the last
+ */
+class Varint {
+public:
+    /**
+     * Append the encoding of value to out
+     */
+    static void write(std::string& out, uint64_t value);
+
+    /**
+     * Decode the integer starting at pos and advance pos past it
+     * @return false if the input ends first or the encoding is too long
+     */
+    static bool read(std::string_view in, size_t& pos, uint64_t& value);
+};
+
+} // namespace util
+} // namespace soliddb
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace soliddb {
+namespace util {
+
+/**
+ * One statement of a captured workload
+ */
+struct CapturedStatement {
+    uint64_t offsetNanoseconds = 0;   // Since the capture started
+    uint32_t session = 0;
+    std::string database;             // Current database when it ran ("" for none)
+    std::string statement;
+};
+
+/**
+ * Process-wide recorder of every executed statement, for soliddb_replay.
+ *
+ * The file starts with an 8-byte magic and holds one frame per statement:
+ *
+ *     u32 frame length (bytes after this field)
+ *     u64 nanoseconds since the capture started
+ *     u32 session id
+ *     u16 database name length, database name
+ *     statement text (the rest of the frame)
+ *
+ * Integers are little-endian. Frames are appended to an in-memory buffer and
+ * written by a background thread; if the buffer grows past MAX_PENDING_BYTES
+ * because the disk cannot keep up, statements are dropped and counted.
+ */
+class WorkloadCapture {
+public:
+    static constexpr char MAGIC[8] = {'S', 'D', 'B', 'C', 'A', 'P', '0', '1'};
+    static constexpr size_t MAX_PENDING_BYTES = 64 * 1024 * 1024;
+
+    static WorkloadCapture& instance();
+
+    /**
+     * Start capturing into a new file (an existing one is overwritten)
+     */
+    bool start(const std::string& path);
+
+    /**
+     * Write out what is buffered and close the file
+     */
+    void stop();
+
+    bool isActive() const;
+
+    /**
+     * Queue one statement; cheap enough for every statement
+     */
+    void record(uint32_t session, const std::string& database, const std::string& statement);
+
+    uint64_t getCapturedCount() const;
+    uint64_t getDroppedCount() const;
+
+    /**
+     * Read every statement of a capture file
+     * @return false if the file cannot be read or is not a capture
+     */
+    static bool read(const std::string& path, std::vector<CapturedStatement>& statements);
+
+private:
+    WorkloadCapture() = default;
+    ~WorkloadCapture();
+
+    void writerLoop();
+
+    std::atomic<bool> active_{false};
+    std::atomic<uint64_t> captured_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::chrono::steady_clock::time_point start_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::string pending_;
+    bool stopping_ = false;
+    std::FILE* file_ = nullptr;
+    std::thread writer_;
+};
+
+} // namespace util
+} // namespace soliddb
@@ -0,0 +1,288 @@
+#include "api/Connection.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <filesystem>
+#include <iterator>
+#include <iostream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+namespace soliddb {
+namespace api {
+
+namespace {
+
+/**
+ * Whether a row can be written to a table file: rows are stored one per
+ * line with comma-separated values, which the SQL front end can never
+ * produce inside a value
+ */
+bool isStorable(const std::vector<std::string>& values) {
+    for (const auto& value : values) {
+        if (value.find_first_of(",\r\n") != std::string::npos) {
+            std::cerr << "Error: Value '" << value << "' contains a comma or line break." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+InsertStatement::InsertStatement(Connection& connection, std::string table, size_t columnCount)
+    : connection_(connection), table_(std::move(table)), row_(columnCount) {
+}
+
+InsertStatement& InsertStatement::bind(size_t column, int64_t value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    row_.at(column).assign(buffer, result.ptr);
+    return *this;
+}
+
+InsertStatement& InsertStatement::bind(size_t column, double value) {
+    row_.at(column) = std::to_string(value);
+    return *this;
+}
+
+InsertStatement& InsertStatement::bind(size_t column, std::string_view value) {
+    row_.at(column).assign(value.data(), value.size());
+    return *this;
+}
+
+InsertStatement& InsertStatement::bindNull(size_t column) {
+    row_.at(column).clear();
+    return *this;
+}
+
+bool InsertStatement::execute() {
+    return connection_.insertRow(table_, row_);
+}
+
+void InsertStatement::addBatch() {
+    batch_.push_back(row_);
+}
+
+size_t InsertStatement::executeBatch() {
+    size_t inserted = connection_.insertRows(table_, batch_);
+    batch_.clear();
+    return inserted;
+}
+
+size_t InsertStatement::getBatchSize() const {
+    return batch_.size();
+}
+
+Cursor::Cursor(core::TableCursor cursor, size_t columnCount, int filterColumn, std::string filterValue)
+    : cursor_(std::move(cursor)), columnCount_(columnCount),
+      filterColumn_(filterColumn), filterValue_(std::move(filterValue)) {
+}
+
+bool Cursor::next() {
+    while (cursor_.next()) {
+        if (filterColumn_ < 0 || cursor_.get(filterColumn_) == filterValue_) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Cursor::getColumnCount() const {
+    return columnCount_;
+}
+
+bool Cursor::isNull(size_t column) const {
+    return cursor_.get(checkColumn(column)).empty();
+}
+
+std::string_view Cursor::getString(size_t column) const {
+    return cursor_.get(checkColumn(column));
+}
+
+std::optional<int64_t> Cursor::getInt(size_t column) const {
+    std::string_view text = cursor_.get(checkColumn(column));
+    int64_t value = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::optional<double> Cursor::getDouble(size_t column) const {
+    // strtod needs a terminated string
+    std::string text(cursor_.get(checkColumn(column)));
+    if (text.empty()) {
+        return std::nullopt;
+    }
+
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end != text.c_str() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+size_t Cursor::checkColumn(size_t column) const {
+    if (column >= columnCount_) {
+        throw std::out_of_range("Cursor column " + std::to_string(column) + " out of range");
+    }
+    return column;
+}
+
+std::vector<std::string> Cursor::getRow() const {
+    return cursor_.row();
+}
+
+TableHandle::TableHandle(Connection& connection, std::shared_ptr<core::Table> table)
+    : connection_(connection), table_(std::move(table)) {
+}
+
+std::string TableHandle::getName() const {
+    return table_->getName();
+}
+
+const std::vector<core::ColumnDef>& TableHandle::getColumns() const {
+    return table_->getColumns();
+}
+
+int TableHandle::getColumnIndex(const std::string& columnName) const {
+    return table_->getColumnIndex(columnName);
+}
+
+InsertStatement TableHandle::prepareInsert() {
+    return InsertStatement(connection_, table_->getName(), table_->getColumns().size());
+}
+
+bool TableHandle::insert(const std::vector<std::string>& values) {
+    return connection_.insertRow(table_->getName(), values);
+}
+
+size_t TableHandle::insertBatch(const std::vector<std::vector<std::string>>& rows) {
+    return connection_.insertRows(table_->getName(), rows);
+}
+
+Cursor TableHandle::scan() const {
+    return Cursor(table_->openCursor(connection_.ownMarker()), table_->getColumns().size(), -1, "");
+}
+
+Cursor TableHandle::scanWhere(size_t column, std::string_view value) const {
+    return Cursor(table_->openCursor(connection_.ownMarker()), table_->getColumns().size(),
+                  static_cast<int>(column), std::string(value));
+}
+
+std::unique_ptr<Connection> Connection::open(const std::string& name) {
+    std::shared_ptr<core::Database> database = core::Database::loadFromFile(name);
+    if (!database) {
+        return nullptr;
+    }
+    return std::make_unique<Connection>(std::move(database));
+}
+
+std::unique_ptr<Connection> Connection::create(const std::string& name) {
+    if (fs::exists(name)) {
+        std::cerr << "Error: Database '" << name << "' already exists." << std::endl;
+        return nullptr;
+    }
+    return std::make_unique<Connection>(std::make_shared<core::Database>(name));
+}
+
+Connection::Connection(std::shared_ptr<core::Database> database)
+    : database_(std::move(database)) {
+}
+
+Connection::~Connection() {
+    rollback();
+}
+
+bool Connection::createTable(const std::string& name, const std::vector<core::ColumnDef>& columns) {
+    return database_->createTable(name, columns);
+}
+
+bool Connection::dropTable(const std::string& name) {
+    return database_->dropTable(name);
+}
+
+std::optional<TableHandle> Connection::table(const std::string& name) {
+    auto table = database_->getTable(name);
+    if (!table) {
+        return std::nullopt;
+    }
+    return TableHandle(*this, std::move(table));
+}
+
+bool Connection::begin() {
+    if (transaction_) {
+        return false;
+    }
+    transaction_ = database_->beginTransaction();
+    return true;
+}
+
+bool Connection::commit() {
+    if (!transaction_) {
+        return false;
+    }
+    bool committed = database_->commitTransaction(*transaction_);
+    transaction_.reset();
+    return committed;
+}
+
+void Connection::rollback() {
+    if (transaction_) {
+        database_->rollbackTransaction(*transaction_);
+        transaction_.reset();
+    }
+}
+
+bool Connection::inTransaction() const {
+    return transaction_ != nullptr;
+}
+
+bool Connection::checkpoint() {
+    return database_->checkpoint();
+}
+
+std::shared_ptr<core::Database> Connection::getDatabase() const {
+    return database_;
+}
+
+bool Connection::insertRow(const std::string& table, const std::vector<std::string>& values) {
+    if (!isStorable(values)) {
+        return false;
+    }
+    if (transaction_) {
+        return database_->insert(table, values, *transaction_);
+    }
+    return database_->insert(table, values);
+}
+
+size_t Connection::insertRows(const std::string& table, const std::vector<std::vector<std::string>>& rows) {
+    if (!transaction_) {
+        auto rejected = std::find_if_not(rows.begin(), rows.end(), isStorable);
+        if (rejected == rows.end()) {
+            return database_->insertBatch(table, rows);
+        }
+        // Insert the others; the batch is copied only when a row is rejected
+        std::vector<std::vector<std::string>> storable(rows.begin(), rejected);
+        std::copy_if(std::next(rejected), rows.end(), std::back_inserter(storable), isStorable);
+        return database_->insertBatch(table, storable);
+    }
+
+    size_t inserted = 0;
+    for (const auto& values : rows) {
+        if (isStorable(values) && database_->insert(table, values, *transaction_)) {
+            inserted++;
+        }
+    }
+    return inserted;
+}
+
+uint64_t Connection::ownMarker() const {
+    return transaction_ ? transaction_->marker() : 0;
+}
+
+} // namespace api
+} // namespace soliddb
@@ -0,0 +1,299 @@
+#include "core/BlockCodec.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <thread>
+#include "util/Lz.h"
+#include "util/Varint.h"
+
+namespace soliddb {
+namespace core {
+
+namespace {
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+unsigned bitWidth(uint64_t value) {
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+/**
+ * Offsets from base, all fitting in width bits, packed low bit first
+ */
+void packBits(const std::vector<uint64_t>& offsets, unsigned width, std::string& out) {
+    size_t start = out.size();
+    out.resize(start + (offsets.size() * width + 7) / 8, '\0');
+    auto* bytes = reinterpret_cast<unsigned char*>(&out[start]);
+    
+    size_t bit = 0;
+    for (uint64_t offset : offsets) {
+        for (unsigned written = 0; written < width;) {
+            unsigned shift = bit & 7;
+            unsigned take = std::min(width - written, 8 - shift);
+            bytes[bit >> 3] |= static_cast<unsigned char>(((offset >> written) & ((1u << take) - 1)) << shift);
+            written += take;
+            bit += take;
+        }
+    }
+}
+
+bool unpackBits(std::string_view in, size_t& pos, size_t count, unsigned width, std::vector<uint64_t>& offsets) {
+    size_t bytes = (count * width + 7) / 8;
+    if (width > 64 || bytes > in.size() - pos) {
+        return false;
+    }
+    const auto* data = reinterpret_cast<const unsigned char*>(in.data() + pos);
+    pos += bytes;
+    
+    offsets.assign(count, 0);
+    size_t bit = 0;
+    for (uint64_t& offset : offsets) {
+        for (unsigned read = 0; read < width;) {
+            unsigned shift = bit & 7;
+            unsigned take = std::min(width - read, 8 - shift);
+            offset |= uint64_t((data[bit >> 3] >> shift) & ((1u << take) - 1)) << read;
+            read += take;
+            bit += take;
+        }
+    }
+    return true;
+}
+
+/**
+ * Offsets of values from their minimum (unsigned arithmetic wraps, so any
+ * int64 range round-trips)
+ */
+std::vector<uint64_t> frameOffsets(const std::vector<int64_t>& values, int64_t& base, unsigned& width) {
+    base = *std::min_element(values.begin(), values.end());
+    std::vector<uint64_t> offsets;
+    offsets.reserve(values.size());
+    uint64_t maxOffset = 0;
+    for (int64_t value : values) {
+        offsets.push_back(static_cast<uint64_t>(value) - static_cast<uint64_t>(base));
+        maxOffset = std::max(maxOffset, offsets.back());
+    }
+    width = bitWidth(maxOffset);
+    return offsets;
+}
+
+void encodeIntegers(const std::vector<int64_t>& values, std::string& segment, BlockCodec::Codec& codec) {
+    int64_t frameBase;
+    unsigned frameWidth;
+    auto frame = frameOffsets(values, frameBase, frameWidth);
+    
+    std::vector<int64_t> deltas;
+    deltas.reserve(values.size());
+    for (size_t i = 1; i < values.size(); i++) {
+        deltas.push_back(static_cast<int64_t>(static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(values[i - 1])));
+    }
+    int64_t deltaBase = 0;
+    unsigned deltaWidth = 0;
+    std::vector<uint64_t> deltaOffsets;
+    if (!deltas.empty()) {
+        deltaOffsets = frameOffsets(deltas, deltaBase, deltaWidth);
+    }
+    
+    if (deltaWidth < frameWidth) {
+        codec = BlockCodec::Codec::DELTA_PACK;
+        util::Varint::write(segment, zigzag(values[0]));
+        util::Varint::write(segment, zigzag(deltaBase));
+        segment.push_back(static_cast<char>(deltaWidth));
+        packBits(deltaOffsets, deltaWidth, segment);
+    } else {
+        codec = BlockCodec::Codec::FRAME_PACK;
+        util::Varint::write(segment, zigzag(frameBase));
+        segment.push_back(static_cast<char>(frameWidth));
+        packBits(frame, frameWidth, segment);
+    }
+}
+
+void encodeText(const std::vector<std::string_view>& values, std::string& segment, BlockCodec::Codec& codec) {
+    // Table files never hold newlines in values, so they separate them
+    std::string joined;
+    for (size_t i = 0; i < values.size(); i++) {
+        joined.append(values[i]);
+        if (i + 1 < values.size()) {
+            joined.push_back('\n');
+        }
+    }
+    
+    util::Varint::write(segment, joined.size());
+    size_t header = segment.size();
+    util::Lz::compress(joined.data(), joined.size(), segment);
+    if (segment.size() - header < joined.size()) {
+        codec = BlockCodec::Codec::LZ;
+    } else {
+        codec = BlockCodec::Codec::PLAIN;
+        segment.resize(header);
+        segment += joined;
+    }
+}
+
+bool decodeText(std::string_view text, size_t rowCount, std::vector<std::string>& values) {
+    size_t start = 0;
+    for (size_t i = 0; i < rowCount; i++) {
+        size_t end = i + 1 < rowCount ? text.find('\n', start) : text.size();
+        if (end == std::string_view::npos) {
+            return false;
+        }
+        values.emplace_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return true;
+}
+
+bool decodeColumn(std::string_view segment, BlockCodec::Codec codec, size_t rowCount,
+                  std::vector<std::string>& values) {
+    size_t pos = 0;
+    uint64_t first;
+    uint64_t base;
+    std::vector<uint64_t> offsets;
+    char digits[24];
+    
+    auto appendInteger = [&](int64_t value) {
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        values.emplace_back(digits, result.ptr);
+    };
+    
+    switch (codec) {
+        case BlockCodec::Codec::PLAIN:
+        case BlockCodec::Codec::LZ: {
+            uint64_t rawSize;
+            if (!util::Varint::read(segment, pos, rawSize)) {
+                return false;
+            }
+            if (codec == BlockCodec::Codec::PLAIN) {
+                return segment.size() - pos == rawSize && decodeText(segment.substr(pos), rowCount, values);
+            }
+            // An LZ byte expands to at most 255 bytes; anything more is corrupt
+            if (rawSize / 255 > segment.size() - pos) {
+                return false;
+            }
+            std::string raw(rawSize, '\0');
+            return util::Lz::decompress(segment.data() + pos, segment.size() - pos, raw.data(), raw.size()) &&
+                   decodeText(raw, rowCount, values);
+        }
+        case BlockCodec::Codec::DELTA_PACK: {
+            if (!util::Varint::read(segment, pos, first) || !util::Varint::read(segment, pos, base) || pos >= segment.size()) {
+                return false;
+            }
+            unsigned width = static_cast<unsigned char>(segment[pos++]);
+            if (!unpackBits(segment, pos, rowCount - 1, width, offsets)) {
+                return false;
+            }
+            uint64_t value = static_cast<uint64_t>(unzigzag(first));
+            appendInteger(static_cast<int64_t>(value));
+            for (uint64_t offset : offsets) {
+                value += static_cast<uint64_t>(unzigzag(base)) + offset;
+                appendInteger(static_cast<int64_t>(value));
+            }
+            return true;
+        }
+        case BlockCodec::Codec::FRAME_PACK: {
+            if (!util::Varint::read(segment, pos, base) || pos >= segment.size()) {
+                return false;
+            }
+            unsigned width = static_cast<unsigned char>(segment[pos++]);
+            if (!unpackBits(segment, pos, rowCount, width, offsets)) {
+                return false;
+            }
+            for (uint64_t offset : offsets) {
+                appendInteger(static_cast<int64_t>(static_cast<uint64_t>(unzigzag(base)) + offset));
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+std::string BlockCodec::encodeBlock(const std::vector<Column>& columns, size_t rowCount) {
+    std::string block;
+    util::Varint::write(block, rowCount);
+    
+    std::string segment;
+    for (const auto& column : columns) {
+        segment.clear();
+        Codec codec;
+        if (column.isInteger && rowCount > 0) {
+            encodeIntegers(column.integers, segment, codec);
+        } else {
+            encodeText(column.text, segment, codec);
+        }
+        block.push_back(static_cast<char>(codec));
+        util::Varint::write(block, segment.size());
+        block += segment;
+    }
+    return block;
+}
+
+bool BlockCodec::decodeBlock(std::string_view block, size_t columnCount,
+                             std::vector<std::vector<std::string>>& rows) {
+    size_t pos = 0;
+    uint64_t rowCount;
+    if (!util::Varint::read(block, pos, rowCount) || rowCount == 0 || rowCount > BLOCK_ROWS) {
+        return false;
+    }
+    
+    std::vector<std::vector<std::string>> columns(columnCount);
+    for (auto& values : columns) {
+        uint64_t size;
+        if (pos >= block.size()) {
+            return false;
+        }
+        auto codec = static_cast<Codec>(block[pos++]);
+        if (!util::Varint::read(block, pos, size) || size > block.size() - pos) {
+            return false;
+        }
+        values.reserve(rowCount);
+        if (!decodeColumn(block.substr(pos, size), codec, rowCount, values)) {
+            return false;
+        }
+        pos += size;
+    }
+    
+    rows.assign(rowCount, {});
+    for (size_t row = 0; row < rowCount; row++) {
+        rows[row].reserve(columnCount);
+        for (auto& values : columns) {
+            rows[row].push_back(std::move(values[row]));
+        }
+    }
+    return true;
+}
+
+void BlockCodec::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    size_t threadCount = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+    
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            task(i);
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,224 @@
+#include "core/BufferPool.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "util/Metrics.h"
+
+namespace soliddb {
+namespace core {
+
+BufferPool::PageHandle::~PageHandle() {
+    release();
+}
+
+BufferPool::PageHandle::PageHandle(PageHandle&& other) noexcept
+    : pool_(other.pool_), frame_(other.frame_), id_(other.id_), data_(other.data_), dirty_(other.dirty_) {
+    other.pool_ = nullptr;
+}
+
+BufferPool::PageHandle& BufferPool::PageHandle::operator=(PageHandle&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        frame_ = other.frame_;
+        id_ = other.id_;
+        data_ = other.data_;
+        dirty_ = other.dirty_;
+        other.pool_ = nullptr;
+    }
+    return *this;
+}
+
+void BufferPool::PageHandle::release() {
+    if (pool_) {
+        pool_->unpin(frame_, dirty_);
+        pool_ = nullptr;
+        data_ = nullptr;
+    }
+}
+
+BufferPool::BufferPool(size_t capacityBytes)
+    : capacityPages_(std::max(MIN_FRAMES, capacityBytes / Pager::PAGE_SIZE)) {
+}
+
+BufferPool& BufferPool::instance() {
+    static BufferPool pool;
+    return pool;
+}
+
+void BufferPool::setCapacity(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacityPages_ = std::max(MIN_FRAMES, bytes / Pager::PAGE_SIZE);
+    
+    // Frames are only dropped from the end, so pinned frames keep their index
+    while (frames_.size() > capacityPages_ && frames_.back().pins == 0 && evict(frames_.back())) {
+        frames_.pop_back();
+    }
+    if (hand_ >= frames_.size()) {
+        hand_ = 0;
+    }
+}
+
+size_t BufferPool::getCapacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacityPages_ * Pager::PAGE_SIZE;
+}
+
+BufferPool::PageHandle BufferPool::pin(Pager& pager, Pager::PageId id) {
+    auto& metrics = util::Metrics::instance();
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = pageTable_.find(PageKey{&pager, id});
+    if (it != pageTable_.end()) {
+        Frame& frame = frames_[it->second];
+        frame.pins++;
+        frame.referenced = true;
+        metrics.add(util::Metrics::Counter::PAGE_HITS);
+        return PageHandle(this, it->second, id, frame.data.get(), false);
+    }
+    
+    metrics.add(util::Metrics::Counter::PAGE_MISSES);
+    auto index = claimFrame();
+    if (!index) {
+        std::cerr << "Error: Buffer pool exhausted (all " << frames_.size() << " pages pinned)" << std::endl;
+        return PageHandle();
+    }
+    
+    Frame& frame = frames_[*index];
+    if (!pager.readPage(id, frame.data.get())) {
+        return PageHandle();
+    }
+    frame.pager = &pager;
+    frame.id = id;
+    frame.pins = 1;
+    frame.referenced = true;
+    pageTable_[PageKey{&pager, id}] = *index;
+    return PageHandle(this, *index, id, frame.data.get(), false);
+}
+
+BufferPool::PageHandle BufferPool::pinNew(Pager& pager) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto index = claimFrame();
+    if (!index) {
+        std::cerr << "Error: Buffer pool exhausted (all " << frames_.size() << " pages pinned)" << std::endl;
+        return PageHandle();
+    }
+    
+    Pager::PageId id = pager.allocatePage();
+    Frame& frame = frames_[*index];
+    std::memset(frame.data.get(), 0, Pager::PAGE_SIZE);
+    frame.pager = &pager;
+    frame.id = id;
+    frame.pins = 1;
+    frame.referenced = true;
+    pageTable_[PageKey{&pager, id}] = *index;
+    return PageHandle(this, *index, id, frame.data.get(), true);
+}
+
+bool BufferPool::flush(Pager& pager) {
+    auto& metrics = util::Metrics::instance();
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    // In page order, so a file written for the first time grows sequentially
+    std::vector<Frame*> dirty;
+    for (auto& frame : frames_) {
+        if (frame.pager == &pager && frame.dirty) {
+            dirty.push_back(&frame);
+        }
+    }
+    std::sort(dirty.begin(), dirty.end(), [](const Frame* a, const Frame* b) { return a->id < b->id; });
+    
+    for (Frame* frame : dirty) {
+        if (!pager.writePage(frame->id, frame->data.get())) {
+            return false;
+        }
+        frame->dirty = false;
+        metrics.add(util::Metrics::Counter::PAGE_WRITEBACKS);
+    }
+    return true;
+}
+
+void BufferPool::discard(Pager& pager) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    for (auto& frame : frames_) {
+        if (frame.pager == &pager) {
+            pageTable_.erase(PageKey{&pager, frame.id});
+            frame.pager = nullptr;
+            frame.dirty = false;
+            frame.referenced = false;
+        }
+    }
+}
+
+BufferPool::Usage BufferPool::getUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    Usage usage;
+    usage.capacityPages = capacityPages_;
+    for (const auto& frame : frames_) {
+        if (frame.pager) {
+            usage.residentPages++;
+            usage.dirtyPages += frame.dirty ? 1 : 0;
+            usage.pinnedPages += frame.pins > 0 ? 1 : 0;
+        }
+    }
+    return usage;
+}
+
+void BufferPool::unpin(size_t index, bool dirty) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Frame& frame = frames_[index];
+    frame.pins--;
+    frame.dirty = frame.dirty || dirty;
+}
+
+std::optional<size_t> BufferPool::claimFrame() {
+    if (frames_.size() < capacityPages_) {
+        frames_.emplace_back();
+        return frames_.size() - 1;
+    }
+    
+    // Two sweeps: the first may only clear reference bits
+    for (size_t step = 0; step < 2 * frames_.size(); step++) {
+        size_t index = hand_;
+        hand_ = (hand_ + 1) % frames_.size();
+        Frame& frame = frames_[index];
+    
+        if (frame.pins > 0) {
+            continue;
+        }
+        if (frame.referenced) {
+            frame.referenced = false;
+            continue;
+        }
+        if (evict(frame)) {
+            return index;
+        }
+    }
+    return std::nullopt;
+}
+
+bool BufferPool::evict(Frame& frame) {
+    if (!frame.pager) {
+        return true;
+    }
+    
+    auto& metrics = util::Metrics::instance();
+    if (frame.dirty) {
+        if (!frame.pager->writePage(frame.id, frame.data.get())) {
+            return false;
+        }
+        metrics.add(util::Metrics::Counter::PAGE_WRITEBACKS);
+    }
+    metrics.add(util::Metrics::Counter::PAGE_EVICTIONS);
+    
+    pageTable_.erase(PageKey{frame.pager, frame.id});
+    frame.pager = nullptr;
+    frame.dirty = false;
+    return true;
+}
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,63 @@
+#include "core/ColumnDictionary.h"
+#include "core/RowStore.h"
+
+namespace soliddb {
+namespace core {
+
+ColumnDictionary::ColumnDictionary()
+    : entries_(new std::string[MAX_SIZE]), memoryBytes_(MAX_SIZE * sizeof(std::string)) {
+}
+
+std::optional<uint32_t> ColumnDictionary::encode(const std::string& value) {
+    if (isFrozen()) {
+        return std::nullopt;
+    }
+    
+    auto it = codes_.find(value);
+    if (it != codes_.end()) {
+        return it->second;
+    }
+    
+    size_t code = size_.load(std::memory_order_relaxed);
+    if (code == MAX_SIZE) {
+        freeze();
+        return std::nullopt;
+    }
+    
+    entries_[code] = value;
+    size_t buckets = codes_.bucket_count();
+    codes_.emplace(value, static_cast<uint32_t>(code));
+    size_.store(code + 1, std::memory_order_release);
+    
+    // Each value is held by the entry and by the lookup table node
+    constexpr size_t node = sizeof(void*) + sizeof(std::pair<const std::string, uint32_t>) + sizeof(size_t);
+    memoryBytes_ += 2 * stringHeapBytes(value) + node +
+                    (codes_.bucket_count() - buckets) * sizeof(void*);
+    return static_cast<uint32_t>(code);
+}
+
+std::optional<uint32_t> ColumnDictionary::find(const std::string& value) const {
+    // At most MAX_SIZE entries and called once per query, so a scan is fine
+    size_t count = size();
+    for (size_t code = 0; code < count; code++) {
+        if (entries_[code] == value) {
+            return static_cast<uint32_t>(code);
+        }
+    }
+    return std::nullopt;
+}
+
+void ColumnDictionary::freeze() {
+    frozen_.store(true, std::memory_order_release);
+}
+
+bool ColumnDictionary::isFrozen() const {
+    return frozen_.load(std::memory_order_acquire);
+}
+
+size_t ColumnDictionary::memoryBytes() const {
+    return memoryBytes_.load(std::memory_order_relaxed);
+}
+
+} // namespace core
+} // namespace soliddb
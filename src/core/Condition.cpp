@@ -0,0 +1,83 @@
+#include "core/Condition.h"
+#include <charconv>
+
+namespace soliddb {
+namespace core {
+
+const char* comparisonSymbol(Comparison comparison) {
+    switch (comparison) {
+        case Comparison::EQUAL: return "=";
+        case Comparison::LESS: return "<";
+        case Comparison::LESS_EQUAL: return "<=";
+        case Comparison::GREATER: return ">";
+        case Comparison::GREATER_EQUAL: return ">=";
+    }
+    return "=";
+}
+
+bool parseInteger(std::string_view text, int64_t& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+bool Condition::parse(const std::string& text, Condition& condition) {
+    size_t pos = text.find_first_of("=<>");
+    if (pos == std::string::npos) {
+        return false;
+    }
+    
+    condition.column = text.substr(0, pos);
+    condition.comparison = Comparison::EQUAL;
+    size_t valuePos = pos + 1;
+    if (text[pos] != '=') {
+        bool orEqual = valuePos < text.size() && text[valuePos] == '=';
+        if (text[pos] == '<') {
+            condition.comparison = orEqual ? Comparison::LESS_EQUAL : Comparison::LESS;
+        } else {
+            condition.comparison = orEqual ? Comparison::GREATER_EQUAL : Comparison::GREATER;
+        }
+        valuePos += orEqual ? 1 : 0;
+    }
+    
+    condition.value = text.substr(valuePos);
+    std::string& value = condition.value;
+    if (!value.empty() && value.front() == '"' && value.back() == '"') {
+        value = value.substr(1, value.size() - 2);
+    }
+    return true;
+}
+
+ColumnPredicate ColumnPredicate::plan(const Condition& condition, int column, bool integerColumn) {
+    ColumnPredicate predicate;
+    predicate.column = column;
+    predicate.matchesNothing = column < 0;
+    predicate.comparison = condition.comparison;
+    predicate.value = condition.value;
+    predicate.isInteger = column >= 0 && condition.comparison != Comparison::EQUAL && integerColumn &&
+                          parseInteger(predicate.value, predicate.integer);
+    return predicate;
+}
+
+bool ColumnPredicate::matches(std::string_view text) const {
+    if (matchesNothing || column < 0) {
+        return !matchesNothing;
+    }
+    if (comparison == Comparison::EQUAL) {
+        return text == value;
+    }
+    if (text.empty()) {
+        return false;
+    }
+    if (isInteger) {
+        int64_t rowInteger = 0;
+        return parseInteger(text, rowInteger) && holds(comparison, (rowInteger > integer) - (rowInteger < integer));
+    }
+    return holds(comparison, text.compare(value));
+}
+
+std::string ColumnPredicate::describe(const std::string& columnName) const {
+    return columnName + " " + comparisonSymbol(comparison) + " '" + value + "'";
+}
+
+} // namespace core
+} // namespace soliddb
@@ -4,89 +4,1157 @@
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
+#include <map>
+#include <algorithm>
+#include <cerrno>
+#include <tuple>
+#include <fcntl.h>
+#include <unistd.h>
+#include "util/Console.h"
+#include "util/Metrics.h"
+#include "util/StringUtils.h"
 
 namespace fs = std::filesystem;
 namespace soliddb {
 namespace core {
 
-Database::Database(const std::string& name) : name_(name) {
+namespace {
+
+/**
+ * Redo log record: kind, table and the row's values
+ */
+std::string redoRecord(char kind, const std::string& tableName, const std::vector<std::string>& values) {
+    std::string record(1, kind);
+    record += "\t" + tableName + "\t";
+    for (size_t i = 0; i < values.size(); i++) {
+        record += values[i];
+        if (i < values.size() - 1) {
+            record += ",";
+        }
+    }
+    record += "\n";
+    return record;
+}
+
+} // namespace
+
+Database::Database(const std::string& name)
+    : name_(name), versionManager_(std::make_shared<VersionManager>()) {
     fs::create_directories(name);
+    gcThread_ = std::thread(&Database::garbageCollectorLoop, this);
 }
 
 Database::~Database() {
+    stopGarbageCollector();
+    
     try {
-        checkpoint();
+        if (isDirty()) {
+            checkpoint();
+        }
     } catch (const std::exception& e) {
         std::cerr << "Error during database cleanup: " << e.what() << std::endl;
     }
+    ResultCache::instance().forget(this);
 }
 
 bool Database::createTable(const std::string& tableName, 
-                          const std::vector<core::ColumnDef>& columns) {
-    if (tables_.find(tableName) != tables_.end()) {
+                          const std::vector<core::ColumnDef>& columns, StorageEngine engine) {
+    std::unique_lock<std::shared_mutex> lock(catalogMutex_);
+    
+    if (readOnly_) {
+        std::cout << "Error: Database '" << name_ << "' is open read-only." << std::endl;
+        return false;
+    }
+    
+    if (isCatalogued(tableName)) {
         std::cout << "Error: Table '" << tableName << "' already exists." << std::endl;
         return false;
     }
     
-    tables_[tableName] = std::make_unique<Table>(tableName, columns);
-    std::cout << "Table '" << tableName << "' created with constraints." << std::endl;
+    if (engine == StorageEngine::PAGED) {
+        auto table = PagedTable::create(tableName, columns, name_ + "/" + tableName + ".pages");
+        if (!table) {
+            return false;
+        }
+        pagedTables_[tableName] = std::move(table);
+        catalogVersion_++;
+        util::Console::info() << "Table '" << tableName << "' created with constraints (paged).\n";
+        return true;
+    }
+    
+    if (engine == StorageEngine::LSM) {
+        auto table = LsmTable::create(tableName, columns, name_ + "/" + tableName + ".lsm");
+        if (!table) {
+            return false;
+        }
+        lsmTables_[tableName] = std::move(table);
+        catalogVersion_++;
+        util::Console::info() << "Table '" << tableName << "' created with constraints (LSM).\n";
+        return true;
+    }
+    
+    tables_[tableName] = std::make_shared<Table>(tableName, columns, versionManager_);
+    catalogVersion_++;
+    util::Console::info() << "Table '" << tableName << "' created with constraints.\n";
     return true;
 }
 
 bool Database::createTable(const std::string& tableName, 
                          const std::vector<std::pair<std::string, std::string>>& columns) {
-    if (tables_.find(tableName) != tables_.end()) {
+    std::unique_lock<std::shared_mutex> lock(catalogMutex_);
+    
+    if (readOnly_) {
+        std::cout << "Error: Database '" << name_ << "' is open read-only." << std::endl;
+        return false;
+    }
+    
+    if (isCatalogued(tableName)) {
         std::cout << "Error: Table '" << tableName << "' already exists." << std::endl;
         return false;
     }
     
-    tables_[tableName] = std::make_unique<Table>(tableName, columns);
-    std::cout << "Table '" << tableName << "' created." << std::endl;
+    tables_[tableName] = std::make_shared<Table>(tableName, columns, versionManager_);
+    catalogVersion_++;
+    util::Console::info() << "Table '" << tableName << "' created.\n";
     return true;
 }
 
-bool Database::insert(const std::string& tableName, const std::vector<std::string>& values) {
+bool Database::createPartitionedTable(const std::string& tableName, const std::vector<ColumnDef>& columns,
+                                      const PartitionScheme& scheme) {
+    std::unique_lock<std::shared_mutex> lock(catalogMutex_);
+    
+    if (readOnly_) {
+        std::cout << "Error: Database '" << name_ << "' is open read-only." << std::endl;
+        return false;
+    }
+    
+    if (isCatalogued(tableName)) {
+        std::cout << "Error: Table '" << tableName << "' already exists." << std::endl;
+        return false;
+    }
+    
+    auto table = PartitionedTable::create(tableName, columns, scheme, versionManager_);
+    if (!table) {
+        return false;
+    }
+    partitionedTables_[tableName] = std::move(table);
+    catalogVersion_++;
+    util::Console::info() << "Table '" << tableName << "' created with constraints (partitioned by "
+                          << scheme.describe() << ").\n";
+    return true;
+}
+
+bool Database::isCatalogued(const std::string& tableName) const {
+    return tables_.find(tableName) != tables_.end() || pagedTables_.find(tableName) != pagedTables_.end() ||
+           lsmTables_.find(tableName) != lsmTables_.end() ||
+           partitionedTables_.find(tableName) != partitionedTables_.end() ||
+           mappedTables_.find(tableName) != mappedTables_.end();
+}
+
+bool Database::resultVersion(const std::string& tableName, ResultCache::Version& version) const {
+    std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+    version.catalog = catalogVersion_;
+    if (auto it = tables_.find(tableName); it != tables_.end()) {
+        version.commit = it->second->getLastCommitTimestamp();
+        return true;
+    }
+    if (auto it = partitionedTables_.find(tableName); it != partitionedTables_.end()) {
+        version.commit = it->second->getLastCommitTimestamp();
+        return true;
+    }
+    return false;
+}
+
+bool Database::dropTable(const std::string& tableName) {
+    std::shared_ptr<Table> dropped;
+    std::shared_ptr<PagedTable> droppedPaged;
+    std::shared_ptr<LsmTable> droppedLsm;
+    std::shared_ptr<PartitionedTable> droppedPartitioned;
+    {
+        std::unique_lock<std::shared_mutex> lock(catalogMutex_);
+        
+        auto it = tables_.find(tableName);
+        auto pagedIt = pagedTables_.find(tableName);
+        auto lsmIt = lsmTables_.find(tableName);
+        auto partitionedIt = partitionedTables_.find(tableName);
+        if (it != tables_.end()) {
+            dropped = std::move(it->second);
+            tables_.erase(it);
+        } else if (pagedIt != pagedTables_.end()) {
+            droppedPaged = std::move(pagedIt->second);
+            pagedTables_.erase(pagedIt);
+        } else if (lsmIt != lsmTables_.end()) {
+            droppedLsm = std::move(lsmIt->second);
+            lsmTables_.erase(lsmIt);
+        } else if (partitionedIt != partitionedTables_.end()) {
+            droppedPartitioned = std::move(partitionedIt->second);
+            partitionedTables_.erase(partitionedIt);
+        } else {
+            return false;
+        }
+        catalogVersion_++;
+    }
+    
+    std::error_code ec;
+    if (droppedPaged) {
+        // Statements still using it keep the file open until they finish
+        fs::remove(name_ + "/" + tableName + ".pages", ec);
+    } else if (droppedLsm) {
+        // Stop its compactions before the files go
+        droppedLsm.reset();
+        fs::remove_all(name_ + "/" + tableName + ".lsm", ec);
+    } else if (droppedPartitioned) {
+        for (const auto& partition : droppedPartitioned->getPartitions()) {
+            fs::remove(name_ + "/" + tableName + "." + partition.name + ".tbl", ec);
+        }
+    } else {
+        fs::remove(name_ + "/" + tableName + ".tbl", ec);
+    }
+    return true;
+}
+
+bool Database::dropPartition(const std::string& tableName, const std::string& partitionName) {
+    auto partitioned = getPartitionedTable(tableName);
+    if (!partitioned) {
+        std::cout << "Error: Table '" << tableName << "' is not partitioned." << std::endl;
+        return false;
+    }
+    
+    // Under the catalog lock, so a checkpoint sees the partition gone and the catalog change together
+    {
+        std::unique_lock<std::shared_mutex> lock(catalogMutex_);
+        if (!partitioned->dropPartition(partitionName)) {
+            return false;
+        }
+        catalogVersion_++;
+    }
+    
+    // Save the partition list before the file goes, so a restart cannot
+    // bring the partition back (empty, or refilled from the redo log)
+    checkpoint();
+    std::error_code ec;
+    fs::remove(name_ + "/" + tableName + "." + partitionName + ".tbl", ec);
+    return true;
+}
+
+std::shared_ptr<Table> Database::getTable(const std::string& tableName) const {
+    std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+    
     auto it = tables_.find(tableName);
     if (it == tables_.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+std::shared_ptr<PagedTable> Database::getPagedTable(const std::string& tableName) const {
+    std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+    
+    auto it = pagedTables_.find(tableName);
+    if (it == pagedTables_.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+std::shared_ptr<LsmTable> Database::getLsmTable(const std::string& tableName) const {
+    std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+    
+    auto it = lsmTables_.find(tableName);
+    if (it == lsmTables_.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+std::shared_ptr<PartitionedTable> Database::getPartitionedTable(const std::string& tableName) const {
+    std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+    
+    auto it = partitionedTables_.find(tableName);
+    if (it == partitionedTables_.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+std::shared_ptr<Table> Database::tableForRow(const std::string& tableName,
+                                             const std::vector<std::string>& values) const {
+    if (auto partitioned = getPartitionedTable(tableName)) {
+        return partitioned->partitionFor(values);
+    }
+    return getTable(tableName);
+}
+
+bool Database::insert(const std::string& tableName, const std::vector<std::string>& values) {
+    if (auto paged = getPagedTable(tableName)) {
+        return admitWrite() && paged->insertRow(values);
+    }
+    if (auto lsm = getLsmTable(tableName)) {
+        return admitWrite() && lsm->insertRow(values);
+    }
+    
+    auto table = tableForRow(tableName, values);
+    if (!table || !admitWrite()) {
         return false;
     }
     
-    return it->second->insertRow(values);
+    return table->insertRow(values);
+}
+
+size_t Database::insertBatch(const std::string& tableName,
+                             const std::vector<std::vector<std::string>>& rows) {
+    if (auto paged = getPagedTable(tableName)) {
+        size_t inserted = 0;
+        if (admitWrite()) {
+            for (const auto& row : rows) {
+                inserted += paged->insertRow(row) ? 1 : 0;
+            }
+        }
+        return inserted;
+    }
+    if (auto lsm = getLsmTable(tableName)) {
+        size_t inserted = 0;
+        if (admitWrite()) {
+            for (const auto& row : rows) {
+                inserted += lsm->insertRow(row) ? 1 : 0;
+            }
+        }
+        return inserted;
+    }
+    if (auto partitioned = getPartitionedTable(tableName)) {
+        if (!admitWrite()) {
+            return 0;
+        }
+        // One insertRows() per partition; rows no partition takes are skipped
+        std::map<std::shared_ptr<Table>, std::vector<std::vector<std::string>>> byPartition;
+        for (const auto& row : rows) {
+            if (auto partition = partitioned->partitionFor(row)) {
+                byPartition[partition].push_back(row);
+            }
+        }
+        size_t inserted = 0;
+        for (const auto& [partition, partitionRows] : byPartition) {
+            inserted += partition->insertRows(partitionRows);
+        }
+        return inserted;
+    }
+    
+    auto table = getTable(tableName);
+    if (!table || !admitWrite()) {
+        return 0;
+    }
+    
+    return table->insertRows(rows);
+}
+
+bool Database::update(const std::string& tableName,
+                      const std::vector<std::pair<std::string, std::string>>& assignments,
+                      const std::string& whereCondition, size_t& count) {
+    if (auto paged = getPagedTable(tableName)) {
+        return admitWrite() && paged->updateRows(assignments, whereCondition, count);
+    }
+    if (auto lsm = getLsmTable(tableName)) {
+        return admitWrite() && lsm->updateRows(assignments, whereCondition, count);
+    }
+    if (auto partitioned = getPartitionedTable(tableName)) {
+        if (partitioned->rejectsAssignments(assignments) || !admitWrite()) {
+            return false;
+        }
+        auto partitions = partitioned->partitionsFor(whereCondition);
+        if (partitions.size() != 1) {
+            // Several partitions change at one commit timestamp, or not at all
+            auto transaction = beginTransaction();
+            if (!changePartitions(*partitioned, &assignments, whereCondition, *transaction, count)) {
+                return false;
+            }
+            return commitTransaction(*transaction);
+        }
+        RowChanges changes;
+        if (!partitions.front().table->updateRows(assignments, whereCondition, 0, changes)) {
+            return false;
+        }
+        count = changes.ended.size();
+        return true;
+    }
+    
+    auto table = getTable(tableName);
+    if (!table || !admitWrite()) {
+        return false;
+    }
+    
+    RowChanges changes;
+    if (!table->updateRows(assignments, whereCondition, 0, changes)) {
+        return false;
+    }
+    count = changes.ended.size();
+    return true;
+}
+
+bool Database::deleteRows(const std::string& tableName, const std::string& whereCondition, size_t& count) {
+    // Not subject to the memory budget: deleting is how memory gets freed
+    if (auto paged = getPagedTable(tableName)) {
+        return paged->deleteRows(whereCondition, count);
+    }
+    if (auto lsm = getLsmTable(tableName)) {
+        return lsm->deleteRows(whereCondition, count);
+    }
+    if (auto partitioned = getPartitionedTable(tableName)) {
+        auto partitions = partitioned->partitionsFor(whereCondition);
+        if (partitions.size() != 1) {
+            auto transaction = beginTransaction();
+            if (!changePartitions(*partitioned, nullptr, whereCondition, *transaction, count)) {
+                return false;
+            }
+            return commitTransaction(*transaction);
+        }
+        RowChanges changes;
+        if (!partitions.front().table->deleteRows(whereCondition, 0, changes)) {
+            return false;
+        }
+        count = changes.ended.size();
+        return true;
+    }
+    
+    auto table = getTable(tableName);
+    if (!table) {
+        return false;
+    }
+    
+    RowChanges changes;
+    if (!table->deleteRows(whereCondition, 0, changes)) {
+        return false;
+    }
+    count = changes.ended.size();
+    return true;
 }
 
 std::vector<std::vector<std::string>> Database::select(
     const std::string& tableName, 
     const std::vector<std::string>& columns,
-    const std::string& whereCondition) {
+    const std::string& whereCondition,
+    const Transaction* transaction,
+    QueryPlan* analysis) {
     
-    auto it = tables_.find(tableName);
-    if (it == tables_.end()) {
+    if (readOnly_) {
+        auto mapped = getMappedTable(tableName);
+        return mapped ? mapped->selectRows(columns, whereCondition, analysis)
+                      : std::vector<std::vector<std::string>>{};
+    }
+    
+    // Paged and LSM rows are not versioned: every statement sees the latest values
+    if (auto paged = getPagedTable(tableName)) {
+        return paged->selectRows(columns, whereCondition, analysis);
+    }
+    if (auto lsm = getLsmTable(tableName)) {
+        return lsm->selectRows(columns, whereCondition, analysis);
+    }
+    // Outside transactions, results are cached by the table's write
+    // version. The version is read before the rows: a commit racing the
+    // select changes it, so the entry misses rather than serving the rows
+    // without that commit. It must also be visible already, or the rows
+    // could be read at a snapshot that misses it.
+    ResultCache& cache = ResultCache::instance();
+    ResultCache::Version version;
+    std::string cacheKey;
+    bool cacheable = !transaction && !analysis && cache.isEnabled() && resultVersion(tableName, version) &&
+                     version.commit <= versionManager_->currentTimestamp();
+    if (cacheable) {
+        cacheKey = ResultCache::makeKey(tableName, columns, whereCondition);
+        if (auto rows = cache.lookup(this, cacheKey, version)) {
+            auto& metrics = util::Metrics::instance();
+            metrics.add(util::Metrics::Counter::ROWS_RETURNED, rows->size());
+            if (auto* trace = util::Metrics::activeTrace()) {
+                trace->accessPath = "ResultCache " + tableName;
+            }
+            return *rows;
+        }
+    }
+    
+    std::vector<std::vector<std::string>> results;
+    if (auto partitioned = getPartitionedTable(tableName)) {
+        results = partitioned->selectRows(columns, whereCondition, transaction ? transaction->marker() : 0, analysis);
+    } else if (auto table = getTable(tableName)) {
+        results = table->selectRows(columns, whereCondition, transaction ? transaction->marker() : 0, analysis);
+    } else {
         return {};
     }
     
-    return it->second->selectRows(columns, whereCondition);
+    if (cacheable) {
+        cache.store(this, cacheKey, version, results);
+    }
+    return results;
+}
+
+bool Database::explainSelect(const std::string& tableName, const std::vector<std::string>& columns,
+                             const std::string& whereCondition, QueryPlan& plan) const {
+    if (readOnly_) {
+        auto mapped = getMappedTable(tableName);
+        if (mapped) {
+            plan = mapped->explainSelect(columns, whereCondition);
+        }
+        return mapped != nullptr;
+    }
+    
+    if (auto paged = getPagedTable(tableName)) {
+        plan = paged->explainSelect(columns, whereCondition);
+        return true;
+    }
+    if (auto lsm = getLsmTable(tableName)) {
+        plan = lsm->explainSelect(columns, whereCondition);
+        return true;
+    }
+    if (auto partitioned = getPartitionedTable(tableName)) {
+        plan = partitioned->explainSelect(columns, whereCondition);
+        return true;
+    }
+    
+    auto table = getTable(tableName);
+    if (!table) {
+        return false;
+    }
+    
+    plan = table->explainSelect(columns, whereCondition);
+    return true;
+}
+
+std::unique_ptr<Transaction> Database::beginTransaction() {
+    return std::make_unique<Transaction>(nextTransactionId_++);
+}
+
+bool Database::rejectUnversionedInTransaction(const std::string& tableName) const {
+    if (getPagedTable(tableName)) {
+        std::cout << "Error: Table '" << tableName << "' is paged; paged tables cannot be changed in a transaction."
+                  << std::endl;
+        return true;
+    }
+    if (getLsmTable(tableName)) {
+        std::cout << "Error: Table '" << tableName << "' uses the LSM engine; LSM tables cannot be changed in a "
+                  << "transaction." << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool Database::insert(const std::string& tableName, const std::vector<std::string>& values,
+                      Transaction& transaction) {
+    if (rejectUnversionedInTransaction(tableName)) {
+        return false;
+    }
+    
+    auto table = tableForRow(tableName, values);
+    if (!table || !admitWrite()) {
+        return false;
+    }
+    
+    size_t slot;
+    if (!table->insertUncommitted(values, transaction.marker(), slot)) {
+        return false;
+    }
+    
+    transaction.undoLog_.push_back({table, slot, false});
+    transaction.changeCount_++;
+    transaction.redoLog_ += redoRecord('I', tableName, values);
+    return true;
+}
+
+bool Database::update(const std::string& tableName,
+                      const std::vector<std::pair<std::string, std::string>>& assignments,
+                      const std::string& whereCondition, Transaction& transaction, size_t& count) {
+    if (rejectUnversionedInTransaction(tableName)) {
+        return false;
+    }
+    if (auto partitioned = getPartitionedTable(tableName)) {
+        return !partitioned->rejectsAssignments(assignments) && admitWrite() &&
+               changePartitions(*partitioned, &assignments, whereCondition, transaction, count);
+    }
+    
+    auto table = getTable(tableName);
+    if (!table || !admitWrite()) {
+        return false;
+    }
+    
+    RowChanges changes;
+    if (!table->updateRows(assignments, whereCondition, transaction.marker(), changes)) {
+        return false;
+    }
+    addRedoRecords(transaction, tableName, table, changes);
+    count = changes.ended.size();
+    return true;
+}
+
+bool Database::deleteRows(const std::string& tableName, const std::string& whereCondition,
+                          Transaction& transaction, size_t& count) {
+    if (rejectUnversionedInTransaction(tableName)) {
+        return false;
+    }
+    if (auto partitioned = getPartitionedTable(tableName)) {
+        return changePartitions(*partitioned, nullptr, whereCondition, transaction, count);
+    }
+    
+    auto table = getTable(tableName);
+    if (!table) {
+        return false;
+    }
+    
+    RowChanges changes;
+    if (!table->deleteRows(whereCondition, transaction.marker(), changes)) {
+        return false;
+    }
+    addRedoRecords(transaction, tableName, table, changes);
+    count = changes.ended.size();
+    return true;
+}
+
+bool Database::changePartitions(const PartitionedTable& table,
+                                const std::vector<std::pair<std::string, std::string>>* assignments,
+                                const std::string& whereCondition, Transaction& transaction, size_t& count) {
+    size_t undoSize = transaction.undoLog_.size();
+    size_t redoSize = transaction.redoLog_.size();
+    size_t changeCount = transaction.changeCount_;
+    
+    count = 0;
+    for (const auto& partition : table.partitionsFor(whereCondition)) {
+        RowChanges changes;
+        bool changed = assignments
+            ? partition.table->updateRows(*assignments, whereCondition, transaction.marker(), changes)
+            : partition.table->deleteRows(whereCondition, transaction.marker(), changes);
+        if (!changed) {
+            undoChanges(transaction, undoSize);
+            transaction.redoLog_.resize(redoSize);
+            transaction.changeCount_ = changeCount;
+            count = 0;
+            return false;
+        }
+        // Redo records name the table; replay routes them to the partition again
+        addRedoRecords(transaction, table.getName(), partition.table, changes);
+        count += changes.ended.size();
+    }
+    return true;
+}
+
+void Database::addRedoRecords(Transaction& transaction, const std::string& tableName,
+                              const std::shared_ptr<Table>& table, const RowChanges& changes) {
+    // Deletes are undone after the inserts that replaced them (rollback runs newest first)
+    for (size_t slot : changes.ended) {
+        transaction.undoLog_.push_back({table, slot, true});
+    }
+    for (size_t slot : changes.added) {
+        transaction.undoLog_.push_back({table, slot, false});
+    }
+    transaction.changeCount_ += changes.ended.size();
+    
+    // Replay removes each old row before adding its replacement, which may reuse its key
+    for (const auto& values : changes.endedRows) {
+        transaction.redoLog_ += redoRecord('D', tableName, values);
+    }
+    for (const auto& values : changes.addedRows) {
+        transaction.redoLog_ += redoRecord('I', tableName, values);
+    }
+}
+
+bool Database::commitTransaction(Transaction& transaction) {
+    bool durable = true;
+    
+    if (!transaction.undoLog_.empty()) {
+        VersionManager::CommitGuard commit(*versionManager_);
+        
+        // Redo records are followed by a commit record; replay ignores a
+        // group whose commit record never made it to disk
+        std::string records = transaction.redoLog_ + "C\t" + std::to_string(commit.timestamp()) + "\n";
+        durable = appendToRedoLog(records);
+        
+        if (durable) {
+            for (const auto& entry : transaction.undoLog_) {
+                if (entry.isDelete) {
+                    entry.table->commitDelete(entry.slot, commit.timestamp());
+                } else {
+                    entry.table->commitVersion(entry.slot, commit.timestamp());
+                }
+            }
+            
+            // Keys of deleted rows were kept from other writers until now.
+            // They are dropped before the guard publishes the timestamp, as
+            // the garbage collector may reclaim the rows once it is visible.
+            for (const auto& entry : transaction.undoLog_) {
+                if (entry.isDelete) {
+                    entry.table->releaseDeleted(entry.slot);
+                }
+            }
+        }
+    }
+    
+    if (!durable) {
+        std::cerr << "Error: Failed to write redo log, rolling back transaction" << std::endl;
+        rollbackTransaction(transaction);
+        return false;
+    }
+    
+    if (!transaction.statements_.empty()) {
+        std::lock_guard<std::mutex> walLock(walMutex_);
+        
+        std::string history = "BEGIN\n";
+        for (const auto& statement : transaction.statements_) {
+            history += statement + "\n";
+        }
+        history += "COMMIT\n";
+        
+        std::ofstream logFile(name_ + "/transactions.log", std::ios::app);
+        logFile << history;
+    }
+    
+    transaction.changeCount_ = 0;
+    transaction.undoLog_.clear();
+    transaction.redoLog_.clear();
+    transaction.statements_.clear();
+    return true;
+}
+
+void Database::rollbackTransaction(Transaction& transaction) {
+    undoChanges(transaction, 0);
+    
+    transaction.changeCount_ = 0;
+    transaction.redoLog_.clear();
+    transaction.statements_.clear();
+}
+
+void Database::undoChanges(Transaction& transaction, size_t undoSize) {
+    while (transaction.undoLog_.size() > undoSize) {
+        const auto& entry = transaction.undoLog_.back();
+        if (entry.isDelete) {
+            entry.table->undoDelete(entry.slot);
+        } else {
+            entry.table->undoInsert(entry.slot);
+        }
+        transaction.undoLog_.pop_back();
+    }
+}
+
+std::string Database::redoLogPath() const {
+    return name_ + "/wal.log";
+}
+
+bool Database::appendToRedoLog(const std::string& records) {
+    util::PhaseTimer walTimer(util::Metrics::Phase::WAL);
+    std::lock_guard<std::mutex> lock(redoMutex_);
+    
+    int fd = ::open(redoLogPath().c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    
+    const char* data = records.data();
+    size_t remaining = records.size();
+    bool success = true;
+    
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            success = false;
+            break;
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    
+    // The single flush that makes the transaction durable
+    if (success && ::fdatasync(fd) != 0) {
+        success = false;
+    }
+    
+    ::close(fd);
+    util::Metrics::instance().add(util::Metrics::Counter::BYTES_WRITTEN, records.size() - remaining);
+    return success;
+}
+
+size_t Database::redoLogSize() const {
+    std::error_code ec;
+    auto size = fs::file_size(redoLogPath(), ec);
+    return ec ? 0 : static_cast<size_t>(size);
+}
+
+void Database::truncateRedoLog(size_t offset) const {
+    if (offset == 0) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(redoMutex_);
+    
+    std::ifstream in(redoLogPath(), std::ios::binary);
+    if (!in) {
+        return;
+    }
+    in.seekg(static_cast<std::streamoff>(offset));
+    std::stringstream remaining;
+    remaining << in.rdbuf();
+    in.close();
+    
+    std::string tempPath = redoLogPath() + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out << remaining.str();
+    }
+    fs::rename(tempPath, redoLogPath());
+}
+
+size_t Database::recoverFromRedoLog() {
+    std::ifstream in(redoLogPath());
+    if (!in) {
+        return 0;
+    }
+    
+    // Kind ('I' insert, 'D' delete), table and values of each record
+    std::vector<std::tuple<char, std::string, std::vector<std::string>>> pending;
+    size_t recovered = 0;
+    std::string line;
+    
+    while (std::getline(in, line)) {
+        if (util::StringUtils::startsWith(line, "I\t") || util::StringUtils::startsWith(line, "D\t")) {
+            size_t tab = line.find('\t', 2);
+            if (tab == std::string::npos) {
+                continue;
+            }
+            
+            std::vector<std::string> values;
+            std::stringstream valueStream(line.substr(tab + 1));
+            std::string value;
+            while (std::getline(valueStream, value, ',')) {
+                values.push_back(value);
+            }
+            pending.emplace_back(line[0], line.substr(2, tab - 2), std::move(values));
+        } else if (util::StringUtils::startsWith(line, "C\t")) {
+            for (const auto& [kind, tableName, values] : pending) {
+                auto table = tableForRow(tableName, values);
+                if (!table) {
+                    continue;
+                }
+                if (kind == 'D') {
+                    table->unloadRow(values);
+                } else {
+                    table->loadRow(values);
+                }
+            }
+            pending.clear();
+            recovered++;
+        }
+    }
+    
+    // Records without a commit record belong to a transaction that never committed
+    return recovered;
 }
 
 std::string Database::getName() const {
     return name_;
 }
 
+std::shared_ptr<VersionManager> Database::getVersionManager() const {
+    return versionManager_;
+}
+
+bool Database::isDirty() const {
+    uint64_t catalogVersion;
+    {
+        std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+        catalogVersion = catalogVersion_;
+        for (const auto& [_, table] : pagedTables_) {
+            if (table->isModified()) {
+                return true;
+            }
+        }
+        for (const auto& [_, table] : lsmTables_) {
+            if (table->isModified()) {
+                return true;
+            }
+        }
+    }
+    return catalogVersion != savedCatalogVersion_.load() ||
+           versionManager_->currentTimestamp() > savedTimestamp_.load();
+}
+
+size_t Database::getMemoryUsage() const {
+    std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+    
+    size_t bytes = walBytes_.load();
+    for (const auto& [_, table] : tables_) {
+        bytes += table->getMemoryUsage().total();
+    }
+    for (const auto& [_, table] : pagedTables_) {
+        bytes += table->getMemoryUsage().total();
+    }
+    for (const auto& [_, table] : lsmTables_) {
+        bytes += table->getMemoryUsage().total();
+    }
+    for (const auto& [_, table] : partitionedTables_) {
+        for (const auto& partition : table->getPartitions()) {
+            bytes += partition.table->getMemoryUsage().total();
+        }
+    }
+    return bytes;
+}
+
+DatabaseMemoryUsage Database::getMemoryReport() const {
+    DatabaseMemoryUsage report;
+    report.operationLog = walBytes_.load();
+    {
+        std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+        for (const auto& [tableName, table] : tables_) {
+            report.tables.emplace_back(tableName, table->getMemoryUsage());
+        }
+        for (const auto& [tableName, table] : pagedTables_) {
+            report.tables.emplace_back(tableName, table->getMemoryUsage());
+        }
+        for (const auto& [tableName, table] : lsmTables_) {
+            report.tables.emplace_back(tableName, table->getMemoryUsage());
+        }
+        for (const auto& [tableName, table] : partitionedTables_) {
+            for (const auto& partition : table->getPartitions()) {
+                report.tables.emplace_back(tableName + "." + partition.name, partition.table->getMemoryUsage());
+            }
+        }
+    }
+    std::sort(report.tables.begin(), report.tables.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    return report;
+}
+
+void Database::setMemoryBudget(size_t bytes) {
+    memoryBudget_ = bytes;
+}
+
+size_t Database::getMemoryBudget() const {
+    return memoryBudget_.load();
+}
+
+void Database::setCompression(bool enabled) {
+    std::unique_lock<std::shared_mutex> lock(catalogMutex_);
+    if (compression_ != enabled) {
+        compression_ = enabled;
+        catalogVersion_++;
+    }
+}
+
+bool Database::isCompressionEnabled() const {
+    std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+    return compression_;
+}
+
+bool Database::admitWrite() {
+    size_t budget = memoryBudget_.load();
+    if (budget == 0 || getMemoryUsage() <= budget) {
+        return true;
+    }
+    
+    // Dead versions are the only memory that can be freed without losing data
+    collectGarbage();
+    size_t used = getMemoryUsage();
+    if (used <= budget) {
+        return true;
+    }
+    
+    std::cout << "Error: Memory budget exceeded (" << used / 1024 << " KiB used, budget "
+              << budget / 1024 << " KiB); write rejected." << std::endl;
+    return false;
+}
+
+std::vector<std::shared_ptr<Table>> Database::allTables() const {
+    std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+    
+    std::vector<std::shared_ptr<Table>> tables;
+    for (const auto& [_, table] : tables_) {
+        tables.push_back(table);
+    }
+    for (const auto& [_, table] : partitionedTables_) {
+        for (const auto& partition : table->getPartitions()) {
+            tables.push_back(partition.table);
+        }
+    }
+    return tables;
+}
+
+size_t Database::collectGarbage() {
+    std::vector<std::shared_ptr<Table>> tables = allTables();
+    
+    uint64_t horizon = versionManager_->oldestActiveSnapshot();
+    size_t reclaimed = 0;
+    for (const auto& table : tables) {
+        reclaimed += table->collectGarbage(horizon);
+    }
+    return reclaimed;
+}
+
+size_t Database::compact() {
+    std::vector<std::shared_ptr<Table>> tables = allTables();
+    
+    size_t moved = 0;
+    for (const auto& table : tables) {
+        moved += table->compact();
+    }
+    return moved;
+}
+
+void Database::garbageCollectorLoop() {
+    std::unique_lock<std::mutex> lock(gcMutex_);
+    
+    while (!gcWake_.wait_for(lock, GC_INTERVAL, [this] { return gcStopping_; })) {
+        lock.unlock();
+        try {
+            collectGarbage();
+            compact();
+        } catch (const std::exception& e) {
+            std::cerr << "Error during garbage collection: " << e.what() << std::endl;
+        }
+        lock.lock();
+    }
+}
+
+void Database::stopGarbageCollector() {
+    {
+        std::lock_guard<std::mutex> lock(gcMutex_);
+        gcStopping_ = true;
+    }
+    gcWake_.notify_all();
+    
+    if (gcThread_.joinable()) {
+        gcThread_.join();
+    }
+}
+
 std::vector<std::string> Database::getTableNames() const {
+    std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+    
     std::vector<std::string> names;
     names.reserve(tables_.size());
     
     for (const auto& [name, _] : tables_) {
         names.push_back(name);
     }
+    for (const auto& [name, _] : pagedTables_) {
+        names.push_back(name);
+    }
+    for (const auto& [name, _] : lsmTables_) {
+        names.push_back(name);
+    }
+    for (const auto& [name, _] : partitionedTables_) {
+        names.push_back(name);
+    }
+    for (const auto& [name, _] : mappedTables_) {
+        names.push_back(name);
+    }
     
     return names;
 }
 
 bool Database::tableExists(const std::string& tableName) const {
-    return tables_.find(tableName) != tables_.end();
+    std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+    return isCatalogued(tableName);
+}
+
+bool Database::isReadOnly() const {
+    return readOnly_;
+}
+
+std::shared_ptr<MappedTable> Database::getMappedTable(const std::string& tableName) const {
+    auto it = mappedTables_.find(tableName);
+    return it == mappedTables_.end() ? nullptr : it->second;
+}
+
+bool Database::exportReadOnly() const {
+    std::vector<std::pair<std::string, std::shared_ptr<Table>>> tables;
+    {
+        std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+        tables.assign(tables_.begin(), tables_.end());
+        for (const auto& [tableName, _] : pagedTables_) {
+            std::cerr << "Warning: Paged table " << tableName << " is not exported" << std::endl;
+        }
+        for (const auto& [tableName, _] : lsmTables_) {
+            std::cerr << "Warning: LSM table " << tableName << " is not exported" << std::endl;
+        }
+        for (const auto& [tableName, _] : partitionedTables_) {
+            std::cerr << "Warning: Partitioned table " << tableName << " is not exported" << std::endl;
+        }
+    }
+    
+    for (const auto& [tableName, table] : tables) {
+        if (!MappedTable::write(*table, name_ + "/" + tableName + ".ro")) {
+            std::cerr << "Error: Failed to export table " << tableName << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<Database> Database::openReadOnly(const std::string& name) {
+    std::ifstream metaFile(name + "/metadata.db");
+    if (!metaFile) {
+        std::cerr << "Error: Metadata file not found: " << name << "/metadata.db" << std::endl;
+        return nullptr;
+    }
+    
+    auto db = std::make_unique<Database>(name);
+    db->readOnly_ = true;
+    
+    int tableCount = 0;
+    metaFile >> tableCount;
+    metaFile.ignore();
+    for (int i = 0; i < tableCount; i++) {
+        std::string tableName;
+        std::getline(metaFile, tableName);
+        
+        auto table = MappedTable::open(name + "/" + tableName + ".ro");
+        if (!table) {
+            std::cerr << "Warning: No read-only file for table " << tableName
+                      << " (run EXPORT READONLY on a writable copy)" << std::endl;
+            continue;
+        }
+        db->mappedTables_[tableName] = std::move(table);
+    }
+    
+    // Nothing to save when it closes
+    db->savedTimestamp_ = db->versionManager_->currentTimestamp();
+    db->savedCatalogVersion_ = db->catalogVersion_;
+    return db;
 }
 
 bool Database::saveToFile() const {
+    if (readOnly_) {
+        // The mapped files are the database; there is nothing else to write
+        return true;
+    }
+    
+    util::PhaseTimer checkpointTimer(util::Metrics::Phase::CHECKPOINT);
+    std::lock_guard<std::mutex> saveLock(saveMutex_);
+    
+    // Work on a snapshot of the catalog so tables can be created meanwhile
+    std::vector<std::pair<std::string, std::shared_ptr<Table>>> tables;
+    std::vector<std::pair<std::string, std::shared_ptr<PagedTable>>> pagedTables;
+    std::vector<std::pair<std::string, std::shared_ptr<LsmTable>>> lsmTables;
+    std::vector<std::pair<std::string, std::shared_ptr<PartitionedTable>>> partitionedTables;
+    std::vector<std::vector<Partition>> partitions;  // Of each partitioned table
+    uint64_t catalogVersion;
+    bool compression;
+    {
+        std::shared_lock<std::shared_mutex> lock(catalogMutex_);
+        tables.assign(tables_.begin(), tables_.end());
+        pagedTables.assign(pagedTables_.begin(), pagedTables_.end());
+        lsmTables.assign(lsmTables_.begin(), lsmTables_.end());
+        partitionedTables.assign(partitionedTables_.begin(), partitionedTables_.end());
+        for (const auto& [_, table] : partitionedTables) {
+            partitions.push_back(table->getPartitions());
+        }
+        catalogVersion = catalogVersion_;
+        compression = compression_;
+    }
+    
+    // All tables are written at one snapshot. The redo log records written
+    // before it are exactly the commits it contains.
+    size_t coveredRedoBytes = 0;
+    auto snapshot = versionManager_->openSnapshotExclusive([&](uint64_t) {
+        std::lock_guard<std::mutex> lock(redoMutex_);
+        coveredRedoBytes = redoLogSize();
+    });
+    
     try {
         fs::create_directories(name_);
         
@@ -99,40 +1167,117 @@ bool Database::saveToFile() const {
             return false;
         }
         
-        metaFile << tables_.size() << std::endl;
-        for (const auto& [tableName, _] : tables_) {
+        metaFile << tables.size() + pagedTables.size() + lsmTables.size() + partitionedTables.size() << std::endl;
+        for (const auto& [tableName, _] : tables) {
+            metaFile << tableName << std::endl;
+        }
+        for (const auto& [tableName, _] : pagedTables) {
+            metaFile << tableName << std::endl;
+        }
+        for (const auto& [tableName, _] : lsmTables) {
             metaFile << tableName << std::endl;
         }
+        for (const auto& [tableName, _] : partitionedTables) {
+            metaFile << tableName << std::endl;
+        }
+        if (compression) {
+            metaFile << "COMPRESSION ON" << std::endl;
+        }
+        for (const auto& [tableName, _] : pagedTables) {
+            metaFile << "ENGINE " << tableName << " PAGED" << std::endl;
+        }
+        for (const auto& [tableName, _] : lsmTables) {
+            metaFile << "ENGINE " << tableName << " LSM" << std::endl;
+        }
+        for (const auto& [tableName, table] : partitionedTables) {
+            const PartitionScheme& scheme = table->getScheme();
+            metaFile << "PARTITION " << tableName << " " << scheme.column;
+            if (scheme.kind == PartitionScheme::Kind::HASH) {
+                metaFile << " HASH " << scheme.count;
+            } else {
+                metaFile << " RANGE";
+                for (const auto& bound : scheme.bounds) {
+                    metaFile << " " << bound;
+                }
+            }
+            metaFile << std::endl;
+            for (const auto& partitionName : table->getDroppedPartitions()) {
+                metaFile << "DROPPED " << tableName << " " << partitionName << std::endl;
+            }
+        }
         metaFile.close();
         
+        // Partitions are written like tables, but only if they changed since
+        // their file was written
+        std::vector<std::pair<std::shared_ptr<PartitionedTable>, std::string>> savedPartitions;
+        for (size_t i = 0; i < partitionedTables.size(); i++) {
+            const auto& [tableName, table] = partitionedTables[i];
+            for (const auto& partition : partitions[i]) {
+                std::string fileName = tableName + "." + partition.name;
+                if (partition.saved && partition.table->getLastCommitTimestamp() <= partition.savedTs &&
+                    fs::exists(name_ + "/" + fileName + ".tbl")) {
+                    continue;
+                }
+                tables.emplace_back(fileName, partition.table);
+                savedPartitions.emplace_back(table, partition.name);
+            }
+        }
+        
+        // Paged tables are written in place: their changed pages are flushed.
+        // LSM tables only sync their logs; their runs are already on disk.
         bool allTablesSuccess = true;
-        for (const auto& [tableName, table] : tables_) {
+        for (const auto& [_, table] : pagedTables) {
+            if (!table->flush()) {
+                allTablesSuccess = false;
+                break;
+            }
+        }
+        for (const auto& [_, table] : lsmTables) {
+            if (allTablesSuccess && !table->flush()) {
+                allTablesSuccess = false;
+            }
+        }
+        
+        for (const auto& [tableName, table] : tables) {
+            if (!allTablesSuccess) {
+                break;
+            }
             std::string tempTableFile = name_ + "/" + tableName + ".tbl.tmp";
-            std::ofstream tableFile(tempTableFile);
+            std::ofstream tableFile(tempTableFile, std::ios::binary);
             if (!tableFile) {
                 std::cerr << "Error: Failed to open table file " << tableName << " for writing" << std::endl;
                 allTablesSuccess = false;
                 break;
             }
-            tableFile << table->serialize();
+            std::string data = table->serialize(snapshot.timestamp(), compression);
+            tableFile << data;
             tableFile.close();
+            util::Metrics::instance().add(util::Metrics::Counter::BYTES_WRITTEN, data.size());
         }
         
         if (allTablesSuccess) {
             fs::rename(tempMetaFile, name_ + "/metadata.db");
             
-            for (const auto& [tableName, _] : tables_) {
+            for (const auto& [tableName, _] : tables) {
                 std::string tempTableFile = name_ + "/" + tableName + ".tbl.tmp";
                 std::string finalTableFile = name_ + "/" + tableName + ".tbl";
                 fs::rename(tempTableFile, finalTableFile);
             }
+            
+            for (const auto& [table, partitionName] : savedPartitions) {
+                table->markSaved(partitionName, snapshot.timestamp());
+            }
+            
+            truncateRedoLog(coveredRedoBytes);
+            savedTimestamp_ = snapshot.timestamp();
+            savedCatalogVersion_ = catalogVersion;
             return true;
         } else {
             if (fs::exists(tempMetaFile)) {
                 fs::remove(tempMetaFile);
             }
             
-            for (const auto& [tableName, _] : tables_) {
+            for (const auto& [tableName, _] : tables) {
                 std::string tempTableFile = name_ + "/" + tableName + ".tbl.tmp";
                 if (fs::exists(tempTableFile)) {
                     fs::remove(tempTableFile);
@@ -159,6 +1304,8 @@ std::unique_ptr<Database> Database::loadFromFile(const std::string& name) {
             return nullptr;
         }
         
+        // The garbage collector already runs, so every change to the
+        // catalog below takes catalogMutex_
         auto db = std::make_unique<Database>(name);
         
         std::ifstream metaFile(metadataPath);
@@ -171,9 +1318,103 @@ std::unique_ptr<Database> Database::loadFromFile(const std::string& name) {
         metaFile >> tableCount;
         metaFile.ignore();
         
-        for (int i = 0; i < tableCount; i++) {
-            std::string tableName;
+        std::vector<std::string> tableNames(std::max(tableCount, 0));
+        for (auto& tableName : tableNames) {
             std::getline(metaFile, tableName);
+        }
+        
+        // Settings follow the table names
+        std::unordered_map<std::string, std::string> engines;
+        std::unordered_map<std::string, PartitionScheme> schemes;
+        std::unordered_map<std::string, std::vector<std::string>> droppedPartitions;
+        std::string setting;
+        while (std::getline(metaFile, setting)) {
+            if (setting == "COMPRESSION ON") {
+                std::unique_lock<std::shared_mutex> lock(db->catalogMutex_);
+                db->compression_ = true;
+            } else if (setting.rfind("ENGINE ", 0) == 0) {
+                std::stringstream settingStream(setting.substr(7));
+                std::string tableName, engine;
+                settingStream >> tableName >> engine;
+                engines[tableName] = engine;
+            } else if (setting.rfind("PARTITION ", 0) == 0) {
+                std::stringstream settingStream(setting.substr(10));
+                std::string tableName, kind;
+                PartitionScheme scheme;
+                settingStream >> tableName >> scheme.column >> kind;
+                if (kind == "HASH") {
+                    settingStream >> scheme.count;
+                } else {
+                    scheme.kind = PartitionScheme::Kind::RANGE;
+                    for (std::string bound; settingStream >> bound;) {
+                        scheme.bounds.push_back(bound);
+                    }
+                }
+                schemes[tableName] = scheme;
+            } else if (setting.rfind("DROPPED ", 0) == 0) {
+                std::stringstream settingStream(setting.substr(8));
+                std::string tableName, partitionName;
+                settingStream >> tableName >> partitionName;
+                droppedPartitions[tableName].push_back(partitionName);
+            }
+        }
+        
+        for (const auto& tableName : tableNames) {
+            auto scheme = schemes.find(tableName);
+            if (scheme != schemes.end()) {
+                const std::vector<std::string>& dropped = droppedPartitions[tableName];
+                std::vector<std::pair<std::string, std::shared_ptr<Table>>> loaded;
+                for (size_t i = 0; i < scheme->second.partitionCount(); i++) {
+                    std::string partitionName = "p" + std::to_string(i);
+                    std::string partitionPath = name + "/" + tableName + "." + partitionName + ".tbl";
+                    std::ifstream partitionFile(partitionPath, std::ios::binary);
+                    if (std::find(dropped.begin(), dropped.end(), partitionName) != dropped.end() || !partitionFile) {
+                        continue;
+                    }
+                    std::stringstream buffer;
+                    buffer << partitionFile.rdbuf();
+                    if (auto partition = Table::deserialize(buffer.str(), db->versionManager_)) {
+                        loaded.emplace_back(partitionName, std::move(partition));
+                    } else {
+                        std::cerr << "Warning: Failed to deserialize partition " << partitionName << " of table "
+                                  << tableName << std::endl;
+                    }
+                }
+                
+                auto table = PartitionedTable::restore(tableName, scheme->second, loaded, dropped, db->versionManager_);
+                if (table) {
+                    std::unique_lock<std::shared_mutex> lock(db->catalogMutex_);
+                    db->partitionedTables_[tableName] = std::move(table);
+                    util::Console::info() << "Loaded partitioned table: " << tableName << "\n";
+                } else {
+                    std::cerr << "Warning: No partition of table " << tableName << " could be loaded" << std::endl;
+                }
+                continue;
+            }
+            
+            auto engine = engines.find(tableName);
+            if (engine != engines.end() && engine->second == "LSM") {
+                auto table = LsmTable::open(name + "/" + tableName + ".lsm");
+                if (table) {
+                    std::unique_lock<std::shared_mutex> lock(db->catalogMutex_);
+                    db->lsmTables_[tableName] = std::move(table);
+                    util::Console::info() << "Opened LSM table: " << tableName << "\n";
+                } else {
+                    std::cerr << "Warning: Failed to open LSM table: " << tableName << std::endl;
+                }
+                continue;
+            }
+            if (engine != engines.end() && engine->second == "PAGED") {
+                auto table = PagedTable::open(name + "/" + tableName + ".pages");
+                if (table) {
+                    std::unique_lock<std::shared_mutex> lock(db->catalogMutex_);
+                    db->pagedTables_[tableName] = std::move(table);
+                    util::Console::info() << "Opened paged table: " << tableName << "\n";
+                } else {
+                    std::cerr << "Warning: Failed to open paged table: " << tableName << std::endl;
+                }
+                continue;
+            }
             
             std::string tableFilePath = name + "/" + tableName + ".tbl";
             if (!fs::exists(tableFilePath)) {
@@ -181,7 +1422,7 @@ std::unique_ptr<Database> Database::loadFromFile(const std::string& name) {
                 continue;
             }
             
-            std::ifstream tableFile(tableFilePath);
+            std::ifstream tableFile(tableFilePath, std::ios::binary);
             if (!tableFile) {
                 std::cerr << "Warning: Failed to open table file: " << tableFilePath << std::endl;
                 continue;
@@ -189,16 +1430,31 @@ std::unique_ptr<Database> Database::loadFromFile(const std::string& name) {
             
             std::stringstream buffer;
             buffer << tableFile.rdbuf();
-            auto table = Table::deserialize(buffer.str());
+            auto table = Table::deserialize(buffer.str(), db->versionManager_);
             
             if (table) {
+                std::unique_lock<std::shared_mutex> lock(db->catalogMutex_);
                 db->tables_[tableName] = std::move(table);
-                std::cout << "Loaded table: " << tableName << std::endl;
+                util::Console::info() << "Loaded table: " << tableName << "\n";
             } else {
                 std::cerr << "Warning: Failed to deserialize table: " << tableName << std::endl;
             }
         }
         
+        size_t recovered = db->recoverFromRedoLog();
+        if (recovered > 0) {
+            util::Console::info() << "Recovered " << recovered << " committed transaction(s) from redo log\n";
+        } else {
+            // Exactly what is on disk: closing it again needs no checkpoint
+            db->savedTimestamp_ = db->versionManager_->currentTimestamp();
+            db->savedCatalogVersion_ = db->catalogVersion_;
+            for (const auto& [_, table] : db->partitionedTables_) {
+                for (const auto& partition : table->getPartitions()) {
+                    table->markSaved(partition.name, db->savedTimestamp_);
+                }
+            }
+        }
+        
         return db;
     } catch (const std::exception& e) {
         std::cerr << "Error loading database: " << e.what() << std::endl;
@@ -207,42 +1463,63 @@ std::unique_ptr<Database> Database::loadFromFile(const std::string& name) {
 }
 
 void Database::logOperation(const std::string& operation) {
-    wal_.push_back(operation);
-    
-    operationsSinceCheckpoint_++;
+    if (readOnly_) {
+        return;
+    }
     
-    try {
-        std::string logFilePath = name_ + "/transactions.log";
+    {
+        util::PhaseTimer walTimer(util::Metrics::Phase::WAL);
+        std::lock_guard<std::mutex> walLock(walMutex_);
+        wal_.push_back(operation);
+        walBytes_ += sizeof(std::string) + stringHeapBytes(wal_.back());
         
-        std::ofstream logFile(logFilePath, std::ios::app);
-        if (logFile) {
-            logFile << operation << std::endl;
-        } else {
-            std::cerr << "Warning: Failed to write to transaction log file" << std::endl;
+        try {
+            std::string logFilePath = name_ + "/transactions.log";
+            
+            std::ofstream logFile(logFilePath, std::ios::app);
+            if (logFile) {
+                logFile << operation << std::endl;
+                util::Metrics::instance().add(util::Metrics::Counter::BYTES_WRITTEN, operation.size() + 1);
+            } else {
+                std::cerr << "Warning: Failed to write to transaction log file" << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error logging operation: " << e.what() << std::endl;
         }
-    } catch (const std::exception& e) {
-        std::cerr << "Error logging operation: " << e.what() << std::endl;
     }
     
-    if (operationsSinceCheckpoint_ >= 5) {
+    if (++operationsSinceCheckpoint_ >= 5) {
         checkpoint();
     }
 }
 
-bool Database::checkpoint() const {
-    std::cout << "Performing checkpoint..." << std::endl;
+bool Database::checkpoint() {
+    util::Console::info() << "Performing checkpoint...\n";
+    
+    // Only what was logged before the save started is covered by it
+    size_t coveredEntries;
+    int coveredOperations;
+    {
+        std::lock_guard<std::mutex> walLock(walMutex_);
+        coveredEntries = wal_.size();
+        coveredOperations = operationsSinceCheckpoint_.load();
+    }
     
     bool success = saveToFile();
     
     if (success) {
-        // reset the operations counter 
-        Database* nonConstThis = const_cast<Database*>(this);
-        nonConstThis->operationsSinceCheckpoint_ = 0;
+        operationsSinceCheckpoint_ -= coveredOperations;
         
-        // clear the WAL after  checkpoint
-        nonConstThis->wal_.clear();
+        {
+            std::lock_guard<std::mutex> walLock(walMutex_);
+            auto coveredEnd = wal_.begin() + std::min(coveredEntries, wal_.size());
+            for (auto it = wal_.begin(); it != coveredEnd; ++it) {
+                walBytes_ -= sizeof(std::string) + stringHeapBytes(*it);
+            }
+            wal_.erase(wal_.begin(), coveredEnd);
+        }
         
-        std::cout << "Checkpoint completed successfully" << std::endl;
+        util::Console::info() << "Checkpoint completed successfully\n";
     } else {
         std::cerr << "Checkpoint failed" << std::endl;
     }
@@ -0,0 +1,197 @@
+#include "core/DatabaseRegistry.h"
+#include "util/Console.h"
+
+namespace soliddb {
+namespace core {
+
+DatabaseRegistry::DatabaseRegistry(size_t memoryBudget)
+    : memoryBudget_(memoryBudget) {
+}
+
+DatabaseRegistry::~DatabaseRegistry() {
+    closeAll();
+}
+
+std::shared_ptr<Database> DatabaseRegistry::open(const std::string& name) {
+    std::shared_ptr<Database> db;
+    std::vector<Closing> evicted;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waitUntilClosedLocked(lock, name);
+        
+        auto it = databases_.find(name);
+        if (it != databases_.end()) {
+            touchLocked(it->second);
+            return it->second.database;
+        }
+        
+        db = std::shared_ptr<Database>(loadLocked(name).release());
+        if (!db) {
+            return nullptr;
+        }
+        insertLocked(name, db);
+        evicted = collectEvictionsLocked();
+    }
+    // Evicted databases are destroyed (and checkpointed) outside the lock
+    finishClosing(evicted);
+    return db;
+}
+
+std::shared_ptr<Database> DatabaseRegistry::create(const std::string& name) {
+    std::shared_ptr<Database> db;
+    std::vector<Closing> evicted;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waitUntilClosedLocked(lock, name);
+        
+        auto it = databases_.find(name);
+        if (it != databases_.end()) {
+            touchLocked(it->second);
+            return it->second.database;
+        }
+        if (readOnly_) {
+            return nullptr;
+        }
+        
+        db = insertLocked(name, std::make_shared<Database>(name));
+        evicted = collectEvictionsLocked();
+    }
+    finishClosing(evicted);
+    return db;
+}
+
+std::shared_ptr<Database> DatabaseRegistry::find(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = databases_.find(name);
+    if (it == databases_.end()) {
+        return nullptr;
+    }
+    return it->second.database;
+}
+
+std::vector<std::string> DatabaseRegistry::getOpenDatabases() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::vector<std::string>(lru_.begin(), lru_.end());
+}
+
+void DatabaseRegistry::setMemoryBudget(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        memoryBudget_ = bytes;
+    }
+    evict();
+}
+
+size_t DatabaseRegistry::getMemoryBudget() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memoryBudget_;
+}
+
+void DatabaseRegistry::setDatabaseMemoryBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    databaseMemoryBudget_ = bytes;
+    for (auto& [_, entry] : databases_) {
+        entry.database->setMemoryBudget(bytes);
+    }
+}
+
+size_t DatabaseRegistry::getDatabaseMemoryBudget() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return databaseMemoryBudget_;
+}
+
+void DatabaseRegistry::setReadOnly(bool readOnly) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    readOnly_ = readOnly;
+}
+
+bool DatabaseRegistry::isReadOnly() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return readOnly_;
+}
+
+size_t DatabaseRegistry::evict() {
+    std::vector<Closing> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        evicted = collectEvictionsLocked();
+    }
+    finishClosing(evicted);
+    return evicted.size();
+}
+
+void DatabaseRegistry::closeAll() {
+    std::vector<Closing> closing;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [name, entry] : databases_) {
+            closing_.insert(name);
+            closing.push_back(Closing{name, std::move(entry.database)});
+        }
+        databases_.clear();
+        lru_.clear();
+    }
+    // Databases are destroyed (and checkpointed) outside the lock
+    finishClosing(closing);
+}
+
+void DatabaseRegistry::waitUntilClosedLocked(std::unique_lock<std::mutex>& lock, const std::string& name) {
+    closed_.wait(lock, [&] { return closing_.find(name) == closing_.end(); });
+}
+
+void DatabaseRegistry::finishClosing(std::vector<Closing>& closing) {
+    for (auto& entry : closing) {
+        entry.database.reset();
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_.erase(entry.name);
+    }
+    if (!closing.empty()) {
+        closed_.notify_all();
+    }
+}
+
+std::unique_ptr<Database> DatabaseRegistry::loadLocked(const std::string& name) const {
+    return readOnly_ ? Database::openReadOnly(name) : Database::loadFromFile(name);
+}
+
+std::shared_ptr<Database> DatabaseRegistry::insertLocked(const std::string& name,
+                                                         std::shared_ptr<Database> database) {
+    database->setMemoryBudget(databaseMemoryBudget_);
+    lru_.push_front(name);
+    databases_[name] = Entry{database, lru_.begin()};
+    return database;
+}
+
+void DatabaseRegistry::touchLocked(Entry& entry) {
+    lru_.splice(lru_.begin(), lru_, entry.lruPosition);
+}
+
+std::vector<DatabaseRegistry::Closing> DatabaseRegistry::collectEvictionsLocked() {
+    size_t total = 0;
+    for (const auto& [_, entry] : databases_) {
+        total += entry.database->getMemoryUsage();
+    }
+    
+    std::vector<Closing> evicted;
+    for (auto it = lru_.rbegin(); it != lru_.rend() && total > memoryBudget_;) {
+        auto entry = databases_.find(*it);
+        
+        // A database a session is still using cannot be closed
+        if (entry->second.database.use_count() > 1) {
+            ++it;
+            continue;
+        }
+        
+        util::Console::info() << "Closing database '" << *it << "' (cache over budget)\n";
+        total -= std::min(total, entry->second.database->getMemoryUsage());
+        closing_.insert(*it);
+        evicted.push_back(Closing{*it, std::move(entry->second.database)});
+        databases_.erase(entry);
+        it = std::make_reverse_iterator(lru_.erase(std::next(it).base()));
+    }
+    return evicted;
+}
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,69 @@
+#include "core/KeyIndex.h"
+#include <algorithm>
+
+namespace soliddb {
+namespace core {
+
+void KeyIndex::allocate(size_t entries) {
+    size_t capacity = GROUP_SIZE;
+    while (entries * 8 > capacity * 7) {
+        capacity *= 2;
+    }
+    
+    control_.assign(capacity, EMPTY);
+    slots_.assign(capacity, 0);
+    size_ = 0;
+    growthLeft_ = capacity / 8 * 7;
+}
+
+std::vector<size_t> KeyIndex::usedSlots() const {
+    std::vector<size_t> used;
+    used.reserve(size_);
+    for (size_t i = 0; i < slots_.size(); i++) {
+        if (control_[i] >= 0) {
+            used.push_back(slots_[i]);
+        }
+    }
+    std::sort(used.begin(), used.end());
+    return used;
+}
+
+void KeyIndex::place(uint64_t hash, size_t slot) {
+    size_t groupMask = slots_.size() / GROUP_SIZE - 1;
+    size_t group = (hash >> 7) & groupMask;
+    uint32_t unused = matchUnused(&control_[group * GROUP_SIZE]);
+    for (size_t step = 1; unused == 0; step++) {
+        group = (group + step) & groupMask;
+        unused = matchUnused(&control_[group * GROUP_SIZE]);
+    }
+    
+    size_t position = group * GROUP_SIZE + static_cast<size_t>(__builtin_ctz(unused));
+    if (control_[position] == EMPTY) {
+        growthLeft_--;
+    }
+    control_[position] = tagOf(hash);
+    slots_[position] = slot;
+    size_++;
+}
+
+bool KeyIndex::erase(uint64_t hash, size_t slot) {
+    size_t position = find(hash, [slot](size_t candidate) { return candidate == slot; });
+    if (position == NOT_FOUND) {
+        return false;
+    }
+    
+    // A lookup stops at a group with a free entry, so if this group has one
+    // no probe sequence runs past it and the entry can be freed outright
+    size_t group = position - position % GROUP_SIZE;
+    if (matchTag(&control_[group], EMPTY) != 0) {
+        control_[position] = EMPTY;
+        growthLeft_++;
+    } else {
+        control_[position] = DELETED;
+    }
+    size_--;
+    return true;
+}
+
+} // namespace core
+} // namespace soliddb
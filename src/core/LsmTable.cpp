@@ -0,0 +1,1120 @@
+#include "core/LsmTable.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <shared_mutex>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include "util/Metrics.h"
+#include "util/StringUtils.h"
+#include "util/Varint.h"
+
+namespace fs = std::filesystem;
+namespace soliddb {
+namespace core {
+
+namespace {
+
+constexpr const char* MANIFEST_MAGIC = "SDBLSM01";
+
+// Big-endian, so byte order is numeric order
+std::string encodeSequence(uint64_t value) {
+    std::string key(sizeof(value), '\0');
+    for (size_t i = 0; i < sizeof(value); i++) {
+        key[i] = static_cast<char>(value >> (8 * (sizeof(value) - 1 - i)));
+    }
+    return key;
+}
+
+uint64_t decodeSequence(std::string_view key) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < key.size() && i < sizeof(value); i++) {
+        value = (value << 8) | static_cast<unsigned char>(key[i]);
+    }
+    return value;
+}
+
+std::string_view rowValue(std::string_view row, size_t column) {
+    size_t pos = 0;
+    for (size_t i = 0;; i++) {
+        uint64_t length;
+        if (!util::Varint::read(row, pos, length) || length > row.size() - pos) {
+            return {};
+        }
+        if (i == column) {
+            return row.substr(pos, length);
+        }
+        pos += length;
+    }
+}
+
+/**
+ * Entries of one memtable or run in key order, for merging
+ */
+class EntrySource {
+public:
+    virtual ~EntrySource() = default;
+    virtual bool valid() const = 0;
+    virtual std::string_view key() const = 0;
+    virtual bool tombstone() const = 0;
+    virtual std::string_view value() const = 0;
+    virtual void next() = 0;
+};
+
+template <typename Memtable>
+class MemtableSource : public EntrySource {
+public:
+    explicit MemtableSource(const Memtable& memtable) : it_(memtable.begin()), end_(memtable.end()) {}
+    bool valid() const override { return it_ != end_; }
+    std::string_view key() const override { return it_->first; }
+    bool tombstone() const override { return it_->second.tombstone; }
+    std::string_view value() const override { return it_->second.value; }
+    void next() override { ++it_; }
+    
+private:
+    typename Memtable::const_iterator it_;
+    typename Memtable::const_iterator end_;
+};
+
+class RunSource : public EntrySource {
+public:
+    explicit RunSource(const SortedRun& run) : it_(run.begin()) {}
+    bool valid() const override { return it_.valid(); }
+    std::string_view key() const override { return it_.key(); }
+    bool tombstone() const override { return it_.tombstone(); }
+    std::string_view value() const override { return it_.value(); }
+    void next() override { it_.next(); }
+    
+private:
+    SortedRun::Iterator it_;
+};
+
+/**
+ * Call fn(key, tombstone, value) with the newest entry of every key, in key
+ * order; sources are ordered newest first
+ */
+template <typename Fn>
+void mergeSources(std::vector<std::unique_ptr<EntrySource>>& sources, Fn fn) {
+    std::string key;
+    while (true) {
+        EntrySource* newest = nullptr;
+        for (auto& source : sources) {
+            if (source->valid() && (!newest || source->key() < newest->key())) {
+                newest = source.get();
+            }
+        }
+        if (!newest) {
+            return;
+        }
+        key.assign(newest->key());
+        fn(std::string_view(key), newest->tombstone(), newest->value());
+        for (auto& source : sources) {
+            if (source->valid() && source->key() == key) {
+                source->next();
+            }
+        }
+    }
+}
+
+} // namespace
+
+LsmTable::LsmTable(const std::string& name, const std::vector<ColumnDef>& columns, const std::string& directory)
+    : name_(name), columns_(columns), directory_(directory) {
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (columns_[i].isPrimaryKey()) {
+            keyColumn_ = static_cast<int>(i);
+            break;
+        }
+    }
+}
+
+LsmTable::~LsmTable() {
+    {
+        std::lock_guard<std::mutex> lock(workerMutex_);
+        workerStopping_ = true;
+    }
+    workerWake_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    
+    // A memtable still in memory is recovered from its logs on the next open
+    if (logFd_ >= 0) {
+        ::fdatasync(logFd_);
+        ::close(logFd_);
+    }
+}
+
+std::unique_ptr<LsmTable> LsmTable::create(const std::string& name, const std::vector<ColumnDef>& columns,
+                                           const std::string& directory) {
+    for (const auto& column : columns) {
+        if (column.isUnique() && !column.isPrimaryKey()) {
+            std::cout << "Error: LSM tables support UNIQUE only on the PRIMARY KEY ('" << column.name
+                      << "' is UNIQUE)." << std::endl;
+            return nullptr;
+        }
+    }
+    
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+    if (!fs::create_directories(directory, ec)) {
+        std::cerr << "Error: Failed to create directory " << directory << ": " << ec.message() << std::endl;
+        return nullptr;
+    }
+    
+    std::unique_ptr<LsmTable> table(new LsmTable(name, columns, directory));
+    if (!table->openLog(table->nextFileId_++) || !table->writeManifest()) {
+        return nullptr;
+    }
+    table->worker_ = std::thread(&LsmTable::backgroundLoop, table.get());
+    return table;
+}
+
+std::unique_ptr<LsmTable> LsmTable::open(const std::string& directory) {
+    std::unique_ptr<LsmTable> table(new LsmTable("", {}, directory));
+    if (!table->loadManifest()) {
+        return nullptr;
+    }
+    
+    // Logs from the manifest's oldest live log on hold the memtable; files
+    // older than that, and runs the manifest does not list, were left by a
+    // crash before they could be removed
+    uint64_t oldestLog = table->memtableLogs_.empty() ? 0 : table->memtableLogs_.front();
+    std::set<uint64_t> liveRuns;
+    for (const auto& level : table->levels_) {
+        for (const auto& run : level) {
+            liveRuns.insert(run->getId());
+        }
+    }
+    std::set<uint64_t> logs;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        std::string stem = entry.path().stem().string();
+        std::string extension = entry.path().extension().string();
+        uint64_t id = 0;
+        auto [end, error] = std::from_chars(stem.data(), stem.data() + stem.size(), id);
+        if (error != std::errc() || end != stem.data() + stem.size()) {
+            continue;
+        }
+        table->nextFileId_ = std::max(table->nextFileId_, id + 1);
+        if (extension == ".log" && id >= oldestLog) {
+            logs.insert(id);
+        } else if (extension == ".log" || (extension == ".run" && liveRuns.count(id) == 0)) {
+            fs::remove(entry.path(), ec);
+        }
+    }
+    
+    table->memtableLogs_.clear();
+    for (uint64_t id : logs) {
+        if (!table->replayLog(id)) {
+            return nullptr;
+        }
+        table->memtableLogs_.push_back(id);
+    }
+    if (!table->openLog(table->nextFileId_++)) {
+        return nullptr;
+    }
+    
+    // Levels may have been left due for compaction
+    table->workPending_ = true;
+    table->worker_ = std::thread(&LsmTable::backgroundLoop, table.get());
+    return table;
+}
+
+bool LsmTable::insertRow(const std::vector<std::string>& values) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    if (!validateRow(values)) {
+        return false;
+    }
+    
+    std::string key;
+    if (keyColumn_ >= 0) {
+        auto& metrics = util::Metrics::instance();
+        key = encodeKey(values[keyColumn_]);
+        std::string existing;
+        metrics.add(util::Metrics::Counter::INDEX_PROBES);
+        if (get(key, existing)) {
+            metrics.add(util::Metrics::Counter::INDEX_HITS);
+            std::cout << "Error: Duplicate primary key value '" << values[keyColumn_] << "'" << std::endl;
+            return false;
+        }
+    } else {
+        key = encodeSequence(nextSequence_);
+    }
+    
+    if (!write({Change{LogOp::INSERT, std::move(key), encodeRow(values)}})) {
+        return false;
+    }
+    rotateMemtable(lock);
+    return true;
+}
+
+bool LsmTable::updateRows(const std::vector<std::pair<std::string, std::string>>& assignments,
+                          const std::string& whereCondition, size_t& count) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    std::vector<std::pair<size_t, std::string>> setColumns;
+    bool keyChanges = false;
+    for (const auto& [columnName, value] : assignments) {
+        int column = getColumnIndex(columnName);
+        if (column < 0) {
+            std::cout << "Error: Unknown column '" << columnName << "'" << std::endl;
+            return false;
+        }
+        setColumns.emplace_back(column, value);
+        keyChanges = keyChanges || column == keyColumn_;
+    }
+    
+    std::vector<std::string> keys;
+    std::vector<std::vector<std::string>> rows;
+    findRows(planCondition(whereCondition), keys, rows);
+    
+    std::vector<std::string> newKeys = keys;
+    for (size_t i = 0; i < rows.size(); i++) {
+        for (const auto& [column, value] : setColumns) {
+            rows[i][column] = value;
+        }
+        if (!validateRow(rows[i])) {
+            return false;
+        }
+        if (keyChanges) {
+            newKeys[i] = encodeKey(rows[i][keyColumn_]);
+        }
+    }
+    
+    // A row may take a key another updated row gives up, but not one kept
+    // by a row that is not updated (keys only clash if the key column is set)
+    std::set<std::string, std::less<>> oldKeySet(keys.begin(), keys.end());
+    std::set<std::string, std::less<>> newKeySet;
+    for (size_t i = 0; i < rows.size(); i++) {
+        std::string existing;
+        if (!newKeySet.insert(newKeys[i]).second ||
+            (oldKeySet.count(newKeys[i]) == 0 && get(newKeys[i], existing))) {
+            std::cout << "Error: Duplicate primary key value '" << rows[i][keyColumn_] << "'" << std::endl;
+            return false;
+        }
+    }
+    
+    std::vector<Change> changes;
+    for (const auto& key : keys) {
+        if (newKeySet.count(key) == 0) {
+            changes.push_back(Change{LogOp::DELETE, key, ""});
+        }
+    }
+    for (size_t i = 0; i < rows.size(); i++) {
+        LogOp op = oldKeySet.count(newKeys[i]) > 0 ? LogOp::UPDATE : LogOp::INSERT;
+        changes.push_back(Change{op, std::move(newKeys[i]), encodeRow(rows[i])});
+    }
+    if (!write(changes)) {
+        return false;
+    }
+    rotateMemtable(lock);
+    
+    count = rows.size();
+    util::Metrics::instance().add(util::Metrics::Counter::ROWS_UPDATED, rows.size());
+    return true;
+}
+
+bool LsmTable::deleteRows(const std::string& whereCondition, size_t& count) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    std::vector<std::string> keys;
+    std::vector<std::vector<std::string>> rows;
+    findRows(planCondition(whereCondition), keys, rows);
+    
+    std::vector<Change> changes;
+    for (auto& key : keys) {
+        changes.push_back(Change{LogOp::DELETE, std::move(key), ""});
+    }
+    if (!write(changes)) {
+        return false;
+    }
+    rotateMemtable(lock);
+    
+    count = rows.size();
+    util::Metrics::instance().add(util::Metrics::Counter::ROWS_DELETED, rows.size());
+    return true;
+}
+
+std::vector<std::vector<std::string>> LsmTable::selectRows(const std::vector<std::string>& columns,
+                                                           const std::string& whereCondition,
+                                                           QueryPlan* analysis) const {
+    std::shared_lock<util::SharedMutex> lock(mutex_);
+    
+    std::vector<int> columnIndices;
+    Predicate predicate;
+    {
+        util::PhaseTimer planTimer(util::Metrics::Phase::PLAN);
+        planSelect(columns, whereCondition, columnIndices, predicate);
+    }
+    
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::vector<std::string>> result;
+    Clock::duration projectTime{0};
+    size_t scanned = 0;
+    bool byKey = predicate.isEquality() && predicate.column == keyColumn_;
+    auto& metrics = util::Metrics::instance();
+    
+    auto project = [&](std::string_view row) {
+        auto projectStart = Clock::now();
+        std::vector<std::string> resultRow;
+        resultRow.reserve(columnIndices.size());
+        for (int idx : columnIndices) {
+            resultRow.emplace_back(rowValue(row, idx));
+        }
+        result.push_back(std::move(resultRow));
+        if (analysis) {
+            projectTime += Clock::now() - projectStart;
+        }
+    };
+    
+    auto start = Clock::now();
+    if (predicate.matchesNothing) {
+        // Unknown column: no row can match
+    } else if (byKey) {
+        std::string row;
+        metrics.add(util::Metrics::Counter::INDEX_PROBES);
+        if (get(encodeKey(predicate.value), row)) {
+            metrics.add(util::Metrics::Counter::INDEX_HITS);
+            scanned++;
+            project(row);
+        }
+    } else {
+        scan([&](std::string_view, std::string_view row) {
+            scanned++;
+            if (predicate.column >= 0 && !predicate.matches(rowValue(row, predicate.column))) {
+                return;
+            }
+            project(row);
+        });
+    }
+    auto total = Clock::now() - start;
+    
+    if (analysis) {
+        auto toNanos = [](Clock::duration d) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+        };
+        *analysis = describeSelect(columnIndices, predicate, !whereCondition.empty());
+        analysis->analyzed = true;
+    
+        // The filter runs inside the access loop and is timed with it
+        PlanOperator* access = byKey ? analysis->find("IndexLookup") : analysis->find("MergeScan");
+        access->rowsIn = rowCount_;
+        access->rowsOut = scanned;
+        access->nanoseconds = toNanos(total - projectTime);
+        if (PlanOperator* filter = analysis->find("Filter")) {
+            filter->rowsIn = scanned;
+            filter->rowsOut = result.size();
+        }
+        PlanOperator* projectOperator = analysis->find("Project");
+        projectOperator->rowsIn = result.size();
+        projectOperator->rowsOut = result.size();
+        projectOperator->nanoseconds = toNanos(projectTime);
+    }
+    
+    metrics.add(util::Metrics::Counter::ROWS_SCANNED, scanned);
+    metrics.add(util::Metrics::Counter::ROWS_RETURNED, result.size());
+    if (auto* trace = util::Metrics::activeTrace()) {
+        if (byKey) {
+            trace->accessPath = "IndexLookup " + name_ + "." + columns_[keyColumn_].name + " (lsm)";
+        } else {
+            trace->accessPath = "MergeScan " + name_ + " (lsm)";
+            if (predicate.column >= 0) {
+                trace->accessPath += ", filter on " + columns_[predicate.column].name;
+            }
+        }
+    }
+    
+    return result;
+}
+
+QueryPlan LsmTable::explainSelect(const std::vector<std::string>& columns,
+                                  const std::string& whereCondition) const {
+    std::shared_lock<util::SharedMutex> lock(mutex_);
+    
+    std::vector<int> columnIndices;
+    Predicate predicate;
+    planSelect(columns, whereCondition, columnIndices, predicate);
+    return describeSelect(columnIndices, predicate, !whereCondition.empty());
+}
+
+bool LsmTable::flush() {
+    std::shared_lock<util::SharedMutex> lock(mutex_);
+    
+    uint64_t version = version_.load();
+    if (::fdatasync(logFd_) != 0) {
+        std::cerr << "Error: Failed to sync the log of table " << name_ << std::endl;
+        return false;
+    }
+    flushedVersion_ = version;
+    return true;
+}
+
+bool LsmTable::isModified() const {
+    return version_.load() != flushedVersion_.load();
+}
+
+const std::string& LsmTable::getName() const {
+    return name_;
+}
+
+const std::vector<ColumnDef>& LsmTable::getColumns() const {
+    return columns_;
+}
+
+size_t LsmTable::getRowCount() const {
+    std::shared_lock<util::SharedMutex> lock(mutex_);
+    return rowCount_;
+}
+
+LsmStats LsmTable::getStats() const {
+    std::shared_lock<util::SharedMutex> lock(mutex_);
+    
+    LsmStats stats = stats_;
+    stats.memtableBytes = memtableBytes_ + immutableBytes_;
+    for (const auto& level : levels_) {
+        uint64_t bytes = 0;
+        for (const auto& run : level) {
+            bytes += run->getFileBytes();
+        }
+        stats.runsPerLevel.push_back(level.size());
+        stats.bytesPerLevel.push_back(bytes);
+    }
+    return stats;
+}
+
+TableMemoryUsage LsmTable::getMemoryUsage() const {
+    std::shared_lock<util::SharedMutex> lock(mutex_);
+    
+    TableMemoryUsage usage;
+    usage.values = memtableBytes_ + immutableBytes_;
+    for (const auto& level : levels_) {
+        for (const auto& run : level) {
+            usage.primaryKeyIndex += run->getMemoryUsage();
+        }
+    }
+    return usage;
+}
+
+int LsmTable::getColumnIndex(const std::string& columnName) const {
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (columns_[i].name == columnName) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+std::string LsmTable::runPath(uint64_t id) const {
+    return directory_ + "/" + std::to_string(id) + ".run";
+}
+
+std::string LsmTable::logPath(uint64_t id) const {
+    return directory_ + "/" + std::to_string(id) + ".log";
+}
+
+std::string LsmTable::encodeKey(const std::string& value) const {
+    // Canonical integers sort numerically: a tag byte, then the value with
+    // its sign bit flipped, big-endian. Anything else sorts after them as text.
+    if (util::StringUtils::toUpper(columns_[keyColumn_].type) == "INT") {
+        int64_t number = 0;
+        auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+        if (error == std::errc() && end == value.data() + value.size() && std::to_string(number) == value) {
+            return "\x01" + encodeSequence(static_cast<uint64_t>(number) ^ (uint64_t{1} << 63));
+        }
+    }
+    return "\x02" + value;
+}
+
+std::string LsmTable::encodeRow(const std::vector<std::string>& values) {
+    std::string row;
+    for (const auto& value : values) {
+        util::Varint::write(row, value.size());
+        row += value;
+    }
+    return row;
+}
+
+std::vector<std::string> LsmTable::decodeRow(std::string_view row) const {
+    std::vector<std::string> values;
+    values.reserve(columns_.size());
+    for (size_t i = 0; i < columns_.size(); i++) {
+        values.emplace_back(rowValue(row, i));
+    }
+    return values;
+}
+
+bool LsmTable::get(std::string_view key, std::string& row) const {
+    for (const Memtable* memtable : {&memtable_, immutable_.get()}) {
+        if (!memtable) {
+            continue;
+        }
+        auto it = memtable->find(key);
+        if (it != memtable->end()) {
+            row = it->second.value;
+            return !it->second.tombstone;
+        }
+    }
+    
+    for (const auto& level : levels_) {
+        for (auto run = level.rbegin(); run != level.rend(); ++run) {
+            switch ((*run)->get(key, row)) {
+            case SortedRun::Lookup::FOUND:
+                return true;
+            case SortedRun::Lookup::DELETED:
+                return false;
+            case SortedRun::Lookup::ABSENT:
+                break;
+            }
+        }
+    }
+    return false;
+}
+
+void LsmTable::scan(const std::function<void(std::string_view, std::string_view)>& fn) const {
+    std::vector<std::unique_ptr<EntrySource>> sources;
+    sources.push_back(std::make_unique<MemtableSource<Memtable>>(memtable_));
+    if (immutable_) {
+        sources.push_back(std::make_unique<MemtableSource<Memtable>>(*immutable_));
+    }
+    for (const auto& level : levels_) {
+        for (auto run = level.rbegin(); run != level.rend(); ++run) {
+            sources.push_back(std::make_unique<RunSource>(**run));
+        }
+    }
+    
+    mergeSources(sources, [&](std::string_view key, bool tombstone, std::string_view row) {
+        if (!tombstone) {
+            fn(key, row);
+        }
+    });
+}
+
+void LsmTable::findRows(const Predicate& predicate, std::vector<std::string>& keys,
+                        std::vector<std::vector<std::string>>& rows) const {
+    if (predicate.matchesNothing) {
+        return;
+    }
+    
+    if (predicate.isEquality() && predicate.column == keyColumn_) {
+        std::string key = encodeKey(predicate.value);
+        std::string row;
+        util::Metrics::instance().add(util::Metrics::Counter::INDEX_PROBES);
+        if (get(key, row)) {
+            util::Metrics::instance().add(util::Metrics::Counter::INDEX_HITS);
+            keys.push_back(std::move(key));
+            rows.push_back(decodeRow(row));
+        }
+        return;
+    }
+    
+    size_t scanned = 0;
+    scan([&](std::string_view key, std::string_view row) {
+        scanned++;
+        if (predicate.column < 0 || predicate.matches(rowValue(row, predicate.column))) {
+            keys.emplace_back(key);
+            rows.push_back(decodeRow(row));
+        }
+    });
+    util::Metrics::instance().add(util::Metrics::Counter::ROWS_SCANNED, scanned);
+}
+
+bool LsmTable::validateRow(const std::vector<std::string>& values) const {
+    if (values.size() != columns_.size()) {
+        std::cout << "Error: Expected " << columns_.size() << " values, got " << values.size() << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (columns_[i].isNotNull() && values[i].empty()) {
+            std::cout << "Error: Column '" << columns_[i].name << "' cannot be NULL" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LsmTable::write(const std::vector<Change>& changes) {
+    if (changes.empty()) {
+        return true;
+    }
+    
+    // Record: uint32 size of the rest, op, varint key size, key, row
+    std::string records;
+    for (const auto& change : changes) {
+        std::string record(1, static_cast<char>(change.op));
+        util::Varint::write(record, change.key.size());
+        record += change.key;
+        record += change.row;
+        uint32_t size = static_cast<uint32_t>(record.size());
+        records.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        records += record;
+    }
+    if (!appendLog(records)) {
+        std::cout << "Error: Failed to write the log of table '" << name_ << "'" << std::endl;
+        return false;
+    }
+    
+    for (const auto& change : changes) {
+        apply(change);
+        stats_.bytesIn += change.key.size() + change.row.size();
+    }
+    stats_.logBytes += records.size();
+    version_++;
+    return true;
+}
+
+void LsmTable::apply(const Change& change) {
+    // Per entry: the tree node with its key and value strings
+    constexpr size_t nodeBytes = sizeof(Memtable::value_type) + 4 * sizeof(void*);
+    
+    auto [it, inserted] = memtable_.try_emplace(change.key);
+    if (inserted) {
+        memtableBytes_ += nodeBytes + change.key.size();
+    } else {
+        memtableBytes_ -= it->second.value.size();
+    }
+    it->second.tombstone = change.op == LogOp::DELETE;
+    it->second.value = change.row;
+    memtableBytes_ += change.row.size();
+    
+    if (change.op == LogOp::INSERT) {
+        rowCount_++;
+        if (keyColumn_ < 0) {
+            nextSequence_ = std::max(nextSequence_, decodeSequence(change.key) + 1);
+        }
+    } else if (change.op == LogOp::DELETE) {
+        rowCount_--;
+    }
+}
+
+void LsmTable::rotateMemtable(std::unique_lock<util::SharedMutex>& lock) {
+    if (memtableBytes_ < MEMTABLE_BYTES) {
+        return;
+    }
+    
+    // One frozen memtable at a time: writers stall until the last is written
+    immutableWritten_.wait(lock, [this] { return !immutable_ || backgroundFailed_; });
+    if (immutable_ || memtableBytes_ < MEMTABLE_BYTES) {
+        return;
+    }
+    
+    std::vector<uint64_t> frozenLogs = memtableLogs_;
+    uint64_t logId = nextFileId_++;
+    if (!openLog(logId)) {
+        return;
+    }
+    memtableLogs_.assign(1, logId);
+    immutable_ = std::make_shared<const Memtable>(std::move(memtable_));
+    immutableBytes_ = memtableBytes_;
+    immutableLogs_ = std::move(frozenLogs);
+    memtable_.clear();
+    memtableBytes_ = 0;
+    frozenSequence_ = nextSequence_;
+    frozenRowCount_ = rowCount_;
+    
+    {
+        std::lock_guard<std::mutex> workerLock(workerMutex_);
+        workPending_ = true;
+    }
+    workerWake_.notify_one();
+}
+
+bool LsmTable::openLog(uint64_t id) {
+    int fd = ::open(logPath(id).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: Failed to open " << logPath(id) << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (logFd_ >= 0) {
+        ::fdatasync(logFd_);
+        ::close(logFd_);
+    }
+    logFd_ = fd;
+    memtableLogs_.push_back(id);
+    return true;
+}
+
+bool LsmTable::appendLog(const std::string& records) {
+    size_t done = 0;
+    while (done < records.size()) {
+        ssize_t n = ::write(logFd_, records.data() + done, records.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    util::Metrics::instance().add(util::Metrics::Counter::BYTES_WRITTEN, records.size());
+    return true;
+}
+
+bool LsmTable::replayLog(uint64_t id) {
+    std::ifstream file(logPath(id), std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: Failed to read " << logPath(id) << std::endl;
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    
+    // A record cut short by a crash ends the log
+    size_t pos = 0;
+    while (data.size() - pos >= sizeof(uint32_t)) {
+        uint32_t size;
+        std::memcpy(&size, data.data() + pos, sizeof(size));
+        if (size == 0 || size > data.size() - pos - sizeof(size)) {
+            break;
+        }
+        std::string_view record(data.data() + pos + sizeof(size), size);
+        pos += sizeof(size) + size;
+    
+        size_t recordPos = 1;
+        uint64_t keySize;
+        if (!util::Varint::read(record, recordPos, keySize) || keySize > record.size() - recordPos) {
+            break;
+        }
+        Change change{static_cast<LogOp>(record[0]), std::string(record.substr(recordPos, keySize)),
+                      std::string(record.substr(recordPos + keySize))};
+        apply(change);
+    }
+    return true;
+}
+
+bool LsmTable::writeManifest() const {
+    std::string path = directory_ + "/MANIFEST";
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::trunc);
+        if (!file) {
+            std::cerr << "Error: Failed to write " << tempPath << std::endl;
+            return false;
+        }
+        file << MANIFEST_MAGIC << "\n" << name_ << "\n" << columns_.size() << "\n";
+        for (const auto& column : columns_) {
+            file << column.name << "," << column.type << "," << column.constraints << "\n";
+        }
+        // The oldest log not yet covered by a run
+        uint64_t oldestLog = !immutableLogs_.empty() ? immutableLogs_.front() : memtableLogs_.front();
+        file << "SEQUENCE " << manifestSequence_ << "\n";
+        file << "ROWS " << manifestRowCount_ << "\n";
+        file << "LOG " << oldestLog << "\n";
+        for (size_t level = 0; level < levels_.size(); level++) {
+            for (const auto& run : levels_[level]) {
+                file << "RUN " << level << " " << run->getId() << "\n";
+            }
+        }
+        if (!file.flush()) {
+            return false;
+        }
+    }
+    
+    std::error_code ec;
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        std::cerr << "Error: Failed to replace " << path << ": " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool LsmTable::loadManifest() {
+    std::ifstream file(directory_ + "/MANIFEST");
+    std::string magic;
+    if (!file || !std::getline(file, magic) || magic != MANIFEST_MAGIC) {
+        return false;
+    }
+    
+    size_t columnCount = 0;
+    std::string line;
+    std::getline(file, name_);
+    std::getline(file, line);
+    columnCount = std::strtoul(line.c_str(), nullptr, 10);
+    for (size_t i = 0; i < columnCount && std::getline(file, line); i++) {
+        std::stringstream columnStream(line);
+        std::string columnName, columnType, constraints;
+        std::getline(columnStream, columnName, ',');
+        std::getline(columnStream, columnType, ',');
+        std::getline(columnStream, constraints, ',');
+        columns_.emplace_back(columnName, columnType, std::atoi(constraints.c_str()));
+        if (keyColumn_ < 0 && columns_.back().isPrimaryKey()) {
+            keyColumn_ = static_cast<int>(i);
+        }
+    }
+    if (columns_.size() != columnCount || columnCount == 0) {
+        return false;
+    }
+    
+    while (std::getline(file, line)) {
+        std::stringstream lineStream(line);
+        std::string keyword;
+        lineStream >> keyword;
+        if (keyword == "SEQUENCE") {
+            lineStream >> manifestSequence_;
+        } else if (keyword == "ROWS") {
+            lineStream >> manifestRowCount_;
+        } else if (keyword == "LOG") {
+            uint64_t id = 0;
+            lineStream >> id;
+            memtableLogs_.assign(1, id);
+        } else if (keyword == "RUN") {
+            size_t level = 0;
+            uint64_t id = 0;
+            lineStream >> level >> id;
+            auto run = SortedRun::open(runPath(id), id);
+            if (!run) {
+                std::cerr << "Error: Run file " << runPath(id) << " is missing or corrupt" << std::endl;
+                return false;
+            }
+            if (levels_.size() <= level) {
+                levels_.resize(level + 1);
+            }
+            levels_[level].push_back(std::move(run));
+        }
+    }
+    
+    nextSequence_ = manifestSequence_;
+    rowCount_ = manifestRowCount_;
+    return true;
+}
+
+void LsmTable::backgroundLoop() {
+    std::unique_lock<std::mutex> lock(workerMutex_);
+    while (true) {
+        workerWake_.wait(lock, [this] { return workPending_ || workerStopping_; });
+        if (workerStopping_) {
+            return;
+        }
+        workPending_ = false;
+        lock.unlock();
+    
+        // Frozen memtables first: writers may be waiting for them
+        while (true) {
+            bool frozen;
+            int level;
+            {
+                std::shared_lock<util::SharedMutex> tableLock(mutex_);
+                frozen = immutable_ && !backgroundFailed_;
+                level = levelDueForCompaction();
+            }
+            if (frozen) {
+                flushImmutable();
+            } else if (level >= 0) {
+                compactLevel(static_cast<size_t>(level));
+            } else {
+                break;
+            }
+    
+            std::lock_guard<std::mutex> stopLock(workerMutex_);
+            if (workerStopping_) {
+                return;
+            }
+        }
+        lock.lock();
+    }
+}
+
+void LsmTable::flushImmutable() {
+    std::shared_ptr<const Memtable> frozen;
+    uint64_t id;
+    {
+        std::unique_lock<util::SharedMutex> lock(mutex_);
+        frozen = immutable_;
+        id = nextFileId_++;
+    }
+    
+    // Tombstones are kept: older runs may still hold the rows they delete
+    SortedRun::Writer writer(runPath(id), frozen->size());
+    bool written = true;
+    for (const auto& [key, entry] : *frozen) {
+        written = written && writer.add(key, entry.tombstone, entry.value);
+    }
+    auto run = written ? writer.finish(id) : nullptr;
+    
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    if (!run) {
+        std::cerr << "Error: Failed to write a run of table " << name_ << "; its memtable keeps growing"
+                  << std::endl;
+        backgroundFailed_ = true;
+        immutableWritten_.notify_all();
+        return;
+    }
+    
+    if (levels_.empty()) {
+        levels_.emplace_back();
+    }
+    levels_[0].push_back(run);
+    std::vector<uint64_t> obsoleteLogs = std::move(immutableLogs_);
+    immutable_.reset();
+    immutableBytes_ = 0;
+    immutableLogs_.clear();
+    manifestSequence_ = frozenSequence_;
+    manifestRowCount_ = frozenRowCount_;
+    
+    if (writeManifest()) {
+        std::error_code ec;
+        for (uint64_t log : obsoleteLogs) {
+            fs::remove(logPath(log), ec);
+        }
+    }
+    stats_.flushes++;
+    stats_.flushBytes += run->getFileBytes();
+    util::Metrics::instance().add(util::Metrics::Counter::LSM_FLUSHES);
+    immutableWritten_.notify_all();
+}
+
+void LsmTable::compactLevel(size_t level) {
+    std::vector<std::shared_ptr<SortedRun>> inputs;
+    bool deepest = true;
+    uint64_t id;
+    {
+        std::unique_lock<util::SharedMutex> lock(mutex_);
+        inputs = levels_[level];
+        for (size_t older = level + 1; older < levels_.size(); older++) {
+            deepest = deepest && levels_[older].empty();
+        }
+        id = nextFileId_++;
+    }
+    
+    // Runs are immutable, so readers go on using the inputs meanwhile
+    std::vector<std::unique_ptr<EntrySource>> sources;
+    size_t expectedEntries = 0;
+    for (auto run = inputs.rbegin(); run != inputs.rend(); ++run) {
+        sources.push_back(std::make_unique<RunSource>(**run));
+        expectedEntries += (*run)->getEntryCount();
+    }
+    SortedRun::Writer writer(runPath(id), expectedEntries);
+    bool written = true;
+    mergeSources(sources, [&](std::string_view key, bool tombstone, std::string_view value) {
+        // Nothing older is left for a tombstone to hide
+        if (!(tombstone && deepest)) {
+            written = written && writer.add(key, tombstone, value);
+        }
+    });
+    bool empty = writer.getEntryCount() == 0;
+    auto run = written ? writer.finish(id) : nullptr;
+    
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    if (!run) {
+        std::cerr << "Error: Failed to compact level " << level << " of table " << name_ << std::endl;
+        backgroundFailed_ = true;
+        return;
+    }
+    
+    auto& runs = levels_[level];
+    for (const auto& input : inputs) {
+        runs.erase(std::remove(runs.begin(), runs.end(), input), runs.end());
+    }
+    if (!empty) {
+        if (levels_.size() <= level + 1) {
+            levels_.emplace_back();
+        }
+        levels_[level + 1].push_back(run);
+    }
+    
+    std::error_code ec;
+    if (writeManifest()) {
+        for (const auto& input : inputs) {
+            fs::remove(input->getPath(), ec);
+        }
+    }
+    if (empty) {
+        fs::remove(run->getPath(), ec);
+    }
+    stats_.compactions++;
+    stats_.compactionBytes += empty ? 0 : run->getFileBytes();
+    util::Metrics::instance().add(util::Metrics::Counter::LSM_COMPACTIONS);
+}
+
+int LsmTable::levelDueForCompaction() const {
+    if (backgroundFailed_) {
+        return -1;
+    }
+    for (size_t level = 0; level < levels_.size(); level++) {
+        if (levels_[level].size() >= RUNS_PER_LEVEL) {
+            return static_cast<int>(level);
+        }
+    }
+    return -1;
+}
+
+LsmTable::Predicate LsmTable::planCondition(const std::string& condition) const {
+    // Same conditions as Table::planCondition
+    Condition parsed;
+    if (!Condition::parse(condition, parsed)) {
+        return Predicate();
+    }
+    
+    int column = getColumnIndex(parsed.column);
+    bool integerColumn = column >= 0 && util::StringUtils::toUpper(columns_[column].type) == "INT";
+    return Predicate::plan(parsed, column, integerColumn);
+}
+
+void LsmTable::planSelect(const std::vector<std::string>& columns, const std::string& whereCondition,
+                          std::vector<int>& columnIndices, Predicate& predicate) const {
+    if (!columns.empty()) {
+        for (const auto& col : columns) {
+            int idx = getColumnIndex(col);
+            if (idx >= 0) {
+                columnIndices.push_back(idx);
+            }
+        }
+    } else {
+        for (size_t i = 0; i < columns_.size(); i++) {
+            columnIndices.push_back(static_cast<int>(i));
+        }
+    }
+    predicate = planCondition(whereCondition);
+}
+
+QueryPlan LsmTable::describeSelect(const std::vector<int>& columnIndices, const Predicate& predicate,
+                                   bool hasCondition) const {
+    QueryPlan plan;
+    
+    std::string projection;
+    for (int idx : columnIndices) {
+        projection += (projection.empty() ? "" : ", ") + columns_[idx].name;
+    }
+    plan.add("Project", projection);
+    
+    std::string sources = std::string(immutable_ ? "2 memtables" : "memtable") + " and " +
+                          std::to_string(runCount()) + " run(s)";
+    if (predicate.isEquality() && predicate.column == keyColumn_) {
+        plan.add("IndexLookup", name_ + "." + columns_[keyColumn_].name + " = '" + predicate.value + "', " +
+                 sources + " by Bloom filter and fence pointers");
+        return plan;
+    }
+    
+    if (hasCondition) {
+        std::string filter;
+        if (predicate.matchesNothing) {
+            filter = "unknown column, matches no rows";
+        } else if (predicate.column >= 0) {
+            filter = predicate.describe(columns_[predicate.column].name);
+        } else {
+            filter = "no comparison, matches every row";
+        }
+        plan.add("Filter", filter);
+    }
+    plan.add("MergeScan", name_ + ", " + std::to_string(rowCount_) + " row(s) in " + sources);
+    return plan;
+}
+
+size_t LsmTable::runCount() const {
+    size_t count = 0;
+    for (const auto& level : levels_) {
+        count += level.size();
+    }
+    return count;
+}
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,423 @@
+#include "core/MappedTable.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "util/Metrics.h"
+#include "util/StringUtils.h"
+
+namespace fs = std::filesystem;
+namespace soliddb {
+namespace core {
+
+namespace {
+
+uint64_t alignUp(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+}
+
+/**
+ * Whether [offset, offset + length) lies inside a file of the given size
+ */
+bool inFile(uint64_t offset, uint64_t length, size_t size) {
+    return offset <= size && length <= size - offset;
+}
+
+} // namespace
+
+MappedTable::~MappedTable() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+std::unique_ptr<MappedTable> MappedTable::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(FileHeader)) {
+        ::close(fd);
+        return nullptr;
+    }
+    
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    
+    std::unique_ptr<MappedTable> table(new MappedTable());
+    table->data_ = static_cast<const char*>(mapping);
+    table->size_ = size;
+    
+    // Only the header, schema and section bounds are checked; no row is touched
+    FileHeader header;
+    std::memcpy(&header, table->data_, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        !inFile(header.schemaOffset, header.schemaSize, size) ||
+        header.columnCount > size / sizeof(ColumnSegment) ||
+        !inFile(header.columnsOffset, header.columnCount * sizeof(ColumnSegment), size) ||
+        header.rowCount >= size / sizeof(uint64_t)) {
+        return nullptr;
+    }
+    
+    std::stringstream schema(std::string(table->data_ + header.schemaOffset, header.schemaSize));
+    std::getline(schema, table->name_);
+    std::string columnDef;
+    while (std::getline(schema, columnDef)) {
+        std::stringstream columnStream(columnDef);
+        std::string columnName, columnType, constraints;
+        std::getline(columnStream, columnName, ',');
+        std::getline(columnStream, columnType, ',');
+        std::getline(columnStream, constraints, ',');
+        table->columns_.emplace_back(columnName, columnType, std::atoi(constraints.c_str()));
+    }
+    if (table->columns_.size() != header.columnCount) {
+        return nullptr;
+    }
+    
+    table->rowCount_ = header.rowCount;
+    for (size_t i = 0; i < header.columnCount; i++) {
+        ColumnSegment segment;
+        std::memcpy(&segment, table->data_ + header.columnsOffset + i * sizeof(ColumnSegment), sizeof(segment));
+    
+        uint64_t offsetsBytes = (header.rowCount + 1) * sizeof(uint64_t);
+        if (segment.offsetsOffset % alignof(uint64_t) != 0 || segment.indexOffset % alignof(uint64_t) != 0 ||
+            !inFile(segment.offsetsOffset, offsetsBytes, size) || segment.indexCount > header.rowCount ||
+            !inFile(segment.indexOffset, segment.indexCount * sizeof(uint64_t), size)) {
+            return nullptr;
+        }
+        const auto* offsets = reinterpret_cast<const uint64_t*>(table->data_ + segment.offsetsOffset);
+        if (!inFile(segment.bytesOffset, offsets[header.rowCount], size)) {
+            return nullptr;
+        }
+    
+        table->offsets_.push_back(offsets);
+        table->bytes_.push_back(table->data_ + segment.bytesOffset);
+        table->indexes_.push_back(segment.indexOffset == 0
+            ? nullptr : reinterpret_cast<const uint64_t*>(table->data_ + segment.indexOffset));
+        table->indexCounts_.push_back(segment.indexCount);
+    }
+    
+    return table;
+}
+
+bool MappedTable::write(const Table& table, const std::string& path) {
+    const auto& columns = table.getColumns();
+    size_t columnCount = columns.size();
+    
+    std::vector<std::vector<uint64_t>> offsets(columnCount, std::vector<uint64_t>{0});
+    std::vector<std::string> bytes(columnCount);
+    size_t rowCount = 0;
+    
+    TableCursor cursor = table.openCursor();
+    while (cursor.next()) {
+        for (size_t i = 0; i < columnCount; i++) {
+            bytes[i] += cursor.get(i);
+            offsets[i].push_back(bytes[i].size());
+        }
+        rowCount++;
+    }
+    
+    // Key columns get their row ids sorted by value, for binary search
+    std::vector<std::vector<uint64_t>> indexes(columnCount);
+    for (size_t i = 0; i < columnCount; i++) {
+        if (!columns[i].requiresUniqueValue()) {
+            continue;
+        }
+        auto valueOf = [&](uint64_t row) {
+            return std::string_view(bytes[i]).substr(offsets[i][row], offsets[i][row + 1] - offsets[i][row]);
+        };
+        for (uint64_t row = 0; row < rowCount; row++) {
+            if (offsets[i][row + 1] > offsets[i][row]) {
+                indexes[i].push_back(row);
+            }
+        }
+        std::sort(indexes[i].begin(), indexes[i].end(), [&](uint64_t a, uint64_t b) {
+            return valueOf(a) < valueOf(b);
+        });
+    }
+    
+    std::string schema = table.getName() + "\n";
+    for (const auto& column : columns) {
+        schema += column.name + "," + column.type + "," + std::to_string(column.constraints) + "\n";
+    }
+    
+    // Lay the sections out, then write them in the same order
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.rowCount = rowCount;
+    header.columnCount = columnCount;
+    header.schemaOffset = sizeof(FileHeader);
+    header.schemaSize = schema.size();
+    header.columnsOffset = alignUp(header.schemaOffset + schema.size());
+    
+    std::vector<ColumnSegment> segments(columnCount);
+    uint64_t position = header.columnsOffset + columnCount * sizeof(ColumnSegment);
+    for (size_t i = 0; i < columnCount; i++) {
+        segments[i].offsetsOffset = position;
+        segments[i].bytesOffset = position + offsets[i].size() * sizeof(uint64_t);
+        position = alignUp(segments[i].bytesOffset + bytes[i].size());
+        if (columns[i].requiresUniqueValue()) {
+            segments[i].indexOffset = position;
+            segments[i].indexCount = indexes[i].size();
+            position += indexes[i].size() * sizeof(uint64_t);
+        }
+    }
+    
+    std::string tempPath = path + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Error: Failed to open " << tempPath << " for writing" << std::endl;
+        return false;
+    }
+    
+    uint64_t written = 0;
+    auto put = [&](const void* data, size_t length) {
+        file.write(static_cast<const char*>(data), length);
+        written += length;
+    };
+    auto padTo = [&](uint64_t offset) {
+        static const char zeros[8] = {};
+        put(zeros, offset - written);
+    };
+    
+    put(&header, sizeof(header));
+    put(schema.data(), schema.size());
+    padTo(header.columnsOffset);
+    put(segments.data(), segments.size() * sizeof(ColumnSegment));
+    for (size_t i = 0; i < columnCount; i++) {
+        put(offsets[i].data(), offsets[i].size() * sizeof(uint64_t));
+        put(bytes[i].data(), bytes[i].size());
+        padTo(alignUp(written));
+        put(indexes[i].data(), indexes[i].size() * sizeof(uint64_t));
+    }
+    
+    file.close();
+    if (!file) {
+        std::cerr << "Error: Failed to write " << tempPath << std::endl;
+        return false;
+    }
+    util::Metrics::instance().add(util::Metrics::Counter::BYTES_WRITTEN, written);
+    
+    // Processes that mapped the old file keep it until they close it
+    std::error_code ec;
+    fs::rename(tempPath, path, ec);
+    return !ec;
+}
+
+const std::string& MappedTable::getName() const {
+    return name_;
+}
+
+const std::vector<ColumnDef>& MappedTable::getColumns() const {
+    return columns_;
+}
+
+size_t MappedTable::getRowCount() const {
+    return rowCount_;
+}
+
+size_t MappedTable::getMappedBytes() const {
+    return size_;
+}
+
+std::string_view MappedTable::value(size_t row, size_t column) const {
+    const uint64_t* offsets = offsets_[column];
+    if (row >= rowCount_ || offsets[row] > offsets[row + 1] || offsets[row + 1] > offsets[rowCount_]) {
+        return {};
+    }
+    return std::string_view(bytes_[column] + offsets[row], offsets[row + 1] - offsets[row]);
+}
+
+std::vector<size_t> MappedTable::lookup(size_t column, const std::string& key) const {
+    const uint64_t* first = indexes_[column];
+    const uint64_t* last = first + indexCounts_[column];
+    const uint64_t* it = std::lower_bound(first, last, key, [&](uint64_t row, const std::string& value) {
+        return this->value(row, column) < value;
+    });
+    
+    if (it == last || value(*it, column) != key) {
+        return {};
+    }
+    return {static_cast<size_t>(*it)};
+}
+
+std::vector<std::vector<std::string>> MappedTable::selectRows(const std::vector<std::string>& columns,
+                                                              const std::string& whereCondition,
+                                                              QueryPlan* analysis) const {
+    std::vector<int> columnIndices;
+    Predicate predicate;
+    {
+        util::PhaseTimer planTimer(util::Metrics::Phase::PLAN);
+        planSelect(columns, whereCondition, columnIndices, predicate);
+    }
+    
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::vector<std::string>> result;
+    Clock::duration projectTime{0};
+    size_t scanned = 0;
+    bool indexed = predicate.isEquality() && indexes_[predicate.column];
+    auto& metrics = util::Metrics::instance();
+    
+    auto project = [&](size_t row) {
+        auto projectStart = Clock::now();
+        std::vector<std::string> resultRow;
+        resultRow.reserve(columnIndices.size());
+        for (int idx : columnIndices) {
+            resultRow.emplace_back(value(row, idx));
+        }
+        result.push_back(std::move(resultRow));
+        if (analysis) {
+            projectTime += Clock::now() - projectStart;
+        }
+    };
+    
+    auto start = Clock::now();
+    if (predicate.matchesNothing) {
+        // Unknown column: no row can match
+    } else if (indexed) {
+        metrics.add(util::Metrics::Counter::INDEX_PROBES);
+        auto rows = lookup(predicate.column, predicate.value);
+        if (!rows.empty()) {
+            metrics.add(util::Metrics::Counter::INDEX_HITS);
+        }
+        for (size_t row : rows) {
+            scanned++;
+            project(row);
+        }
+    } else {
+        for (size_t row = 0; row < rowCount_; row++) {
+            scanned++;
+            if (predicate.column >= 0 && !predicate.matches(value(row, predicate.column))) {
+                continue;
+            }
+            project(row);
+        }
+    }
+    auto total = Clock::now() - start;
+    
+    if (analysis) {
+        auto toNanos = [](Clock::duration d) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+        };
+        *analysis = describeSelect(columnIndices, predicate, !whereCondition.empty());
+        analysis->analyzed = true;
+    
+        // The filter runs inside the access loop and is timed with it
+        PlanOperator* access = indexed ? analysis->find("IndexLookup") : analysis->find("SeqScan");
+        access->rowsIn = indexed ? indexCounts_[predicate.column] : rowCount_;
+        access->rowsOut = scanned;
+        access->nanoseconds = toNanos(total - projectTime);
+        if (PlanOperator* filter = analysis->find("Filter")) {
+            filter->rowsIn = scanned;
+            filter->rowsOut = result.size();
+        }
+        PlanOperator* projectOperator = analysis->find("Project");
+        projectOperator->rowsIn = result.size();
+        projectOperator->rowsOut = result.size();
+        projectOperator->nanoseconds = toNanos(projectTime);
+    }
+    
+    metrics.add(util::Metrics::Counter::ROWS_SCANNED, scanned);
+    metrics.add(util::Metrics::Counter::ROWS_RETURNED, result.size());
+    if (auto* trace = util::Metrics::activeTrace()) {
+        if (indexed) {
+            trace->accessPath = "IndexLookup " + name_ + "." + columns_[predicate.column].name + " (mapped)";
+        } else {
+            trace->accessPath = "SeqScan " + name_ + " (mapped)";
+            if (predicate.column >= 0) {
+                trace->accessPath += ", filter on " + columns_[predicate.column].name;
+            }
+        }
+    }
+    
+    return result;
+}
+
+QueryPlan MappedTable::explainSelect(const std::vector<std::string>& columns,
+                                     const std::string& whereCondition) const {
+    std::vector<int> columnIndices;
+    Predicate predicate;
+    planSelect(columns, whereCondition, columnIndices, predicate);
+    return describeSelect(columnIndices, predicate, !whereCondition.empty());
+}
+
+void MappedTable::planSelect(const std::vector<std::string>& columns, const std::string& whereCondition,
+                             std::vector<int>& columnIndices, Predicate& predicate) const {
+    if (!columns.empty()) {
+        for (const auto& col : columns) {
+            int idx = getColumnIndex(col);
+            if (idx >= 0) {
+                columnIndices.push_back(idx);
+            }
+        }
+    } else {
+        for (size_t i = 0; i < columns_.size(); i++) {
+            columnIndices.push_back(static_cast<int>(i));
+        }
+    }
+    
+    // Same conditions as Table::planCondition
+    Condition parsed;
+    if (!Condition::parse(whereCondition, parsed)) {
+        return;
+    }
+    int column = getColumnIndex(parsed.column);
+    bool integerColumn = column >= 0 && util::StringUtils::toUpper(columns_[column].type) == "INT";
+    predicate = Predicate::plan(parsed, column, integerColumn);
+}
+
+QueryPlan MappedTable::describeSelect(const std::vector<int>& columnIndices, const Predicate& predicate,
+                                      bool hasCondition) const {
+    QueryPlan plan;
+    
+    std::string projection;
+    for (int idx : columnIndices) {
+        projection += (projection.empty() ? "" : ", ") + columns_[idx].name;
+    }
+    plan.add("Project", projection);
+    
+    if (predicate.isEquality() && indexes_[predicate.column]) {
+        plan.add("IndexLookup", name_ + "." + columns_[predicate.column].name + " = '" + predicate.value +
+                 "', mapped index of " + std::to_string(indexCounts_[predicate.column]) + " key(s)");
+        return plan;
+    }
+    
+    if (hasCondition) {
+        std::string filter;
+        if (predicate.matchesNothing) {
+            filter = "unknown column, matches no rows";
+        } else if (predicate.column >= 0) {
+            filter = predicate.describe(columns_[predicate.column].name);
+        } else {
+            filter = "no comparison, matches every row";
+        }
+        plan.add("Filter", filter);
+    }
+    plan.add("SeqScan", name_ + ", mapped file of " + std::to_string(rowCount_) + " row(s)");
+    return plan;
+}
+
+int MappedTable::getColumnIndex(const std::string& columnName) const {
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (columns_[i].name == columnName) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,883 @@
+#include "core/PagedTable.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include "util/Metrics.h"
+#include "util/StringUtils.h"
+
+namespace fs = std::filesystem;
+namespace soliddb {
+namespace core {
+
+namespace {
+
+uint16_t read16(const char* p) {
+    uint16_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+void append16(std::string& out, uint16_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+} // namespace
+
+PagedTable::PagedTable(const std::string& name, const std::vector<ColumnDef>& columns,
+                       std::unique_ptr<Pager> pager, BufferPool& pool)
+    : name_(name), columns_(columns), pager_(std::move(pager)), pool_(pool) {
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (columns_[i].requiresUniqueValue()) {
+            indexes_[i];
+        }
+    }
+}
+
+PagedTable::~PagedTable() {
+    // The pool must not keep pages of a closed file
+    flush();
+    pool_.discard(*pager_);
+}
+
+std::unique_ptr<PagedTable> PagedTable::create(const std::string& name, const std::vector<ColumnDef>& columns,
+                                               const std::string& path, BufferPool& pool) {
+    std::string schema = name + "\n";
+    for (const auto& column : columns) {
+        schema += column.name + "," + column.type + "," + std::to_string(column.constraints) + "\n";
+    }
+    if (sizeof(MAGIC) + sizeof(uint32_t) + schema.size() > Pager::PAGE_SIZE) {
+        std::cout << "Error: The schema of table '" << name << "' does not fit in a page." << std::endl;
+        return nullptr;
+    }
+    
+    std::error_code ec;
+    fs::remove(path, ec);
+    auto pager = Pager::open(path);
+    if (!pager) {
+        return nullptr;
+    }
+    
+    std::unique_ptr<PagedTable> table(new PagedTable(name, columns, std::move(pager), pool));
+    {
+        auto header = pool.pinNew(*table->pager_);
+        if (!header) {
+            return nullptr;
+        }
+        char* data = header.mutableData();
+        uint32_t schemaSize = static_cast<uint32_t>(schema.size());
+        std::memcpy(data, MAGIC, sizeof(MAGIC));
+        std::memcpy(data + sizeof(MAGIC), &schemaSize, sizeof(schemaSize));
+        std::memcpy(data + sizeof(MAGIC) + sizeof(schemaSize), schema.data(), schema.size());
+    }
+    table->freeBytes_.assign(1, 0);
+    table->isReusable_.assign(1, false);
+    
+    if (!table->flush()) {
+        return nullptr;
+    }
+    return table;
+}
+
+std::unique_ptr<PagedTable> PagedTable::open(const std::string& path, BufferPool& pool) {
+    if (!fs::exists(path)) {
+        return nullptr;
+    }
+    auto pager = Pager::open(path);
+    if (!pager || pager->getPageCount() == 0) {
+        return nullptr;
+    }
+    
+    std::string schema;
+    {
+        auto header = pool.pin(*pager, 0);
+        if (!header) {
+            return nullptr;
+        }
+        uint32_t schemaSize;
+        std::memcpy(&schemaSize, header.data() + sizeof(MAGIC), sizeof(schemaSize));
+        if (std::memcmp(header.data(), MAGIC, sizeof(MAGIC)) != 0 ||
+            schemaSize > Pager::PAGE_SIZE - sizeof(MAGIC) - sizeof(schemaSize)) {
+            header.release();
+            pool.discard(*pager);
+            return nullptr;
+        }
+        schema.assign(header.data() + sizeof(MAGIC) + sizeof(schemaSize), schemaSize);
+    }
+    
+    std::stringstream schemaStream(schema);
+    std::string name;
+    std::getline(schemaStream, name);
+    std::vector<ColumnDef> columns;
+    std::string columnDef;
+    while (std::getline(schemaStream, columnDef)) {
+        std::stringstream columnStream(columnDef);
+        std::string columnName, columnType, constraints;
+        std::getline(columnStream, columnName, ',');
+        std::getline(columnStream, columnType, ',');
+        std::getline(columnStream, constraints, ',');
+        columns.emplace_back(columnName, columnType, std::atoi(constraints.c_str()));
+    }
+    
+    std::unique_ptr<PagedTable> table(new PagedTable(name, columns, std::move(pager), pool));
+    if (columns.empty() || !table->loadRows()) {
+        std::cerr << "Error: Page file " << path << " is corrupt" << std::endl;
+        return nullptr;
+    }
+    return table;
+}
+
+bool PagedTable::loadRows() {
+    size_t pageCount = pager_->getPageCount();
+    freeBytes_.assign(pageCount, 0);
+    isReusable_.assign(pageCount, false);
+    lastPage_ = pageCount > 1 ? static_cast<Pager::PageId>(pageCount - 1) : 0;
+    
+    for (Pager::PageId page = 1; page < pageCount; page++) {
+        auto handle = pool_.pin(*pager_, page);
+        if (!handle) {
+            return false;
+        }
+        const char* data = handle.data();
+    
+        PageHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.slotCount == 0) {
+            // Empty, possibly allocated but never written back
+            noteFreeSpace(page, data);
+            continue;
+        }
+        size_t slotsEnd = sizeof(PageHeader) + header.slotCount * sizeof(Slot);
+        if (slotsEnd > header.dataStart || header.dataStart > Pager::PAGE_SIZE) {
+            return false;
+        }
+        for (size_t slot = 0; slot < header.slotCount; slot++) {
+            Slot entry;
+            std::memcpy(&entry, data + sizeof(PageHeader) + slot * sizeof(Slot), sizeof(entry));
+            if (entry.length == 0) {
+                continue;
+            }
+            if (entry.offset < header.dataStart || entry.offset + entry.length > Pager::PAGE_SIZE) {
+                return false;
+            }
+            indexRow(decodeRecord(std::string_view(data + entry.offset, entry.length)), makeRowId(page, slot));
+            rowCount_++;
+        }
+        noteFreeSpace(page, data);
+    }
+    
+    flushedVersion_ = version_.load();
+    return true;
+}
+
+bool PagedTable::insertRow(const std::vector<std::string>& values) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    if (!validateRow(values) || !checkConstraints(values)) {
+        return false;
+    }
+    
+    RowId row;
+    if (!placeRecord(encodeRecord(values), 0, row)) {
+        return false;
+    }
+    indexRow(values, row);
+    rowCount_++;
+    version_++;
+    return true;
+}
+
+bool PagedTable::updateRows(const std::vector<std::pair<std::string, std::string>>& assignments,
+                            const std::string& whereCondition, size_t& count) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    std::vector<std::pair<size_t, std::string>> setColumns;
+    for (const auto& [columnName, value] : assignments) {
+        int column = getColumnIndex(columnName);
+        if (column < 0) {
+            std::cout << "Error: Unknown column '" << columnName << "'" << std::endl;
+            return false;
+        }
+        setColumns.emplace_back(column, value);
+    }
+    
+    std::vector<RowId> rows;
+    std::vector<std::vector<std::string>> oldRows;
+    if (!findRows(planCondition(whereCondition), rows, oldRows)) {
+        return false;
+    }
+    
+    std::vector<std::vector<std::string>> newRows = oldRows;
+    std::vector<std::string> records;
+    for (auto& values : newRows) {
+        for (const auto& [column, value] : setColumns) {
+            values[column] = value;
+        }
+        records.push_back(encodeRecord(values));
+        if (records.back().size() > MAX_RECORD_SIZE) {
+            std::cout << "Error: Row of " << records.back().size() << " bytes does not fit in a page (at most "
+                      << MAX_RECORD_SIZE << ")" << std::endl;
+            return false;
+        }
+    }
+    
+    // Release the old keys first, so rows can keep (or swap) their keys, and
+    // check the new rows against each other by indexing them as pending
+    for (const auto& values : oldRows) {
+        unindexRow(values);
+    }
+    size_t checked = 0;
+    while (checked < newRows.size() && checkConstraints(newRows[checked])) {
+        indexRow(newRows[checked], PENDING_ROW);
+        checked++;
+    }
+    if (checked < newRows.size()) {
+        for (size_t i = 0; i < checked; i++) {
+            unindexRow(newRows[i]);
+        }
+        for (size_t i = 0; i < rows.size(); i++) {
+            indexRow(oldRows[i], rows[i]);
+        }
+        return false;
+    }
+    
+    // The new records are placed before the old ones go, so a page that
+    // cannot be pinned or written leaves every row as it was
+    std::vector<RowId> placed;
+    for (size_t i = 0; i < rows.size(); i++) {
+        RowId row;
+        if (!placeRecord(records[i], pageOf(rows[i]), row)) {
+            break;
+        }
+        placed.push_back(row);
+    }
+    size_t removed = 0;
+    if (placed.size() == rows.size()) {
+        while (removed < rows.size() && removeRecord(rows[removed])) {
+            removed++;
+        }
+    }
+    
+    if (removed < rows.size()) {
+        std::cout << "Error: Could not write the updated rows of table '" << name_ << "'" << std::endl;
+        for (RowId row : placed) {
+            removeRecord(row);
+        }
+        for (const auto& values : newRows) {
+            unindexRow(values);
+        }
+        for (size_t i = 0; i < rows.size(); i++) {
+            RowId row = rows[i];
+            if (i < removed && !placeRecord(encodeRecord(oldRows[i]), pageOf(rows[i]), row)) {
+                std::cout << "Error: Lost a row of table '" << name_ << "' while undoing the update" << std::endl;
+                rowCount_--;
+                continue;
+            }
+            indexRow(oldRows[i], row);
+        }
+        version_++;
+        return false;
+    }
+    
+    for (size_t i = 0; i < rows.size(); i++) {
+        indexRow(newRows[i], placed[i]);
+    }
+    version_++;
+    count = rows.size();
+    util::Metrics::instance().add(util::Metrics::Counter::ROWS_UPDATED, rows.size());
+    return true;
+}
+
+bool PagedTable::deleteRows(const std::string& whereCondition, size_t& count) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    std::vector<RowId> rows;
+    std::vector<std::vector<std::string>> values;
+    if (!findRows(planCondition(whereCondition), rows, values)) {
+        return false;
+    }
+    
+    // A row stays indexed and counted unless its record is really gone
+    count = 0;
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (!removeRecord(rows[i])) {
+            std::cout << "Error: Could not delete the rows of table '" << name_ << "' (" << count << " of "
+                      << rows.size() << " deleted)" << std::endl;
+            break;
+        }
+        unindexRow(values[i]);
+        rowCount_--;
+        count++;
+    }
+    
+    version_++;
+    util::Metrics::instance().add(util::Metrics::Counter::ROWS_DELETED, count);
+    return count == rows.size();
+}
+
+std::vector<std::vector<std::string>> PagedTable::selectRows(const std::vector<std::string>& columns,
+                                                             const std::string& whereCondition,
+                                                             QueryPlan* analysis) const {
+    std::shared_lock<util::SharedMutex> lock(mutex_);
+    
+    std::vector<int> columnIndices;
+    Predicate predicate;
+    {
+        util::PhaseTimer planTimer(util::Metrics::Phase::PLAN);
+        planSelect(columns, whereCondition, columnIndices, predicate);
+    }
+    
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::vector<std::string>> result;
+    Clock::duration projectTime{0};
+    size_t scanned = 0;
+    bool indexed = predicate.isEquality() && indexes_.count(predicate.column) > 0;
+    auto& metrics = util::Metrics::instance();
+    
+    auto project = [&](std::string_view record) {
+        auto projectStart = Clock::now();
+        std::vector<std::string> resultRow;
+        resultRow.reserve(columnIndices.size());
+        for (int idx : columnIndices) {
+            resultRow.emplace_back(recordValue(record, idx));
+        }
+        result.push_back(std::move(resultRow));
+        if (analysis) {
+            projectTime += Clock::now() - projectStart;
+        }
+    };
+    
+    auto start = Clock::now();
+    if (predicate.matchesNothing) {
+        // Unknown column: no row can match
+    } else if (indexed) {
+        RowId row;
+        std::string record;
+        if (lookup(predicate, row) && readRecord(row, record)) {
+            scanned++;
+            project(record);
+        }
+    } else {
+        scan([&](RowId, std::string_view record) {
+            scanned++;
+            if (predicate.column >= 0 && !predicate.matches(recordValue(record, predicate.column))) {
+                return;
+            }
+            project(record);
+        });
+    }
+    auto total = Clock::now() - start;
+    
+    if (analysis) {
+        auto toNanos = [](Clock::duration d) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+        };
+        *analysis = describeSelect(columnIndices, predicate, !whereCondition.empty());
+        analysis->analyzed = true;
+    
+        // The filter runs inside the access loop and is timed with it
+        PlanOperator* access = indexed ? analysis->find("IndexLookup") : analysis->find("SeqScan");
+        access->rowsIn = indexed ? indexes_.at(predicate.column).rows.size() : rowCount_;
+        access->rowsOut = scanned;
+        access->nanoseconds = toNanos(total - projectTime);
+        if (PlanOperator* filter = analysis->find("Filter")) {
+            filter->rowsIn = scanned;
+            filter->rowsOut = result.size();
+        }
+        PlanOperator* projectOperator = analysis->find("Project");
+        projectOperator->rowsIn = result.size();
+        projectOperator->rowsOut = result.size();
+        projectOperator->nanoseconds = toNanos(projectTime);
+    }
+    
+    metrics.add(util::Metrics::Counter::ROWS_SCANNED, scanned);
+    metrics.add(util::Metrics::Counter::ROWS_RETURNED, result.size());
+    if (auto* trace = util::Metrics::activeTrace()) {
+        if (indexed) {
+            trace->accessPath = "IndexLookup " + name_ + "." + columns_[predicate.column].name + " (paged)";
+        } else {
+            trace->accessPath = "SeqScan " + name_ + " (paged)";
+            if (predicate.column >= 0) {
+                trace->accessPath += ", filter on " + columns_[predicate.column].name;
+            }
+        }
+    }
+    
+    return result;
+}
+
+QueryPlan PagedTable::explainSelect(const std::vector<std::string>& columns,
+                                    const std::string& whereCondition) const {
+    std::shared_lock<util::SharedMutex> lock(mutex_);
+    
+    std::vector<int> columnIndices;
+    Predicate predicate;
+    planSelect(columns, whereCondition, columnIndices, predicate);
+    return describeSelect(columnIndices, predicate, !whereCondition.empty());
+}
+
+bool PagedTable::flush() {
+    // Writers are locked out, so the pages written are one consistent state
+    std::shared_lock<util::SharedMutex> lock(mutex_);
+    
+    uint64_t version = version_.load();
+    if (!pool_.flush(*pager_) || !pager_->sync()) {
+        std::cerr << "Error: Failed to write pages of table " << name_ << std::endl;
+        return false;
+    }
+    flushedVersion_ = version;
+    return true;
+}
+
+bool PagedTable::isModified() const {
+    return version_.load() != flushedVersion_.load();
+}
+
+const std::string& PagedTable::getName() const {
+    return name_;
+}
+
+const std::vector<ColumnDef>& PagedTable::getColumns() const {
+    return columns_;
+}
+
+size_t PagedTable::getRowCount() const {
+    std::shared_lock<util::SharedMutex> lock(mutex_);
+    return rowCount_;
+}
+
+size_t PagedTable::getPageCount() const {
+    return pager_->getPageCount();
+}
+
+TableMemoryUsage PagedTable::getMemoryUsage() const {
+    std::shared_lock<util::SharedMutex> lock(mutex_);
+    
+    // Per entry: the hash node (key, row id, next pointer, cached hash)
+    constexpr size_t nodeBytes = sizeof(std::string) + sizeof(RowId) + 2 * sizeof(void*);
+    
+    TableMemoryUsage usage;
+    for (const auto& [column, index] : indexes_) {
+        size_t bytes = index.rows.size() * nodeBytes + index.rows.bucket_count() * sizeof(void*) +
+                       index.keyBytes;
+        if (columns_[column].isPrimaryKey()) {
+            usage.primaryKeyIndex += bytes;
+        } else {
+            usage.uniqueIndexes += bytes;
+        }
+    }
+    return usage;
+}
+
+int PagedTable::getColumnIndex(const std::string& columnName) const {
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (columns_[i].name == columnName) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+std::string PagedTable::encodeRecord(const std::vector<std::string>& values) {
+    std::string record;
+    for (const auto& value : values) {
+        // Longer values make the record too large for a page anyway
+        append16(record, static_cast<uint16_t>(std::min<size_t>(value.size(), UINT16_MAX)));
+        record += value;
+    }
+    return record;
+}
+
+std::string_view PagedTable::recordValue(std::string_view record, size_t column) {
+    size_t pos = 0;
+    for (size_t i = 0;; i++) {
+        if (record.size() - pos < sizeof(uint16_t)) {
+            return {};
+        }
+        size_t length = read16(record.data() + pos);
+        pos += sizeof(uint16_t);
+        if (i == column) {
+            return record.substr(pos, length);
+        }
+        pos += length;
+        if (pos > record.size()) {
+            return {};
+        }
+    }
+}
+
+std::vector<std::string> PagedTable::decodeRecord(std::string_view record) const {
+    std::vector<std::string> values;
+    values.reserve(columns_.size());
+    for (size_t i = 0; i < columns_.size(); i++) {
+        values.emplace_back(recordValue(record, i));
+    }
+    return values;
+}
+
+std::string_view PagedTable::recordAt(const char* page, size_t slot) {
+    Slot entry;
+    std::memcpy(&entry, page + sizeof(PageHeader) + slot * sizeof(Slot), sizeof(entry));
+    return std::string_view(page + entry.offset, entry.length);
+}
+
+bool PagedTable::validateRow(const std::vector<std::string>& values) const {
+    if (values.size() != columns_.size()) {
+        std::cout << "Error: Expected " << columns_.size() << " values, got " << values.size() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool PagedTable::checkConstraints(const std::vector<std::string>& values) const {
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (columns_[i].isNotNull() && values[i].empty()) {
+            std::cout << "Error: Column '" << columns_[i].name << "' cannot be NULL" << std::endl;
+            return false;
+        }
+    }
+    
+    auto& metrics = util::Metrics::instance();
+    for (const auto& [column, index] : indexes_) {
+        const std::string& value = values[column];
+        if (value.empty() && !columns_[column].isPrimaryKey()) {
+            continue;
+        }
+        metrics.add(util::Metrics::Counter::INDEX_PROBES);
+        if (index.rows.count(value) == 0) {
+            continue;
+        }
+        metrics.add(util::Metrics::Counter::INDEX_HITS);
+        if (columns_[column].isPrimaryKey()) {
+            std::cout << "Error: Duplicate primary key value '" << value << "'" << std::endl;
+        } else {
+            std::cout << "Error: Duplicate value '" << value << "' in unique column '"
+                      << columns_[column].name << "'" << std::endl;
+        }
+        return false;
+    }
+    return true;
+}
+
+void PagedTable::indexRow(const std::vector<std::string>& values, RowId row) {
+    for (auto& [column, index] : indexes_) {
+        const std::string& value = values[column];
+        if (value.empty() && !columns_[column].isPrimaryKey()) {
+            continue;
+        }
+        auto [it, inserted] = index.rows.try_emplace(value, row);
+        if (inserted) {
+            index.keyBytes += stringHeapBytes(it->first);
+        } else {
+            it->second = row;
+        }
+    }
+}
+
+void PagedTable::unindexRow(const std::vector<std::string>& values) {
+    for (auto& [column, index] : indexes_) {
+        auto it = index.rows.find(values[column]);
+        if (it != index.rows.end()) {
+            index.keyBytes -= stringHeapBytes(it->first);
+            index.rows.erase(it);
+        }
+    }
+}
+
+bool PagedTable::placeRecord(const std::string& record, Pager::PageId preferredPage, RowId& row) {
+    if (record.size() > MAX_RECORD_SIZE) {
+        std::cout << "Error: Row of " << record.size() << " bytes does not fit in a page (at most "
+                  << MAX_RECORD_SIZE << ")" << std::endl;
+        return false;
+    }
+    
+    if (preferredPage != 0 && placeOnPage(preferredPage, record, row)) {
+        return true;
+    }
+    if (lastPage_ != 0 && freeBytes_[lastPage_] >= record.size() && placeOnPage(lastPage_, record, row)) {
+        return true;
+    }
+    
+    // Pages deletes emptied, newest first; pages that turn out too full drop off
+    while (!reusablePages_.empty()) {
+        Pager::PageId page = reusablePages_.back();
+        if (freeBytes_[page] >= record.size() && placeOnPage(page, record, row)) {
+            return true;
+        }
+        reusablePages_.pop_back();
+        isReusable_[page] = false;
+    }
+    
+    Pager::PageId page;
+    {
+        auto handle = pool_.pinNew(*pager_);
+        if (!handle) {
+            return false;
+        }
+        PageHeader header{0, static_cast<uint16_t>(Pager::PAGE_SIZE)};
+        std::memcpy(handle.mutableData(), &header, sizeof(header));
+        page = handle.id();
+    }
+    freeBytes_.resize(page + 1, 0);
+    isReusable_.resize(page + 1, false);
+    lastPage_ = page;
+    return placeOnPage(page, record, row);
+}
+
+bool PagedTable::placeOnPage(Pager::PageId page, const std::string& record, RowId& row) {
+    auto handle = pool_.pin(*pager_, page);
+    if (!handle) {
+        return false;
+    }
+    
+    PageHeader header;
+    std::memcpy(&header, handle.data(), sizeof(header));
+    if (header.slotCount == 0) {
+        header.dataStart = static_cast<uint16_t>(Pager::PAGE_SIZE);
+    }
+    size_t slot = header.slotCount;
+    for (size_t i = 0; i < header.slotCount; i++) {
+        if (recordAt(handle.data(), i).empty()) {
+            slot = i;
+            break;
+        }
+    }
+    size_t needed = record.size() + (slot == header.slotCount ? sizeof(Slot) : 0);
+    if (reclaimableBytes(handle.data()) < needed) {
+        return false;
+    }
+    
+    char* data = handle.mutableData();
+    if (header.dataStart - (sizeof(PageHeader) + header.slotCount * sizeof(Slot)) < needed) {
+        compactPage(data);
+        std::memcpy(&header, data, sizeof(header));
+    }
+    
+    header.dataStart -= static_cast<uint16_t>(record.size());
+    std::memcpy(data + header.dataStart, record.data(), record.size());
+    Slot entry{header.dataStart, static_cast<uint16_t>(record.size())};
+    std::memcpy(data + sizeof(PageHeader) + slot * sizeof(Slot), &entry, sizeof(entry));
+    if (slot == header.slotCount) {
+        header.slotCount++;
+    }
+    std::memcpy(data, &header, sizeof(header));
+    
+    noteFreeSpace(page, data);
+    row = makeRowId(page, slot);
+    return true;
+}
+
+bool PagedTable::removeRecord(RowId row) {
+    auto handle = pool_.pin(*pager_, pageOf(row));
+    if (!handle) {
+        return false;
+    }
+    
+    char* data = handle.mutableData();
+    PageHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    size_t slot = slotOf(row);
+    if (slot >= header.slotCount) {
+        return false;
+    }
+    
+    Slot freeSlot{0, 0};
+    std::memcpy(data + sizeof(PageHeader) + slot * sizeof(Slot), &freeSlot, sizeof(freeSlot));
+    while (header.slotCount > 0 && recordAt(data, header.slotCount - 1).empty()) {
+        header.slotCount--;
+    }
+    if (header.slotCount == 0) {
+        header.dataStart = static_cast<uint16_t>(Pager::PAGE_SIZE);
+    }
+    std::memcpy(data, &header, sizeof(header));
+    
+    noteFreeSpace(pageOf(row), data);
+    return true;
+}
+
+size_t PagedTable::reclaimableBytes(const char* page) {
+    PageHeader header;
+    std::memcpy(&header, page, sizeof(header));
+    size_t used = sizeof(PageHeader) + header.slotCount * sizeof(Slot);
+    for (size_t slot = 0; slot < header.slotCount; slot++) {
+        used += recordAt(page, slot).size();
+    }
+    return Pager::PAGE_SIZE - used;
+}
+
+void PagedTable::compactPage(char* page) {
+    PageHeader header;
+    std::memcpy(&header, page, sizeof(header));
+    
+    // Records are copied out first; they may overlap where they move to
+    std::string records;
+    std::vector<Slot> slots(header.slotCount);
+    for (size_t slot = 0; slot < header.slotCount; slot++) {
+        std::memcpy(&slots[slot], page + sizeof(PageHeader) + slot * sizeof(Slot), sizeof(Slot));
+        std::string_view record(page + slots[slot].offset, slots[slot].length);
+        slots[slot].offset = static_cast<uint16_t>(records.size());
+        records += record;
+    }
+    
+    size_t end = Pager::PAGE_SIZE;
+    for (size_t slot = 0; slot < header.slotCount; slot++) {
+        if (slots[slot].length == 0) {
+            continue;
+        }
+        end -= slots[slot].length;
+        std::memcpy(page + end, records.data() + slots[slot].offset, slots[slot].length);
+        slots[slot].offset = static_cast<uint16_t>(end);
+        std::memcpy(page + sizeof(PageHeader) + slot * sizeof(Slot), &slots[slot], sizeof(Slot));
+    }
+    header.dataStart = static_cast<uint16_t>(end);
+    std::memcpy(page, &header, sizeof(header));
+}
+
+void PagedTable::noteFreeSpace(Pager::PageId page, const char* data) {
+    freeBytes_[page] = static_cast<uint16_t>(reclaimableBytes(data));
+    if (freeBytes_[page] >= Pager::PAGE_SIZE / 4 && page != lastPage_ && !isReusable_[page]) {
+        reusablePages_.push_back(page);
+        isReusable_[page] = true;
+    }
+}
+
+bool PagedTable::scan(const std::function<void(RowId, std::string_view)>& fn) const {
+    size_t pageCount = pager_->getPageCount();
+    for (Pager::PageId page = 1; page < pageCount; page++) {
+        auto handle = pool_.pin(*pager_, page);
+        if (!handle) {
+            return false;
+        }
+        PageHeader header;
+        std::memcpy(&header, handle.data(), sizeof(header));
+        for (size_t slot = 0; slot < header.slotCount; slot++) {
+            std::string_view record = recordAt(handle.data(), slot);
+            if (!record.empty()) {
+                fn(makeRowId(page, slot), record);
+            }
+        }
+    }
+    return true;
+}
+
+bool PagedTable::readRecord(RowId row, std::string& record) const {
+    auto handle = pool_.pin(*pager_, pageOf(row));
+    if (!handle) {
+        return false;
+    }
+    record.assign(recordAt(handle.data(), slotOf(row)));
+    return true;
+}
+
+bool PagedTable::lookup(const Predicate& predicate, RowId& row) const {
+    auto& metrics = util::Metrics::instance();
+    metrics.add(util::Metrics::Counter::INDEX_PROBES);
+    
+    const auto& rows = indexes_.at(predicate.column).rows;
+    auto it = rows.find(predicate.value);
+    if (it == rows.end()) {
+        return false;
+    }
+    metrics.add(util::Metrics::Counter::INDEX_HITS);
+    row = it->second;
+    return true;
+}
+
+bool PagedTable::findRows(const Predicate& predicate, std::vector<RowId>& rows,
+                          std::vector<std::vector<std::string>>& values) const {
+    if (predicate.matchesNothing) {
+        return true;
+    }
+    
+    if (predicate.isEquality() && indexes_.count(predicate.column) > 0) {
+        RowId row;
+        std::string record;
+        if (lookup(predicate, row)) {
+            if (!readRecord(row, record)) {
+                return false;
+            }
+            rows.push_back(row);
+            values.push_back(decodeRecord(record));
+        }
+        return true;
+    }
+    
+    size_t scanned = 0;
+    bool complete = scan([&](RowId row, std::string_view record) {
+        scanned++;
+        if (predicate.column < 0 || predicate.matches(recordValue(record, predicate.column))) {
+            rows.push_back(row);
+            values.push_back(decodeRecord(record));
+        }
+    });
+    util::Metrics::instance().add(util::Metrics::Counter::ROWS_SCANNED, scanned);
+    return complete;
+}
+
+PagedTable::Predicate PagedTable::planCondition(const std::string& condition) const {
+    // Same conditions as Table::planCondition
+    Condition parsed;
+    if (!Condition::parse(condition, parsed)) {
+        return Predicate();
+    }
+    
+    int column = getColumnIndex(parsed.column);
+    bool integerColumn = column >= 0 && util::StringUtils::toUpper(columns_[column].type) == "INT";
+    return Predicate::plan(parsed, column, integerColumn);
+}
+
+void PagedTable::planSelect(const std::vector<std::string>& columns, const std::string& whereCondition,
+                            std::vector<int>& columnIndices, Predicate& predicate) const {
+    if (!columns.empty()) {
+        for (const auto& col : columns) {
+            int idx = getColumnIndex(col);
+            if (idx >= 0) {
+                columnIndices.push_back(idx);
+            }
+        }
+    } else {
+        for (size_t i = 0; i < columns_.size(); i++) {
+            columnIndices.push_back(static_cast<int>(i));
+        }
+    }
+    predicate = planCondition(whereCondition);
+}
+
+QueryPlan PagedTable::describeSelect(const std::vector<int>& columnIndices, const Predicate& predicate,
+                                     bool hasCondition) const {
+    QueryPlan plan;
+    
+    std::string projection;
+    for (int idx : columnIndices) {
+        projection += (projection.empty() ? "" : ", ") + columns_[idx].name;
+    }
+    plan.add("Project", projection);
+    
+    if (predicate.isEquality() && indexes_.count(predicate.column) > 0) {
+        plan.add("IndexLookup", name_ + "." + columns_[predicate.column].name + " = '" + predicate.value +
+                 "', index of " + std::to_string(indexes_.at(predicate.column).rows.size()) + " key(s)");
+        return plan;
+    }
+    
+    if (hasCondition) {
+        std::string filter;
+        if (predicate.matchesNothing) {
+            filter = "unknown column, matches no rows";
+        } else if (predicate.column >= 0) {
+            filter = predicate.describe(columns_[predicate.column].name);
+        } else {
+            filter = "no comparison, matches every row";
+        }
+        plan.add("Filter", filter);
+    }
+    plan.add("SeqScan", name_ + ", " + std::to_string(rowCount_) + " row(s) in " +
+             std::to_string(pager_->getPageCount() - 1) + " page(s)");
+    return plan;
+}
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,94 @@
+#include "core/Pager.h"
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "util/Metrics.h"
+
+namespace soliddb {
+namespace core {
+
+Pager::Pager(int fd, const std::string& path, size_t pageCount)
+    : fd_(fd), path_(path), pageCount_(pageCount) {
+}
+
+Pager::~Pager() {
+    ::close(fd_);
+}
+
+std::unique_ptr<Pager> Pager::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: Failed to open page file " << path << ": " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+    
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size % PAGE_SIZE != 0) {
+        std::cerr << "Error: " << path << " is not a page file" << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+    
+    return std::unique_ptr<Pager>(new Pager(fd, path, static_cast<size_t>(info.st_size) / PAGE_SIZE));
+}
+
+bool Pager::readPage(PageId id, char* data) const {
+    off_t offset = static_cast<off_t>(id) * PAGE_SIZE;
+    size_t done = 0;
+    while (done < PAGE_SIZE) {
+        ssize_t n = ::pread(fd_, data + done, PAGE_SIZE - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: Failed to read page " << id << " of " << path_ << std::endl;
+            return false;
+        }
+        if (n == 0) {
+            // Allocated but never written back
+            std::memset(data + done, 0, PAGE_SIZE - done);
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool Pager::writePage(PageId id, const char* data) {
+    off_t offset = static_cast<off_t>(id) * PAGE_SIZE;
+    size_t done = 0;
+    while (done < PAGE_SIZE) {
+        ssize_t n = ::pwrite(fd_, data + done, PAGE_SIZE - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: Failed to write page " << id << " of " << path_ << std::endl;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    util::Metrics::instance().add(util::Metrics::Counter::BYTES_WRITTEN, PAGE_SIZE);
+    return true;
+}
+
+Pager::PageId Pager::allocatePage() {
+    return static_cast<PageId>(pageCount_++);
+}
+
+size_t Pager::getPageCount() const {
+    return pageCount_.load();
+}
+
+bool Pager::sync() {
+    return ::fdatasync(fd_) == 0;
+}
+
+const std::string& Pager::getPath() const {
+    return path_;
+}
+
+} // namespace core
+} // namespace soliddb
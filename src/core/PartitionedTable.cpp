@@ -0,0 +1,468 @@
+#include "core/PartitionedTable.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include "core/BlockCodec.h"
+#include "util/BloomFilter.h"
+#include "util/Metrics.h"
+#include "util/StringUtils.h"
+
+namespace soliddb {
+namespace core {
+
+namespace {
+
+/**
+ * One plan for scanning several partitions: an Append of the partitions
+ * above their operators, whose figures are summed. Details are the first
+ * partition's, except that the scan lists every partition's.
+ */
+QueryPlan appendPlans(const std::vector<QueryPlan>& plans, const std::string& appendDetail) {
+    QueryPlan combined;
+    combined.add("Append", appendDetail);
+    if (plans.empty()) {
+        return combined;
+    }
+    
+    combined.analyzed = plans.front().analyzed;
+    for (const PlanOperator& first : plans.front().operators) {
+        PlanOperator op{first.name, first.detail};
+        if (op.name == "SeqScan") {
+            op.detail.clear();
+        }
+        for (const QueryPlan& plan : plans) {
+            for (const PlanOperator& other : plan.operators) {
+                if (other.name != op.name) {
+                    continue;
+                }
+                if (op.name == "SeqScan") {
+                    op.detail += (op.detail.empty() ? "" : "; ") + other.detail;
+                }
+                op.nanoseconds += other.nanoseconds;
+                op.rowsIn += other.rowsIn;
+                op.rowsOut += other.rowsOut;
+                op.bytesAllocated += other.bytesAllocated;
+            }
+        }
+        combined.operators.push_back(std::move(op));
+    }
+    return combined;
+}
+
+} // namespace
+
+std::string PartitionScheme::describe() const {
+    if (kind == Kind::HASH) {
+        return "HASH(" + column + ") " + std::to_string(count);
+    }
+    std::string text = "RANGE(" + column + ") (";
+    for (size_t i = 0; i < bounds.size(); i++) {
+        text += (i > 0 ? ", " : "") + bounds[i];
+    }
+    return text + ")";
+}
+
+std::string Partition::describeBounds(const PartitionScheme& scheme) const {
+    if (scheme.kind == PartitionScheme::Kind::HASH) {
+        return "hash(" + scheme.column + ") % " + std::to_string(scheme.count) + " = " + name.substr(1);
+    }
+    if (hasLower && hasUpper) {
+        return lower + " <= " + scheme.column + " < " + upper;
+    }
+    if (hasLower) {
+        return scheme.column + " >= " + lower;
+    }
+    if (hasUpper) {
+        return scheme.column + " < " + upper;
+    }
+    return "every " + scheme.column;
+}
+
+PartitionedTable::PartitionedTable(const std::string& name, const std::vector<ColumnDef>& columns,
+                                   const PartitionScheme& scheme, std::shared_ptr<VersionManager> versionManager)
+    : name_(name), columns_(columns), scheme_(scheme), versionManager_(std::move(versionManager)) {
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (columns_[i].name == scheme_.column) {
+            column_ = i;
+            integerColumn_ = util::StringUtils::toUpper(columns_[i].type) == "INT";
+        }
+    }
+}
+
+std::unique_ptr<PartitionedTable> PartitionedTable::create(const std::string& name,
+                                                           const std::vector<ColumnDef>& columns,
+                                                           const PartitionScheme& scheme,
+                                                           std::shared_ptr<VersionManager> versionManager) {
+    auto column = std::find_if(columns.begin(), columns.end(),
+                               [&](const ColumnDef& def) { return def.name == scheme.column; });
+    if (column == columns.end()) {
+        std::cout << "Error: Unknown partition column '" << scheme.column << "'" << std::endl;
+        return nullptr;
+    }
+    
+    // Keys are only checked within a partition, so a key must decide its partition
+    for (const auto& def : columns) {
+        if (def.requiresUniqueValue() && def.name != scheme.column) {
+            std::cout << "Error: PRIMARY KEY and UNIQUE columns of a partitioned table must be the partition "
+                      << "column ('" << def.name << "' is not '" << scheme.column << "')" << std::endl;
+            return nullptr;
+        }
+    }
+    
+    if (scheme.kind == PartitionScheme::Kind::HASH && scheme.count == 0) {
+        std::cout << "Error: A HASH partitioned table needs at least one partition" << std::endl;
+        return nullptr;
+    }
+    
+    if (scheme.kind == PartitionScheme::Kind::RANGE) {
+        if (scheme.bounds.empty()) {
+            std::cout << "Error: A RANGE partitioned table needs at least one bound" << std::endl;
+            return nullptr;
+        }
+        bool integer = util::StringUtils::toUpper(column->type) == "INT";
+        for (size_t i = 0; i < scheme.bounds.size(); i++) {
+            const std::string& bound = scheme.bounds[i];
+            int64_t value = 0;
+            // Bounds are stored space-separated in the metadata file
+            bool hasSpace = std::any_of(bound.begin(), bound.end(), [](unsigned char c) { return std::isspace(c); });
+            if (bound.empty() || hasSpace) {
+                std::cout << "Error: Invalid partition bound '" << bound << "'" << std::endl;
+                return nullptr;
+            }
+            if (integer && !parseInteger(bound, value)) {
+                std::cout << "Error: Partition bound '" << bound << "' of INT column '" << scheme.column
+                          << "' is not an integer" << std::endl;
+                return nullptr;
+            }
+        }
+    }
+    
+    std::unique_ptr<PartitionedTable> table(new PartitionedTable(name, columns, scheme, versionManager));
+    if (scheme.kind == PartitionScheme::Kind::RANGE) {
+        for (size_t i = 1; i < scheme.bounds.size(); i++) {
+            if (table->compareValues(scheme.bounds[i - 1], scheme.bounds[i]) >= 0) {
+                std::cout << "Error: Partition bounds must be ascending ('" << scheme.bounds[i - 1]
+                          << "' is not below '" << scheme.bounds[i] << "')" << std::endl;
+                return nullptr;
+            }
+        }
+    }
+    
+    table->partitions_ = table->layout();
+    for (auto& partition : table->partitions_) {
+        partition.table = std::make_shared<Table>(name + "." + partition.name, columns, versionManager);
+    }
+    return table;
+}
+
+std::unique_ptr<PartitionedTable> PartitionedTable::restore(
+    const std::string& name, const PartitionScheme& scheme,
+    const std::vector<std::pair<std::string, std::shared_ptr<Table>>>& loaded,
+    const std::vector<std::string>& dropped, std::shared_ptr<VersionManager> versionManager) {
+    if (loaded.empty()) {
+        return nullptr;
+    }
+    
+    const std::vector<ColumnDef>& columns = loaded.front().second->getColumns();
+    std::unique_ptr<PartitionedTable> table(new PartitionedTable(name, columns, scheme, versionManager));
+    table->dropped_ = dropped;
+    
+    for (auto& partition : table->layout()) {
+        if (std::find(dropped.begin(), dropped.end(), partition.name) != dropped.end()) {
+            continue;
+        }
+        auto it = std::find_if(loaded.begin(), loaded.end(),
+                               [&](const auto& entry) { return entry.first == partition.name; });
+        if (it != loaded.end()) {
+            partition.table = it->second;
+        } else {
+            std::cerr << "Warning: Partition " << partition.name << " of table " << name << " starts empty"
+                      << std::endl;
+            partition.table = std::make_shared<Table>(name + "." + partition.name, columns, versionManager);
+        }
+        table->partitions_.push_back(std::move(partition));
+    }
+    return table;
+}
+
+std::vector<Partition> PartitionedTable::layout() const {
+    std::vector<Partition> partitions;
+    for (size_t i = 0; i < scheme_.partitionCount(); i++) {
+        Partition partition;
+        partition.name = "p" + std::to_string(i);
+        if (scheme_.kind == PartitionScheme::Kind::RANGE) {
+            partition.hasLower = i > 0;
+            partition.hasUpper = i < scheme_.bounds.size();
+            partition.lower = partition.hasLower ? scheme_.bounds[i - 1] : "";
+            partition.upper = partition.hasUpper ? scheme_.bounds[i] : "";
+        }
+        partitions.push_back(std::move(partition));
+    }
+    return partitions;
+}
+
+std::string PartitionedTable::getName() const {
+    return name_;
+}
+
+const std::vector<ColumnDef>& PartitionedTable::getColumns() const {
+    return columns_;
+}
+
+const PartitionScheme& PartitionedTable::getScheme() const {
+    return scheme_;
+}
+
+std::vector<Partition> PartitionedTable::getPartitions() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return partitions_;
+}
+
+std::vector<std::string> PartitionedTable::getDroppedPartitions() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return dropped_;
+}
+
+int PartitionedTable::compareValues(std::string_view left, std::string_view right) const {
+    int64_t leftInteger = 0;
+    int64_t rightInteger = 0;
+    if (integerColumn_ && parseInteger(left, leftInteger) && parseInteger(right, rightInteger)) {
+        return (leftInteger > rightInteger) - (leftInteger < rightInteger);
+    }
+    int order = left.compare(right);
+    return (order > 0) - (order < 0);
+}
+
+bool PartitionedTable::mayHold(const Partition& partition, Comparison comparison, std::string_view value) const {
+    bool aboveLower = !partition.hasLower || compareValues(partition.lower, value) <= 0;
+    bool belowUpper = !partition.hasUpper || compareValues(value, partition.upper) < 0;
+    switch (comparison) {
+        case Comparison::EQUAL:
+            return aboveLower && belowUpper;
+        case Comparison::LESS:
+            return !partition.hasLower || compareValues(partition.lower, value) < 0;
+        case Comparison::LESS_EQUAL:
+            return aboveLower;
+        default:
+            return belowUpper;
+    }
+}
+
+std::shared_ptr<Table> PartitionedTable::partitionFor(const std::vector<std::string>& values) const {
+    if (values.size() != columns_.size()) {
+        std::cout << "Error: Expected " << columns_.size() << " values, got " << values.size() << std::endl;
+        return nullptr;
+    }
+    
+    const std::string& value = values[column_];
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (scheme_.kind == PartitionScheme::Kind::HASH) {
+        return partitions_[util::BloomFilter::hash(value) % scheme_.count].table;
+    }
+    
+    int64_t integer = 0;
+    if (integerColumn_ && !parseInteger(value, integer)) {
+        std::cout << "Error: Partition column '" << scheme_.column << "' needs an integer value, got '" << value
+                  << "'" << std::endl;
+        return nullptr;
+    }
+    for (const auto& partition : partitions_) {
+        if (mayHold(partition, Comparison::EQUAL, value)) {
+            return partition.table;
+        }
+    }
+    std::cout << "Error: No partition of table '" << name_ << "' takes " << scheme_.column << " = '" << value
+              << "'" << std::endl;
+    return nullptr;
+}
+
+std::vector<Partition> PartitionedTable::partitionsFor(const std::string& whereCondition) const {
+    std::vector<Partition> partitions = getPartitions();
+    
+    // Same parsing as Table::planCondition, so pruning agrees with the filter
+    Condition condition;
+    if (whereCondition.empty() || !Condition::parse(whereCondition, condition) ||
+        condition.column != scheme_.column) {
+        return partitions;
+    }
+    
+    if (scheme_.kind == PartitionScheme::Kind::HASH) {
+        if (condition.comparison != Comparison::EQUAL) {
+            return partitions;
+        }
+        return {partitions[util::BloomFilter::hash(condition.value) % scheme_.count]};
+    }
+    
+    // Rows compare as text with a non-integer; every partition may match then
+    int64_t integer = 0;
+    if (integerColumn_ && !parseInteger(condition.value, integer)) {
+        return partitions;
+    }
+    partitions.erase(std::remove_if(partitions.begin(), partitions.end(), [&](const Partition& partition) {
+        return !mayHold(partition, condition.comparison, condition.value);
+    }), partitions.end());
+    return partitions;
+}
+
+bool PartitionedTable::rejectsAssignments(const std::vector<std::pair<std::string, std::string>>& assignments) const {
+    for (const auto& [columnName, _] : assignments) {
+        if (columnName == scheme_.column) {
+            std::cout << "Error: Column '" << columnName << "' decides the partition of a row and cannot be updated"
+                      << std::endl;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PartitionedTable::scansInParallel(const std::vector<Partition>& partitions) const {
+    size_t versions = 0;
+    for (const auto& partition : partitions) {
+        versions += partition.table->getVersionCount();
+    }
+    return partitions.size() > 1 && versions >= PARALLEL_SCAN_VERSIONS && std::thread::hardware_concurrency() > 1;
+}
+
+std::vector<std::vector<std::string>> PartitionedTable::selectRows(const std::vector<std::string>& columns,
+                                                                   const std::string& whereCondition,
+                                                                   uint64_t ownMarker,
+                                                                   QueryPlan* analysis) const {
+    std::vector<Partition> partitions = partitionsFor(whereCondition);
+    size_t totalPartitions = getPartitions().size();
+    bool parallel = scansInParallel(partitions);
+    
+    // Every partition reads the same snapshot. Each scan records into a
+    // trace of its own, merged into the statement's afterwards.
+    auto snapshot = versionManager_->openSnapshot();
+    std::vector<std::vector<std::vector<std::string>>> results(partitions.size());
+    std::vector<QueryPlan> plans(analysis ? partitions.size() : 0);
+    std::vector<util::Metrics::Trace> traces(partitions.size());
+    auto scan = [&](size_t i) {
+        util::TraceScope traceScope(traces[i]);
+        results[i] = partitions[i].table->selectRows(columns, whereCondition, ownMarker,
+                                                     analysis ? &plans[i] : nullptr, &snapshot);
+    };
+    
+    auto start = std::chrono::steady_clock::now();
+    if (parallel) {
+        BlockCodec::parallelFor(partitions.size(), scan);
+    } else {
+        for (size_t i = 0; i < partitions.size(); i++) {
+            scan(i);
+        }
+    }
+    
+    size_t rowCount = 0;
+    for (const auto& rows : results) {
+        rowCount += rows.size();
+    }
+    std::vector<std::vector<std::string>> result;
+    result.reserve(rowCount);
+    for (auto& rows : results) {
+        std::move(rows.begin(), rows.end(), std::back_inserter(result));
+    }
+    
+    std::string scanned = std::to_string(partitions.size()) + " of " + std::to_string(totalPartitions) +
+                          " partition(s)";
+    if (analysis) {
+        std::string names;
+        for (const auto& partition : partitions) {
+            names += (names.empty() ? ": " : ", ") + partition.name;
+        }
+        *analysis = appendPlans(plans, scanned + names + (parallel ? ", in parallel" : ""));
+        analysis->analyzed = true;
+        PlanOperator& append = analysis->operators.front();
+        append.nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        append.rowsIn = result.size();
+        append.rowsOut = result.size();
+        append.bytesAllocated = result.capacity() * sizeof(std::vector<std::string>);
+    }
+    
+    if (auto* trace = util::Metrics::activeTrace()) {
+        trace->accessPath = "PartitionScan " + name_ + ", " + scanned + (parallel ? " in parallel" : "");
+        for (const auto& partitionTrace : traces) {
+            for (size_t i = 0; i < trace->phaseNanoseconds.size(); i++) {
+                trace->phaseNanoseconds[i] += partitionTrace.phaseNanoseconds[i];
+            }
+            for (size_t i = 0; i < trace->counters.size(); i++) {
+                trace->counters[i] += partitionTrace.counters[i];
+            }
+            trace->accessPath += "; " + partitionTrace.accessPath;
+        }
+    }
+    
+    return result;
+}
+
+QueryPlan PartitionedTable::explainSelect(const std::vector<std::string>& columns,
+                                          const std::string& whereCondition) const {
+    std::vector<Partition> partitions = partitionsFor(whereCondition);
+    std::vector<QueryPlan> plans;
+    std::string names;
+    for (const auto& partition : partitions) {
+        plans.push_back(partition.table->explainSelect(columns, whereCondition));
+        names += (names.empty() ? ": " : ", ") + partition.name;
+    }
+    bool parallel = scansInParallel(partitions);
+    
+    return appendPlans(plans, std::to_string(partitions.size()) + " of " + std::to_string(getPartitions().size()) +
+                              " partition(s)" + names + (parallel ? ", in parallel" : ""));
+}
+
+std::shared_ptr<Table> PartitionedTable::dropPartition(const std::string& partitionName) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    
+    if (scheme_.kind != PartitionScheme::Kind::RANGE) {
+        std::cout << "Error: Only RANGE partitions can be dropped" << std::endl;
+        return nullptr;
+    }
+    auto it = std::find_if(partitions_.begin(), partitions_.end(),
+                           [&](const Partition& partition) { return partition.name == partitionName; });
+    if (it == partitions_.end()) {
+        std::cout << "Error: Table '" << name_ << "' has no partition '" << partitionName << "'" << std::endl;
+        return nullptr;
+    }
+    if (partitions_.size() == 1) {
+        std::cout << "Error: Cannot drop the last partition of table '" << name_ << "'" << std::endl;
+        return nullptr;
+    }
+    
+    // Statements still scanning it keep the table alive until they finish
+    std::shared_ptr<Table> table = std::move(it->table);
+    partitions_.erase(it);
+    dropped_.push_back(partitionName);
+    return table;
+}
+
+void PartitionedTable::markSaved(const std::string& partitionName, uint64_t timestamp) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (auto& partition : partitions_) {
+        if (partition.name == partitionName) {
+            partition.saved = true;
+            partition.savedTs = timestamp;
+        }
+    }
+}
+
+size_t PartitionedTable::getRowCount() const {
+    size_t rows = 0;
+    for (const auto& partition : getPartitions()) {
+        rows += partition.table->getRowCount();
+    }
+    return rows;
+}
+
+uint64_t PartitionedTable::getLastCommitTimestamp() const {
+    uint64_t timestamp = VersionManager::BOOTSTRAP_TS;
+    for (const auto& partition : getPartitions()) {
+        timestamp = std::max(timestamp, partition.table->getLastCommitTimestamp());
+    }
+    return timestamp;
+}
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,44 @@
+#include "core/QueryPlan.h"
+#include "util/Metrics.h"
+#include <sstream>
+
+namespace soliddb {
+namespace core {
+
+PlanOperator& QueryPlan::add(const std::string& name, const std::string& detail) {
+    operators.push_back(PlanOperator{name, detail});
+    return operators.back();
+}
+
+PlanOperator* QueryPlan::find(const std::string& name) {
+    for (auto& op : operators) {
+        if (op.name == name) {
+            return &op;
+        }
+    }
+    return nullptr;
+}
+
+std::string QueryPlan::format() const {
+    std::ostringstream out;
+    
+    for (size_t depth = 0; depth < operators.size(); depth++) {
+        const PlanOperator& op = operators[depth];
+        
+        out << std::string(depth * 2, ' ') << (depth > 0 ? "-> " : "") << op.name;
+        if (!op.detail.empty()) {
+            out << " [" << op.detail << "]";
+        }
+        if (analyzed) {
+            out << " (time=" << util::Metrics::formatDuration(op.nanoseconds)
+                << " rows in=" << op.rowsIn << " out=" << op.rowsOut
+                << " bytes=" << op.bytesAllocated << ")";
+        }
+        out << "\n";
+    }
+    
+    return out.str();
+}
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,143 @@
+#include "core/ResultCache.h"
+#include "core/Condition.h"
+#include "util/Metrics.h"
+
+namespace soliddb {
+namespace core {
+
+namespace {
+
+/**
+ * Estimated heap bytes of a result
+ */
+size_t sizeOfRows(const ResultCache::Rows& rows) {
+    size_t bytes = sizeof(ResultCache::Rows);
+    for (const auto& row : rows) {
+        bytes += sizeof(row) + row.size() * sizeof(std::string);
+        for (const auto& value : row) {
+            bytes += value.size();
+        }
+    }
+    return bytes;
+}
+
+} // namespace
+
+ResultCache& ResultCache::instance() {
+    static ResultCache cache;
+    return cache;
+}
+
+void ResultCache::setCapacity(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacityBytes_ = bytes;
+    evictToCapacity();
+}
+
+size_t ResultCache::getCapacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacityBytes_;
+}
+
+bool ResultCache::isEnabled() const {
+    return getCapacity() > 0;
+}
+
+std::string ResultCache::makeKey(const std::string& tableName, const std::vector<std::string>& columns,
+                                 const std::string& whereCondition) {
+    std::string key = tableName;
+    key += '\0';
+    for (size_t i = 0; i < columns.size(); i++) {
+        key += (i > 0 ? "," : "") + columns[i];
+    }
+    key += '\0';
+    
+    // Spell a condition the way the tables read it, so that name="bob" and
+    // name=bob share an entry; anything else is kept as written
+    Condition condition;
+    if (!whereCondition.empty() && Condition::parse(whereCondition, condition)) {
+        key += condition.column + comparisonSymbol(condition.comparison) + condition.value;
+    } else {
+        key += '\0' + whereCondition;
+    }
+    return key;
+}
+
+std::string ResultCache::entryKey(const void* database, const std::string& key) {
+    return std::to_string(reinterpret_cast<uintptr_t>(database)) + '\0' + key;
+}
+
+std::shared_ptr<const ResultCache::Rows> ResultCache::lookup(const void* database, const std::string& key,
+                                                             const Version& version) {
+    auto& metrics = util::Metrics::instance();
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = index_.find(entryKey(database, key));
+    if (it == index_.end()) {
+        metrics.add(util::Metrics::Counter::CACHE_MISSES);
+        return nullptr;
+    }
+    if (!(it->second->version == version)) {
+        // The table was written since; the entry can never hit again
+        erase(it->second);
+        metrics.add(util::Metrics::Counter::CACHE_MISSES);
+        return nullptr;
+    }
+    
+    entries_.splice(entries_.begin(), entries_, it->second);
+    metrics.add(util::Metrics::Counter::CACHE_HITS);
+    return entries_.front().rows;
+}
+
+void ResultCache::store(const void* database, const std::string& key, const Version& version, Rows rows) {
+    std::string fullKey = entryKey(database, key);
+    size_t bytes = sizeof(Entry) + fullKey.size() + sizeOfRows(rows);
+    auto shared = std::make_shared<const Rows>(std::move(rows));
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (bytes > capacityBytes_) {
+        return;
+    }
+    
+    auto it = index_.find(fullKey);
+    if (it != index_.end()) {
+        erase(it->second);
+    }
+    entries_.push_front(Entry{database, fullKey, version, std::move(shared), bytes});
+    index_.emplace(std::move(fullKey), entries_.begin());
+    bytes_ += bytes;
+    evictToCapacity();
+}
+
+void ResultCache::forget(const void* database) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        auto next = std::next(it);
+        if (it->database == database) {
+            erase(it);
+        }
+        it = next;
+    }
+}
+
+ResultCache::Usage ResultCache::getUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Usage{capacityBytes_, bytes_, entries_.size()};
+}
+
+void ResultCache::erase(std::list<Entry>::iterator entry) {
+    bytes_ -= entry->bytes;
+    index_.erase(entry->key);
+    entries_.erase(entry);
+}
+
+void ResultCache::evictToCapacity() {
+    auto& metrics = util::Metrics::instance();
+    while (bytes_ > capacityBytes_ && !entries_.empty()) {
+        erase(std::prev(entries_.end()));
+        metrics.add(util::Metrics::Counter::CACHE_EVICTIONS);
+    }
+}
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,182 @@
+#include "core/RowStore.h"
+
+namespace soliddb {
+namespace core {
+
+size_t RowStore::append(const RowImage& row, uint64_t beginTs) {
+    size_t slot = published_.load(std::memory_order_relaxed);
+    size_t chunkIndex = slot / CHUNK_SIZE;
+    
+    Chunk* chunk;
+    {
+        std::lock_guard<std::mutex> lock(directoryMutex_);
+        if (chunkIndex >= chunks_.size()) {
+            chunks_.push_back(std::make_shared<Chunk>());
+        }
+        chunk = chunks_[chunkIndex].get();
+    }
+    
+    // Codes, then the end offset of each value, then the value bytes
+    size_t textBytes = 0;
+    for (const auto& value : row.values) {
+        textBytes += value.size();
+    }
+    size_t reserved = chunk->values.reservedBytes();
+    size_t wordCount = row.codes.size() + row.values.size();
+    auto* data = static_cast<uint32_t*>(
+        chunk->values.allocate(wordCount * sizeof(uint32_t) + textBytes, alignof(uint32_t)));
+    std::copy(row.codes.begin(), row.codes.end(), data);
+    uint32_t* ends = data + row.codes.size();
+    char* text = reinterpret_cast<char*>(ends + row.values.size());
+    uint32_t offset = 0;
+    for (size_t i = 0; i < row.values.size(); i++) {
+        std::copy(row.values[i].begin(), row.values[i].end(), text + offset);
+        offset += static_cast<uint32_t>(row.values[i].size());
+        ends[i] = offset;
+    }
+    valueBytes_.fetch_add(chunk->values.reservedBytes() - reserved, std::memory_order_relaxed);
+    
+    RowVersion& version = chunk->versions[slot % CHUNK_SIZE];
+    version.row.data = data;
+    version.row.codedColumns = row.codedColumns;
+    version.row.codeCount = static_cast<uint32_t>(row.codes.size());
+    version.row.valueCount = static_cast<uint32_t>(row.values.size());
+    version.end.store(VersionManager::INFINITE_TS, std::memory_order_relaxed);
+    version.begin.store(beginTs, std::memory_order_relaxed);
+    
+    published_.store(slot + 1, std::memory_order_release);
+    return slot;
+}
+
+size_t RowStore::appendCopy(size_t slot, uint64_t beginTs) {
+    const EncodedRow& source = at(slot).row;
+    
+    // The views point into the source chunk's arena, which append leaves alone
+    RowImage copy;
+    copy.codedColumns = source.codedColumns;
+    copy.codes.assign(source.data, source.data + source.codeCount);
+    copy.values.reserve(source.valueCount);
+    for (size_t i = 0; i < source.valueCount; i++) {
+        copy.values.push_back(source.value(i));
+    }
+    return append(copy, beginTs);
+}
+
+void RowStore::retire(size_t slot, uint64_t endTs) {
+    Chunk* chunk;
+    {
+        std::lock_guard<std::mutex> lock(directoryMutex_);
+        chunk = chunks_[slot / CHUNK_SIZE].get();
+    }
+    
+    size_t offset = slot % CHUNK_SIZE;
+    chunk->versions[offset].end.store(endTs, std::memory_order_release);
+    chunk->tombstones[offset / 64].fetch_or(uint64_t{1} << (offset % 64), std::memory_order_release);
+}
+
+RowVersion& RowStore::at(size_t slot) {
+    std::lock_guard<std::mutex> lock(directoryMutex_);
+    return chunks_[slot / CHUNK_SIZE]->versions[slot % CHUNK_SIZE];
+}
+
+const RowVersion& RowStore::at(size_t slot) const {
+    std::lock_guard<std::mutex> lock(directoryMutex_);
+    return chunks_[slot / CHUNK_SIZE]->versions[slot % CHUNK_SIZE];
+}
+
+RowStore::View RowStore::view() const {
+    View view;
+    // Load the count first: every chunk it covers is already in the directory
+    view.count_ = published_.load(std::memory_order_acquire);
+    
+    std::lock_guard<std::mutex> lock(directoryMutex_);
+    size_t chunkCount = (view.count_ + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    view.chunks_.assign(chunks_.begin(), chunks_.begin() + chunkCount);
+    return view;
+}
+
+size_t RowStore::size() const {
+    return published_.load(std::memory_order_acquire);
+}
+
+size_t RowStore::collectGarbage(uint64_t horizon) {
+    size_t reclaimed = 0;
+    
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    {
+        std::lock_guard<std::mutex> lock(directoryMutex_);
+        chunks = chunks_;
+    }
+    
+    for (size_t c = 0; c < chunks.size(); c++) {
+        Chunk* chunk = chunks[c].get();
+        if (!chunk) {
+            continue;
+        }
+        
+        // Only ended versions can be reclaimed; live ones are never visited
+        for (size_t word = 0; word < chunk->tombstones.size(); word++) {
+            uint64_t bits = chunk->tombstones[word].load(std::memory_order_acquire);
+            while (bits != 0) {
+                size_t bit = __builtin_ctzll(bits);
+                bits &= bits - 1;
+                
+                RowVersion& version = chunk->versions[word * 64 + bit];
+                if (version.end.load(std::memory_order_acquire) > horizon) {
+                    continue;
+                }
+                // No snapshot can see this version; its values go with the chunk
+                version.reclaimed = true;
+                chunk->tombstones[word].fetch_and(~(uint64_t{1} << bit), std::memory_order_relaxed);
+                chunk->reclaimedCount++;
+                reclaimed++;
+            }
+        }
+        
+        // Release full chunks that hold nothing but reclaimed versions
+        if (chunk->reclaimedCount == CHUNK_SIZE) {
+            valueBytes_.fetch_sub(chunk->values.reservedBytes(), std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(directoryMutex_);
+            chunks_[c].reset();
+        }
+    }
+    
+    return reclaimed;
+}
+
+std::vector<size_t> RowStore::sparseChunks() const {
+    size_t fullChunks = published_.load(std::memory_order_acquire) / CHUNK_SIZE;
+    std::lock_guard<std::mutex> lock(directoryMutex_);
+    
+    std::vector<size_t> sparse;
+    for (size_t c = 0; c < fullChunks; c++) {
+        const Chunk* chunk = chunks_[c].get();
+        if (chunk && chunk->reclaimedCount >= COMPACT_THRESHOLD && chunk->reclaimedCount < CHUNK_SIZE) {
+            sparse.push_back(c);
+        }
+    }
+    return sparse;
+}
+
+size_t RowStore::chunkCount() const {
+    std::lock_guard<std::mutex> lock(directoryMutex_);
+    
+    size_t live = 0;
+    for (const auto& chunk : chunks_) {
+        if (chunk) {
+            live++;
+        }
+    }
+    return live;
+}
+
+size_t RowStore::slotBytes() const {
+    return chunkCount() * (sizeof(Chunk) + CHUNK_SIZE * sizeof(RowVersion));
+}
+
+size_t RowStore::valueBytes() const {
+    return valueBytes_.load(std::memory_order_relaxed);
+}
+
+} // namespace core
+} // namespace soliddb
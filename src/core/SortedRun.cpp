@@ -0,0 +1,314 @@
+#include "core/SortedRun.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "core/RowStore.h"
+#include "util/Metrics.h"
+#include "util/Varint.h"
+
+namespace soliddb {
+namespace core {
+
+namespace {
+
+constexpr char FOOTER_MAGIC[8] = {'S', 'D', 'B', 'R', 'U', 'N', '0', '1'};
+constexpr size_t FOOTER_SIZE = 3 * sizeof(uint64_t) + sizeof(FOOTER_MAGIC);
+constexpr size_t WRITE_BUFFER_SIZE = 1024 * 1024;
+
+void append64(std::string& out, uint64_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+uint64_t read64(const char* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+bool preadFully(int fd, char* data, size_t size, uint64_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::pread(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+SortedRun::Writer::Writer(const std::string& path, size_t expectedEntries)
+    : path_(path), filter_(expectedEntries) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "Error: Failed to create run file " << path << ": " << std::strerror(errno) << std::endl;
+        failed_ = true;
+    }
+}
+
+SortedRun::Writer::~Writer() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool SortedRun::Writer::add(std::string_view key, bool tombstone, std::string_view value) {
+    if (failed_) {
+        return false;
+    }
+    if (block_.empty()) {
+        blockFirstKey_.assign(key);
+    }
+    
+    util::Varint::write(block_, key.size());
+    block_ += key;
+    block_.push_back(tombstone ? 1 : 0);
+    util::Varint::write(block_, value.size());
+    block_ += value;
+    filter_.add(key);
+    entryCount_++;
+    
+    return block_.size() < BLOCK_SIZE || endBlock();
+}
+
+bool SortedRun::Writer::endBlock() {
+    if (block_.empty()) {
+        return true;
+    }
+    util::Varint::write(index_, blockFirstKey_.size());
+    index_ += blockFirstKey_;
+    util::Varint::write(index_, offset_);
+    util::Varint::write(index_, block_.size());
+    blockCount_++;
+    
+    bool written = append(block_);
+    block_.clear();
+    return written;
+}
+
+bool SortedRun::Writer::append(const std::string& data) {
+    buffer_ += data;
+    offset_ += data.size();
+    return buffer_.size() < WRITE_BUFFER_SIZE || writeBuffer();
+}
+
+bool SortedRun::Writer::writeBuffer() {
+    size_t done = 0;
+    while (done < buffer_.size()) {
+        ssize_t n = ::write(fd_, buffer_.data() + done, buffer_.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            std::cerr << "Error: Failed to write run file " << path_ << ": " << std::strerror(errno) << std::endl;
+            failed_ = true;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    util::Metrics::instance().add(util::Metrics::Counter::BYTES_WRITTEN, buffer_.size());
+    buffer_.clear();
+    return true;
+}
+
+std::shared_ptr<SortedRun> SortedRun::Writer::finish(uint64_t id) {
+    if (failed_ || !endBlock()) {
+        return nullptr;
+    }
+    
+    std::string tail;
+    uint64_t indexOffset = offset_;
+    util::Varint::write(tail, blockCount_);
+    tail += index_;
+    uint64_t filterOffset = offset_ + tail.size();
+    filter_.serialize(tail);
+    append64(tail, indexOffset);
+    append64(tail, filterOffset);
+    append64(tail, entryCount_);
+    tail.append(FOOTER_MAGIC, sizeof(FOOTER_MAGIC));
+    
+    if (!append(tail) || !writeBuffer() || ::fsync(fd_) != 0) {
+        return nullptr;
+    }
+    ::close(fd_);
+    fd_ = -1;
+    return SortedRun::open(path_, id);
+}
+
+SortedRun::Iterator::Iterator(const SortedRun& run) : run_(&run) {
+    valid_ = loadBlock() && decodeCurrent();
+}
+
+bool SortedRun::Iterator::loadBlock() {
+    pos_ = 0;
+    block_.clear();
+    while (blockIndex_ < run_->fences_.size()) {
+        if (!run_->readBlock(blockIndex_++, block_)) {
+            std::cerr << "Error: Failed to read run file " << run_->path_ << std::endl;
+            return false;
+        }
+        if (!block_.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SortedRun::Iterator::decodeCurrent() {
+    std::string_view key, value;
+    if (!decodeEntry(block_, pos_, key, tombstone_, value)) {
+        return false;
+    }
+    keyOffset_ = static_cast<size_t>(key.data() - block_.data());
+    keySize_ = key.size();
+    valueOffset_ = static_cast<size_t>(value.data() - block_.data());
+    valueSize_ = value.size();
+    return true;
+}
+
+void SortedRun::Iterator::next() {
+    valid_ = decodeCurrent() || (loadBlock() && decodeCurrent());
+}
+
+SortedRun::~SortedRun() {
+    ::close(fd_);
+}
+
+std::shared_ptr<SortedRun> SortedRun::open(const std::string& path, uint64_t id) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    std::shared_ptr<SortedRun> run(new SortedRun(fd, path, id));
+    
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < FOOTER_SIZE) {
+        return nullptr;
+    }
+    run->fileBytes_ = static_cast<uint64_t>(info.st_size);
+    
+    char footer[FOOTER_SIZE];
+    if (!preadFully(fd, footer, FOOTER_SIZE, run->fileBytes_ - FOOTER_SIZE) ||
+        std::memcmp(footer + 3 * sizeof(uint64_t), FOOTER_MAGIC, sizeof(FOOTER_MAGIC)) != 0) {
+        return nullptr;
+    }
+    uint64_t indexOffset = read64(footer);
+    uint64_t filterOffset = read64(footer + sizeof(uint64_t));
+    run->entryCount_ = read64(footer + 2 * sizeof(uint64_t));
+    if (indexOffset > filterOffset || filterOffset > run->fileBytes_ - FOOTER_SIZE) {
+        return nullptr;
+    }
+    
+    std::string tail(run->fileBytes_ - FOOTER_SIZE - indexOffset, '\0');
+    if (!preadFully(fd, tail.data(), tail.size(), indexOffset)) {
+        return nullptr;
+    }
+    std::string_view index(tail.data(), filterOffset - indexOffset);
+    std::string_view filter(tail.data() + index.size(), tail.size() - index.size());
+    
+    size_t pos = 0;
+    uint64_t blockCount;
+    if (!util::Varint::read(index, pos, blockCount)) {
+        return nullptr;
+    }
+    run->fences_.reserve(blockCount);
+    for (uint64_t i = 0; i < blockCount; i++) {
+        uint64_t keySize, offset, size;
+        if (!util::Varint::read(index, pos, keySize) || keySize > index.size() - pos) {
+            return nullptr;
+        }
+        std::string firstKey(index.substr(pos, keySize));
+        pos += keySize;
+        if (!util::Varint::read(index, pos, offset) || !util::Varint::read(index, pos, size) ||
+            offset > indexOffset || size > indexOffset - offset) {
+            return nullptr;
+        }
+        run->fences_.push_back(Fence{std::move(firstKey), offset, size});
+    }
+    if (!util::BloomFilter::deserialize(filter, run->filter_)) {
+        return nullptr;
+    }
+    return run;
+}
+
+SortedRun::Lookup SortedRun::get(std::string_view key, std::string& value) const {
+    auto& metrics = util::Metrics::instance();
+    if (!filter_.mayContain(key)) {
+        metrics.add(util::Metrics::Counter::BLOOM_SKIPS);
+        return Lookup::ABSENT;
+    }
+    
+    // Last block whose first key is not greater than the key
+    auto it = std::upper_bound(fences_.begin(), fences_.end(), key,
+                               [](std::string_view k, const Fence& fence) { return k < fence.firstKey; });
+    if (it == fences_.begin()) {
+        return Lookup::ABSENT;
+    }
+    
+    std::string block;
+    metrics.add(util::Metrics::Counter::RUN_BLOCK_READS);
+    if (!readBlock(static_cast<size_t>(it - fences_.begin()) - 1, block)) {
+        std::cerr << "Error: Failed to read run file " << path_ << std::endl;
+        return Lookup::ABSENT;
+    }
+    
+    size_t pos = 0;
+    std::string_view entryKey, entryValue;
+    bool tombstone;
+    while (decodeEntry(block, pos, entryKey, tombstone, entryValue)) {
+        if (entryKey == key) {
+            if (tombstone) {
+                return Lookup::DELETED;
+            }
+            value.assign(entryValue);
+            return Lookup::FOUND;
+        }
+        if (entryKey > key) {
+            break;
+        }
+    }
+    return Lookup::ABSENT;
+}
+
+size_t SortedRun::getMemoryUsage() const {
+    size_t bytes = fences_.capacity() * sizeof(Fence) + filter_.memoryBytes();
+    for (const auto& fence : fences_) {
+        bytes += stringHeapBytes(fence.firstKey);
+    }
+    return bytes;
+}
+
+bool SortedRun::readBlock(size_t index, std::string& block) const {
+    const Fence& fence = fences_[index];
+    block.resize(fence.size);
+    return preadFully(fd_, block.data(), block.size(), fence.offset);
+}
+
+bool SortedRun::decodeEntry(std::string_view block, size_t& pos, std::string_view& key, bool& tombstone,
+                            std::string_view& value) {
+    uint64_t keySize, valueSize;
+    if (!util::Varint::read(block, pos, keySize) || keySize >= block.size() - pos) {
+        return false;
+    }
+    key = block.substr(pos, keySize);
+    pos += keySize;
+    tombstone = block[pos++] != 0;
+    if (!util::Varint::read(block, pos, valueSize) || valueSize > block.size() - pos) {
+        return false;
+    }
+    value = block.substr(pos, valueSize);
+    pos += valueSize;
+    return true;
+}
+
+} // namespace core
+} // namespace soliddb
@@ -1,13 +1,73 @@
 #include "core/Table.h"
+#include "core/BlockCodec.h"
+#include "core/Transaction.h"
+#include "util/Metrics.h"
+#include "util/StringUtils.h"
 #include <sstream>
 #include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
 
 namespace soliddb {
 namespace core {
 
-Table::Table(const std::string& name, const std::vector<ColumnDef>& columns)
-    : name_(name), columns_(columns) {
+TableCursor::TableCursor(std::unique_ptr<VersionManager::Snapshot> snapshot, RowStore::View view,
+                         ColumnDictionaries dictionaries, uint64_t ownMarker)
+    : snapshot_(std::move(snapshot)), view_(std::move(view)),
+      dictionaries_(std::move(dictionaries)), ownMarker_(ownMarker) {
+}
+
+bool TableCursor::next() {
+    while (position_ < view_.size()) {
+        const RowVersion* version = view_.get(position_);
+        if (!version) {
+            // Released chunk: skip to the start of the next one
+            position_ = (position_ / RowStore::CHUNK_SIZE + 1) * RowStore::CHUNK_SIZE;
+            continue;
+        }
+        
+        position_++;
+        if (version->isVisible(snapshot_->timestamp(), ownMarker_)) {
+            current_ = version;
+            isDecoded_ = false;
+            return true;
+        }
+    }
+    
+    current_ = nullptr;
+    return false;
+}
+
+std::string_view TableCursor::get(size_t column) const {
+    return decodeColumn(current_->row, column, dictionaries_);
+}
+
+const std::vector<std::string>& TableCursor::row() const {
+    if (!isDecoded_) {
+        decoded_.resize(current_->row.columnCount());
+        for (size_t i = 0; i < decoded_.size(); i++) {
+            decoded_[i].assign(decodeColumn(current_->row, i, dictionaries_));
+        }
+        isDecoded_ = true;
+    }
+    return decoded_;
+}
+
+size_t TableCursor::getColumnCount() const {
+    return dictionaries_.size();
+}
+
+Table::Table(const std::string& name, const std::vector<ColumnDef>& columns,
+             std::shared_ptr<VersionManager> versionManager)
+    : name_(name), columns_(columns), versionManager_(std::move(versionManager)) {
+    
+    if (!versionManager_) {
+        versionManager_ = std::make_shared<VersionManager>();
+    }
     
     uniqueIndexes_.resize(columns.size());
     
@@ -18,10 +78,18 @@ Table::Table(const std::string& name, const std::vector<ColumnDef>& columns)
             columns_[pkIndex].constraints |= static_cast<int>(ColumnConstraint::NOT_NULL);
         }
     }
+    
+    initDictionaries();
+    zones_ = newZoneMap();
 }
 
-Table::Table(const std::string& name, const std::vector<std::pair<std::string, std::string>>& columns)
-    : name_(name) {
+Table::Table(const std::string& name, const std::vector<std::pair<std::string, std::string>>& columns,
+             std::shared_ptr<VersionManager> versionManager)
+    : name_(name), versionManager_(std::move(versionManager)) {
+    
+    if (!versionManager_) {
+        versionManager_ = std::make_shared<VersionManager>();
+    }
     
     // Convert simple columns to ColumnDef objects (with no constraints)
     columns_.reserve(columns.size());
@@ -31,9 +99,75 @@ Table::Table(const std::string& name, const std::vector<std::pair<std::string, s
     
     // Initialize empty unique indexes
     uniqueIndexes_.resize(columns.size());
+    
+    initDictionaries();
+    zones_ = newZoneMap();
+}
+
+void Table::initDictionaries() {
+    // Key columns have as many distinct values as rows; nothing to share
+    dictionaries_.resize(columns_.size());
+    for (size_t i = 0; i < columns_.size() && i < EncodedRow::MAX_CODED_COLUMNS; i++) {
+        if (!columns_[i].requiresUniqueValue()) {
+            dictionaries_[i] = std::make_shared<ColumnDictionary>();
+        }
+    }
+}
+
+ZoneMap Table::newZoneMap() const {
+    std::vector<bool> integerColumns(columns_.size());
+    for (size_t i = 0; i < columns_.size(); i++) {
+        integerColumns[i] = util::StringUtils::toUpper(columns_[i].type) == "INT";
+    }
+    return ZoneMap(std::move(integerColumns));
+}
+
+void Table::rebuildZones() {
+    std::unique_lock<util::SharedMutex> lock(zonesMutex_);
+    zones_.clear();
+    RowStore::View view = rows_.view();
+    for (size_t slot = 0; slot < view.size(); slot++) {
+        const RowVersion* version = view.get(slot);
+        if (!version) {
+            continue;
+        }
+        for (size_t i = 0; i < version->row.columnCount(); i++) {
+            zones_.add(slot, i, decodeColumn(version->row, i, dictionaries_));
+        }
+    }
+}
+
+const RowImage& Table::encodeRow(const std::vector<std::string>& values) {
+    RowImage& row = encodeBuffer_;
+    row.clear();
+    
+    for (size_t i = 0; i < values.size(); i++) {
+        std::optional<uint32_t> code;
+        if (dictionaries_[i]) {
+            code = dictionaries_[i]->encode(values[i]);
+        }
+        if (code) {
+            row.codes.push_back(*code);
+            row.codedColumns |= uint64_t{1} << i;
+        } else {
+            row.values.push_back(values[i]);
+        }
+    }
+    return row;
+}
+
+std::vector<std::string> Table::decodeRow(const EncodedRow& row) const {
+    std::vector<std::string> values;
+    values.reserve(row.columnCount());
+    for (size_t i = 0; i < row.columnCount(); i++) {
+        values.emplace_back(decodeColumn(row, i, dictionaries_));
+    }
+    return values;
 }
 
 bool Table::insertRow(const std::vector<std::string>& values) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
     if (!validateRow(values)) {
         return false;
     }
@@ -43,40 +177,555 @@ bool Table::insertRow(const std::vector<std::string>& values) {
         return false;
     }
     
-    // Add row
-    rows_.push_back(values);
+    // Stamp the new version; it becomes visible when the commit completes
+    VersionManager::CommitGuard commit(*versionManager_);
+    appendRow(values, commit.timestamp());
+    
+    return true;
+}
+
+size_t Table::insertRows(const std::vector<std::vector<std::string>>& rows) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    VersionManager::CommitGuard commit(*versionManager_);
+    size_t inserted = 0;
+    
+    for (const auto& values : rows) {
+        if (validateRow(values) && checkConstraints(values)) {
+            appendRow(values, commit.timestamp());
+            inserted++;
+        }
+    }
+    
+    return inserted;
+}
+
+TableCursor Table::openCursor(uint64_t ownMarker) const {
+    auto snapshot = versionManager_->openSnapshotHandle();
+    return TableCursor(std::move(snapshot), rows_.view(), dictionaries_, ownMarker);
+}
+
+bool Table::insertUncommitted(const std::vector<std::string>& values, uint64_t txnMarker, size_t& slot) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    // Uncommitted rows are indexed right away, so a concurrent transaction
+    // inserting the same key fails instead of both committing
+    if (!validateRow(values) || !checkConstraints(values, txnMarker)) {
+        return false;
+    }
+    
+    slot = appendRow(values, txnMarker);
+    return true;
+}
+
+void Table::commitVersion(size_t slot, uint64_t commitTs) {
+    noteCommit(commitTs);
+    rows_.at(slot).begin.store(commitTs, std::memory_order_release);
+}
+
+void Table::undoInsert(size_t slot) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    unindexVersion(slot);
+    // Never visible to anyone, so it can be reclaimed at the next collection
+    retireVersion(slot, VersionManager::BOOTSTRAP_TS);
+}
+
+bool Table::updateRows(const std::vector<std::pair<std::string, std::string>>& assignments,
+                       const std::string& whereCondition, uint64_t txnMarker, RowChanges& changes) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    std::vector<std::pair<size_t, std::string>> setColumns;
+    for (const auto& [columnName, value] : assignments) {
+        int column = getColumnIndex(columnName);
+        if (column < 0) {
+            std::cout << "Error: Unknown column '" << columnName << "'" << std::endl;
+            return false;
+        }
+        setColumns.emplace_back(column, value);
+    }
+    
+    std::vector<size_t> slots;
+    if (!findRowsToChange(whereCondition, txnMarker, slots)) {
+        return false;
+    }
+    
+    std::vector<std::vector<std::string>> oldRows;
+    std::vector<std::vector<std::string>> newRows;
+    oldRows.reserve(slots.size());
+    newRows.reserve(slots.size());
+    for (size_t slot : slots) {
+        oldRows.push_back(decodeRow(rows_.at(slot).row));
+        newRows.push_back(oldRows.back());
+        for (const auto& [column, value] : setColumns) {
+            newRows.back()[column] = value;
+        }
+    }
+    
+    // Release the old keys first, so rows can keep (or swap) their keys, and
+    // check the new rows against each other by indexing them as pending
+    for (size_t i = 0; i < slots.size(); i++) {
+        unindexRow(oldRows[i], slots[i]);
+    }
+    pendingRows_ = &newRows;
+    size_t checked = 0;
+    while (checked < newRows.size() && checkConstraints(newRows[checked])) {
+        indexRow(newRows[checked], PENDING_SLOT | checked);
+        checked++;
+    }
+    if (checked < newRows.size()) {
+        for (size_t i = 0; i < checked; i++) {
+            unindexRow(newRows[i], PENDING_SLOT | i);
+        }
+        pendingRows_ = nullptr;
+        for (size_t i = 0; i < slots.size(); i++) {
+            indexRow(oldRows[i], slots[i]);
+        }
+        return false;
+    }
+    
+    std::optional<VersionManager::CommitGuard> commit;
+    if (txnMarker == 0) {
+        commit.emplace(*versionManager_);
+    }
+    uint64_t stamp = commit ? commit->timestamp() : txnMarker;
+    
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (commit) {
+            retireVersion(slots[i], stamp);
+        } else {
+            rows_.at(slots[i]).end.store(stamp, std::memory_order_release);
+        }
+        changes.ended.push_back(slots[i]);
+        changes.added.push_back(appendRow(newRows[i], stamp));
+    }
+    // Every pending entry now points at its row
+    pendingRows_ = nullptr;
+    
+    if (!commit) {
+        // Keys the update changed stay reserved for the old rows until commit
+        for (size_t i = 0; i < slots.size(); i++) {
+            indexRow(oldRows[i], slots[i], false);
+        }
+        changes.endedRows = std::move(oldRows);
+        changes.addedRows = std::move(newRows);
+    }
+    
+    util::Metrics::instance().add(util::Metrics::Counter::ROWS_UPDATED, slots.size());
+    return true;
+}
+
+bool Table::deleteRows(const std::string& whereCondition, uint64_t txnMarker, RowChanges& changes) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    std::vector<size_t> slots;
+    if (!findRowsToChange(whereCondition, txnMarker, slots)) {
+        return false;
+    }
+    
+    if (txnMarker == 0) {
+        VersionManager::CommitGuard commit(*versionManager_);
+        for (size_t slot : slots) {
+            unindexVersion(slot);
+            retireVersion(slot, commit.timestamp());
+        }
+    } else {
+        // The keys stay indexed until commit; see releaseDeleted()
+        for (size_t slot : slots) {
+            rows_.at(slot).end.store(txnMarker, std::memory_order_release);
+            changes.endedRows.push_back(decodeRow(rows_.at(slot).row));
+        }
+    }
+    
+    util::Metrics::instance().add(util::Metrics::Counter::ROWS_DELETED, slots.size());
+    changes.ended = std::move(slots);
+    return true;
+}
+
+template <typename Fn>
+size_t Table::scanBlocks(const RowStore::View& view, const Predicate& predicate, uint64_t snapshot,
+                         uint64_t ownMarker, Fn&& fn) const {
+    std::vector<bool> ruledOut = ruledOutBlocks(predicate, view.size());
+    size_t skipped = 0;
+    for (size_t block = 0; block < ruledOut.size(); block++) {
+        if (ruledOut[block]) {
+            skipped++;
+            continue;
+        }
+        size_t first = block * ZoneMap::BLOCK_ROWS;
+        view.forEachVisible(snapshot, fn, ownMarker, first, first + ZoneMap::BLOCK_ROWS);
+    }
+    
+    auto& metrics = util::Metrics::instance();
+    metrics.add(util::Metrics::Counter::BLOCKS_SKIPPED, skipped);
+    metrics.add(util::Metrics::Counter::BLOCKS_SCANNED, ruledOut.size() - skipped);
+    return skipped;
+}
+
+bool Table::findRowsToChange(const std::string& whereCondition, uint64_t ownMarker,
+                             std::vector<size_t>& slots) const {
+    Predicate predicate;
+    if (!whereCondition.empty()) {
+        predicate = planCondition(whereCondition);
+    }
+    
+    // Writers are serialized, so the newest committed versions plus our own
+    // are the current rows; a matching row whose version another
+    // transaction has ended (or replaced) is a write conflict
+    bool conflict = false;
+    auto collect = [&](size_t slot, const RowVersion& version) {
+        if (!predicate.matches(version.row)) {
+            return;
+        }
+        uint64_t beginTs = version.begin.load(std::memory_order_acquire);
+        bool isOtherTransaction = (beginTs & Transaction::MARKER_FLAG) != 0 && beginTs != ownMarker;
+        if (version.end.load(std::memory_order_acquire) != VersionManager::INFINITE_TS || isOtherTransaction) {
+            conflict = true;
+            return;
+        }
+        slots.push_back(slot);
+    };
+    
+    int pkIndex = getPrimaryKeyColumnIndex();
+    RowStore::View view = rows_.view();
+    if (pkIndex >= 0 && predicate.column == pkIndex && predicate.comparison == Comparison::EQUAL) {
+        // Point change: the primary key index holds the slot of the current version
+        util::Metrics::instance().add(util::Metrics::Counter::INDEX_PROBES);
+        size_t position = findKey(primaryKeyIndex_, pkIndex, predicate.value);
+        if (position != KeyIndex::NOT_FOUND && !isPending(primaryKeyIndex_.slotAt(position))) {
+            util::Metrics::instance().add(util::Metrics::Counter::INDEX_HITS);
+            size_t slot = primaryKeyIndex_.slotAt(position);
+            const RowVersion& version = *view.get(slot);
+            // Our own deletes keep their key indexed until commit
+            if (version.end.load(std::memory_order_acquire) != ownMarker || ownMarker == 0) {
+                collect(slot, version);
+            }
+        }
+        if (auto* trace = util::Metrics::activeTrace()) {
+            trace->accessPath = "PrimaryKeyLookup " + name_;
+        }
+    } else {
+        size_t scanned = 0;
+        size_t skipped = scanBlocks(view, predicate, versionManager_->currentTimestamp(), ownMarker,
+                                    [&](size_t slot, const RowVersion& version) {
+            scanned++;
+            collect(slot, version);
+        });
+        util::Metrics::instance().add(util::Metrics::Counter::ROWS_SCANNED, scanned);
+        if (auto* trace = util::Metrics::activeTrace()) {
+            trace->accessPath = "SeqScan " + name_;
+            if (predicate.column >= 0) {
+                trace->accessPath += ", filter on " + columns_[predicate.column].name;
+            }
+            if (skipped > 0) {
+                trace->accessPath += ", " + std::to_string(skipped) + " block(s) skipped";
+            }
+        }
+    }
+    
+    if (conflict) {
+        std::cout << "Error: A row of '" << name_ << "' is being changed by another transaction" << std::endl;
+        slots.clear();
+        return false;
+    }
+    return true;
+}
+
+void Table::commitDelete(size_t slot, uint64_t commitTs) {
+    retireVersion(slot, commitTs);
+}
+
+void Table::releaseDeleted(size_t slot) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    unindexVersion(slot);
+}
+
+void Table::undoDelete(size_t slot) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    rows_.at(slot).end.store(VersionManager::INFINITE_TS, std::memory_order_release);
+    // An update undone just before dropped the keys this row shared with its new version
+    indexRow(decodeRow(rows_.at(slot).row), slot);
+}
+
+bool Table::loadRow(const std::vector<std::string>& values) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    if (!validateRow(values) || !checkConstraints(values)) {
+        return false;
+    }
+    
+    appendRow(values, VersionManager::BOOTSTRAP_TS);
+    return true;
+}
+
+bool Table::unloadRow(const std::vector<std::string>& values) {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    std::optional<size_t> found;
+    rows_.view().forEachVisible(versionManager_->currentTimestamp(), [&](size_t slot, const RowVersion& version) {
+        if (!found && version.row.columnCount() == values.size() && decodeRow(version.row) == values) {
+            found = slot;
+        }
+    });
+    if (!found) {
+        return false;
+    }
+    
+    unindexVersion(*found);
+    retireVersion(*found, VersionManager::BOOTSTRAP_TS);
+    return true;
+}
+
+size_t Table::appendRow(const std::vector<std::string>& values, uint64_t beginTs) {
+    // A scan must never see a row its block's zones do not cover yet
+    if (maintainZones_) {
+        std::unique_lock<util::SharedMutex> zonesLock(zonesMutex_);
+        for (size_t i = 0; i < values.size(); i++) {
+            zones_.add(rows_.size(), i, values[i]);
+        }
+    }
+    
+    noteCommit(beginTs);
+    size_t slot = rows_.append(encodeRow(values), beginTs);
+    indexRow(values, slot);
+    liveRows_++;
+    return slot;
+}
+
+void Table::indexRow(const std::vector<std::string>& values, size_t slot, bool replace) {
+    // Growing an index re-reads the key of every entry; a view reads the
+    // rows without taking the directory lock for each
+    std::optional<RowStore::View> view;
+    auto index = [&](KeyIndex& keyIndex, size_t column) {
+        const std::string& key = values[column];
+        size_t position = findKey(keyIndex, column, key);
+        if (position == KeyIndex::NOT_FOUND) {
+            keyIndex.insert(KeyIndex::hash(key), slot, [&](size_t other) {
+                if (isPending(other)) {
+                    return KeyIndex::hash(indexedKey(other, column));
+                }
+                if (!view) {
+                    view = rows_.view();
+                }
+                return KeyIndex::hash(decodeColumn(view->get(other)->row, column, dictionaries_));
+            });
+        } else if (replace) {
+            keyIndex.setSlot(position, slot);
+        }
+    };
+    
+    int pkIndex = getPrimaryKeyColumnIndex();
+    if (pkIndex >= 0) {
+        index(primaryKeyIndex_, pkIndex);
+    }
     
-    // Update indexes
-    size_t rowIndex = rows_.size() - 1;
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (isUniqueIndexed(i) && !values[i].empty()) {
+            index(uniqueIndexes_[i], i);
+        }
+    }
     
-    // Update primary key index if there is one
+    updateIndexMemory();
+}
+
+void Table::unindexRow(const std::vector<std::string>& values, size_t slot) {
+    // Entries another version has taken over are left alone
     int pkIndex = getPrimaryKeyColumnIndex();
     if (pkIndex >= 0) {
-        primaryKeyIndex_[values[pkIndex]] = rowIndex;
+        primaryKeyIndex_.erase(KeyIndex::hash(values[pkIndex]), slot);
     }
     
-    // Update unique indexes
     for (size_t i = 0; i < columns_.size(); i++) {
-        if (columns_[i].requiresUniqueValue()) {
-            uniqueIndexes_[i].insert(values[i]);
+        if (isUniqueIndexed(i)) {
+            uniqueIndexes_[i].erase(KeyIndex::hash(values[i]), slot);
         }
     }
     
-    return true;
+    updateIndexMemory();
+}
+
+void Table::unindexVersion(size_t slot) {
+    bool hasKeys = getPrimaryKeyColumnIndex() >= 0;
+    for (size_t i = 0; i < columns_.size() && !hasKeys; i++) {
+        hasKeys = isUniqueIndexed(i);
+    }
+    if (hasKeys) {
+        unindexRow(decodeRow(rows_.at(slot).row), slot);
+    }
+}
+
+void Table::updateIndexMemory() {
+    primaryKeyIndexBytes_ = primaryKeyIndex_.memoryBytes();
+    
+    size_t uniqueBytes = 0;
+    for (const auto& index : uniqueIndexes_) {
+        uniqueBytes += index.memoryBytes();
+    }
+    uniqueIndexBytes_ = uniqueBytes;
+}
+
+std::string_view Table::indexedKey(size_t slot, size_t column) const {
+    if (isPending(slot)) {
+        return (*pendingRows_)[slot & ~PENDING_SLOT][column];
+    }
+    return decodeColumn(rows_.at(slot).row, column, dictionaries_);
+}
+
+size_t Table::findKey(const KeyIndex& index, size_t column, std::string_view key) const {
+    return index.find(KeyIndex::hash(key), [&](size_t slot) { return indexedKey(slot, column) == key; });
+}
+
+bool Table::isUniqueIndexed(size_t column) const {
+    return columns_[column].isUnique() && !columns_[column].isPrimaryKey();
+}
+
+void Table::retireVersion(size_t slot, uint64_t endTs) {
+    noteCommit(endTs);
+    rows_.retire(slot, endTs);
+    liveRows_--;
+    retiredVersions_++;
+}
+
+void Table::noteCommit(uint64_t commitTs) {
+    if ((commitTs & Transaction::MARKER_FLAG) != 0) {
+        return;
+    }
+    uint64_t last = lastCommitTs_.load(std::memory_order_relaxed);
+    while (last < commitTs && !lastCommitTs_.compare_exchange_weak(last, commitTs, std::memory_order_relaxed)) {
+    }
 }
 
 std::vector<std::vector<std::string>> Table::selectRows(
     const std::vector<std::string>& columns,
-    const std::string& whereCondition) const {
+    const std::string& whereCondition,
+    uint64_t ownMarker,
+    QueryPlan* analysis,
+    const VersionManager::Snapshot* snapshot) const {
     
     std::vector<std::vector<std::string>> result;
+    std::vector<int> columnIndices;
+    Predicate predicate;
     
-    // If no columns specified, return all columns
-    bool returnAllColumns = columns.empty();
+    {
+        util::PhaseTimer planTimer(util::Metrics::Phase::PLAN);
+        planSelect(columns, whereCondition, columnIndices, predicate);
+    }
+    
+    // Scan a snapshot; concurrent inserts are not blocked and not seen
+    std::unique_ptr<VersionManager::Snapshot> ownSnapshot;
+    if (!snapshot) {
+        ownSnapshot = versionManager_->openSnapshotHandle();
+        snapshot = ownSnapshot.get();
+    }
+    RowStore::View view = rows_.view();
+    size_t scanned = 0;
+    size_t skipped = 0;
+    
+    if (analysis) {
+        // Same loop, but every operator is timed separately
+        using Clock = std::chrono::steady_clock;
+        *analysis = describeSelect(columnIndices, predicate, !whereCondition.empty(), view);
+        analysis->analyzed = true;
+        PlanOperator* scan = analysis->find("SeqScan");
+        PlanOperator* filter = analysis->find("Filter");
+        PlanOperator* project = analysis->find("Project");
+        
+        Clock::duration filterTime{0};
+        Clock::duration projectTime{0};
+        auto scanStart = Clock::now();
+        
+        skipped = scanBlocks(view, predicate, snapshot->timestamp(), ownMarker, [&](size_t, const RowVersion& version) {
+            const EncodedRow& row = version.row;
+            scanned++;
+            
+            auto filterStart = Clock::now();
+            bool matches = predicate.matches(row);
+            auto projectStart = Clock::now();
+            filterTime += projectStart - filterStart;
+            if (!matches) {
+                return;
+            }
+            
+            std::vector<std::string> resultRow;
+            resultRow.reserve(columnIndices.size());
+            size_t bytes = sizeof(resultRow) + columnIndices.size() * sizeof(std::string);
+            for (int idx : columnIndices) {
+                resultRow.emplace_back(decodeColumn(row, idx, dictionaries_));
+                if (resultRow.back().capacity() > std::string().capacity()) {
+                    bytes += resultRow.back().capacity() + 1;
+                }
+            }
+            result.push_back(std::move(resultRow));
+            project->bytesAllocated += bytes;
+            projectTime += Clock::now() - projectStart;
+        });
+        
+        auto toNanos = [](Clock::duration d) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+        };
+        auto total = Clock::now() - scanStart;
+        project->bytesAllocated += result.capacity() * sizeof(std::vector<std::string>);
+        
+        scan->rowsIn = view.size();
+        scan->rowsOut = scanned;
+        scan->nanoseconds = toNanos(total - filterTime - projectTime);
+        if (filter) {
+            filter->rowsIn = scanned;
+            filter->rowsOut = result.size();
+            filter->nanoseconds = toNanos(filterTime);
+        }
+        project->rowsIn = result.size();
+        project->rowsOut = result.size();
+        project->nanoseconds = toNanos(projectTime);
+    } else {
+        skipped = scanBlocks(view, predicate, snapshot->timestamp(), ownMarker, [&](size_t, const RowVersion& version) {
+            const EncodedRow& row = version.row;
+            scanned++;
+            
+            // Skip rows that don't satisfy the condition
+            if (!predicate.matches(row)) {
+                return;
+            }
+            
+            // Add matching row (with selected columns) to result
+            std::vector<std::string> resultRow;
+            resultRow.reserve(columnIndices.size());
+            for (int idx : columnIndices) {
+                resultRow.emplace_back(decodeColumn(row, idx, dictionaries_));
+            }
+            result.push_back(std::move(resultRow));
+        });
+    }
+    
+    auto& metrics = util::Metrics::instance();
+    metrics.add(util::Metrics::Counter::ROWS_SCANNED, scanned);
+    metrics.add(util::Metrics::Counter::ROWS_RETURNED, result.size());
+    if (auto* trace = util::Metrics::activeTrace()) {
+        trace->accessPath = "SeqScan " + name_;
+        if (predicate.column >= 0) {
+            trace->accessPath += ", filter on " + columns_[predicate.column].name;
+        }
+        if (skipped > 0) {
+            trace->accessPath += ", " + std::to_string(skipped) + " block(s) skipped";
+        }
+    }
     
-    // Determine column indices to return
+    return result;
+}
+
+QueryPlan Table::explainSelect(const std::vector<std::string>& columns,
+                               const std::string& whereCondition) const {
     std::vector<int> columnIndices;
-    if (!returnAllColumns) {
+    Predicate predicate;
+    planSelect(columns, whereCondition, columnIndices, predicate);
+    return describeSelect(columnIndices, predicate, !whereCondition.empty(), rows_.view());
+}
+
+void Table::planSelect(const std::vector<std::string>& columns, const std::string& whereCondition,
+                       std::vector<int>& columnIndices, Predicate& predicate) const {
+    // If no columns specified, return all columns
+    if (!columns.empty()) {
         for (const auto& col : columns) {
             int idx = getColumnIndex(col);
             if (idx >= 0) {
@@ -84,28 +733,52 @@ std::vector<std::vector<std::string>> Table::selectRows(
             }
         }
     } else {
-        // Return all columns
         for (size_t i = 0; i < columns_.size(); i++) {
             columnIndices.push_back(static_cast<int>(i));
         }
     }
     
-    // Process each row
-    for (const auto& row : rows_) {
-        // Skip rows that don't satisfy the condition
-        if (!whereCondition.empty() && !evaluateCondition(row, whereCondition)) {
-            continue;
-        }
-        
-        // Add matching row (with selected columns) to result
-        std::vector<std::string> resultRow;
-        for (int idx : columnIndices) {
-            resultRow.push_back(row[idx]);
+    if (!whereCondition.empty()) {
+        predicate = planCondition(whereCondition);
+    }
+}
+
+QueryPlan Table::describeSelect(const std::vector<int>& columnIndices, const Predicate& predicate,
+                                bool hasCondition, const RowStore::View& view) const {
+    QueryPlan plan;
+    
+    std::string projection;
+    for (int idx : columnIndices) {
+        projection += (projection.empty() ? "" : ", ") + columns_[idx].name;
+    }
+    plan.add("Project", projection);
+    
+    if (hasCondition) {
+        std::string filter;
+        if (predicate.matchesNothing) {
+            filter = "unknown column, matches no rows";
+        } else if (predicate.column >= 0) {
+            filter = columns_[predicate.column].name + " " + comparisonSymbol(predicate.comparison) + " '" +
+                     predicate.value + "'";
+            if (predicate.hasCode) {
+                filter += ", dictionary code " + std::to_string(predicate.code);
+            }
+        } else {
+            filter = "no comparison, matches every row";
         }
-        result.push_back(resultRow);
+        plan.add("Filter", filter);
     }
     
-    return result;
+    // Every select is a scan of the visible versions; the PK and UNIQUE
+    // indexes are only used for constraint checks
+    std::string scan = name_ + ", snapshot of " + std::to_string(view.size()) + " version(s)";
+    if (predicate.column >= 0) {
+        std::vector<bool> ruledOut = ruledOutBlocks(predicate, view.size());
+        scan += ", zone maps skip " + std::to_string(std::count(ruledOut.begin(), ruledOut.end(), true)) +
+                " of " + std::to_string(ruledOut.size()) + " block(s)";
+    }
+    plan.add("SeqScan", scan);
+    return plan;
 }
 
 std::string Table::getName() const {
@@ -128,9 +801,116 @@ const std::vector<ColumnDef>& Table::getColumns() const {
 }
 
 size_t Table::getRowCount() const {
+    return liveRows_.load();
+}
+
+size_t Table::getVersionCount() const {
     return rows_.size();
 }
 
+TableMemoryUsage Table::getMemoryUsage() const {
+    TableMemoryUsage usage;
+    usage.versionSlots = rows_.slotBytes();
+    usage.values = rows_.valueBytes();
+    usage.primaryKeyIndex = primaryKeyIndexBytes_.load();
+    usage.uniqueIndexes = uniqueIndexBytes_.load();
+    for (const auto& dictionary : dictionaries_) {
+        if (dictionary) {
+            usage.dictionaries += dictionary->memoryBytes();
+        }
+    }
+    return usage;
+}
+
+uint64_t Table::getLastCommitTimestamp() const {
+    return lastCommitTs_.load();
+}
+
+size_t Table::collectGarbage(uint64_t horizon) {
+    if (retiredVersions_.load() == 0) {
+        return 0;
+    }
+    
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    size_t reclaimed = rows_.collectGarbage(horizon);
+    retiredVersions_ -= reclaimed;
+    return reclaimed;
+}
+
+size_t Table::compact() {
+    std::unique_lock<util::SharedMutex> lock(mutex_);
+    
+    std::vector<size_t> chunks = rows_.sparseChunks();
+    if (chunks.empty()) {
+        return 0;
+    }
+    
+    // Slots of versions an open transaction wrote or deleted are in its undo
+    // log, so chunks holding any are left for a later pass
+    RowStore::View view = rows_.view();
+    std::vector<size_t> moving;
+    for (size_t chunk : chunks) {
+        size_t first = chunk * RowStore::CHUNK_SIZE;
+        std::vector<size_t> current;
+        bool pinned = false;
+        for (size_t slot = first; slot < first + RowStore::CHUNK_SIZE && !pinned; slot++) {
+            const RowVersion& version = *view.get(slot);
+            if (version.reclaimed) {
+                continue;
+            }
+            uint64_t endTs = version.end.load(std::memory_order_acquire);
+            if (endTs == VersionManager::INFINITE_TS) {
+                pinned = (version.begin.load(std::memory_order_acquire) & Transaction::MARKER_FLAG) != 0;
+                current.push_back(slot);
+            } else {
+                pinned = (endTs & Transaction::MARKER_FLAG) != 0;
+            }
+        }
+        if (!pinned) {
+            moving.insert(moving.end(), current.begin(), current.end());
+        }
+    }
+    if (moving.empty()) {
+        return 0;
+    }
+    
+    // Snapshots before the commit read the originals, later ones the copies
+    VersionManager::CommitGuard commit(*versionManager_);
+    int pkIndex = getPrimaryKeyColumnIndex();
+    for (size_t slot : moving) {
+        {
+            std::unique_lock<util::SharedMutex> zonesLock(zonesMutex_);
+            const EncodedRow& original = rows_.at(slot).row;
+            for (size_t i = 0; i < original.columnCount(); i++) {
+                zones_.add(rows_.size(), i, decodeColumn(original, i, dictionaries_));
+            }
+        }
+        size_t copy = rows_.appendCopy(slot, commit.timestamp());
+        rows_.retire(slot, commit.timestamp());
+        
+        // Point the keys at the copy
+        const EncodedRow& row = rows_.at(slot).row;
+        auto remap = [&](KeyIndex& index, size_t column) {
+            size_t position = findKey(index, column, decodeColumn(row, column, dictionaries_));
+            if (position != KeyIndex::NOT_FOUND && index.slotAt(position) == slot) {
+                index.setSlot(position, copy);
+            }
+        };
+        if (pkIndex >= 0) {
+            remap(primaryKeyIndex_, pkIndex);
+        }
+        for (size_t i = 0; i < columns_.size(); i++) {
+            if (isUniqueIndexed(i)) {
+                remap(uniqueIndexes_[i], i);
+            }
+        }
+    }
+    retiredVersions_ += moving.size();
+    
+    util::Metrics::instance().add(util::Metrics::Counter::ROWS_COMPACTED, moving.size());
+    return moving.size();
+}
+
 bool Table::validateRow(const std::vector<std::string>& values) const {
     if (values.size() != columns_.size()) {
         std::cout << "Error: Expected " << columns_.size() << " values, got " << values.size() << std::endl;
@@ -142,7 +922,7 @@ bool Table::validateRow(const std::vector<std::string>& values) const {
     return true;
 }
 
-bool Table::checkConstraints(const std::vector<std::string>& values) {
+bool Table::checkConstraints(const std::vector<std::string>& values, uint64_t ownMarker) {
     //  NOT NULL constraints
     for (size_t i = 0; i < columns_.size(); i++) {
         if (columns_[i].isNotNull() && values[i].empty()) {
@@ -151,11 +931,23 @@ bool Table::checkConstraints(const std::vector<std::string>& values) {
         }
     }
     
+    auto& metrics = util::Metrics::instance();
+    auto isTaken = [&](const KeyIndex& index, size_t column, const std::string& key) {
+        size_t position = findKey(index, column, key);
+        if (position == KeyIndex::NOT_FOUND) {
+            return false;
+        }
+        size_t slot = index.slotAt(position);
+        return ownMarker == 0 || isPending(slot) || rows_.at(slot).end.load(std::memory_order_acquire) != ownMarker;
+    };
+    
     //  PRIMARY KEY constraint
     int pkIndex = getPrimaryKeyColumnIndex();
     if (pkIndex >= 0) {
         const std::string& pkValue = values[pkIndex];
-        if (primaryKeyIndex_.find(pkValue) != primaryKeyIndex_.end()) {
+        metrics.add(util::Metrics::Counter::INDEX_PROBES);
+        if (isTaken(primaryKeyIndex_, pkIndex, pkValue)) {
+            metrics.add(util::Metrics::Counter::INDEX_HITS);
             std::cout << "Error: Duplicate primary key value '" << pkValue << "'" << std::endl;
             return false;
         }
@@ -163,9 +955,14 @@ bool Table::checkConstraints(const std::vector<std::string>& values) {
     
     //  UNIQUE constraints
     for (size_t i = 0; i < columns_.size(); i++) {
-        if (columns_[i].isUnique() && !columns_[i].isPrimaryKey()) {
+        if (isUniqueIndexed(i)) {
             const std::string& uniqueValue = values[i];
-            if (!uniqueValue.empty() && uniqueIndexes_[i].find(uniqueValue) != uniqueIndexes_[i].end()) {
+            if (uniqueValue.empty()) {
+                continue;
+            }
+            metrics.add(util::Metrics::Counter::INDEX_PROBES);
+            if (isTaken(uniqueIndexes_[i], i, uniqueValue)) {
+                metrics.add(util::Metrics::Counter::INDEX_HITS);
                 std::cout << "Error: Duplicate value '" << uniqueValue << "' in unique column '" 
                           << columns_[i].name << "'" << std::endl;
                 return false;
@@ -185,27 +982,49 @@ int Table::getColumnIndex(const std::string& columnName) const {
     return -1;
 }
 
-bool Table::evaluateCondition(const std::vector<std::string>& row, const std::string& condition) const {
-    // only supports conditions like "column=value"
+Table::Predicate Table::planCondition(const std::string& condition) const {
+    // only supports conditions like "column=value", "column<value", ...
+    Predicate predicate;
     
-    size_t pos = condition.find('=');
-    if (pos == std::string::npos) {
-        return true; 
+    Condition parsed;
+    if (!Condition::parse(condition, parsed)) {
+        return predicate; 
     }
     
-    std::string columnName = condition.substr(0, pos);
-    std::string value = condition.substr(pos + 1);
+    predicate.column = getColumnIndex(parsed.column);
+    predicate.matchesNothing = predicate.column < 0;
+    predicate.comparison = parsed.comparison;
+    predicate.value = std::move(parsed.value);
     
-    if (!value.empty() && value.front() == '"' && value.back() == '"') {
-        value = value.substr(1, value.size() - 2);
+    if (predicate.column >= 0 && predicate.comparison != Comparison::EQUAL) {
+        predicate.isInteger = util::StringUtils::toUpper(columns_[predicate.column].type) == "INT" &&
+                              parseInteger(predicate.value, predicate.integer);
+        predicate.dictionary = dictionaries_[predicate.column].get();
+        return predicate;
     }
     
-    int colIndex = getColumnIndex(columnName);
-    if (colIndex < 0 || colIndex >= static_cast<int>(row.size())) {
-        return false;
+    // Coded rows are compared by code; a value missing from the dictionary
+    // can only match rows stored as text
+    if (predicate.column >= 0 && dictionaries_[predicate.column]) {
+        if (auto code = dictionaries_[predicate.column]->find(predicate.value)) {
+            predicate.hasCode = true;
+            predicate.code = *code;
+        }
+    }
+    return predicate;
+}
+
+std::vector<bool> Table::ruledOutBlocks(const Predicate& predicate, size_t slotCount) const {
+    std::vector<bool> ruledOut((slotCount + ZoneMap::BLOCK_ROWS - 1) / ZoneMap::BLOCK_ROWS, false);
+    if (predicate.matchesNothing || predicate.column < 0) {
+        return ruledOut;
     }
     
-    return row[colIndex] == value;
+    std::shared_lock<util::SharedMutex> lock(zonesMutex_);
+    for (size_t block = 0; block < ruledOut.size(); block++) {
+        ruledOut[block] = zones_.rulesOut(block, predicate.column, predicate.comparison, predicate.value);
+    }
+    return ruledOut;
 }
 
 int Table::getPrimaryKeyColumnIndex() const {
@@ -218,6 +1037,93 @@ int Table::getPrimaryKeyColumnIndex() const {
 }
 
 std::string Table::serialize() const {
+    // Serialize a consistent snapshot without blocking writers
+    auto snapshot = versionManager_->openSnapshot();
+    return serialize(snapshot.timestamp());
+}
+
+std::string Table::serialize(uint64_t snapshotTs, bool compressed) const {
+    // Capture the dictionaries first: any version visible at the snapshot
+    // was coded (or not) before its commit, so it agrees with this state
+    std::vector<size_t> dictionarySizes(columns_.size(), 0);
+    std::vector<bool> writeCodes(columns_.size(), false);
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (dictionaries_[i]) {
+            writeCodes[i] = !dictionaries_[i]->isFrozen();
+            dictionarySizes[i] = dictionaries_[i]->size();
+        }
+    }
+    
+    RowStore::View view = rows_.view();
+    
+    std::stringstream rowStream;
+    size_t rowCount = 0;
+    
+    // Zones of the rows as written, which get slots in file order on loading
+    ZoneMap fileZones = newZoneMap();
+    auto addZones = [&](const EncodedRow& row) {
+        for (size_t i = 0; i < row.columnCount(); i++) {
+            fileZones.add(rowCount, i, decodeColumn(row, i, dictionaries_));
+        }
+    };
+    std::vector<std::vector<BlockCodec::Column>> blocks;
+    if (compressed) {
+        // Values stay in the arenas (or dictionaries) while the snapshot is
+        // open. Columns written as codes are coded in every visible version.
+        std::vector<bool> integerColumns(columns_.size());
+        for (size_t i = 0; i < columns_.size(); i++) {
+            integerColumns[i] = writeCodes[i] || util::StringUtils::toUpper(columns_[i].type) == "INT";
+        }
+        view.forEachVisible(snapshotTs, [&](size_t, const RowVersion& version) {
+            const EncodedRow& row = version.row;
+            if (rowCount % BlockCodec::BLOCK_ROWS == 0) {
+                blocks.emplace_back(columns_.size());
+                for (size_t i = 0; i < columns_.size(); i++) {
+                    blocks.back()[i].isInteger = integerColumns[i];
+                }
+            }
+            for (size_t i = 0; i < row.columnCount(); i++) {
+                auto& column = blocks.back()[i];
+                if (writeCodes[i]) {
+                    column.integers.push_back(row.code(row.position(i)));
+                    continue;
+                }
+                std::string_view value = decodeColumn(row, i, dictionaries_);
+                column.text.push_back(value);
+                if (column.isInteger) {
+                    // Only integers that print back as the same text are packed
+                    int64_t integer = 0;
+                    char digits[24];
+                    auto parsed = std::from_chars(value.data(), value.data() + value.size(), integer);
+                    auto printed = std::to_chars(digits, digits + sizeof(digits), integer);
+                    column.isInteger = parsed.ec == std::errc() &&
+                                       parsed.ptr == value.data() + value.size() &&
+                                       value == std::string_view(digits, printed.ptr - digits);
+                    column.integers.push_back(integer);
+                }
+            }
+            addZones(row);
+            rowCount++;
+        });
+    } else {
+        view.forEachVisible(snapshotTs, [&](size_t, const RowVersion& version) {
+            const EncodedRow& row = version.row;
+            for (size_t i = 0; i < row.columnCount(); i++) {
+                if (writeCodes[i] && row.isCoded(i)) {
+                    rowStream << row.code(row.position(i));
+                } else {
+                    rowStream << decodeColumn(row, i, dictionaries_);
+                }
+                if (i < row.columnCount() - 1) {
+                    rowStream << ",";
+                }
+            }
+            rowStream << "\n";
+            addZones(row);
+            rowCount++;
+        });
+    }
+    
     std::stringstream ss;
     
     ss << name_ << std::endl;
@@ -227,21 +1133,47 @@ std::string Table::serialize() const {
         ss << col.name << "," << col.type << "," << col.constraints << std::endl;
     }
     
-    ss << rows_.size() << std::endl;
-    for (const auto& row : rows_) {
-        for (size_t i = 0; i < row.size(); i++) {
-            ss << row[i];
-            if (i < row.size() - 1) {
-                ss << ",";
+    // Rows hold codes for columns with a DICTIONARY section; PLAIN marks a
+    // column whose dictionary overflowed, so loading does not retry it
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (writeCodes[i]) {
+            ss << "DICTIONARY " << i << " " << dictionarySizes[i] << "\n";
+            for (size_t code = 0; code < dictionarySizes[i]; code++) {
+                ss << dictionaries_[i]->decode(static_cast<uint32_t>(code)) << "\n";
             }
+        } else if (dictionaries_[i]) {
+            ss << "PLAIN " << i << "\n";
         }
-        ss << std::endl;
+    }
+    fileZones.write(ss);
+    
+    if (!compressed) {
+        ss << rowCount << std::endl;
+        ss << rowStream.str();
+        return ss.str();
+    }
+    
+    std::vector<std::string> encoded(blocks.size());
+    BlockCodec::parallelFor(blocks.size(), [&](size_t i) {
+        size_t blockRows = std::min(BlockCodec::BLOCK_ROWS, rowCount - i * BlockCodec::BLOCK_ROWS);
+        encoded[i] = BlockCodec::encodeBlock(blocks[i], blockRows);
+    });
+    
+    // Each block is prefixed by its size (4 bytes, little endian)
+    ss << "BLOCKS " << rowCount << " " << encoded.size() << "\n";
+    for (const auto& block : encoded) {
+        uint32_t size = static_cast<uint32_t>(block.size());
+        char prefix[4] = {static_cast<char>(size), static_cast<char>(size >> 8),
+                          static_cast<char>(size >> 16), static_cast<char>(size >> 24)};
+        ss.write(prefix, sizeof(prefix));
+        ss << block;
     }
     
     return ss.str();
 }
 
-std::unique_ptr<Table> Table::deserialize(const std::string& data) {
+std::unique_ptr<Table> Table::deserialize(const std::string& data,
+                                          std::shared_ptr<VersionManager> versionManager) {
     std::stringstream ss(data);
     std::string line;
     
@@ -276,11 +1208,86 @@ std::unique_ptr<Table> Table::deserialize(const std::string& data) {
         columns.emplace_back(colName, colType, constraints);
     }
     
-    auto table = std::make_unique<Table>(tableName, columns);
+    auto table = std::make_unique<Table>(tableName, columns, std::move(versionManager));
     
-    int rowCount;
-    ss >> rowCount;
-    ss.ignore(); 
+    // Dictionaries come back with the same codes; files written before
+    // dictionary coding have no such sections and are coded while loading
+    std::vector<bool> readCodes(columns.size(), false);
+    int rowCount = 0;
+    size_t blockCount = 0;
+    bool blocks = false;
+    ZoneMap fileZones = table->newZoneMap();
+    bool hasZones = false;
+    while (std::getline(ss, line)) {
+        std::stringstream header(line);
+        std::string kind;
+        size_t column = 0;
+        header >> kind >> column;
+        
+        if (kind == "DICTIONARY" && column < columns.size() && table->dictionaries_[column]) {
+            size_t size = 0;
+            header >> size;
+            for (size_t code = 0; code < size && std::getline(ss, line); code++) {
+                table->dictionaries_[column]->encode(line);
+            }
+            readCodes[column] = true;
+        } else if (kind == "PLAIN" && column < columns.size() && table->dictionaries_[column]) {
+            table->dictionaries_[column]->freeze();
+        } else if (kind == "ZONES") {
+            // "ZONES <blocks>"; loading the rows then skips maintaining them
+            hasZones = fileZones.read(ss, column);
+        } else if (kind == "BLOCKS") {
+            // "BLOCKS <rows> <blocks>", then the size-prefixed blocks
+            rowCount = static_cast<int>(column);
+            header >> blockCount;
+            blocks = true;
+            break;
+        } else {
+            try {
+                rowCount = std::stoi(line);
+            } catch (...) {
+                rowCount = 0;
+            }
+            break;
+        }
+    }
+    
+    auto loadValues = [&](std::vector<std::string>& values) {
+        for (size_t column = 0; column < values.size() && column < readCodes.size(); column++) {
+            if (readCodes[column]) {
+                // Stored as a code; re-encoding the text finds the same code
+                std::string& value = values[column];
+                uint32_t code = 0;
+                auto result = std::from_chars(value.data(), value.data() + value.size(), code);
+                if (result.ec == std::errc() && code < table->dictionaries_[column]->size()) {
+                    value = table->dictionaries_[column]->decode(code);
+                }
+            }
+        }
+        table->loadRow(values);
+    };
+    
+    // The stored zones fit only if every row got the slot of its position
+    table->maintainZones_ = !hasZones;
+    auto installZones = [&]() {
+        if (hasZones) {
+            table->maintainZones_ = true;
+            if (table->rows_.size() == static_cast<size_t>(rowCount)) {
+                table->zones_ = std::move(fileZones);
+            } else {
+                table->rebuildZones();
+            }
+        }
+    };
+    
+    if (blocks) {
+        if (!table->loadBlocks(data, ss.tellg(), blockCount, loadValues)) {
+            std::cerr << "Warning: Table '" << tableName << "' has a corrupt block; later rows were not loaded"
+                      << std::endl;
+        }
+        installZones();
+        return table;
+    }
     
     for (int i = 0; i < rowCount; i++) {
         std::string rowData;
@@ -294,11 +1301,50 @@ std::unique_ptr<Table> Table::deserialize(const std::string& data) {
             values.push_back(value);
         }
         
-        table->insertRow(values);
+        loadValues(values);
     }
     
+    installZones();
     return table;
 }
 
+bool Table::loadBlocks(const std::string& data, size_t offset, size_t blockCount,
+                       const std::function<void(std::vector<std::string>&)>& loadValues) {
+    std::vector<std::string_view> blocks;
+    for (size_t i = 0; i < blockCount; i++) {
+        if (data.size() - offset < 4) {
+            break;
+        }
+        const auto* prefix = reinterpret_cast<const unsigned char*>(data.data() + offset);
+        size_t size = prefix[0] | (prefix[1] << 8) | (prefix[2] << 16) | (size_t(prefix[3]) << 24);
+        offset += 4;
+        if (size > data.size() - offset) {
+            break;
+        }
+        blocks.emplace_back(data.data() + offset, size);
+        offset += size;
+    }
+    
+    // Decode a wave of blocks in parallel, then load its rows in file order
+    size_t waveSize = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::vector<std::vector<std::string>>> decoded(waveSize);
+    std::vector<char> valid(waveSize);
+    for (size_t first = 0; first < blocks.size(); first += waveSize) {
+        size_t count = std::min(waveSize, blocks.size() - first);
+        BlockCodec::parallelFor(count, [&](size_t i) {
+            valid[i] = BlockCodec::decodeBlock(blocks[first + i], columns_.size(), decoded[i]);
+        });
+        for (size_t i = 0; i < count; i++) {
+            if (!valid[i]) {
+                return false;
+            }
+            for (auto& values : decoded[i]) {
+                loadValues(values);
+            }
+        }
+    }
+    return blocks.size() == blockCount;
+}
+
 } // namespace core
 } // namespace soliddb 
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "core/VersionManager.h"
+
+namespace soliddb {
+namespace core {
+
+VersionManager::Snapshot::Snapshot(VersionManager& manager, uint64_t timestamp)
+    : manager_(manager), timestamp_(timestamp) {
+}
+
+VersionManager::Snapshot::~Snapshot() {
+    manager_.releaseSnapshot(timestamp_);
+}
+
+VersionManager::CommitGuard::CommitGuard(VersionManager& manager)
+    : manager_(manager), lock_(manager.commitMutex_) {
+    timestamp_ = manager_.clock_.load(std::memory_order_relaxed) + 1;
+}
+
+VersionManager::CommitGuard::~CommitGuard() {
+    manager_.clock_.store(timestamp_, std::memory_order_release);
+}
+
+uint64_t VersionManager::currentTimestamp() const {
+    return clock_.load(std::memory_order_acquire);
+}
+
+VersionManager::Snapshot VersionManager::openSnapshot() {
+    return Snapshot(*this, registerSnapshot());
+}
+
+std::unique_ptr<VersionManager::Snapshot> VersionManager::openSnapshotHandle() {
+    return std::make_unique<Snapshot>(*this, registerSnapshot());
+}
+
+uint64_t VersionManager::registerSnapshot() {
+    std::lock_guard<std::mutex> lock(snapshotMutex_);
+    
+    // Read the clock under the lock so the garbage collector never computes
+    // a horizon newer than a snapshot that is being registered
+    uint64_t timestamp = clock_.load(std::memory_order_acquire);
+    activeSnapshots_[timestamp]++;
+    return timestamp;
+}
+
+void VersionManager::releaseSnapshot(uint64_t timestamp) {
+    std::lock_guard<std::mutex> lock(snapshotMutex_);
+    
+    auto it = activeSnapshots_.find(timestamp);
+    if (it != activeSnapshots_.end() && --it->second == 0) {
+        activeSnapshots_.erase(it);
+    }
+}
+
+uint64_t VersionManager::oldestActiveSnapshot() const {
+    std::lock_guard<std::mutex> lock(snapshotMutex_);
+    
+    if (activeSnapshots_.empty()) {
+        return clock_.load(std::memory_order_acquire);
+    }
+    return activeSnapshots_.begin()->first;
+}
+
+size_t VersionManager::activeSnapshotCount() const {
+    std::lock_guard<std::mutex> lock(snapshotMutex_);
+    
+    size_t count = 0;
+    for (const auto& [_, readers] : activeSnapshots_) {
+        count += readers;
+    }
+    return count;
+}
+
+} // namespace core
+} // namespace soliddb
@@ -0,0 +1,167 @@
+#include "core/ZoneMap.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace soliddb {
+namespace core {
+
+namespace {
+
+template <typename T>
+int orderOf(const T& left, const T& right) {
+    return left < right ? -1 : (right < left ? 1 : 0);
+}
+
+/**
+ * Whether no value between min and max satisfies "x <comparison> value"
+ */
+template <typename T>
+bool outside(Comparison comparison, const T& min, const T& max, const T& value) {
+    switch (comparison) {
+        case Comparison::EQUAL:
+            return value < min || max < value;
+        case Comparison::LESS:
+        case Comparison::LESS_EQUAL:
+            return !holds(comparison, orderOf(min, value));
+        default:
+            return !holds(comparison, orderOf(max, value));
+    }
+}
+
+} // namespace
+
+ZoneMap::ZoneMap(std::vector<bool> integerColumns)
+    : integerColumns_(std::move(integerColumns)) {}
+
+ZoneMap::Zone& ZoneMap::zoneOf(size_t block, size_t column) {
+    return zones_[block * integerColumns_.size() + column];
+}
+
+const ZoneMap::Zone& ZoneMap::zoneOf(size_t block, size_t column) const {
+    return zones_[block * integerColumns_.size() + column];
+}
+
+void ZoneMap::add(size_t slot, size_t column, std::string_view value) {
+    size_t block = slot / BLOCK_ROWS;
+    if (block >= blockCount()) {
+        zones_.resize((block + 1) * integerColumns_.size());
+    }
+    
+    Zone& zone = zoneOf(block, column);
+    if (value.empty()) {
+        zone.nullCount++;
+        return;
+    }
+    
+    bool first = zone.valueCount++ == 0;
+    if (integerColumns_[column]) {
+        int64_t integer = 0;
+        if (!parseInteger(value, integer)) {
+            zone.ordered = false;
+        } else if (first) {
+            zone.minInteger = integer;
+            zone.maxInteger = integer;
+        } else {
+            zone.minInteger = std::min(zone.minInteger, integer);
+            zone.maxInteger = std::max(zone.maxInteger, integer);
+        }
+        return;
+    }
+    
+    if (first || value < zone.minText) {
+        zone.minText = value;
+    }
+    if (first || value > zone.maxText) {
+        zone.maxText = value;
+    }
+}
+
+bool ZoneMap::rulesOut(size_t block, size_t column, Comparison comparison, std::string_view value) const {
+    if (block >= blockCount()) {
+        return false;
+    }
+    
+    // NULLs only match "column=" (an empty value); ranges never match them
+    const Zone& zone = zoneOf(block, column);
+    if (value.empty() && comparison == Comparison::EQUAL) {
+        return zone.nullCount == 0;
+    }
+    if (zone.valueCount == 0) {
+        return true;
+    }
+    
+    if (!integerColumns_[column]) {
+        return outside(comparison, std::string_view(zone.minText), std::string_view(zone.maxText), value);
+    }
+    if (!zone.ordered) {
+        return false;
+    }
+    int64_t integer = 0;
+    if (!parseInteger(value, integer)) {
+        // Rows compare as text then; only equality is decided (by no
+        // non-integer being in the block)
+        return comparison == Comparison::EQUAL;
+    }
+    return outside(comparison, zone.minInteger, zone.maxInteger, integer);
+}
+
+size_t ZoneMap::blockCount() const {
+    return integerColumns_.empty() ? 0 : zones_.size() / integerColumns_.size();
+}
+
+void ZoneMap::clear() {
+    zones_.clear();
+}
+
+void ZoneMap::write(std::ostream& out) const {
+    // Per zone: "<nulls> <values> <ordered>", then the minimum and maximum
+    // on lines of their own if the zone has ordered values
+    out << "ZONES " << blockCount() << "\n";
+    for (size_t i = 0; i < zones_.size(); i++) {
+        const Zone& zone = zones_[i];
+        out << zone.nullCount << " " << zone.valueCount << " " << (zone.ordered ? 1 : 0) << "\n";
+        if (zone.valueCount == 0 || !zone.ordered) {
+            continue;
+        }
+        if (integerColumns_[i % integerColumns_.size()]) {
+            out << zone.minInteger << "\n" << zone.maxInteger << "\n";
+        } else {
+            out << zone.minText << "\n" << zone.maxText << "\n";
+        }
+    }
+}
+
+bool ZoneMap::read(std::istream& in, size_t blockCount) {
+    zones_.assign(blockCount * integerColumns_.size(), Zone());
+    std::string line;
+    for (size_t i = 0; i < zones_.size(); i++) {
+        Zone& zone = zones_[i];
+        int ordered = 1;
+        if (!std::getline(in, line) ||
+            std::sscanf(line.c_str(), "%zu %zu %d", &zone.nullCount, &zone.valueCount, &ordered) != 3) {
+            zones_.clear();
+            return false;
+        }
+        zone.ordered = ordered != 0;
+        if (zone.valueCount == 0 || !zone.ordered) {
+            continue;
+        }
+    
+        std::string min, max;
+        if (!std::getline(in, min) || !std::getline(in, max)) {
+            zones_.clear();
+            return false;
+        }
+        if (!integerColumns_[i % integerColumns_.size()]) {
+            zone.minText = std::move(min);
+            zone.maxText = std::move(max);
+        } else if (!parseInteger(min, zone.minInteger) || !parseInteger(max, zone.maxInteger)) {
+            zones_.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace core
+} // namespace soliddb
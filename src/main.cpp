@@ -1,44 +1,333 @@
 #include "SolidDB.h"
+#include "server/Server.h"
+#include "util/Console.h"
+#include "util/Metrics.h"
+#include "util/SlowQueryLog.h"
+#include "util/WorkloadCapture.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <memory>
 
 using namespace soliddb;
 
-int main() {
+namespace {
+
+/**
+ * Command-line options
+ */
+struct Options {
+    std::string scriptPath;     // "-" reads the script from stdin
+    bool batch = false;
+    bool quiet = false;
+    bool stopOnError = false;
+    std::string listenAddress;  // host:port, enables server mode
+    size_t workers = 4;
+    size_t databaseCacheBytes = core::DatabaseRegistry::DEFAULT_MEMORY_BUDGET;
+    size_t databaseMemoryBudget = 0;
+    bool readOnly = false;          // Open databases from their EXPORT READONLY files
+    size_t bufferPoolBytes = core::BufferPool::DEFAULT_CAPACITY;
+    size_t resultCacheBytes = 0;    // SELECT result cache, disabled when 0
+    size_t slowQueryMillis = 0;     // Slow query log threshold, disabled when 0
+    std::string capturePath;        // Workload capture for soliddb_replay, disabled when empty
+    std::string statsFile;      // Periodic SHOW STATS dump, disabled when empty
+    size_t statsInterval = 60;
+};
+
+server::Server* activeServer = nullptr;
+
+void handleShutdownSignal(int) {
+    if (activeServer) {
+        activeServer->stop();
+    }
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n";
+    std::cout << "  (no options)          Start the interactive shell\n";
+    std::cout << "  -f, --file <path>     Execute statements from a script file ('-' for stdin)\n";
+    std::cout << "  -b, --batch           Execute statements from stdin without prompts\n";
+    std::cout << "  -q, --quiet           Suppress status messages (results and errors are still shown)\n";
+    std::cout << "  --stop-on-error       Abort the script at the first failing statement\n";
+    std::cout << "  --listen <host:port>  Serve clients over TCP instead of the interactive shell\n";
+    std::cout << "  --workers <n>         Worker threads executing statements in server mode (default 4)\n";
+    std::cout << "  --db-cache <MiB>      Memory budget for databases kept open between USE switches (default 256)\n";
+    std::cout << "  --memory-budget <MiB> Reject writes to a database above this memory estimate (default unlimited)\n";
+    std::cout << "  --buffer-pool <MiB>   Memory for caching the pages of ENGINE=PAGED tables (default 64)\n";
+    std::cout << "  --result-cache <MiB>  Memory for caching SELECT results until their table changes (default off)\n";
+    std::cout << "  --read-only           Serve databases read-only from memory-mapped EXPORT READONLY files\n";
+    std::cout << "  --slow-query-ms <ms>  Log statements slower than this to <database>/slow_query.log\n";
+    std::cout << "  --capture <path>      Record every statement to a file for soliddb_replay\n";
+    std::cout << "  --stats-file <path>   Append engine statistics to a file periodically\n";
+    std::cout << "  --stats-interval <s>  Seconds between statistics dumps (default 60)\n";
+    std::cout << "  -h, --help            Show this help message\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if ((arg == "-f" || arg == "--file") && i + 1 < argc) {
+            options.scriptPath = argv[++i];
+            options.batch = true;
+        } else if (arg == "-b" || arg == "--batch") {
+            options.batch = true;
+        } else if (arg == "-q" || arg == "--quiet") {
+            options.quiet = true;
+        } else if (arg == "--read-only") {
+            options.readOnly = true;
+        } else if (arg == "--stop-on-error") {
+            options.stopOnError = true;
+        } else if (arg == "--listen" && i + 1 < argc) {
+            options.listenAddress = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            try {
+                options.workers = std::stoul(argv[++i]);
+            } catch (...) {
+                return false;
+            }
+        } else if (arg == "--stats-file" && i + 1 < argc) {
+            options.statsFile = argv[++i];
+        } else if (arg == "--stats-interval" && i + 1 < argc) {
+            try {
+                options.statsInterval = std::max<size_t>(1, std::stoul(argv[++i]));
+            } catch (...) {
+                return false;
+            }
+        } else if (arg == "--db-cache" && i + 1 < argc) {
+            try {
+                options.databaseCacheBytes = std::stoul(argv[++i]) * 1024 * 1024;
+            } catch (...) {
+                return false;
+            }
+        } else if (arg == "--capture" && i + 1 < argc) {
+            options.capturePath = argv[++i];
+        } else if (arg == "--slow-query-ms" && i + 1 < argc) {
+            try {
+                options.slowQueryMillis = std::stoul(argv[++i]);
+            } catch (...) {
+                return false;
+            }
+        } else if (arg == "--buffer-pool" && i + 1 < argc) {
+            try {
+                options.bufferPoolBytes = std::stoul(argv[++i]) * 1024 * 1024;
+            } catch (...) {
+                return false;
+            }
+        } else if (arg == "--result-cache" && i + 1 < argc) {
+            try {
+                options.resultCacheBytes = std::stoul(argv[++i]) * 1024 * 1024;
+            } catch (...) {
+                return false;
+            }
+        } else if (arg == "--memory-budget" && i + 1 < argc) {
+            try {
+                options.databaseMemoryBudget = std::stoul(argv[++i]) * 1024 * 1024;
+            } catch (...) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Execute every statement of a script without prompts. Output is buffered and
+ * a throughput summary is written to stderr at the end.
+ * @return process exit code
+ */
+int runBatch(const Options& options) {
+    std::ifstream scriptFile;
+    std::istream* input = &std::cin;
+
+    if (!options.scriptPath.empty() && options.scriptPath != "-") {
+        scriptFile.open(options.scriptPath);
+        if (!scriptFile) {
+            std::cerr << "Error: Cannot open script file: " << options.scriptPath << std::endl;
+            return 1;
+        }
+        input = &scriptFile;
+    }
+
+    util::Console::enableBufferedOutput();
+    util::Console::setQuiet(options.quiet);
+
+    std::shared_ptr<core::Database> currentDatabase;
+    parser::CommandParser parser;
+    parser.setQuiet(options.quiet);
+    parser.getRegistry()->setMemoryBudget(options.databaseCacheBytes);
+    parser.getRegistry()->setDatabaseMemoryBudget(options.databaseMemoryBudget);
+    parser.getRegistry()->setReadOnly(options.readOnly);
+
+    size_t statements = 0;
+    size_t failures = 0;
+    size_t lineNumber = 0;
+    bool aborted = false;
+    std::string line;
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (std::getline(*input, line)) {
+        lineNumber++;
+
+        std::string statement = util::StringUtils::trim(line);
+        if (statement.empty() || util::StringUtils::startsWith(statement, "--")) {
+            continue;
+        }
+
+        statements++;
+        bool continueRunning = parser.executeCommand(statement, currentDatabase);
+
+        if (parser.lastCommandFailed()) {
+            failures++;
+            if (options.stopOnError) {
+                std::cout << "Stopping at line " << lineNumber << " (--stop-on-error).\n";
+                aborted = true;
+                break;
+            }
+        }
+
+        if (!continueRunning) {
+            break;
+        }
+    }
+
+    // Final checkpoints happen when the databases close; keep them inside the timing
+    currentDatabase.reset();
+    parser.getRegistry()->closeAll();
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    util::Console::flush();
+
+    double rate = elapsed > 0 ? statements / elapsed : 0.0;
+    std::cerr << "Executed " << statements << " statement(s), " << failures << " failed"
+              << (aborted ? " (aborted)" : "") << " in " << elapsed << " s ("
+              << static_cast<long long>(rate) << " statements/sec)" << std::endl;
+
+    return failures > 0 ? 1 : 0;
+}
+
+int runServer(const Options& options) {
+    server::ServerConfig config;
+    config.workerThreads = options.workers;
+    config.databaseCacheBytes = options.databaseCacheBytes;
+    config.databaseMemoryBudget = options.databaseMemoryBudget;
+    config.readOnly = options.readOnly;
+
+    size_t colonPos = options.listenAddress.rfind(':');
+    if (colonPos == std::string::npos) {
+        std::cerr << "Error: --listen expects <host:port>" << std::endl;
+        return 2;
+    }
+    config.host = options.listenAddress.substr(0, colonPos);
+    try {
+        config.port = static_cast<uint16_t>(std::stoul(options.listenAddress.substr(colonPos + 1)));
+    } catch (...) {
+        std::cerr << "Error: Invalid port in --listen address" << std::endl;
+        return 2;
+    }
+
+    util::Console::setQuiet(options.quiet);
+
+    server::Server server(config);
+    activeServer = &server;
+    std::signal(SIGINT, handleShutdownSignal);
+    std::signal(SIGTERM, handleShutdownSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    bool started = server.run();
+    activeServer = nullptr;
+    return started ? 0 : 1;
+}
+
+int runInteractive(const Options& options) {
     std::shared_ptr<core::Database> currentDatabase;
     parser::CommandParser parser;
     std::string input;
-    
+
+    util::Console::setQuiet(options.quiet);
+    parser.setQuiet(options.quiet);
+    parser.getRegistry()->setMemoryBudget(options.databaseCacheBytes);
+    parser.getRegistry()->setDatabaseMemoryBudget(options.databaseMemoryBudget);
+    parser.getRegistry()->setReadOnly(options.readOnly);
+
     std::cout << "Welcome to SolidDB v" << VERSION << "!\n";
     std::cout << "Type HELP for a list of commands or EXIT to quit.\n";
-    
+
     while (true) {
         if (currentDatabase) {
             std::cout << currentDatabase->getName() << "> ";
         } else {
             std::cout << "SolidDB> ";
         }
-        
+
         if (!std::getline(std::cin, input)) {
             break;
         }
-        
+
         if (input.empty()) {
             continue;
         }
-        
+
         bool continueRunning = parser.executeCommand(input, currentDatabase);
         if (!continueRunning) {
             break;
         }
     }
-    
+
     if (currentDatabase) {
         currentDatabase->saveToFile();
     }
-    
+
     std::cout << "Goodbye!\n";
     return 0;
 }
 
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+
+    if (argc > 1 && (std::strcmp(argv[1], "-h") == 0 || std::strcmp(argv[1], "--help") == 0)) {
+        printUsage(argv[0]);
+        return 0;
+    }
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    if (!options.statsFile.empty()) {
+        util::Metrics::instance().startPeriodicDump(options.statsFile,
+                                                    std::chrono::seconds(options.statsInterval));
+    }
+    core::BufferPool::instance().setCapacity(options.bufferPoolBytes);
+    core::ResultCache::instance().setCapacity(options.resultCacheBytes);
+    util::SlowQueryLog::instance().setThreshold(std::chrono::milliseconds(options.slowQueryMillis));
+    if (!options.capturePath.empty() && !util::WorkloadCapture::instance().start(options.capturePath)) {
+        std::cerr << "Error: Cannot write capture file: " << options.capturePath << std::endl;
+        return 1;
+    }
+
+    int exitCode;
+    if (!options.listenAddress.empty()) {
+        exitCode = runServer(options);
+    } else if (options.batch) {
+        exitCode = runBatch(options);
+    } else {
+        exitCode = runInteractive(options);
+    }
+
+    util::Metrics::instance().stopPeriodicDump();
+    util::SlowQueryLog::instance().flush();
+    util::WorkloadCapture::instance().stop();
+    return exitCode;
+}
@@ -1,36 +1,159 @@
 #include "parser/CommandParser.h"
+#include "core/Condition.h"
 #include "util/StringUtils.h"
+#include "util/Console.h"
+#include "util/Metrics.h"
+#include "util/SlowQueryLog.h"
+#include "util/WorkloadCapture.h"
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
 #include <filesystem>
+#include <iomanip>
+#include <optional>
+#include <sstream>
 
 namespace fs = std::filesystem;
 namespace soliddb {
 namespace parser {
 
-CommandParser::CommandParser() : operationCount(0) {
+namespace {
+
+std::atomic<uint32_t> nextSessionId{1};
+
+uint64_t elapsedSince(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+/**
+ * Position of the " WHERE" keyword of an uppercased statement at or after
+ * from, also when it ends the statement; npos if there is none
+ */
+size_t findWhere(const std::string& upper, size_t from) {
+    size_t pos = upper.find(" WHERE ", from);
+    if (pos == std::string::npos && upper.size() >= from + 6 &&
+        upper.compare(upper.size() - 6, 6, " WHERE") == 0) {
+        pos = upper.size() - 6;
+    }
+    return pos;
+}
+
+/**
+ * Condition of a WHERE clause found at wherePos, or false if the clause is
+ * empty or not a comparison, which a write must not take as "every row"
+ */
+bool parseWhereClause(const std::string& command, size_t wherePos, std::string& whereCondition) {
+    whereCondition = util::StringUtils::trim(command.substr(std::min(wherePos + 7, command.size())));
+    core::Condition condition;
+    return !whereCondition.empty() && core::Condition::parse(whereCondition, condition);
+}
+
+} // namespace
+
+CommandParser::CommandParser()
+    : operationCount(0), sessionId_(nextSessionId++), out_(&std::cout), quiet_(false), lastCommandFailed_(false),
+      registry_(std::make_shared<core::DatabaseRegistry>()) {
+}
+
+CommandParser::~CommandParser() {
+    if (transaction_ && transactionDatabase_) {
+        transactionDatabase_->rollbackTransaction(*transaction_);
+    }
+}
+
+void CommandParser::setOutput(std::ostream& out) {
+    out_ = &out;
+}
+
+void CommandParser::setQuiet(bool quiet) {
+    quiet_ = quiet;
+}
+
+bool CommandParser::lastCommandFailed() const {
+    return lastCommandFailed_;
+}
+
+void CommandParser::setRegistry(std::shared_ptr<core::DatabaseRegistry> registry) {
+    registry_ = std::move(registry);
+}
+
+std::shared_ptr<core::DatabaseRegistry> CommandParser::getRegistry() const {
+    return registry_;
+}
+
+std::ostream& CommandParser::out() const {
+    return *out_;
+}
+
+std::ostream& CommandParser::status() const {
+    if (quiet_) {
+        return util::Console::null();
+    }
+    return *out_;
+}
+
+std::ostream& CommandParser::error() {
+    lastCommandFailed_ = true;
+    return *out_;
 }
 
 bool CommandParser::executeCommand(const std::string& command, std::shared_ptr<core::Database>& currentDatabase) {
+    lastCommandFailed_ = false;
+    
     if (command.empty()) {
         return true;
     }
     
+    auto& metrics = util::Metrics::instance();
+    auto statementStart = std::chrono::steady_clock::now();
+    
     std::vector<std::string> tokens = tokenize(command, ' ');
     if (tokens.empty()) {
         return true;
     }
     
+    auto& capture = util::WorkloadCapture::instance();
+    if (capture.isActive()) {
+        capture.record(sessionId_, currentDatabase ? currentDatabase->getName() : "", command);
+    }
+    
+    util::Metrics::Trace trace;
+    util::TraceScope traceScope(trace);
+    
     std::string cmd = util::StringUtils::toUpper(tokens[0]);
+    metrics.recordPhase(util::Metrics::Phase::PARSE, elapsedSince(statementStart));
+    util::ScopedTimer statementTimer(metrics.statement(util::Metrics::classify(cmd)), statementStart);
+    
+    auto executeStart = std::chrono::steady_clock::now();
     bool result = true;
     bool isWriteOperation = false;
     
     if (cmd == "HELP") {
         printHelp();
     }
+    else if (transaction_ && (cmd == "CREATE" || cmd == "USE" || cmd == "ALTER")) {
+        error() << "Error: " << cmd << " is not allowed inside a transaction. Use COMMIT or ROLLBACK first.\n";
+    }
+    else if (currentDatabase && currentDatabase->isReadOnly() &&
+             (cmd == "INSERT" || cmd == "UPDATE" || cmd == "DELETE" || cmd == "BEGIN" ||
+              (cmd == "CREATE" && tokens.size() >= 2 && util::StringUtils::toUpper(tokens[1]) == "TABLE") ||
+              cmd == "ALTER" ||
+              (cmd == "SET" && tokens.size() >= 2 && util::StringUtils::toUpper(tokens[1]) == "COMPRESSION") ||
+              cmd == "EXPORT")) {
+        error() << "Error: Database '" << currentDatabase->getName() << "' is open read-only.\n";
+    }
     else if (cmd == "EXIT") {
+        if (transaction_) {
+            status() << "Rolling back open transaction...\n";
+            transactionDatabase_->rollbackTransaction(*transaction_);
+            transaction_.reset();
+            transactionDatabase_.reset();
+        }
         if (currentDatabase) {
-            std::cout << "Saving database before exit...\n";
+            status() << "Saving database before exit...\n";
             currentDatabase->checkpoint();
         }
         return false;
@@ -47,22 +170,35 @@ bool CommandParser::executeCommand(const std::string& command, std::shared_ptr<c
             isWriteOperation = true;
         }
         else {
-            std::cout << "Error: Invalid CREATE command. Use CREATE DATABASE or CREATE TABLE.\n";
+            error() << "Error: Invalid CREATE command. Use CREATE DATABASE or CREATE TABLE.\n";
         }
     }
+    else if (cmd == "ALTER" && tokens.size() >= 6) {
+        result = handleAlterTable(tokens, currentDatabase);
+        isWriteOperation = true;
+    }
     else if (cmd == "USE" && tokens.size() >= 2) {
-        if (currentDatabase) {
-            currentDatabase->saveToFile();
-        }
         result = handleUseDatabase(tokens, currentDatabase);
     }
     else if (cmd == "INSERT" && tokens.size() >= 5) {
+        // Inside a transaction the statement is logged when it commits
+        isWriteOperation = !transaction_;
         result = handleInsert(command, tokens, currentDatabase);
-        isWriteOperation = true;
+    }
+    else if (cmd == "UPDATE" && tokens.size() >= 4) {
+        isWriteOperation = !transaction_;
+        result = handleUpdate(command, tokens, currentDatabase);
+    }
+    else if (cmd == "DELETE" && tokens.size() >= 3) {
+        isWriteOperation = !transaction_;
+        result = handleDelete(command, tokens, currentDatabase);
     }
     else if (cmd == "SELECT") {
         result = handleSelect(command, tokens, currentDatabase);
     }
+    else if (cmd == "EXPLAIN" && tokens.size() >= 2) {
+        result = handleExplain(command, tokens, currentDatabase);
+    }
     else if (cmd == "LIST" && tokens.size() >= 2) {
         std::string type = util::StringUtils::toUpper(tokens[1]);
         
@@ -73,75 +209,133 @@ bool CommandParser::executeCommand(const std::string& command, std::shared_ptr<c
             result = handleListTables(tokens, currentDatabase);
         }
         else {
-            std::cout << "Error: Unknown LIST command. Use LIST DATABASES or LIST TABLES.\n";
+            error() << "Error: Unknown LIST command. Use LIST DATABASES or LIST TABLES.\n";
         }
     }
+    else if (cmd == "BEGIN") {
+        result = handleBegin(currentDatabase);
+    }
+    else if (cmd == "COMMIT" && transaction_) {
+        result = handleCommit();
+    }
     else if (cmd == "CHECKPOINT" || cmd == "SAVE" || cmd == "COMMIT") {
         result = handleSave(tokens, currentDatabase);
     }
     else if (cmd == "ROLLBACK") {
-        result = handleRollback(tokens, currentDatabase);
+        result = handleRollback();
+    }
+    else if (cmd == "SHOW" && tokens.size() >= 2 && util::StringUtils::toUpper(tokens[1]) == "STATS") {
+        result = handleShowStats(tokens);
+    }
+    else if (cmd == "SHOW" && tokens.size() >= 2 && util::StringUtils::toUpper(tokens[1]) == "MEMORY") {
+        result = handleShowMemory(currentDatabase);
+    }
+    else if (cmd == "SHOW" && tokens.size() >= 2 && util::StringUtils::toUpper(tokens[1]) == "LSM") {
+        result = handleShowLsm(currentDatabase);
+    }
+    else if (cmd == "SHOW" && tokens.size() >= 2 && util::StringUtils::toUpper(tokens[1]) == "PARTITIONS") {
+        result = handleShowPartitions(currentDatabase);
+    }
+    else if (cmd == "SET" && tokens.size() >= 4 && util::StringUtils::toUpper(tokens[1]) == "MEMORY" &&
+             util::StringUtils::toUpper(tokens[2]) == "BUDGET") {
+        result = handleSetMemoryBudget(tokens, currentDatabase);
+    }
+    else if (cmd == "SET" && tokens.size() >= 3 && util::StringUtils::toUpper(tokens[1]) == "COMPRESSION") {
+        result = handleSetCompression(tokens, currentDatabase);
+    }
+    else if (cmd == "EXPORT" && tokens.size() >= 2 && util::StringUtils::toUpper(tokens[1]) == "READONLY") {
+        result = handleExportReadOnly(currentDatabase);
     }
     else {
-        std::cout << "Unknown or incomplete command. Type HELP for assistance.\n";
+        error() << "Unknown or incomplete command. Type HELP for assistance.\n";
     }
     
+    metrics.recordPhase(util::Metrics::Phase::EXECUTE, elapsedSince(executeStart));
+    
     if (isWriteOperation && currentDatabase) {
-        std::cout << "Operation logged to transaction log.\n";
+        status() << "Operation logged to transaction log.\n";
         currentDatabase->logOperation(command);
         operationCount++;
         
         if (operationCount >= 5) {
             if (currentDatabase->checkpoint()) {
-                std::cout << "Checkpoint: Database state persisted to disk.\n";
+                status() << "Checkpoint: Database state persisted to disk.\n";
             } else {
-                std::cout << "Warning: Checkpoint failed.\n";
+                error() << "Warning: Checkpoint failed.\n";
             }
             operationCount = 0;
         }
     }
     
+    auto& slowQueryLog = util::SlowQueryLog::instance();
+    if (slowQueryLog.isEnabled()) {
+        slowQueryLog.record(currentDatabase ? currentDatabase->getName() : "", command,
+                            elapsedSince(statementStart), trace);
+    }
+    
     return result;
 }
 
 void CommandParser::printHelp() const {
-    std::cout << "SolidDB - Simple Relational Database\n";
-    std::cout << "Available commands:\n";
-    std::cout << "  CREATE DATABASE <name> - Create a new database\n";
-    std::cout << "  USE <database> - Switch to the specified database\n";
-    std::cout << "  CREATE TABLE <name> (<column1> <type1> [constraints], <column2> <type2> [constraints], ...) - Create a new table\n";
-    std::cout << "      Column constraints: PRIMARY KEY, UNIQUE, NOT NULL\n";
-    std::cout << "      Example: CREATE TABLE users (id INT PRIMARY KEY, name STRING NOT NULL, email STRING UNIQUE)\n";
-    std::cout << "  INSERT INTO <table> VALUES (<value1>, <value2>, ...) - Insert a row into a table\n";
-    std::cout << "  SELECT <column1>, <column2>, ... FROM <table> [WHERE <condition>] - Query data from a table\n";
-    std::cout << "  LIST DATABASES - Show all available databases\n";
-    std::cout << "  LIST TABLES - Show all tables in the current database\n";
-    std::cout << "  COMMIT - Save all changes to disk (same as CHECKPOINT)\n";
-    std::cout << "  ROLLBACK - Revert changes since last commit/checkpoint\n";
-    std::cout << "  HELP - Show this help message\n";
-    std::cout << "  EXIT - Exit the program\n";
-    std::cout << "\nData Persistence:\n";
-    std::cout << "  - Operations are logged immediately (Write-Ahead Logging)\n";
-    std::cout << "  - Database state is checkpointed after every 5 write operations\n";
-    std::cout << "  - Use COMMIT to save changes immediately\n";
-    std::cout << "  - Use ROLLBACK to revert uncommitted changes\n";
-    std::cout << "  - All changes are guaranteed to be saved when you exit\n";
+    out() << "SolidDB - Simple Relational Database\n";
+    out() << "Available commands:\n";
+    out() << "  CREATE DATABASE <name> - Create a new database\n";
+    out() << "  USE <database> - Switch to the specified database\n";
+    out() << "  CREATE TABLE <name> (<column1> <type1> [constraints], <column2> <type2> [constraints], ...) - Create a new table\n";
+    out() << "      Column constraints: PRIMARY KEY, UNIQUE, NOT NULL\n";
+    out() << "      Example: CREATE TABLE users (id INT PRIMARY KEY, name STRING NOT NULL, email STRING UNIQUE)\n";
+    out() << "      Append ENGINE=PAGED to keep the rows in a page file cached by the buffer pool\n";
+    out() << "      Append ENGINE=LSM for write-heavy tables (logged memtable and sorted runs on disk)\n";
+    out() << "      Append PARTITION BY HASH(<column>) <count> or PARTITION BY RANGE(<column>) (<bound>, ...)\n";
+    out() << "      to split the rows over partitions with their own storage, pruned and scanned in parallel\n";
+    out() << "  ALTER TABLE <table> DROP PARTITION <partition> - Drop a RANGE partition and its rows\n";
+    out() << "  INSERT INTO <table> VALUES (<value1>, <value2>, ...) - Insert a row into a table\n";
+    out() << "  UPDATE <table> SET <column>=<value>[, ...] [WHERE <condition>] - Change the matching rows\n";
+    out() << "  DELETE FROM <table> [WHERE <condition>] - Delete the matching rows\n";
+    out() << "  SELECT <column1>, <column2>, ... FROM <table> [WHERE <condition>] - Query data from a table\n";
+    out() << "  EXPLAIN [ANALYZE] SELECT ... - Show the query plan (ANALYZE runs it and times each operator)\n";
+    out() << "  LIST DATABASES - Show all available databases\n";
+    out() << "  LIST TABLES - Show all tables in the current database\n";
+    out() << "  BEGIN - Start a transaction; its changes are invisible to others until COMMIT\n";
+    out() << "  COMMIT - Commit the open transaction, or save all changes to disk (same as CHECKPOINT)\n";
+    out() << "  ROLLBACK - Undo the changes of the open transaction\n";
+    out() << "  SHOW STATS [RESET] - Show (or clear) latency histograms and engine counters\n";
+    out() << "  SHOW MEMORY - Show the estimated memory of each table of the current database\n";
+    out() << "  SHOW LSM - Show the runs, compactions and write amplification of the current database's LSM tables\n";
+    out() << "  SHOW PARTITIONS - Show the partitions, bounds and row counts of the current database's partitioned tables\n";
+    out() << "  SET MEMORY BUDGET <MiB> - Reject writes to the current database above this much memory (0 = unlimited)\n";
+    out() << "  SET COMPRESSION ON|OFF - Store the current database's table files compressed from the next checkpoint on\n";
+    out() << "  EXPORT READONLY - Write the current database's tables as files for read-only opens (--read-only)\n";
+    out() << "  HELP - Show this help message\n";
+    out() << "  EXIT - Exit the program\n";
+    out() << "\nData Persistence:\n";
+    out() << "  - Operations are logged immediately (Write-Ahead Logging)\n";
+    out() << "  - Database state is checkpointed after every 5 write operations\n";
+    out() << "  - Use COMMIT outside a transaction to save changes immediately\n";
+    out() << "  - A committed transaction is durable after a single redo log flush\n";
+    out() << "  - Use ROLLBACK to undo the changes of an open transaction\n";
+    out() << "  - All changes are guaranteed to be saved when you exit\n";
 }
 
 bool CommandParser::handleCreateDatabase(const std::vector<std::string>& tokens, 
                                   std::shared_ptr<core::Database>& currentDatabase) {
     if (tokens.size() < 3) {
-        std::cout << "Error: Missing database name.\n";
+        error() << "Error: Missing database name.\n";
         return true;
     }
     
     std::string dbName = tokens[2];
     
     if (fs::exists(dbName) && fs::is_directory(dbName) && fs::exists(dbName + "/metadata.db")) {
-        std::cout << "Database '" << dbName << "' already exists.\n";
+        error() << "Database '" << dbName << "' already exists.\n";
     } else {
-        currentDatabase = std::make_shared<core::Database>(dbName);
-        std::cout << "Database '" << dbName << "' created successfully.\n";
+        auto database = registry_->create(dbName);
+        if (!database) {
+            error() << "Error: Cannot create database '" << dbName << "' in read-only mode.\n";
+            return true;
+        }
+        currentDatabase = database;
+        status() << "Database '" << dbName << "' created successfully.\n";
     }
     
     return true;
@@ -151,23 +345,32 @@ bool CommandParser::handleCreateTable(const std::string& command,
                                const std::vector<std::string>& tokens,
                                std::shared_ptr<core::Database>& currentDatabase) {
     if (!currentDatabase) {
-        std::cout << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
+        error() << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
         return true;
     }
     
     if (tokens.size() < 3) {
-        std::cout << "Error: Invalid CREATE TABLE syntax.\n";
+        error() << "Error: Invalid CREATE TABLE syntax.\n";
         return true;
     }
     
     std::string tableName = tokens[2];
     
+    // The column list ends at its matching parenthesis; a PARTITION BY clause may follow
     size_t openParenPos = command.find('(');
-    size_t closeParenPos = command.find_last_of(')');
+    size_t closeParenPos = std::string::npos;
+    int depth = 0;
+    for (size_t i = openParenPos; openParenPos != std::string::npos && i < command.size(); i++) {
+        if (command[i] == '(') {
+            depth++;
+        } else if (command[i] == ')' && --depth == 0) {
+            closeParenPos = i;
+            break;
+        }
+    }
     
-    if (openParenPos == std::string::npos || closeParenPos == std::string::npos || 
-        openParenPos >= closeParenPos) {
-        std::cout << "Error: Invalid table definition syntax.\n";
+    if (openParenPos == std::string::npos || closeParenPos == std::string::npos) {
+        error() << "Error: Invalid table definition syntax.\n";
         return true;
     }
     
@@ -175,14 +378,109 @@ bool CommandParser::handleCreateTable(const std::string& command,
     auto columns = parseColumnDefsWithConstraints(columnDefs);
     
     if (columns.empty()) {
-        std::cout << "Error: No valid columns defined.\n";
+        error() << "Error: No valid columns defined.\n";
+        return true;
+    }
+    
+    // Optional "ENGINE=<engine>" and "PARTITION BY ..." after the column list
+    std::string optionText = command.substr(closeParenPos + 1);
+    std::optional<core::PartitionScheme> scheme;
+    std::string upperOptions = util::StringUtils::toUpper(optionText);
+    size_t partitionPos = upperOptions.find("PARTITION");
+    if (partitionPos != std::string::npos) {
+        // The clause runs up to an ENGINE option following it, if any
+        size_t enginePos = upperOptions.find("ENGINE", partitionPos);
+        size_t clauseLength = enginePos == std::string::npos ? std::string::npos : enginePos - partitionPos;
+        scheme.emplace();
+        if (!parsePartitionClause(optionText.substr(partitionPos, clauseLength), *scheme)) {
+            return true;
+        }
+        optionText.erase(partitionPos, clauseLength);
+    }
+    
+    std::string options = optionText;
+    options.erase(std::remove_if(options.begin(), options.end(), [](unsigned char c) { return std::isspace(c); }),
+                  options.end());
+    options = util::StringUtils::toUpper(options);
+    core::StorageEngine engine = core::StorageEngine::MEMORY;
+    if (options == "ENGINE=PAGED") {
+        engine = core::StorageEngine::PAGED;
+    } else if (options == "ENGINE=LSM") {
+        engine = core::StorageEngine::LSM;
+    } else if (!options.empty() && options != "ENGINE=MEMORY") {
+        error() << "Error: Unknown table option '" << util::StringUtils::trim(optionText)
+                << "'. Expected ENGINE=MEMORY, ENGINE=PAGED or ENGINE=LSM.\n";
+        return true;
+    }
+    if (scheme && engine != core::StorageEngine::MEMORY) {
+        error() << "Error: Partitioned tables only support ENGINE=MEMORY.\n";
+        return true;
+    }
+    
+    bool created = scheme ? currentDatabase->createPartitionedTable(tableName, columns, *scheme)
+                          : currentDatabase->createTable(tableName, columns, engine);
+    if (created) {
+        status() << "Table '" << tableName << "' created successfully.\n";
+    } else {
+        error() << "Error creating table '" << tableName << "'.\n";
+    }
+    
+    return true;
+}
+
+bool CommandParser::parsePartitionClause(const std::string& clause, core::PartitionScheme& scheme) {
+    size_t openParenPos = clause.find('(');
+    size_t closeParenPos = clause.find(')', openParenPos);
+    std::vector<std::string> head = tokenize(util::StringUtils::toUpper(clause.substr(0, openParenPos)), ' ');
+    if (closeParenPos == std::string::npos || head.size() != 3 || head[0] != "PARTITION" || head[1] != "BY" ||
+        (head[2] != "HASH" && head[2] != "RANGE")) {
+        error() << "Error: Invalid PARTITION BY clause. Use PARTITION BY HASH(<column>) <count> or "
+                << "PARTITION BY RANGE(<column>) (<bound>, ...).\n";
+        return false;
+    }
+    
+    scheme.column = util::StringUtils::trim(clause.substr(openParenPos + 1, closeParenPos - openParenPos - 1));
+    std::string rest = util::StringUtils::trim(clause.substr(closeParenPos + 1));
+    
+    if (head[2] == "HASH") {
+        scheme.kind = core::PartitionScheme::Kind::HASH;
+        bool isCount = !rest.empty() && rest.size() <= 4 &&
+                       std::all_of(rest.begin(), rest.end(), [](unsigned char c) { return std::isdigit(c); });
+        if (!isCount) {
+            error() << "Error: PARTITION BY HASH needs a partition count (1 to 9999), got '" << rest << "'.\n";
+            return false;
+        }
+        scheme.count = std::stoul(rest);
         return true;
     }
     
-    if (currentDatabase->createTable(tableName, columns)) {
-        std::cout << "Table '" << tableName << "' created successfully.\n";
+    scheme.kind = core::PartitionScheme::Kind::RANGE;
+    if (rest.size() < 2 || rest.front() != '(' || rest.back() != ')') {
+        error() << "Error: PARTITION BY RANGE needs a list of bounds, e.g. (100, 200).\n";
+        return false;
+    }
+    scheme.bounds = tokenize(rest.substr(1, rest.size() - 2), ',');
+    return true;
+}
+
+bool CommandParser::handleAlterTable(const std::vector<std::string>& tokens,
+                             std::shared_ptr<core::Database>& currentDatabase) {
+    if (!currentDatabase) {
+        error() << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
+        return true;
+    }
+    
+    // ALTER TABLE <table> DROP PARTITION <partition>
+    if (tokens.size() != 6 || util::StringUtils::toUpper(tokens[1]) != "TABLE" ||
+        util::StringUtils::toUpper(tokens[3]) != "DROP" || util::StringUtils::toUpper(tokens[4]) != "PARTITION") {
+        error() << "Error: Invalid ALTER TABLE syntax. Use ALTER TABLE <table> DROP PARTITION <partition>.\n";
+        return true;
+    }
+    
+    if (currentDatabase->dropPartition(tokens[2], tokens[5])) {
+        status() << "Partition '" << tokens[5] << "' of table '" << tokens[2] << "' dropped.\n";
     } else {
-        std::cout << "Error creating table '" << tableName << "'.\n";
+        error() << "Error dropping partition '" << tokens[5] << "'.\n";
     }
     
     return true;
@@ -191,23 +489,25 @@ bool CommandParser::handleCreateTable(const std::string& command,
 bool CommandParser::handleUseDatabase(const std::vector<std::string>& tokens, 
                                std::shared_ptr<core::Database>& currentDatabase) {
     if (tokens.size() < 2) {
-        std::cout << "Error: Missing database name.\n";
+        error() << "Error: Missing database name.\n";
         return true;
     }
     
     std::string dbName = tokens[1];
     
     if (!fs::exists(dbName) || !fs::is_directory(dbName)) {
-        std::cout << "Error: Database '" << dbName << "' does not exist.\n";
+        error() << "Error: Database '" << dbName << "' does not exist.\n";
         handleListDatabases(tokens);
     } else {
-        currentDatabase = std::shared_ptr<core::Database>(
-            core::Database::loadFromFile(dbName).release());
+        // Recently used databases are still open in the registry; the one
+        // being left stays cached and is saved when it is evicted or closed
+        currentDatabase = registry_->open(dbName);
+        registry_->evict();
         
         if (currentDatabase) {
-            std::cout << "Using database '" << dbName << "'.\n";
+            status() << "Using database '" << dbName << "'.\n";
         } else {
-            std::cout << "Error: Could not load database '" << dbName << "'.\n";
+            error() << "Error: Could not load database '" << dbName << "'.\n";
         }
     }
     
@@ -218,14 +518,14 @@ bool CommandParser::handleInsert(const std::string& command,
                          const std::vector<std::string>& tokens,
                          std::shared_ptr<core::Database>& currentDatabase) {
     if (!currentDatabase) {
-        std::cout << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
+        error() << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
         return true;
     }
     
     if (tokens.size() < 5 || 
         util::StringUtils::toUpper(tokens[1]) != "INTO" || 
         util::StringUtils::toUpper(tokens[3]) != "VALUES") {
-        std::cout << "Error: Invalid INSERT syntax.\n";
+        error() << "Error: Invalid INSERT syntax.\n";
         return true;
     }
     
@@ -236,33 +536,160 @@ bool CommandParser::handleInsert(const std::string& command,
     
     if (openParenPos == std::string::npos || closeParenPos == std::string::npos || 
         openParenPos >= closeParenPos) {
-        std::cout << "Error: Invalid INSERT syntax.\n";
+        error() << "Error: Invalid INSERT syntax.\n";
         return true;
     }
     
     std::string valueStr = command.substr(openParenPos + 1, closeParenPos - openParenPos - 1);
     auto values = parseValueList(valueStr);
     
-    if (currentDatabase->insert(tableName, values)) {
-        std::cout << "Row inserted successfully.\n";
+    bool inserted = transaction_
+        ? currentDatabase->insert(tableName, values, *transaction_)
+        : currentDatabase->insert(tableName, values);
+    
+    if (inserted) {
+        if (transaction_) {
+            transaction_->addStatement(command);
+        }
+        status() << "Row inserted successfully.\n";
+    } else {
+        error() << "Error inserting row.\n";
+    }
+    
+    return true;
+}
+
+bool CommandParser::handleUpdate(const std::string& command,
+                         const std::vector<std::string>& tokens,
+                         std::shared_ptr<core::Database>& currentDatabase) {
+    if (!currentDatabase) {
+        error() << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
+        return true;
+    }
+    
+    std::string upper = util::StringUtils::toUpper(command);
+    size_t setPos = upper.find(" SET ");
+    if (util::StringUtils::toUpper(tokens[2]) != "SET" || setPos == std::string::npos) {
+        error() << "Error: Invalid UPDATE syntax.\n";
+        return true;
+    }
+    
+    std::string tableName = tokens[1];
+    if (!currentDatabase->tableExists(tableName)) {
+        error() << "Error: Table '" << tableName << "' does not exist.\n";
+        return true;
+    }
+    
+    size_t wherePos = findWhere(upper, setPos);
+    std::string setClause = command.substr(setPos + 5, wherePos == std::string::npos
+                                                        ? std::string::npos : wherePos - setPos - 5);
+    std::string whereCondition;
+    if (wherePos != std::string::npos && !parseWhereClause(command, wherePos, whereCondition)) {
+        error() << "Error: Invalid WHERE condition '" << whereCondition << "' in UPDATE.\n";
+        return true;
+    }
+    
+    std::vector<std::pair<std::string, std::string>> assignments;
+    for (const auto& assignment : tokenize(setClause, ',')) {
+        size_t eq = assignment.find('=');
+        if (eq == std::string::npos) {
+            error() << "Error: Invalid assignment '" << assignment << "' in UPDATE.\n";
+            return true;
+        }
+        assignments.emplace_back(util::StringUtils::trim(assignment.substr(0, eq)),
+                                 util::StringUtils::trim(assignment.substr(eq + 1)));
+    }
+    
+    size_t count = 0;
+    bool updated = transaction_
+        ? currentDatabase->update(tableName, assignments, whereCondition, *transaction_, count)
+        : currentDatabase->update(tableName, assignments, whereCondition, count);
+    
+    if (updated) {
+        if (transaction_) {
+            transaction_->addStatement(command);
+        }
+        status() << count << " row(s) updated.\n";
     } else {
-        std::cout << "Error inserting row.\n";
+        error() << "Error updating rows.\n";
     }
     
     return true;
 }
 
-bool CommandParser::handleSelect(const std::string& command, 
+bool CommandParser::handleDelete(const std::string& command,
                          const std::vector<std::string>& tokens,
                          std::shared_ptr<core::Database>& currentDatabase) {
     if (!currentDatabase) {
-        std::cout << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
+        error() << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
+        return true;
+    }
+    
+    if (util::StringUtils::toUpper(tokens[1]) != "FROM" ||
+        (tokens.size() > 3 && util::StringUtils::toUpper(tokens[3]) != "WHERE")) {
+        error() << "Error: Invalid DELETE syntax.\n";
+        return true;
+    }
+    
+    std::string tableName = tokens[2];
+    if (!currentDatabase->tableExists(tableName)) {
+        error() << "Error: Table '" << tableName << "' does not exist.\n";
+        return true;
+    }
+    
+    std::string whereCondition;
+    size_t wherePos = findWhere(util::StringUtils::toUpper(command), 0);
+    if (wherePos != std::string::npos && !parseWhereClause(command, wherePos, whereCondition)) {
+        error() << "Error: Invalid WHERE condition '" << whereCondition << "' in DELETE.\n";
+        return true;
+    }
+    
+    size_t count = 0;
+    bool deleted = transaction_
+        ? currentDatabase->deleteRows(tableName, whereCondition, *transaction_, count)
+        : currentDatabase->deleteRows(tableName, whereCondition, count);
+    
+    if (deleted) {
+        if (transaction_) {
+            transaction_->addStatement(command);
+        }
+        status() << count << " row(s) deleted.\n";
+    } else {
+        error() << "Error deleting rows.\n";
+    }
+    
+    return true;
+}
+
+bool CommandParser::handleExplain(const std::string& command,
+                          const std::vector<std::string>& tokens,
+                          std::shared_ptr<core::Database>& currentDatabase) {
+    bool analyze = util::StringUtils::toUpper(tokens[1]) == "ANALYZE";
+    size_t selectToken = analyze ? 2 : 1;
+    
+    if (tokens.size() <= selectToken || util::StringUtils::toUpper(tokens[selectToken]) != "SELECT") {
+        error() << "Error: EXPLAIN supports SELECT statements only.\n";
+        return true;
+    }
+    
+    std::string select = command.substr(command.find(tokens[selectToken]));
+    std::vector<std::string> selectTokens(tokens.begin() + selectToken, tokens.end());
+    return handleSelect(select, selectTokens, currentDatabase,
+                        analyze ? ExplainMode::ANALYZE : ExplainMode::PLAN);
+}
+
+bool CommandParser::handleSelect(const std::string& command, 
+                         const std::vector<std::string>& tokens,
+                         std::shared_ptr<core::Database>& currentDatabase,
+                         ExplainMode explain) {
+    if (!currentDatabase) {
+        error() << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
         return true;
     }
     
     auto fromIt = std::find(tokens.begin(), tokens.end(), "FROM");
     if (fromIt == tokens.end() || std::distance(tokens.begin(), fromIt) <= 1) {
-        std::cout << "Error: Invalid SELECT syntax. Missing FROM clause.\n";
+        error() << "Error: Invalid SELECT syntax. Missing FROM clause.\n";
         return true;
     }
     
@@ -282,34 +709,82 @@ bool CommandParser::handleSelect(const std::string& command,
         whereCondition = command.substr(command.find("WHERE") + 6);
     }
     
-    auto results = currentDatabase->select(tableName, columns, whereCondition);
+    if (explain == ExplainMode::PLAN) {
+        core::QueryPlan plan;
+        if (!currentDatabase->explainSelect(tableName, columns, whereCondition, plan)) {
+            error() << "Error: Table '" << tableName << "' does not exist.\n";
+            return true;
+        }
+        plan.operators.insert(plan.operators.begin(), core::PlanOperator{"Output", "print rows"});
+        out() << plan.format();
+        return true;
+    }
+    
+    if (explain == ExplainMode::ANALYZE) {
+        if (!currentDatabase->tableExists(tableName)) {
+            error() << "Error: Table '" << tableName << "' does not exist.\n";
+            return true;
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        core::QueryPlan plan;
+        auto results = currentDatabase->select(tableName, columns, whereCondition, transaction_.get(), &plan);
+        
+        // Format the rows as SELECT would, but discard them
+        auto outputStart = std::chrono::steady_clock::now();
+        std::ostringstream discarded;
+        for (const auto& row : results) {
+            for (size_t i = 0; i < row.size(); i++) {
+                discarded << row[i];
+                if (i < row.size() - 1) {
+                    discarded << " | ";
+                }
+            }
+            discarded << '\n';
+        }
+        auto end = std::chrono::steady_clock::now();
+        
+        core::PlanOperator output{"Output", "format rows (discarded)"};
+        output.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - outputStart).count();
+        output.rowsIn = results.size();
+        output.rowsOut = results.size();
+        output.bytesAllocated = discarded.str().size();
+        plan.operators.insert(plan.operators.begin(), output);
+        
+        out() << plan.format();
+        out() << "Execution time: " << util::Metrics::formatDuration(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) << "\n";
+        return true;
+    }
+    
+    auto results = currentDatabase->select(tableName, columns, whereCondition, transaction_.get());
     
     if (results.empty()) {
-        std::cout << "No results found.\n";
+        status() << "No results found.\n";
     } else {
         for (const auto& row : results) {
             for (size_t i = 0; i < row.size(); i++) {
-                std::cout << row[i];
+                out() << row[i];
                 if (i < row.size() - 1) {
-                    std::cout << " | ";
+                    out() << " | ";
                 }
             }
-            std::cout << std::endl;
+            out() << '\n';
         }
-        std::cout << results.size() << " row(s) returned.\n";
+        status() << results.size() << " row(s) returned.\n";
     }
     
     return true;
 }
 
 bool CommandParser::handleListDatabases(const std::vector<std::string>& tokens) {
-    std::cout << "Available databases:\n";
+    out() << "Available databases:\n";
     
     for (const auto& entry : fs::directory_iterator(".")) {
         if (entry.is_directory()) {
             std::string path = entry.path().filename().string();
             if (fs::exists(entry.path() / "metadata.db")) {
-                std::cout << "  " << path << "\n";
+                out() << "  " << path << "\n";
             }
         }
     }
@@ -320,18 +795,18 @@ bool CommandParser::handleListDatabases(const std::vector<std::string>& tokens)
 bool CommandParser::handleListTables(const std::vector<std::string>& tokens, 
                              std::shared_ptr<core::Database>& currentDatabase) {
     if (!currentDatabase) {
-        std::cout << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
+        error() << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
         return true;
     }
     
-    std::cout << "Tables in " << currentDatabase->getName() << ":\n";
+    out() << "Tables in " << currentDatabase->getName() << ":\n";
     
     auto tableNames = currentDatabase->getTableNames();
     if (tableNames.empty()) {
-        std::cout << "  No tables found.\n";
+        out() << "  No tables found.\n";
     } else {
         for (const auto& name : tableNames) {
-            std::cout << "  " << name << "\n";
+            out() << "  " << name << "\n";
         }
     }
     
@@ -341,39 +816,252 @@ bool CommandParser::handleListTables(const std::vector<std::string>& tokens,
 bool CommandParser::handleSave(const std::vector<std::string>& tokens, 
                        std::shared_ptr<core::Database>& currentDatabase) {
     if (!currentDatabase) {
-        std::cout << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
+        error() << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
         return true;
     }
     
     if (currentDatabase->checkpoint()) {
-        std::cout << "Changes committed to disk successfully.\n";
+        status() << "Changes committed to disk successfully.\n";
         operationCount = 0;
     } else {
-        std::cout << "Error committing changes.\n";
+        error() << "Error committing changes.\n";
     }
     
     return true;
 }
 
-bool CommandParser::handleRollback(const std::vector<std::string>& tokens,
-                           std::shared_ptr<core::Database>& currentDatabase) {
+bool CommandParser::handleBegin(std::shared_ptr<core::Database>& currentDatabase) {
     if (!currentDatabase) {
-        std::cout << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
+        error() << "Error: No database selected. Use CREATE DATABASE or USE command first.\n";
         return true;
     }
     
-    std::string dbName = currentDatabase->getName();
+    if (transaction_) {
+        error() << "Error: A transaction is already in progress.\n";
+        return true;
+    }
     
-    currentDatabase = std::shared_ptr<core::Database>(
-        core::Database::loadFromFile(dbName).release());
+    transaction_ = currentDatabase->beginTransaction();
+    transactionDatabase_ = currentDatabase;
+    status() << "Transaction started.\n";
     
-    if (currentDatabase) {
-        std::cout << "Changes rolled back successfully. Database restored to last committed state.\n";
-        operationCount = 0;
+    return true;
+}
+
+bool CommandParser::handleCommit() {
+    size_t changes = transaction_->getChangeCount();
+    
+    if (transactionDatabase_->commitTransaction(*transaction_)) {
+        status() << "Transaction committed (" << changes << " change(s)).\n";
+    } else {
+        error() << "Error: Transaction could not be made durable and was rolled back.\n";
+    }
+    
+    transaction_.reset();
+    transactionDatabase_.reset();
+    return true;
+}
+
+bool CommandParser::handleRollback() {
+    if (!transaction_) {
+        error() << "Error: No transaction in progress. Use BEGIN to start one.\n";
+        return true;
+    }
+    
+    size_t changes = transaction_->getChangeCount();
+    transactionDatabase_->rollbackTransaction(*transaction_);
+    transaction_.reset();
+    transactionDatabase_.reset();
+    
+    status() << "Transaction rolled back (" << changes << " change(s) undone).\n";
+    return true;
+}
+
+bool CommandParser::handleShowStats(const std::vector<std::string>& tokens) {
+    auto& metrics = util::Metrics::instance();
+    
+    if (tokens.size() >= 3 && util::StringUtils::toUpper(tokens[2]) == "RESET") {
+        metrics.reset();
+        status() << "Statistics reset.\n";
+        return true;
+    }
+    
+    out() << metrics.report();
+    return true;
+}
+
+bool CommandParser::handleShowMemory(std::shared_ptr<core::Database>& currentDatabase) {
+    if (!currentDatabase) {
+        error() << "Error: No database selected. Use 'USE <database>' first.\n";
+        return true;
+    }
+    
+    auto kib = [](size_t bytes) { return std::to_string((bytes + 1023) / 1024) + " KiB"; };
+    core::DatabaseMemoryUsage usage = currentDatabase->getMemoryReport();
+    
+    out() << "Memory of " << currentDatabase->getName() << ":\n";
+    out() << "  " << std::left << std::setw(20) << "table" << std::right
+          << std::setw(14) << "versions" << std::setw(14) << "values"
+          << std::setw(14) << "pk index" << std::setw(14) << "unique idx" << std::setw(14) << "dictionaries"
+          << std::setw(14) << "total" << "\n";
+    for (const auto& [tableName, table] : usage.tables) {
+        out() << "  " << std::left << std::setw(20) << tableName << std::right
+              << std::setw(14) << kib(table.versionSlots) << std::setw(14) << kib(table.values)
+              << std::setw(14) << kib(table.primaryKeyIndex) << std::setw(14) << kib(table.uniqueIndexes)
+              << std::setw(14) << kib(table.dictionaries)
+              << std::setw(14) << kib(table.total()) << "\n";
+    }
+    out() << "  " << std::left << std::setw(20) << "operation log" << std::right
+          << std::setw(84) << kib(usage.operationLog) << "\n";
+    
+    // Shared by the paged tables of every database, so not part of the total
+    auto pool = core::BufferPool::instance().getUsage();
+    if (pool.residentPages > 0) {
+        out() << "Buffer pool: " << kib(pool.residentPages * core::Pager::PAGE_SIZE) << " resident ("
+              << pool.dirtyPages << " dirty page(s)) of " << kib(pool.capacityPages * core::Pager::PAGE_SIZE) << "\n";
+    }
+    auto cache = core::ResultCache::instance().getUsage();
+    if (cache.entries > 0) {
+        out() << "Result cache: " << kib(cache.bytes) << " in " << cache.entries << " result(s) of "
+              << kib(cache.capacityBytes) << "\n";
+    }
+    out() << "Total: " << kib(usage.total());
+    
+    size_t budget = currentDatabase->getMemoryBudget();
+    if (budget > 0) {
+        out() << " of " << kib(budget) << " budget";
+    }
+    out() << "\n";
+    return true;
+}
+
+bool CommandParser::handleShowLsm(std::shared_ptr<core::Database>& currentDatabase) {
+    if (!currentDatabase) {
+        error() << "Error: No database selected. Use 'USE <database>' first.\n";
+        return true;
+    }
+    
+    auto kib = [](uint64_t bytes) { return std::to_string((bytes + 1023) / 1024) + " KiB"; };
+    bool any = false;
+    for (const auto& tableName : currentDatabase->getTableNames()) {
+        auto table = currentDatabase->getLsmTable(tableName);
+        if (!table) {
+            continue;
+        }
+        any = true;
+        core::LsmStats stats = table->getStats();
+        
+        out() << tableName << ": " << table->getRowCount() << " row(s), memtable " << kib(stats.memtableBytes) << "\n";
+        for (size_t level = 0; level < stats.runsPerLevel.size(); level++) {
+            out() << "  level " << level << ": " << stats.runsPerLevel[level] << " run(s), "
+                  << kib(stats.bytesPerLevel[level]) << "\n";
+        }
+        out() << "  " << stats.flushes << " flush(es) (" << kib(stats.flushBytes) << "), "
+              << stats.compactions << " compaction(s) (" << kib(stats.compactionBytes) << "), log "
+              << kib(stats.logBytes) << "\n";
+        std::ostringstream amplification;
+        amplification << std::fixed << std::setprecision(2) << stats.writeAmplification();
+        out() << "  write amplification: " << amplification.str() << " (" << kib(stats.bytesIn)
+              << " written by statements)\n";
+    }
+    if (!any) {
+        out() << "No LSM tables in " << currentDatabase->getName() << ".\n";
+    }
+    return true;
+}
+
+bool CommandParser::handleShowPartitions(std::shared_ptr<core::Database>& currentDatabase) {
+    if (!currentDatabase) {
+        error() << "Error: No database selected. Use 'USE <database>' first.\n";
+        return true;
+    }
+    
+    auto tableNames = currentDatabase->getTableNames();
+    std::sort(tableNames.begin(), tableNames.end());
+    bool any = false;
+    for (const auto& tableName : tableNames) {
+        auto table = currentDatabase->getPartitionedTable(tableName);
+        if (!table) {
+            continue;
+        }
+        any = true;
+        
+        const core::PartitionScheme& scheme = table->getScheme();
+        out() << tableName << ": " << scheme.describe() << ", " << table->getRowCount() << " row(s)\n";
+        for (const auto& partition : table->getPartitions()) {
+            out() << "  " << partition.name << ": " << partition.describeBounds(scheme) << ", "
+                  << partition.table->getRowCount() << " row(s)\n";
+        }
+        auto dropped = table->getDroppedPartitions();
+        if (!dropped.empty()) {
+            std::string names;
+            for (const auto& name : dropped) {
+                names += (names.empty() ? "" : ", ") + name;
+            }
+            out() << "  dropped: " << names << "\n";
+        }
+    }
+    if (!any) {
+        out() << "No partitioned tables in " << currentDatabase->getName() << ".\n";
+    }
+    return true;
+}
+
+bool CommandParser::handleSetMemoryBudget(const std::vector<std::string>& tokens,
+                                          std::shared_ptr<core::Database>& currentDatabase) {
+    if (!currentDatabase) {
+        error() << "Error: No database selected. Use 'USE <database>' first.\n";
+        return true;
+    }
+    
+    size_t megabytes = 0;
+    try {
+        megabytes = std::stoul(tokens[3]);
+    } catch (...) {
+        error() << "Error: Invalid memory budget '" << tokens[3] << "'. Expected a size in MiB.\n";
+        return false;
+    }
+    
+    currentDatabase->setMemoryBudget(megabytes * 1024 * 1024);
+    if (megabytes == 0) {
+        status() << "Memory budget of " << currentDatabase->getName() << " removed.\n";
     } else {
-        std::cout << "Error rolling back changes. Could not reload database state.\n";
+        status() << "Memory budget of " << currentDatabase->getName() << " set to " << megabytes << " MiB.\n";
+    }
+    return true;
+}
+
+bool CommandParser::handleSetCompression(const std::vector<std::string>& tokens,
+                                         std::shared_ptr<core::Database>& currentDatabase) {
+    if (!currentDatabase) {
+        error() << "Error: No database selected. Use 'USE <database>' first.\n";
+        return true;
     }
     
+    std::string mode = util::StringUtils::toUpper(tokens[2]);
+    if (mode != "ON" && mode != "OFF") {
+        error() << "Error: Invalid compression mode '" << tokens[2] << "'. Expected ON or OFF.\n";
+        return false;
+    }
+    
+    currentDatabase->setCompression(mode == "ON");
+    status() << "Compression of " << currentDatabase->getName() << " turned " << util::StringUtils::toLower(mode)
+             << "; table files are rewritten at the next checkpoint.\n";
+    return true;
+}
+
+bool CommandParser::handleExportReadOnly(std::shared_ptr<core::Database>& currentDatabase) {
+    if (!currentDatabase) {
+        error() << "Error: No database selected. Use 'USE <database>' first.\n";
+        return true;
+    }
+    
+    // The read-only open takes its table names from the metadata file
+    if (!currentDatabase->checkpoint() || !currentDatabase->exportReadOnly()) {
+        error() << "Error: Failed to export " << currentDatabase->getName() << ".\n";
+        return false;
+    }
+    status() << "Database '" << currentDatabase->getName() << "' exported for read-only access.\n";
     return true;
 }
 
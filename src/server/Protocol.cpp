@@ -0,0 +1,70 @@
+#include "server/Protocol.h"
+
+namespace soliddb {
+namespace server {
+namespace protocol {
+
+namespace {
+
+void appendHeader(std::string& out, uint32_t length) {
+    out.push_back(static_cast<char>((length >> 24) & 0xFF));
+    out.push_back(static_cast<char>((length >> 16) & 0xFF));
+    out.push_back(static_cast<char>((length >> 8) & 0xFF));
+    out.push_back(static_cast<char>(length & 0xFF));
+}
+
+} // namespace
+
+void appendFrame(std::string& out, const std::string& payload) {
+    appendHeader(out, static_cast<uint32_t>(payload.size()));
+    out.append(payload);
+}
+
+void appendResponse(std::string& out, char status, const std::string& body) {
+    appendHeader(out, static_cast<uint32_t>(body.size() + 1));
+    out.push_back(status);
+    out.append(body);
+}
+
+} // namespace protocol
+
+void FrameDecoder::feed(const char* data, size_t length) {
+    // Drop consumed bytes before growing the buffer
+    if (offset_ > 0 && offset_ * 2 >= buffer_.size()) {
+        buffer_.erase(0, offset_);
+        offset_ = 0;
+    }
+    buffer_.append(data, length);
+}
+
+bool FrameDecoder::next(std::string& payload) {
+    if (error_ || buffer_.size() - offset_ < protocol::HEADER_SIZE) {
+        return false;
+    }
+    
+    const auto* header = reinterpret_cast<const unsigned char*>(buffer_.data() + offset_);
+    uint32_t length = (static_cast<uint32_t>(header[0]) << 24) |
+                      (static_cast<uint32_t>(header[1]) << 16) |
+                      (static_cast<uint32_t>(header[2]) << 8) |
+                      static_cast<uint32_t>(header[3]);
+    
+    if (length > protocol::MAX_FRAME_SIZE) {
+        error_ = true;
+        return false;
+    }
+    
+    if (buffer_.size() - offset_ - protocol::HEADER_SIZE < length) {
+        return false;
+    }
+    
+    payload.assign(buffer_, offset_ + protocol::HEADER_SIZE, length);
+    offset_ += protocol::HEADER_SIZE + length;
+    return true;
+}
+
+bool FrameDecoder::hasError() const {
+    return error_;
+}
+
+} // namespace server
+} // namespace soliddb
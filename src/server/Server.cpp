@@ -0,0 +1,384 @@
+#include "server/Server.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace soliddb {
+namespace server {
+
+namespace {
+
+constexpr uint64_t LISTEN_ID = 0;
+constexpr uint64_t WAKE_ID = 1;
+constexpr int MAX_EVENTS = 256;
+constexpr size_t READ_CHUNK = 64 * 1024;
+constexpr size_t MAX_PENDING_REQUESTS = 64;   // Stop reading a connection beyond this
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+} // namespace
+
+Server::Server(const ServerConfig& config)
+    : config_(config), registry_(std::make_shared<core::DatabaseRegistry>(config.databaseCacheBytes)) {
+    registry_->setDatabaseMemoryBudget(config.databaseMemoryBudget);
+    registry_->setReadOnly(config.readOnly);
+}
+
+Server::~Server() {
+    for (auto& [id, conn] : connections_) {
+        close(conn->fd);
+    }
+    connections_.clear();
+    
+    // Joins workers before the registry (and its databases) go away
+    workers_.reset();
+    registry_->closeAll();
+    
+    if (listenFd_ >= 0) close(listenFd_);
+    if (epollFd_ >= 0) close(epollFd_);
+    if (wakeFd_ >= 0) close(wakeFd_);
+}
+
+bool Server::openListenSocket() {
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "Error: Cannot create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    int reuse = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(config_.port);
+    if (inet_pton(AF_INET, config_.host.c_str(), &address.sin_addr) != 1) {
+        std::cerr << "Error: Invalid listen address: " << config_.host << std::endl;
+        return false;
+    }
+    
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "Error: Cannot bind " << config_.host << ":" << config_.port
+                  << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    if (listen(listenFd_, SOMAXCONN) < 0 || !setNonBlocking(listenFd_)) {
+        std::cerr << "Error: Cannot listen: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+bool Server::run() {
+    if (!openListenSocket()) {
+        return false;
+    }
+    
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        std::cerr << "Error: Cannot create event loop: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = LISTEN_ID;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event);
+    event.data.u64 = WAKE_ID;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+    
+    workers_ = std::make_unique<util::ThreadPool>(config_.workerThreads);
+    running_ = true;
+    
+    std::cout << "SolidDB server listening on " << config_.host << ":" << config_.port
+              << " (" << workers_->size() << " worker threads)" << std::endl;
+    
+    epoll_event events[MAX_EVENTS];
+    
+    while (running_) {
+        int ready = epoll_wait(epollFd_, events, MAX_EVENTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: epoll_wait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        
+        for (int i = 0; i < ready; i++) {
+            uint64_t id = events[i].data.u64;
+            
+            if (id == LISTEN_ID) {
+                acceptConnections();
+                continue;
+            }
+            if (id == WAKE_ID) {
+                uint64_t counter;
+                while (read(wakeFd_, &counter, sizeof(counter)) > 0) {
+                }
+                drainCompletions();
+                continue;
+            }
+            
+            auto it = connections_.find(id);
+            if (it == connections_.end()) {
+                continue;
+            }
+            
+            Connection& conn = *it->second;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(id);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                handleWritable(id, conn);
+                if (connections_.find(id) == connections_.end()) {
+                    continue;
+                }
+            }
+            if (events[i].events & EPOLLIN) {
+                handleReadable(id, conn);
+            }
+        }
+    }
+    
+    std::cout << "SolidDB server shutting down" << std::endl;
+    return true;
+}
+
+void Server::stop() {
+    running_ = false;
+    wake();
+}
+
+void Server::wake() {
+    if (wakeFd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd_, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+void Server::acceptConnections() {
+    while (true) {
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "Warning: accept failed: " << std::strerror(errno) << std::endl;
+            }
+            return;
+        }
+        
+        if (connections_.size() >= config_.maxConnections) {
+            close(fd);
+            continue;
+        }
+        
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        
+        uint64_t id = nextConnectionId_++;
+        auto conn = std::make_unique<Connection>();
+        conn->fd = fd;
+        conn->session = std::make_shared<Session>(registry_);
+        conn->events = EPOLLIN;
+        
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = id;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+        
+        connections_[id] = std::move(conn);
+    }
+}
+
+void Server::handleReadable(uint64_t id, Connection& conn) {
+    char buffer[READ_CHUNK];
+    
+    while (true) {
+        ssize_t received = read(conn.fd, buffer, sizeof(buffer));
+        if (received > 0) {
+            conn.decoder.feed(buffer, static_cast<size_t>(received));
+            if (static_cast<size_t>(received) < sizeof(buffer)) {
+                break;
+            }
+            continue;
+        }
+        if (received == 0) {
+            // The client is done sending; answer what it sent before closing
+            conn.peerClosed = true;
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        closeConnection(id);
+        return;
+    }
+    
+    std::string payload;
+    while (conn.decoder.next(payload)) {
+        conn.pending.push_back(std::move(payload));
+    }
+    
+    if (conn.decoder.hasError()) {
+        protocol::appendResponse(conn.writeBuffer, protocol::STATUS_ERROR, "Error: Frame too large.\n");
+        conn.closeAfterWrite = true;
+        conn.pending.clear();
+    }
+    
+    if (!conn.busy) {
+        dispatchNext(id, conn);
+    }
+    if (conn.peerClosed) {
+        handleWritable(id, conn);
+        return;
+    }
+    updateInterest(id, conn);
+}
+
+void Server::handleWritable(uint64_t id, Connection& conn) {
+    if (!flushWrites(conn)) {
+        closeConnection(id);
+        return;
+    }
+    
+    bool answered = conn.closeAfterWrite || (conn.peerClosed && conn.pending.empty());
+    if (conn.writeOffset == conn.writeBuffer.size() && answered && !conn.busy) {
+        closeConnection(id);
+        return;
+    }
+    
+    updateInterest(id, conn);
+}
+
+void Server::dispatchNext(uint64_t id, Connection& conn) {
+    if (conn.busy || conn.pending.empty() || conn.closeAfterWrite) {
+        return;
+    }
+    
+    conn.busy = true;
+    std::string request = std::move(conn.pending.front());
+    conn.pending.pop_front();
+    
+    std::shared_ptr<Session> session = conn.session;
+    workers_->submit([this, id, session, request = std::move(request)]() {
+        Response response = session->execute(request);
+        {
+            std::lock_guard<std::mutex> lock(completionMutex_);
+            completions_.push_back({id, std::move(response)});
+        }
+        wake();
+    });
+}
+
+void Server::drainCompletions() {
+    std::deque<Completion> ready;
+    {
+        std::lock_guard<std::mutex> lock(completionMutex_);
+        ready.swap(completions_);
+    }
+    
+    for (auto& completion : ready) {
+        auto it = connections_.find(completion.connectionId);
+        if (it == connections_.end()) {
+            continue;  // Client went away while its request was running
+        }
+        
+        Connection& conn = *it->second;
+        const Response& response = completion.response;
+        char status = response.close ? protocol::STATUS_CLOSE
+                    : response.ok ? protocol::STATUS_OK : protocol::STATUS_ERROR;
+        protocol::appendResponse(conn.writeBuffer, status, response.body);
+        
+        conn.busy = false;
+        if (response.close) {
+            conn.closeAfterWrite = true;
+            conn.pending.clear();
+        }
+        
+        handleWritable(completion.connectionId, conn);
+        
+        it = connections_.find(completion.connectionId);
+        if (it != connections_.end()) {
+            dispatchNext(completion.connectionId, *it->second);
+            updateInterest(completion.connectionId, *it->second);
+        }
+    }
+}
+
+bool Server::flushWrites(Connection& conn) {
+    while (conn.writeOffset < conn.writeBuffer.size()) {
+        ssize_t written = send(conn.fd, conn.writeBuffer.data() + conn.writeOffset,
+                               conn.writeBuffer.size() - conn.writeOffset, MSG_NOSIGNAL);
+        if (written > 0) {
+            conn.writeOffset += static_cast<size_t>(written);
+            continue;
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        }
+        return false;
+    }
+    
+    conn.writeBuffer.clear();
+    conn.writeOffset = 0;
+    return true;
+}
+
+void Server::updateInterest(uint64_t id, Connection& conn) {
+    uint32_t events = 0;
+    if (!conn.closeAfterWrite && !conn.peerClosed && conn.pending.size() < MAX_PENDING_REQUESTS) {
+        events |= EPOLLIN;
+    }
+    if (conn.writeOffset < conn.writeBuffer.size()) {
+        events |= EPOLLOUT;
+    }
+    
+    if (events == conn.events) {
+        return;
+    }
+    
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = id;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, conn.fd, &event);
+    conn.events = events;
+}
+
+void Server::closeConnection(uint64_t id) {
+    auto it = connections_.find(id);
+    if (it == connections_.end()) {
+        return;
+    }
+    
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, it->second->fd, nullptr);
+    close(it->second->fd);
+    connections_.erase(it);
+}
+
+} // namespace server
+} // namespace soliddb
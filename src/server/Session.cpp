@@ -0,0 +1,154 @@
+#include "server/Session.h"
+#include "util/StringUtils.h"
+#include <sstream>
+
+namespace soliddb {
+namespace server {
+
+namespace {
+
+Response errorResponse(const std::string& message) {
+    Response response;
+    response.ok = false;
+    response.body = message + "\n";
+    return response;
+}
+
+} // namespace
+
+Session::Session(std::shared_ptr<core::DatabaseRegistry> registry)
+    : registry_(std::move(registry)) {
+    parser_.setRegistry(registry_);
+}
+
+std::string Session::getCurrentDatabaseName() const {
+    return currentDatabase_ ? currentDatabase_->getName() : "";
+}
+
+Response Session::execute(const std::string& request) {
+    std::string statement = util::StringUtils::trim(request);
+    std::vector<std::string> tokens = util::StringUtils::tokenize(statement, ' ');
+    
+    if (!tokens.empty()) {
+        std::string cmd = util::StringUtils::toUpper(tokens[0]);
+        if (cmd == "PREPARE") {
+            return handlePrepare(statement, tokens);
+        }
+        if (cmd == "EXECUTE") {
+            return handleExecute(statement, tokens);
+        }
+        if (cmd == "DEALLOCATE") {
+            return handleDeallocate(tokens);
+        }
+    }
+    
+    return runStatement(statement);
+}
+
+Response Session::runStatement(const std::string& statement) {
+    std::ostringstream output;
+    parser_.setOutput(output);
+    
+    bool continueRunning = parser_.executeCommand(statement, currentDatabase_);
+    
+    Response response;
+    response.ok = !parser_.lastCommandFailed();
+    response.close = !continueRunning;
+    response.body = output.str();
+    return response;
+}
+
+Response Session::handlePrepare(const std::string& request, const std::vector<std::string>& tokens) {
+    if (tokens.size() < 4 || util::StringUtils::toUpper(tokens[2]) != "AS") {
+        return errorResponse("Error: Invalid PREPARE syntax. Use PREPARE <name> AS <statement>.");
+    }
+    
+    const std::string& name = tokens[1];
+    size_t namePos = request.find(name, tokens[0].size());
+    size_t asPos = request.find(tokens[2], namePos + name.size());
+    std::string statement = util::StringUtils::trim(request.substr(asPos + 2));
+    
+    preparedStatements_[name] = statement;
+    
+    Response response;
+    response.body = "Statement '" + name + "' prepared.\n";
+    return response;
+}
+
+Response Session::handleExecute(const std::string& request, const std::vector<std::string>& tokens) {
+    if (tokens.size() < 2) {
+        return errorResponse("Error: Invalid EXECUTE syntax. Use EXECUTE <name> [(<values>)].");
+    }
+    
+    std::string name = tokens[1];
+    size_t parenPos = name.find('(');
+    if (parenPos != std::string::npos) {
+        name = name.substr(0, parenPos);
+    }
+    
+    auto it = preparedStatements_.find(name);
+    if (it == preparedStatements_.end()) {
+        return errorResponse("Error: Unknown prepared statement '" + name + "'.");
+    }
+    
+    std::vector<std::string> parameters;
+    size_t openParenPos = request.find('(');
+    size_t closeParenPos = request.find_last_of(')');
+    if (openParenPos != std::string::npos && closeParenPos != std::string::npos &&
+        openParenPos < closeParenPos) {
+        parameters = util::StringUtils::tokenize(
+            request.substr(openParenPos + 1, closeParenPos - openParenPos - 1), ',');
+    }
+    
+    std::string error;
+    std::string statement = bindParameters(it->second, parameters, error);
+    if (!error.empty()) {
+        return errorResponse(error);
+    }
+    
+    return runStatement(statement);
+}
+
+Response Session::handleDeallocate(const std::vector<std::string>& tokens) {
+    if (tokens.size() < 2) {
+        return errorResponse("Error: Invalid DEALLOCATE syntax. Use DEALLOCATE <name>.");
+    }
+    
+    if (preparedStatements_.erase(tokens[1]) == 0) {
+        return errorResponse("Error: Unknown prepared statement '" + tokens[1] + "'.");
+    }
+    
+    Response response;
+    response.body = "Statement '" + tokens[1] + "' deallocated.\n";
+    return response;
+}
+
+std::string Session::bindParameters(const std::string& statement,
+                                    const std::vector<std::string>& parameters,
+                                    std::string& error) {
+    std::string bound;
+    bound.reserve(statement.size() + parameters.size() * 8);
+    size_t next = 0;
+    
+    for (char c : statement) {
+        if (c != '?') {
+            bound.push_back(c);
+            continue;
+        }
+        if (next >= parameters.size()) {
+            error = "Error: Not enough parameters for prepared statement.";
+            return "";
+        }
+        bound.append(parameters[next++]);
+    }
+    
+    if (next != parameters.size()) {
+        error = "Error: Too many parameters for prepared statement.";
+        return "";
+    }
+    
+    return bound;
+}
+
+} // namespace server
+} // namespace soliddb
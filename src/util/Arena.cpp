@@ -0,0 +1,28 @@
+#include "util/Arena.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace soliddb {
+namespace util {
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    size_t padding = (alignment - reinterpret_cast<uintptr_t>(cursor_) % alignment) % alignment;
+    if (cursor_ == nullptr || padding + bytes > remaining_) {
+        // The tail of the current slab is abandoned; new[] aligns to max_align_t
+        size_t slabSize = std::max(nextSlabSize_, bytes);
+        slabs_.emplace_back(new char[slabSize]);
+        cursor_ = slabs_.back().get();
+        remaining_ = slabSize;
+        reservedBytes_ += slabSize;
+        nextSlabSize_ = std::min(nextSlabSize_ * 2, MAX_SLAB_SIZE);
+        padding = 0;
+    }
+
+    void* block = cursor_ + padding;
+    cursor_ += padding + bytes;
+    remaining_ -= padding + bytes;
+    return block;
+}
+
+} // namespace util
+} // namespace soliddb
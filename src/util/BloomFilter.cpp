@@ -0,0 +1,134 @@
+#include "util/BloomFilter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace soliddb {
+namespace util {
+
+namespace {
+
+constexpr uint64_t MULTIPLIER = 0xc6a4a7935bd1e995ULL;
+
+uint64_t read64(const char* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Second, independent hash for the bit positions within the block
+uint64_t remix(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+} // namespace
+
+BloomFilter::BloomFilter(size_t expectedKeys, size_t bitsPerKey) {
+    size_t bits = std::max<size_t>(expectedKeys, 1) * bitsPerKey;
+    blocks_.assign((bits + BLOCK_BITS - 1) / BLOCK_BITS, Block{});
+    probes_ = static_cast<uint32_t>(std::clamp<double>(std::round(bitsPerKey * 0.69), 1, 12));
+}
+
+uint64_t BloomFilter::hash(std::string_view key) {
+    // MurmurHash64A
+    uint64_t hash = 0x5bd1e995ULL ^ (key.size() * MULTIPLIER);
+    size_t pos = 0;
+    for (; pos + 8 <= key.size(); pos += 8) {
+        uint64_t word = read64(key.data() + pos);
+        word *= MULTIPLIER;
+        word ^= word >> 47;
+        word *= MULTIPLIER;
+        hash ^= word;
+        hash *= MULTIPLIER;
+    }
+    if (pos < key.size()) {
+        uint64_t tail = 0;
+        std::memcpy(&tail, key.data() + pos, key.size() - pos);
+        hash ^= tail;
+        hash *= MULTIPLIER;
+    }
+    hash ^= hash >> 47;
+    hash *= MULTIPLIER;
+    hash ^= hash >> 47;
+    return hash;
+}
+
+void BloomFilter::add(std::string_view key) {
+    addHash(hash(key));
+}
+
+bool BloomFilter::mayContain(std::string_view key) const {
+    return mayContainHash(hash(key));
+}
+
+size_t BloomFilter::blockIndex(uint64_t hash) const {
+    // Multiply-shift maps the high bits onto the blocks without a division
+    return static_cast<size_t>(((hash >> 32) * blocks_.size()) >> 32);
+}
+
+void BloomFilter::addHash(uint64_t hash) {
+    if (blocks_.empty()) {
+        return;
+    }
+    Block& block = blocks_[blockIndex(hash)];
+    uint64_t bits = remix(hash);
+    uint32_t step = static_cast<uint32_t>(bits >> 32) | 1;
+    uint32_t position = static_cast<uint32_t>(bits);
+    for (uint32_t i = 0; i < probes_; i++, position += step) {
+        uint32_t bit = position % BLOCK_BITS;
+        block.words[bit / 64] |= uint64_t{1} << (bit % 64);
+    }
+}
+
+bool BloomFilter::mayContainHash(uint64_t hash) const {
+    if (blocks_.empty()) {
+        return true;
+    }
+    const Block& block = blocks_[blockIndex(hash)];
+    uint64_t bits = remix(hash);
+    uint32_t step = static_cast<uint32_t>(bits >> 32) | 1;
+    uint32_t position = static_cast<uint32_t>(bits);
+    for (uint32_t i = 0; i < probes_; i++, position += step) {
+        uint32_t bit = position % BLOCK_BITS;
+        if ((block.words[bit / 64] & (uint64_t{1} << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BloomFilter::serialize(std::string& out) const {
+    uint64_t blockCount = blocks_.size();
+    out.append(reinterpret_cast<const char*>(&probes_), sizeof(probes_));
+    out.append(reinterpret_cast<const char*>(&blockCount), sizeof(blockCount));
+    out.append(reinterpret_cast<const char*>(blocks_.data()), blocks_.size() * sizeof(Block));
+}
+
+bool BloomFilter::deserialize(std::string_view data, BloomFilter& filter) {
+    uint32_t probes;
+    uint64_t blockCount;
+    if (data.size() < sizeof(probes) + sizeof(blockCount)) {
+        return false;
+    }
+    std::memcpy(&probes, data.data(), sizeof(probes));
+    std::memcpy(&blockCount, data.data() + sizeof(probes), sizeof(blockCount));
+    data.remove_prefix(sizeof(probes) + sizeof(blockCount));
+    if (data.size() / sizeof(Block) < blockCount || probes == 0) {
+        return false;
+    }
+
+    filter.probes_ = probes;
+    filter.blocks_.resize(blockCount);
+    std::memcpy(filter.blocks_.data(), data.data(), blockCount * sizeof(Block));
+    return true;
+}
+
+size_t BloomFilter::memoryBytes() const {
+    return blocks_.capacity() * sizeof(Block);
+}
+
+} // namespace util
+} // namespace soliddb
@@ -0,0 +1,106 @@
+#include "util/Console.h"
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <streambuf>
+#include <vector>
+
+namespace soliddb {
+namespace util {
+
+namespace {
+
+std::atomic<bool> quietMode{false};
+
+/**
+ * Stream buffer that drops all output
+ */
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+/**
+ * Stream buffer that accumulates output and writes it to stdout only when
+ * the buffer fills up or drain() is called. sync() is deliberately a no-op.
+ */
+class LargeOutputBuffer : public std::streambuf {
+public:
+    explicit LargeOutputBuffer(size_t size) : buffer_(size) {
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+    }
+
+    void drain() {
+        std::ptrdiff_t pending = pptr() - pbase();
+        if (pending > 0) {
+            std::fwrite(pbase(), 1, static_cast<size_t>(pending), stdout);
+        }
+        std::fflush(stdout);
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+    }
+
+protected:
+    int overflow(int c) override {
+        drain();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override {
+        return 0;
+    }
+
+private:
+    std::vector<char> buffer_;
+};
+
+LargeOutputBuffer* outputBuffer = nullptr;
+
+} // namespace
+
+void Console::setQuiet(bool quiet) {
+    quietMode.store(quiet, std::memory_order_relaxed);
+}
+
+bool Console::isQuiet() {
+    return quietMode.load(std::memory_order_relaxed);
+}
+
+std::ostream& Console::info() {
+    if (isQuiet()) {
+        return null();
+    }
+    return std::cout;
+}
+
+std::ostream& Console::null() {
+    static NullBuffer nullBuffer;
+    // One stream per thread so concurrent writers never share stream state
+    thread_local std::ostream nullStream(&nullBuffer);
+    return nullStream;
+}
+
+void Console::enableBufferedOutput(size_t bufferSize) {
+    if (outputBuffer) {
+        return;
+    }
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+    outputBuffer = new LargeOutputBuffer(bufferSize);
+    std::cout.rdbuf(outputBuffer);
+}
+
+void Console::flush() {
+    if (outputBuffer) {
+        outputBuffer->drain();
+    } else {
+        std::cout.flush();
+    }
+}
+
+} // namespace util
+} // namespace soliddb
@@ -0,0 +1,153 @@
+#include "util/Lz.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace soliddb {
+namespace util {
+
+namespace {
+
+uint32_t read32(const char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+void writeLength(std::string& out, size_t length) {
+    // Lengths of 15 and more continue in bytes of 255 and a final remainder
+    for (; length >= 255; length -= 255) {
+        out.push_back(static_cast<char>(255));
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+bool readLength(const unsigned char* in, size_t size, size_t& pos, size_t& length) {
+    unsigned char byte;
+    do {
+        if (pos >= size) {
+            return false;
+        }
+        byte = in[pos++];
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+void writeSequence(std::string& out, const char* literals, size_t literalCount,
+                   size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength - 4;
+    out.push_back(static_cast<char>((std::min<size_t>(literalCount, 15) << 4) |
+                                    std::min<size_t>(matchCode, 15)));
+    if (literalCount >= 15) {
+        writeLength(out, literalCount - 15);
+    }
+    out.append(literals, literalCount);
+    out.push_back(static_cast<char>(offset & 0xff));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15) {
+        writeLength(out, matchCode - 15);
+    }
+}
+
+} // namespace
+
+void Lz::compress(const char* data, size_t size, std::string& out) {
+    size_t anchor = 0;
+
+    if (size > MATCH_LIMIT) {
+        std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+        size_t limit = size - MATCH_LIMIT;
+        size_t matchEndLimit = size - LAST_LITERALS;
+        size_t pos = 0;
+
+        while (pos < limit) {
+            uint32_t sequence = read32(data + pos);
+            uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+            size_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(pos);
+
+            if (candidate >= pos || pos - candidate > MAX_OFFSET || read32(data + candidate) != sequence) {
+                // Step further the longer nothing matched, so incompressible data stays cheap
+                pos += 1 + ((pos - anchor) >> 6);
+                continue;
+            }
+
+            size_t matchEnd = pos + MIN_MATCH;
+            while (matchEnd < matchEndLimit && data[matchEnd] == data[candidate + (matchEnd - pos)]) {
+                matchEnd++;
+            }
+            while (pos > anchor && candidate > 0 && data[pos - 1] == data[candidate - 1]) {
+                pos--;
+                candidate--;
+            }
+
+            writeSequence(out, data + anchor, pos - anchor, pos - candidate, matchEnd - pos);
+            pos = matchEnd;
+            anchor = pos;
+        }
+    }
+
+    size_t literalCount = size - anchor;
+    out.push_back(static_cast<char>(std::min<size_t>(literalCount, 15) << 4));
+    if (literalCount >= 15) {
+        writeLength(out, literalCount - 15);
+    }
+    out.append(data + anchor, literalCount);
+}
+
+bool Lz::decompress(const char* data, size_t size, char* out, size_t outSize) {
+    const auto* in = reinterpret_cast<const unsigned char*>(data);
+    size_t inPos = 0;
+    size_t outPos = 0;
+
+    while (inPos < size) {
+        unsigned token = in[inPos++];
+
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(in, size, inPos, literalCount)) {
+            return false;
+        }
+        if (literalCount > size - inPos || literalCount > outSize - outPos) {
+            return false;
+        }
+        std::memcpy(out + outPos, data + inPos, literalCount);
+        inPos += literalCount;
+        outPos += literalCount;
+
+        if (inPos == size) {
+            break;
+        }
+
+        if (size - inPos < 2) {
+            return false;
+        }
+        size_t offset = in[inPos] | (size_t(in[inPos + 1]) << 8);
+        inPos += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(in, size, inPos, matchLength)) {
+            return false;
+        }
+        matchLength += MIN_MATCH;
+        if (offset == 0 || offset > outPos || matchLength > outSize - outPos) {
+            return false;
+        }
+
+        // Matches may overlap their own output (runs), so copy forwards
+        const char* source = out + outPos - offset;
+        if (offset >= matchLength) {
+            std::memcpy(out + outPos, source, matchLength);
+        } else {
+            for (size_t i = 0; i < matchLength; i++) {
+                out[outPos + i] = source[i];
+            }
+        }
+        outPos += matchLength;
+    }
+
+    return outPos == outSize;
+}
+
+} // namespace util
+} // namespace soliddb
@@ -0,0 +1,283 @@
+#include "util/Metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace soliddb {
+namespace util {
+
+namespace {
+
+const char* const STATEMENT_NAMES[] = {
+    "CREATE", "USE", "INSERT", "UPDATE", "DELETE", "SELECT", "BEGIN", "COMMIT", "ROLLBACK", "CHECKPOINT", "LIST", "SHOW",
+    "EXPLAIN", "OTHER"};
+const char* const PHASE_NAMES[] = {"parse", "plan", "execute", "wal", "checkpoint"};
+const char* const COUNTER_NAMES[] = {
+    "rows_scanned", "rows_returned", "rows_updated", "rows_deleted", "rows_compacted", "index_probes", "index_hits",
+    "bytes_written", "page_hits", "page_misses", "page_evictions", "page_writebacks", "lsm_flushes",
+    "lsm_compactions", "bloom_skips", "run_block_reads", "blocks_skipped", "blocks_scanned",
+    "cache_hits", "cache_misses", "cache_evictions"};
+
+thread_local Metrics::Trace* activeTraceOfThread = nullptr;
+
+void appendHistogramRow(std::ostringstream& out, const std::string& name, const Histogram& histogram) {
+    uint64_t count = histogram.count();
+    if (count == 0) {
+        return;
+    }
+    out << "  " << std::left << std::setw(12) << name << std::right
+        << std::setw(10) << count
+        << std::setw(10) << Metrics::formatDuration(histogram.sum() / count)
+        << std::setw(10) << Metrics::formatDuration(histogram.percentile(0.50))
+        << std::setw(10) << Metrics::formatDuration(histogram.percentile(0.99))
+        << std::setw(10) << Metrics::formatDuration(histogram.percentile(0.999))
+        << std::setw(10) << Metrics::formatDuration(histogram.max()) << "\n";
+}
+
+} // namespace
+
+void Histogram::record(uint64_t value) {
+    buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t current = max_.load(std::memory_order_relaxed);
+    while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::recordSince(std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+}
+
+uint64_t Histogram::count() const {
+    return count_.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::sum() const {
+    return sum_.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::max() const {
+    return max_.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::percentile(double fraction) const {
+    // Sum the buckets rather than trusting count_, which may be slightly
+    // ahead of them while other threads are recording
+    uint64_t total = 0;
+    for (const auto& bucket : buckets_) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    // Nearest rank: the smallest sample with at least fraction of them at
+    // or below it, so p99 of fewer than 100 samples is the maximum. The
+    // epsilon keeps 0.999 * 1000 from rounding up past 999.
+    uint64_t target = static_cast<uint64_t>(std::ceil(fraction * total - 1e-9));
+    target = std::min(std::max<uint64_t>(target, 1), total);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            uint64_t bound = bucketUpperBound(i);
+            uint64_t highest = max();
+            return bound < highest ? bound : highest;
+        }
+    }
+    return max();
+}
+
+void Histogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+size_t Histogram::bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    size_t subBucket = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + subBucket;
+}
+
+uint64_t Histogram::bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    int exponent = static_cast<int>(index / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+    uint64_t subBucket = index % SUB_BUCKETS;
+    int shift = exponent - SUB_BUCKET_BITS;
+    uint64_t lower = (SUB_BUCKETS + subBucket) << shift;
+    return lower + ((uint64_t{1} << shift) - 1);
+}
+
+Metrics& Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::~Metrics() {
+    stopPeriodicDump();
+}
+
+Histogram& Metrics::statement(Statement type) {
+    return statements_[static_cast<size_t>(type)];
+}
+
+Histogram& Metrics::phase(Phase phase) {
+    return phases_[static_cast<size_t>(phase)];
+}
+
+void Metrics::recordPhase(Phase phase, uint64_t nanoseconds) {
+    phases_[static_cast<size_t>(phase)].record(nanoseconds);
+    if (activeTraceOfThread) {
+        activeTraceOfThread->phaseNanoseconds[static_cast<size_t>(phase)] += nanoseconds;
+    }
+}
+
+void Metrics::add(Counter counter, uint64_t amount) {
+    counters_[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+    if (activeTraceOfThread) {
+        activeTraceOfThread->counters[static_cast<size_t>(counter)] += amount;
+    }
+}
+
+uint64_t Metrics::get(Counter counter) const {
+    return counters_[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+}
+
+std::string Metrics::formatDuration(uint64_t nanoseconds) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1);
+    if (nanoseconds < 1000) {
+        text << nanoseconds << "ns";
+    } else if (nanoseconds < 1000000) {
+        text << nanoseconds / 1e3 << "us";
+    } else if (nanoseconds < 1000000000) {
+        text << nanoseconds / 1e6 << "ms";
+    } else {
+        text << nanoseconds / 1e9 << "s";
+    }
+    return text.str();
+}
+
+Metrics::Statement Metrics::classify(const std::string& keyword) {
+    for (size_t i = 0; i < static_cast<size_t>(Statement::OTHER); i++) {
+        if (keyword == STATEMENT_NAMES[i]) {
+            return static_cast<Statement>(i);
+        }
+    }
+    // SAVE is an alias of CHECKPOINT
+    if (keyword == "SAVE") {
+        return Statement::CHECKPOINT;
+    }
+    return Statement::OTHER;
+}
+
+Metrics::Trace* Metrics::activeTrace() {
+    return activeTraceOfThread;
+}
+
+void Metrics::setActiveTrace(Trace* trace) {
+    activeTraceOfThread = trace;
+}
+
+const char* Metrics::phaseName(Phase phase) {
+    return PHASE_NAMES[static_cast<size_t>(phase)];
+}
+
+const char* Metrics::counterName(Counter counter) {
+    return COUNTER_NAMES[static_cast<size_t>(counter)];
+}
+
+std::string Metrics::report() const {
+    std::ostringstream out;
+
+    out << "Statement latency:\n";
+    out << "  " << std::left << std::setw(12) << "statement" << std::right << std::setw(10) << "count"
+        << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p99"
+        << std::setw(10) << "p99.9" << std::setw(10) << "max" << "\n";
+    for (size_t i = 0; i < statements_.size(); i++) {
+        appendHistogramRow(out, STATEMENT_NAMES[i], statements_[i]);
+    }
+
+    out << "Phase latency:\n";
+    out << "  " << std::left << std::setw(12) << "phase" << std::right << std::setw(10) << "count"
+        << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p99"
+        << std::setw(10) << "p99.9" << std::setw(10) << "max" << "\n";
+    for (size_t i = 0; i < phases_.size(); i++) {
+        appendHistogramRow(out, PHASE_NAMES[i], phases_[i]);
+    }
+
+    out << "Counters:\n";
+    for (size_t i = 0; i < counters_.size(); i++) {
+        out << "  " << std::left << std::setw(16) << COUNTER_NAMES[i] << std::right
+            << counters_[i].load(std::memory_order_relaxed) << "\n";
+    }
+    return out.str();
+}
+
+void Metrics::reset() {
+    for (auto& histogram : statements_) {
+        histogram.reset();
+    }
+    for (auto& histogram : phases_) {
+        histogram.reset();
+    }
+    for (auto& counter : counters_) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool Metrics::startPeriodicDump(const std::string& path, std::chrono::seconds interval) {
+    std::lock_guard<std::mutex> lock(dumpMutex_);
+    if (dumpThread_.joinable()) {
+        return false;
+    }
+
+    dumpStopping_ = false;
+    dumpThread_ = std::thread([this, path, interval]() {
+        std::unique_lock<std::mutex> lock(dumpMutex_);
+        while (!dumpWake_.wait_for(lock, interval, [this] { return dumpStopping_; })) {
+            lock.unlock();
+
+            std::ofstream file(path, std::ios::app);
+            if (file) {
+                std::time_t now = std::time(nullptr);
+                file << "=== " << std::put_time(std::localtime(&now), "%Y-%m-%d %H:%M:%S") << " ===\n"
+                     << report() << "\n";
+            }
+
+            lock.lock();
+        }
+    });
+    return true;
+}
+
+void Metrics::stopPeriodicDump() {
+    {
+        std::lock_guard<std::mutex> lock(dumpMutex_);
+        if (!dumpThread_.joinable()) {
+            return;
+        }
+        dumpStopping_ = true;
+    }
+    dumpWake_.notify_all();
+    dumpThread_.join();
+}
+
+} // namespace util
+} // namespace soliddb
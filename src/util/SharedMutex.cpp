@@ -0,0 +1,50 @@
+#include "util/SharedMutex.h"
+#include <system_error>
+
+namespace soliddb {
+namespace util {
+
+SharedMutex::SharedMutex() {
+    pthread_rwlockattr_t attributes;
+    pthread_rwlockattr_init(&attributes);
+#if defined(__GLIBC__)
+    pthread_rwlockattr_setkind_np(&attributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    int rc = pthread_rwlock_init(&rwlock_, &attributes);
+    pthread_rwlockattr_destroy(&attributes);
+    
+    if (rc != 0) {
+        throw std::system_error(rc, std::system_category(), "pthread_rwlock_init");
+    }
+}
+
+SharedMutex::~SharedMutex() {
+    pthread_rwlock_destroy(&rwlock_);
+}
+
+void SharedMutex::lock() {
+    pthread_rwlock_wrlock(&rwlock_);
+}
+
+bool SharedMutex::try_lock() {
+    return pthread_rwlock_trywrlock(&rwlock_) == 0;
+}
+
+void SharedMutex::unlock() {
+    pthread_rwlock_unlock(&rwlock_);
+}
+
+void SharedMutex::lock_shared() {
+    pthread_rwlock_rdlock(&rwlock_);
+}
+
+bool SharedMutex::try_lock_shared() {
+    return pthread_rwlock_tryrdlock(&rwlock_) == 0;
+}
+
+void SharedMutex::unlock_shared() {
+    pthread_rwlock_unlock(&rwlock_);
+}
+
+} // namespace util
+} // namespace soliddb
@@ -0,0 +1,186 @@
+#include "util/SlowQueryLog.h"
+#include <cctype>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace soliddb {
+namespace util {
+
+SlowQueryLog& SlowQueryLog::instance() {
+    static SlowQueryLog log;
+    return log;
+}
+
+SlowQueryLog::~SlowQueryLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+void SlowQueryLog::setThreshold(std::chrono::microseconds threshold) {
+    thresholdMicros_ = threshold.count() > 0 ? threshold.count() : 0;
+}
+
+std::chrono::microseconds SlowQueryLog::getThreshold() const {
+    return std::chrono::microseconds(thresholdMicros_.load());
+}
+
+bool SlowQueryLog::isEnabled() const {
+    return thresholdMicros_.load() > 0;
+}
+
+void SlowQueryLog::record(const std::string& directory, const std::string& statement,
+                          uint64_t totalNanoseconds, const Metrics::Trace& trace) {
+    int64_t threshold = thresholdMicros_.load();
+    if (threshold <= 0 || totalNanoseconds < static_cast<uint64_t>(threshold) * 1000) {
+        return;
+    }
+
+    std::ostringstream line;
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    line << std::put_time(&local, "%Y-%m-%d %H:%M:%S")
+         << " time=" << Metrics::formatDuration(totalNanoseconds);
+    for (size_t i = 0; i < trace.phaseNanoseconds.size(); i++) {
+        if (trace.phaseNanoseconds[i] > 0) {
+            line << " " << Metrics::phaseName(static_cast<Metrics::Phase>(i)) << "="
+                 << Metrics::formatDuration(trace.phaseNanoseconds[i]);
+        }
+    }
+    line << " rows_scanned=" << trace.counters[static_cast<size_t>(Metrics::Counter::ROWS_SCANNED)]
+         << " rows_returned=" << trace.counters[static_cast<size_t>(Metrics::Counter::ROWS_RETURNED)]
+         << " access=\"" << (trace.accessPath.empty() ? "-" : trace.accessPath) << "\""
+         << " statement=\"" << normalize(statement) << "\"\n";
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() >= MAX_QUEUED_ENTRIES) {
+            dropped_++;
+            return;
+        }
+        queue_.push_back(Entry{directory, line.str()});
+        if (!writer_.joinable()) {
+            writer_ = std::thread(&SlowQueryLog::writerLoop, this);
+        }
+    }
+    wake_.notify_one();
+}
+
+std::string SlowQueryLog::normalize(const std::string& statement) {
+    std::string result;
+    result.reserve(statement.size());
+
+    size_t i = 0;
+    while (i < statement.size()) {
+        char c = statement[i];
+
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            while (i < statement.size() && std::isspace(static_cast<unsigned char>(statement[i]))) {
+                i++;
+            }
+            if (!result.empty()) {
+                result += ' ';
+            }
+            continue;
+        }
+
+        if (c == '\'' || c == '"') {
+            // Quoted literal; a doubled quote is an escaped quote
+            i++;
+            while (i < statement.size()) {
+                if (statement[i] == c) {
+                    if (i + 1 < statement.size() && statement[i + 1] == c) {
+                        i += 2;
+                        continue;
+                    }
+                    i++;
+                    break;
+                }
+                i++;
+            }
+            result += '?';
+            continue;
+        }
+
+        bool startsWord = result.empty() ||
+            !(std::isalnum(static_cast<unsigned char>(result.back())) || result.back() == '_');
+        bool isNumber = std::isdigit(static_cast<unsigned char>(c)) ||
+            ((c == '-' || c == '.') && i + 1 < statement.size() &&
+             std::isdigit(static_cast<unsigned char>(statement[i + 1])));
+        if (startsWord && isNumber) {
+            i++;
+            while (i < statement.size() &&
+                   (std::isalnum(static_cast<unsigned char>(statement[i])) || statement[i] == '.')) {
+                i++;
+            }
+            result += '?';
+            continue;
+        }
+
+        result += c;
+        i++;
+    }
+
+    while (!result.empty() && result.back() == ' ') {
+        result.pop_back();
+    }
+    return result;
+}
+
+void SlowQueryLog::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [this] { return queue_.empty() && !writing_; });
+}
+
+uint64_t SlowQueryLog::getDroppedCount() const {
+    return dropped_.load();
+}
+
+void SlowQueryLog::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;
+        }
+
+        std::deque<Entry> batch;
+        batch.swap(queue_);
+        writing_ = true;
+        lock.unlock();
+
+        // Consecutive entries for the same database share one open file
+        std::ofstream file;
+        std::string openDirectory;
+        for (const auto& entry : batch) {
+            if (!file.is_open() || entry.directory != openDirectory) {
+                file.close();
+                file.clear();
+                openDirectory = entry.directory;
+                std::string path = openDirectory.empty() ? FILE_NAME : openDirectory + "/" + FILE_NAME;
+                file.open(path, std::ios::app);
+            }
+            if (file) {
+                file << entry.line;
+            }
+        }
+        file.close();
+
+        lock.lock();
+        writing_ = false;
+        if (queue_.empty()) {
+            drained_.notify_all();
+        }
+    }
+}
+
+} // namespace util
+} // namespace soliddb
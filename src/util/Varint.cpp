@@ -0,0 +1,30 @@
+#include "util/Varint.h"
+
+namespace soliddb {
+namespace util {
+
+void Varint::write(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool Varint::read(std::string_view in, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (pos >= in.size()) {
+            return false;
+        }
+        auto byte = static_cast<unsigned char>(in[pos++]);
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace util
+} // namespace soliddb
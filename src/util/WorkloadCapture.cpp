@@ -0,0 +1,175 @@
+#include "util/WorkloadCapture.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace soliddb {
+namespace util {
+
+namespace {
+
+template <typename T>
+void appendLittleEndian(std::string& out, T value) {
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out += static_cast<char>((static_cast<uint64_t>(value) >> (8 * i)) & 0xFF);
+    }
+}
+
+template <typename T>
+T readLittleEndian(const char* data) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return static_cast<T>(value);
+}
+
+constexpr size_t FRAME_HEADER_BYTES = sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint16_t);
+
+} // namespace
+
+constexpr char WorkloadCapture::MAGIC[8];
+
+WorkloadCapture& WorkloadCapture::instance() {
+    static WorkloadCapture capture;
+    return capture;
+}
+
+WorkloadCapture::~WorkloadCapture() {
+    stop();
+}
+
+bool WorkloadCapture::start(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+        return false;
+    }
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_ || std::fwrite(MAGIC, 1, sizeof(MAGIC), file_) != sizeof(MAGIC)) {
+        if (file_) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+        return false;
+    }
+
+    start_ = std::chrono::steady_clock::now();
+    stopping_ = false;
+    writer_ = std::thread(&WorkloadCapture::writerLoop, this);
+    active_ = true;
+    return true;
+}
+
+void WorkloadCapture::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!file_) {
+            return;
+        }
+        active_ = false;
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    writer_.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+bool WorkloadCapture::isActive() const {
+    return active_.load(std::memory_order_relaxed);
+}
+
+void WorkloadCapture::record(uint32_t session, const std::string& database, const std::string& statement) {
+    if (!isActive()) {
+        return;
+    }
+
+    auto offset = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_).count();
+    uint16_t databaseLength = static_cast<uint16_t>(std::min<size_t>(database.size(), UINT16_MAX));
+    uint32_t frameLength = static_cast<uint32_t>(FRAME_HEADER_BYTES + databaseLength + statement.size());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!active_ || pending_.size() + frameLength > MAX_PENDING_BYTES) {
+            dropped_++;
+            return;
+        }
+        appendLittleEndian(pending_, frameLength);
+        appendLittleEndian(pending_, static_cast<uint64_t>(offset));
+        appendLittleEndian(pending_, session);
+        appendLittleEndian(pending_, databaseLength);
+        pending_.append(database, 0, databaseLength);
+        pending_ += statement;
+    }
+    captured_++;
+    wake_.notify_one();
+}
+
+uint64_t WorkloadCapture::getCapturedCount() const {
+    return captured_.load();
+}
+
+uint64_t WorkloadCapture::getDroppedCount() const {
+    return dropped_.load();
+}
+
+bool WorkloadCapture::read(const std::string& path, std::vector<CapturedStatement>& statements) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(MAGIC) || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+
+    size_t pos = sizeof(MAGIC);
+    while (pos + sizeof(uint32_t) <= data.size()) {
+        uint32_t frameLength = readLittleEndian<uint32_t>(data.data() + pos);
+        pos += sizeof(uint32_t);
+        if (frameLength < FRAME_HEADER_BYTES || pos + frameLength > data.size()) {
+            break;  // Truncated last frame, e.g. the process was killed
+        }
+
+        const char* frame = data.data() + pos;
+        CapturedStatement captured;
+        captured.offsetNanoseconds = readLittleEndian<uint64_t>(frame);
+        captured.session = readLittleEndian<uint32_t>(frame + 8);
+        uint16_t databaseLength = readLittleEndian<uint16_t>(frame + 12);
+        if (FRAME_HEADER_BYTES + databaseLength > frameLength) {
+            break;
+        }
+        captured.database.assign(frame + FRAME_HEADER_BYTES, databaseLength);
+        captured.statement.assign(frame + FRAME_HEADER_BYTES + databaseLength,
+                                  frameLength - FRAME_HEADER_BYTES - databaseLength);
+        statements.push_back(std::move(captured));
+        pos += frameLength;
+    }
+    return true;
+}
+
+void WorkloadCapture::writerLoop() {
+    std::string batch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            return;
+        }
+
+        batch.clear();
+        batch.swap(pending_);
+        lock.unlock();
+        std::fwrite(batch.data(), 1, batch.size(), file_);
+        std::fflush(file_);
+        lock.lock();
+    }
+}
+
+} // namespace util
+} // namespace soliddb